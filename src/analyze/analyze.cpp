@@ -7,11 +7,41 @@
  */
 std::shared_ptr<Query> Analyze::do_analyze(std::shared_ptr<ast::TreeNode> parse)
 {
+    if (auto x = std::dynamic_pointer_cast<ast::ExplainStmt>(parse)) {
+        // explain只分析其中的select语句，parse保留explain节点供planner识别
+        if (std::dynamic_pointer_cast<ast::SelectStmt>(x->stmt) == nullptr) {
+            throw RMDBError("EXPLAIN only supports SELECT statements");
+        }
+        std::shared_ptr<Query> query = do_analyze(x->stmt);
+        query->parse = std::move(parse);
+        return query;
+    }
+    if (auto x = std::dynamic_pointer_cast<ast::CreateMaterializedView>(parse)) {
+        // 视图只支持连接上的选择投影和count(*)，它们可以按基表的每条记录变更增量维护
+        auto select = std::dynamic_pointer_cast<ast::SelectStmt>(x->query);
+        if (select == nullptr) {
+            throw RMDBError("A materialized view must be defined by a SELECT statement");
+        }
+        if (sm_manager_->db_.is_table(x->view_name)) {
+            throw TableExistsError(x->view_name);
+        }
+        if (select->sample != nullptr || select->has_sort || select->limit != nullptr || !select->group_by.empty() ||
+            select->distinct) {
+            throw RMDBError("Materialized views do not support DISTINCT, TABLESAMPLE, GROUP BY, ORDER BY or LIMIT");
+        }
+        if (!select->aggs.empty() &&
+            (select->aggs.size() != 1 || select->aggs[0]->func != ast::SV_AGG_COUNT_STAR)) {
+            throw RMDBError("Materialized views only support the count(*) aggregate");
+        }
+        std::shared_ptr<Query> query = do_analyze(select);
+        query->parse = std::move(parse);
+        return query;
+    }
     std::shared_ptr<Query> query = std::make_shared<Query>();
     if (auto x = std::dynamic_pointer_cast<ast::SelectStmt>(parse))
     {
-        // 处理表名
-        query->tables = std::move(x->tabs);
+        // 处理表名，复制而不是移走，语法树可以被预编译语句重复分析
+        query->tables = x->tabs;
         // 检查表是否存在
         for (auto tbl : query->tables) {
             if(!sm_manager_->db_.is_table(tbl)) {
@@ -19,6 +49,18 @@ std::shared_ptr<Query> Analyze::do_analyze(std::shared_ptr<ast::TreeNode> parse)
             }
         }
 
+        // 处理tablesample，只支持单表
+        if (x->sample != nullptr) {
+            if (query->tables.size() != 1) {
+                throw RMDBError("TABLESAMPLE only supports a single table");
+            }
+            if (!(x->sample->percent >= 0 && x->sample->percent <= 100)) {
+                throw RMDBError("TABLESAMPLE percentage must be between 0 and 100");
+            }
+            query->sample.method = x->sample->method == ast::SV_SAMPLE_SYSTEM ? SAMPLE_SYSTEM : SAMPLE_BERNOULLI;
+            query->sample.fraction = x->sample->percent / 100.0;
+        }
+
         // 处理target list，再target list中添加上表名，例如 a.id
         for (auto &sv_sel_col : x->cols) {
             TabCol sel_col = {.tab_name = sv_sel_col->tab_name, .col_name = sv_sel_col->col_name};
@@ -27,7 +69,36 @@ std::shared_ptr<Query> Analyze::do_analyze(std::shared_ptr<ast::TreeNode> parse)
         // auto all_cols = get_all_cols(query->tables);
         std::vector<ColMeta> all_cols;
         get_all_cols(query->tables, all_cols);
-        if (query->cols.empty()) {
+        if (!x->aggs.empty()) {
+            // 带聚集函数的查询暂不支持排序
+            if (x->has_sort) {
+                throw RMDBError("ORDER BY is not supported with aggregate functions");
+            }
+            // 分组字段，select列表中的普通字段必须出现在group by中
+            for (auto &sv_col : x->group_by) {
+                TabCol group_col = {.tab_name = sv_col->tab_name, .col_name = sv_col->col_name};
+                query->group_by.push_back(check_column(all_cols, group_col));
+            }
+            for (auto &sel_col : query->cols) {
+                sel_col = check_column(all_cols, sel_col);
+                auto same_col = [&](const TabCol &col) {
+                    return col.tab_name == sel_col.tab_name && col.col_name == sel_col.col_name;
+                };
+                if (std::none_of(query->group_by.begin(), query->group_by.end(), same_col)) {
+                    throw RMDBError("Column " + sel_col.tab_name + "." + sel_col.col_name +
+                                    " must appear in the GROUP BY clause");
+                }
+            }
+            for (auto &sv_agg : x->aggs) {
+                AggExpr agg = {.func = AGG_COUNT_STAR, .arg = {}};
+                if (sv_agg->func == ast::SV_AGG_APPROX_COUNT_DISTINCT) {
+                    TabCol arg = {.tab_name = sv_agg->arg->tab_name, .col_name = sv_agg->arg->col_name};
+                    agg = {.func = AGG_APPROX_COUNT_DISTINCT, .arg = check_column(all_cols, arg)};
+                }
+                query->cols.push_back({.tab_name = "", .col_name = agg.name()});
+                query->aggs.push_back(agg);
+            }
+        } else if (query->cols.empty()) {
             // select all columns
             for (auto &col : all_cols) {
                 TabCol sel_col = {.tab_name = col.tab_name, .col_name = col.name};
@@ -39,10 +110,34 @@ std::shared_ptr<Query> Analyze::do_analyze(std::shared_ptr<ast::TreeNode> parse)
                 sel_col = check_column(all_cols, sel_col);  // 列元数据校验
             }
         }
+        query->distinct = x->distinct;
+        if (x->distinct && x->has_sort) {
+            // 去重后每个键值只剩一条记录，排序字段必须是去重的字段之一
+            TabCol order_col = {.tab_name = x->order->cols->tab_name, .col_name = x->order->cols->col_name};
+            order_col = check_column(all_cols, order_col);
+            auto same_col = [&](const TabCol &col) {
+                return col.tab_name == order_col.tab_name && col.col_name == order_col.col_name;
+            };
+            if (std::none_of(query->cols.begin(), query->cols.end(), same_col)) {
+                throw RMDBError("For SELECT DISTINCT, ORDER BY column " + order_col.tab_name + "." +
+                                order_col.col_name + " must appear in the select list");
+            }
+        }
         //处理where条件
         get_clause(x->conds, query->conds);
         check_clause(query->tables, query->conds);
+        add_like_ranges(query->conds);
+
+        // 处理limit/offset
+        if (x->limit != nullptr) {
+            if (x->limit->count < 0 || x->limit->offset < 0) {
+                throw RMDBError("LIMIT and OFFSET must not be negative");
+            }
+            query->limit = x->limit->count;
+            query->offset = x->limit->offset;
+        }
     } else if (auto x = std::dynamic_pointer_cast<ast::UpdateStmt>(parse)) {
+        check_not_view(x->tab_name);
         // 处理 update 的set 值
         for (auto &sv_set_clause : x->set_clauses) {
             SetClause set_clause = {.lhs = {.tab_name = "", .col_name = sv_set_clause->col_name},
@@ -52,6 +147,7 @@ std::shared_ptr<Query> Analyze::do_analyze(std::shared_ptr<ast::TreeNode> parse)
         TabMeta &tab = sm_manager_->db_.get_table(x->tab_name);
         for (auto &set_clause : query->set_clauses) {
             auto lhs_col = tab.get_col(set_clause.lhs.col_name);
+            coerce_value(set_clause.rhs, lhs_col->type);
             if (lhs_col->type != set_clause.rhs.type) {
                 throw IncompatibleTypeError(coltype2str(lhs_col->type), coltype2str(set_clause.rhs.type));
             }
@@ -60,15 +156,34 @@ std::shared_ptr<Query> Analyze::do_analyze(std::shared_ptr<ast::TreeNode> parse)
         //处理where条件
         get_clause(x->conds, query->conds);
         check_clause({x->tab_name}, query->conds);
+        add_like_ranges(query->conds);
     } else if (auto x = std::dynamic_pointer_cast<ast::DeleteStmt>(parse)) {
+        check_not_view(x->tab_name);
         //处理where条件
         get_clause(x->conds, query->conds);
-        check_clause({x->tab_name}, query->conds);        
+        check_clause({x->tab_name}, query->conds);
+        add_like_ranges(query->conds);
+    } else if (auto x = std::dynamic_pointer_cast<ast::CreateIndex>(parse)) {
+        // 处理部分索引的谓词，只支持 字段 op 常量
+        get_clause(x->conds, query->conds);
+        check_clause({x->tab_name}, query->conds);
+        for (auto &cond : query->conds) {
+            if (!cond.is_rhs_val || cond.op == OP_LIKE) {
+                throw RMDBError("Partial index predicate must compare a column with a constant");
+            }
+        }
     } else if (auto x = std::dynamic_pointer_cast<ast::InsertStmt>(parse)) {
+        check_not_view(x->tab_name);
         // 处理insert 的values值
         for (auto &sv_val : x->vals) {
             query->values.push_back(convert_sv_value(sv_val));
         }
+        TabMeta &tab = sm_manager_->db_.get_table(x->tab_name);
+        for (size_t i = 0; i < query->values.size() && i < tab.cols.size(); i++) {
+            coerce_value(query->values[i], tab.cols[i].type);
+        }
+    } else if (auto x = std::dynamic_pointer_cast<ast::TruncateTable>(parse)) {
+        check_not_view(x->tab_name);
     } else {
         // do nothing
     }
@@ -128,6 +243,15 @@ void Analyze::get_clause(const std::vector<std::shared_ptr<ast::BinaryExpr>> &sv
     }
 }
 
+/**
+ * @description: 物化视图的内容只由基表的修改维护，不能直接修改
+ */
+void Analyze::check_not_view(const std::string &tab_name) {
+    if (sm_manager_->db_.is_view(tab_name)) {
+        throw RMDBError("Cannot modify materialized view " + tab_name + " directly");
+    }
+}
+
 void Analyze::check_clause(const std::vector<std::string> &tab_names, std::vector<Condition> &conds) {
     // auto all_cols = get_all_cols(tab_names);
     std::vector<ColMeta> all_cols;
@@ -143,7 +267,16 @@ void Analyze::check_clause(const std::vector<std::string> &tab_names, std::vecto
         auto lhs_col = lhs_tab.get_col(cond.lhs_col.col_name);
         ColType lhs_type = lhs_col->type;
         ColType rhs_type;
+        if (cond.op == OP_LIKE) {
+            // 模式串可能比字段长，raw按模式串长度分配并以'\0'结尾，同时不短于字段，按字段长度读取也不会越界
+            if (!cond.is_rhs_val || lhs_type != TYPE_STRING || cond.rhs_val.type != TYPE_STRING) {
+                throw RMDBError("LIKE requires a CHAR column and a string pattern");
+            }
+            cond.rhs_val.init_raw(std::max(lhs_col->len, static_cast<int>(cond.rhs_val.str_val.size()) + 1));
+            continue;
+        }
         if (cond.is_rhs_val) {
+            coerce_value(cond.rhs_val, lhs_type);
             cond.rhs_val.init_raw(lhs_col->len);
             rhs_type = cond.rhs_val.type;
         } else {
@@ -157,11 +290,56 @@ void Analyze::check_clause(const std::vector<std::string> &tab_names, std::vecto
     }
 }
 
+/**
+ * @description: 为有前缀的LIKE条件添加等价的范围条件 col >= 'abc' and col < 'abd'，使其可以走B+树范围扫描
+ *               模式恰好为“前缀%”时，范围条件与LIKE等价，去掉LIKE条件
+ */
+void Analyze::add_like_ranges(std::vector<Condition> &conds) {
+    std::vector<Condition> ranges;
+    for (auto it = conds.begin(); it != conds.end();) {
+        if (it->op != OP_LIKE) {
+            ++it;
+            continue;
+        }
+        int len = sm_manager_->db_.get_table(it->lhs_col.tab_name).get_col(it->lhs_col.col_name)->len;
+        bool prefix_only;
+        std::string prefix = like_prefix(it->rhs_val.str_val, &prefix_only);
+        if (prefix.empty() || static_cast<int>(prefix.size()) > len) {
+            // 没有前缀，或前缀比字段长（没有记录满足），只能逐条匹配
+            ++it;
+            continue;
+        }
+        // 上界：前缀的最后一个字节加一，0xff无法进位时去掉该字节
+        std::string upper = prefix;
+        while (!upper.empty() && static_cast<unsigned char>(upper.back()) == 0xff) {
+            upper.pop_back();
+        }
+        Condition lower_cond = {.lhs_col = it->lhs_col, .op = OP_GE, .is_rhs_val = true};
+        lower_cond.rhs_val.set_str(prefix);
+        lower_cond.rhs_val.init_raw(len);
+        ranges.push_back(std::move(lower_cond));
+        if (!upper.empty()) {
+            upper.back() = static_cast<char>(static_cast<unsigned char>(upper.back()) + 1);
+            Condition upper_cond = {.lhs_col = it->lhs_col, .op = OP_LT, .is_rhs_val = true};
+            upper_cond.rhs_val.set_str(upper);
+            upper_cond.rhs_val.init_raw(len);
+            ranges.push_back(std::move(upper_cond));
+        }
+        if (prefix_only && !upper.empty()) {
+            it = conds.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    conds.insert(conds.end(), ranges.begin(), ranges.end());
+}
 
 Value Analyze::convert_sv_value(const std::shared_ptr<ast::Value> &sv_val) {
     Value val;
     if (auto int_lit = std::dynamic_pointer_cast<ast::IntLit>(sv_val)) {
         val.set_int(int_lit->val);
+    } else if (auto bigint_lit = std::dynamic_pointer_cast<ast::BigintLit>(sv_val)) {
+        val.set_bigint(bigint_lit->val);
     } else if (auto float_lit = std::dynamic_pointer_cast<ast::FloatLit>(sv_val)) {
         val.set_float(float_lit->val);
     } else if (auto str_lit = std::dynamic_pointer_cast<ast::StringLit>(sv_val)) {
@@ -172,10 +350,27 @@ Value Analyze::convert_sv_value(const std::shared_ptr<ast::Value> &sv_val) {
     return val;
 }
 
+/**
+ * @description: 常量按字段类型转换：INT常量可以作为BIGINT，字符串常量按'YYYY-MM-DD HH:MM:SS'解析为DATETIME，
+ * 其他类型不匹配的情况留给调用者报IncompatibleTypeError
+ */
+void Analyze::coerce_value(Value &val, ColType type) {
+    if (type == TYPE_BIGINT && val.type == TYPE_INT) {
+        val.set_bigint(val.int_val);
+    } else if (type == TYPE_DATETIME && val.type == TYPE_STRING) {
+        int64_t datetime;
+        if (!parse_datetime(val.str_val, datetime)) {
+            throw InvalidDatetimeError(val.str_val);
+        }
+        val.set_datetime(datetime);
+    }
+}
+
 CompOp Analyze::convert_sv_comp_op(ast::SvCompOp op) {
     std::map<ast::SvCompOp, CompOp> m = {
         {ast::SV_OP_EQ, OP_EQ}, {ast::SV_OP_NE, OP_NE}, {ast::SV_OP_LT, OP_LT},
         {ast::SV_OP_GT, OP_GT}, {ast::SV_OP_LE, OP_LE}, {ast::SV_OP_GE, OP_GE},
+        {ast::SV_OP_LIKE, OP_LIKE},
     };
     return m.at(op);
 }
@@ -34,6 +34,17 @@ class Query{
     std::vector<SetClause> set_clauses;
     //insert 的values值
     std::vector<Value> values;
+    // select列表中的聚集函数，不为空时cols为聚集结果的输出字段
+    std::vector<AggExpr> aggs;
+    // group by的字段，不为空时cols中的普通字段都是分组字段
+    std::vector<TabCol> group_by;
+    // select distinct，去掉在cols上重复的输出记录
+    bool distinct = false;
+    // tablesample
+    TableSample sample;
+    // limit/offset，limit为-1表示不限制
+    int limit = -1;
+    int offset = 0;
 
     Query(){}
 
@@ -54,7 +65,10 @@ private:
     void get_all_cols(const std::vector<std::string> &tab_names, std::vector<ColMeta> &all_cols);
     void get_clause(const std::vector<std::shared_ptr<ast::BinaryExpr>> &sv_conds, std::vector<Condition> &conds);
     void check_clause(const std::vector<std::string> &tab_names, std::vector<Condition> &conds);
+    void check_not_view(const std::string &tab_name);
+    void add_like_ranges(std::vector<Condition> &conds);
     Value convert_sv_value(const std::shared_ptr<ast::Value> &sv_val);
+    void coerce_value(Value &val, ColType type);
     CompOp convert_sv_comp_op(ast::SvCompOp op);
 };
 
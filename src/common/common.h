@@ -11,6 +11,8 @@ See the Mulan PSL v2 for more details. */
 #pragma once
 
 #include <cassert>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <memory>
 #include <string>
@@ -31,8 +33,9 @@ struct TabCol {
 struct Value {
     ColType type;  // type of value
     union {
-        int int_val;      // int value
-        float float_val;  // float value
+        int int_val;         // int value
+        float float_val;     // float value
+        int64_t bigint_val;  // bigint value, datetime按YYYYMMDDhhmmss编码
     };
     std::string str_val;  // string value
 
@@ -48,6 +51,16 @@ struct Value {
         float_val = float_val_;
     }
 
+    void set_bigint(int64_t bigint_val_) {
+        type = TYPE_BIGINT;
+        bigint_val = bigint_val_;
+    }
+
+    void set_datetime(int64_t datetime_val_) {
+        type = TYPE_DATETIME;
+        bigint_val = datetime_val_;
+    }
+
     void set_str(std::string str_val_) {
         type = TYPE_STRING;
         str_val = std::move(str_val_);
@@ -62,6 +75,9 @@ struct Value {
         } else if (type == TYPE_FLOAT) {
             assert(len == sizeof(float));
             *(float *)(raw->data) = float_val;
+        } else if (type == TYPE_BIGINT || type == TYPE_DATETIME) {
+            assert(len == sizeof(int64_t));
+            *(int64_t *)(raw->data) = bigint_val;
         } else if (type == TYPE_STRING) {
             if (len < (int)str_val.size()) {
                 throw StringOverflowError();
@@ -72,7 +88,76 @@ struct Value {
     }
 };
 
-enum CompOp { OP_EQ, OP_NE, OP_LT, OP_GT, OP_LE, OP_GE };
+/**
+ * DATETIME的存储格式：'YYYY-MM-DD HH:MM:SS'按十进制数字YYYYMMDDhhmmss编码为int64_t，
+ * 编码保持时间顺序，因此可以和BIGINT一样直接按8字节整数比较
+ */
+inline bool parse_datetime(const std::string &str, int64_t &datetime) {
+    int year, month, day, hour, minute, second, n = 0;
+    if (str.size() != 19 ||
+        sscanf(str.c_str(), "%4d-%2d-%2d %2d:%2d:%2d%n", &year, &month, &day, &hour, &minute, &second, &n) != 6 ||
+        n != 19) {
+        return false;
+    }
+    static const int days_in_month[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (year < 1000 || month < 1 || month > 12 || day < 1 || hour > 23 || minute > 59 || second > 59 ||
+        hour < 0 || minute < 0 || second < 0) {
+        return false;
+    }
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    if (day > days_in_month[month - 1] + (month == 2 && leap ? 1 : 0)) {
+        return false;
+    }
+    datetime = ((((year * 100LL + month) * 100 + day) * 100 + hour) * 100 + minute) * 100 + second;
+    return true;
+}
+
+inline std::string datetime2str(int64_t datetime) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d", (int)(datetime / 10000000000LL),
+             (int)(datetime / 100000000 % 100), (int)(datetime / 1000000 % 100), (int)(datetime / 10000 % 100),
+             (int)(datetime / 100 % 100), (int)(datetime % 100));
+    return buf;
+}
+
+/**
+ * @description: LIKE匹配，'%'匹配任意长度（可以为0）的字符串，'_'匹配任意一个字符，不支持转义，区分大小写
+ * @param {char*} str CHAR(n)字段的值，到'\0'或第len个字节为止
+ * @param {char*} pattern 以'\0'结尾的模式串
+ */
+inline bool like_match(const char *str, int len, const char *pattern) {
+    int n = 0;
+    while (n < len && str[n] != '\0') n++;
+    // 贪心匹配，遇到不匹配时回到上一个'%'，让它多匹配一个字符
+    int i = 0, j = 0, star = -1, star_i = 0;
+    while (i < n) {
+        if (pattern[j] != '\0' && pattern[j] != '%' && (pattern[j] == '_' || pattern[j] == str[i])) {
+            i++;
+            j++;
+        } else if (pattern[j] == '%') {
+            star = j++;
+            star_i = i;
+        } else if (star >= 0) {
+            j = star + 1;
+            i = ++star_i;
+        } else {
+            return false;
+        }
+    }
+    while (pattern[j] == '%') j++;
+    return pattern[j] == '\0';
+}
+
+/**
+ * @description: LIKE模式中第一个通配符之前的前缀，满足模式的字符串都以它开头
+ * @param {bool*} prefix_only 模式是否恰好为“前缀%”，即以前缀开头就满足模式
+ */
+inline std::string like_prefix(const std::string &pattern, bool *prefix_only) {
+    size_t pos = pattern.find_first_of("%_");
+    std::string prefix = pattern.substr(0, pos);
+    *prefix_only = pos != std::string::npos && pos + 1 == pattern.size() && pattern[pos] == '%';
+    return prefix;
+}
 
 struct Condition {
     TabCol lhs_col;   // left-hand side column
@@ -85,4 +170,34 @@ struct Condition {
 struct SetClause {
     TabCol lhs;
     Value rhs;
-};
\ No newline at end of file
+};
+/* TABLESAMPLE的采样方式：SYSTEM按页面采样，BERNOULLI按记录采样 */
+enum SampleMethod { SAMPLE_NONE, SAMPLE_SYSTEM, SAMPLE_BERNOULLI };
+
+struct TableSample {
+    SampleMethod method = SAMPLE_NONE;
+    double fraction = 1.0;  // 每个页面（SYSTEM）或每条记录（BERNOULLI）被选中的概率
+
+    bool enabled() const { return method != SAMPLE_NONE; }
+
+    /* 页面和记录各自被选中的概率，见RmSampler */
+    double page_fraction() const { return method == SAMPLE_SYSTEM ? fraction : 1.0; }
+    double row_fraction() const { return method == SAMPLE_BERNOULLI ? fraction : 1.0; }
+};
+
+enum AggFunc { AGG_APPROX_COUNT_DISTINCT, AGG_COUNT_STAR };
+
+/* select列表中的聚集函数 */
+struct AggExpr {
+    AggFunc func;
+    TabCol arg;                     // count(*)没有参数
+
+    /* 聚集结果作为输出字段时的字段名 */
+    std::string name() const {
+        switch (func) {
+            case AGG_APPROX_COUNT_DISTINCT: return "approx_count_distinct(" + arg.col_name + ")";
+            case AGG_COUNT_STAR: return "count(*)";
+        }
+        return arg.col_name;
+    }
+};
@@ -34,8 +34,29 @@ static constexpr int HEADER_PAGE_ID = 0;                                      //
 static constexpr int PAGE_SIZE = 4096;                                        // size of a data page in byte  4KB
 static constexpr int BUFFER_POOL_SIZE = 65536;                                // size of buffer pool 256MB
 // static constexpr int BUFFER_POOL_SIZE = 262144;                                // size of buffer pool 1GB
+static constexpr int ASYNC_IO_THREADS = 8;                                    // 异步读盘的工作线程数
 static constexpr int LOG_BUFFER_SIZE = (1024 * PAGE_SIZE);                    // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr size_t LRU_ACCESS_BUFFER_STRIPES = 16;                       // LRUReplacer访问缓冲区的条带数，线程按id分散到各个条带
+static constexpr uint32_t LRU_ACCESS_BUFFER_SIZE = 64;                        // 每个条带缓冲的访问次数，写满时应用到LRU链表
+static constexpr size_t RANGE_DELETE_MIN_ROWS = 32;                           // DELETE删除的记录数不少于该值时尝试按索引范围整段删除
+static constexpr size_t PARALLEL_DML_MIN_ROWS = 65536;                        // UPDATE/DELETE修改的记录数不少于该值时按页面范围分给多个工作线程
+static constexpr int PARALLEL_DML_PARTITION_PAGES = 16;                       // 并行UPDATE/DELETE每个分区至少包含的页面数
+static constexpr size_t PARALLEL_DML_MAX_THREADS = 16;                        // 并行UPDATE/DELETE的最大工作线程数
+static constexpr size_t WORKLOAD_MAX_SHAPES = 4096;                           // 工作负载记录最多记录的扫描形状（表和条件字段的组合）个数
+static constexpr size_t ADVISOR_MAX_INDEXES = 10;                             // ADVISE INDEXES最多推荐的索引个数
+static constexpr double ADVISOR_RANDOM_PAGE_COST = 4.0;                       // 代价模型中随机读一个页面的代价，顺序读一个页面的代价为1
+static constexpr double ADVISOR_CPU_TUPLE_COST = 0.01;                        // 代价模型中处理一条记录的代价
+static constexpr int SEQ_IO_PAGES = 64;                                       // 绕过缓冲池的顺序读写每次读写的页面个数 256KB
+static constexpr size_t EXTERNAL_SORT_MEM_BYTES = (64 << 20);                 // 外部排序在内存中排序的数据量，超过后写出一个有序run 64MB
+static constexpr size_t PARALLEL_SORT_MAX_THREADS = 32;                       // 并行排序的最大工作线程数
+static constexpr size_t PARALLEL_SORT_SAMPLES = 64;                           // 并行归并划分时每个线程对应的样本数
+static constexpr size_t PARALLEL_SORT_MIN_RECS = 65536;                       // ORDER BY的记录数不少于该值时并行排序
+static constexpr int64_t AUTO_ANALYZE_BASE_ROWS = 1000;                       // 草图未反映的删除和更新超过 BASE + SCALE * 记录数 时后台重新ANALYZE
+static constexpr double AUTO_ANALYZE_SCALE = 0.2;
+static constexpr size_t DISTINCT_MEM_BYTES = (64 << 20);                      // DISTINCT哈希表的内存预算，超过后新的键值按哈希划分写入临时文件 64MB
+static constexpr size_t DISTINCT_SPILL_PARTITIONS = 16;                       // DISTINCT溢出时划分的临时文件个数
+static constexpr size_t RESULT_CACHE_MEM_BYTES = (64 << 20);                  // 查询结果缓存的容量，按LRU淘汰 64MB
 
 using frame_id_t = int32_t;  // frame id type, 帧页ID, 页在BufferPool中的存储单元称为帧,一帧对应一页
 using page_id_t = int32_t;   // page id type , 页ID
@@ -52,3 +73,8 @@ static const std::string LOG_FILE_NAME = "db.log";
 static const std::string REPLACER_TYPE = "LRU";
 
 static const std::string DB_META_NAME = "db.meta";
+static const std::string DB_META_VERSION_TAG = "#rmdb_meta";                  // 元数据文件开头的版本头，之后是格式版本号
+static constexpr int DB_META_VERSION = 1;                                     // 元数据文件的格式版本，没有版本头的旧文件按版本0读取
+
+// 表的统计信息，关闭数据库时写出
+static const std::string DB_STATS_NAME = "db.stats";
@@ -15,6 +15,7 @@ See the Mulan PSL v2 for more details. */
 #include "recovery/log_manager.h"
 
 // class TransactionManager;
+struct CachedResult;
 
 // used for data_send
 static int const_offset = -1;
@@ -35,4 +36,5 @@ public:
     char *data_send_;
     int *offset_;
     bool ellipsis_;
+    CachedResult *result_capture_ = nullptr;    // 不为空时select的输出记录同时追加到这里，执行成功后放入结果缓存
 };
\ No newline at end of file
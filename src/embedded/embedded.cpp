@@ -0,0 +1,88 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "embedded.h"
+
+Session::~Session() {
+    Transaction *txn = engine_->txn_manager_->get_transaction(txn_id_);
+    if (txn != nullptr && txn->get_state() != TransactionState::COMMITTED &&
+        txn->get_state() != TransactionState::ABORTED) {
+        engine_->txn_manager_->abort(txn, engine_->log_manager_.get());
+    }
+}
+
+PreparedStatement Session::prepare(const std::string &sql) {
+    auto parse = engine_->parse(sql);
+    if (parse == nullptr) {
+        throw SyntaxError(sql);
+    }
+    return PreparedStatement(std::move(parse), sql);
+}
+
+ResultSet Session::execute(const PreparedStatement &stmt) {
+    ResultSet rs;
+    run(stmt, [&](const RowView &row) { rs.append(row.data()); },
+        [&](const std::vector<ColMeta> &cols) { rs = ResultSet(cols); });
+    rs.message_.assign(send_buf_.data(), send_len_);
+    return rs;
+}
+
+std::vector<ColMeta> Session::execute(const PreparedStatement &stmt, const std::function<void(const RowView &)> &on_row) {
+    std::vector<ColMeta> cols;
+    run(stmt, on_row, [&](const std::vector<ColMeta> &select_cols) { cols = select_cols; });
+    return cols;
+}
+
+/**
+ * @description: 与服务端的client_handler相同的流程：开启或沿用事务 -> 语义分析 -> 优化 -> portal，
+ *               select直接运行流水线，记录交给on_row而不是RecordPrinter；不在显式事务中时执行完自动提交
+ */
+std::vector<ColMeta> Session::run(const PreparedStatement &stmt, const std::function<void(const RowView &)> &on_row,
+                                  const std::function<void(const std::vector<ColMeta> &)> &on_cols) {
+    send_len_ = 0;
+    Context context(engine_->lock_manager_.get(), engine_->log_manager_.get(), nullptr, send_buf_.data(), &send_len_);
+    // 判断当前正在执行的是显式事务还是单条SQL语句的事务
+    context.txn_ = engine_->txn_manager_->get_transaction(txn_id_);
+    if (context.txn_ == nullptr || context.txn_->get_state() == TransactionState::COMMITTED ||
+        context.txn_->get_state() == TransactionState::ABORTED) {
+        context.txn_ = engine_->txn_manager_->begin(nullptr, context.log_mgr_);
+        txn_id_ = context.txn_->get_transaction_id();
+        context.txn_->set_txn_mode(false);
+    }
+
+    std::vector<ColMeta> cols;
+    try {
+        std::shared_ptr<Query> query = engine_->analyze_->do_analyze(stmt.parse_);
+        std::shared_ptr<Plan> plan = engine_->optimizer_->plan_query(query, &context);
+        std::shared_ptr<PortalStmt> portal_stmt = engine_->portal_->start(plan, &context);
+        if (portal_stmt->tag == PORTAL_ONE_SELECT && portal_stmt->pipeline != nullptr) {
+            cols = portal_stmt->pipeline->cols();
+            on_cols(cols);
+            auto sink = [&](const char *rec) { on_row(RowView(rec, &cols)); };
+            portal_stmt->pipeline->run(sink);
+        } else {
+            engine_->portal_->run(portal_stmt, engine_->ql_manager_.get(), &txn_id_, &context);
+        }
+        engine_->portal_->drop();
+    } catch (TransactionAbortException &e) {
+        engine_->txn_manager_->abort(context.txn_, engine_->log_manager_.get());
+        throw;
+    } catch (...) {
+        // 与服务端相同：语句失败不影响所在的事务，单条语句的事务照常提交
+        if (!context.txn_->get_txn_mode()) {
+            engine_->txn_manager_->commit(context.txn_, context.log_mgr_);
+        }
+        throw;
+    }
+    if (!context.txn_->get_txn_mode()) {
+        engine_->txn_manager_->commit(context.txn_, context.log_mgr_);
+    }
+    return cols;
+}
@@ -0,0 +1,176 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "engine.h"
+
+/**
+ * 嵌入式接口：在进程内直接执行SQL，不经过socket，结果不格式化为文本。
+ *   Engine engine; engine.open_db("db");
+ *   Session session(&engine);
+ *   auto stmt = session.prepare("select a, b from t where a > 10;");
+ *   for (auto row : session.execute(stmt)) { row.get_int(0); ... }
+ * 每个线程使用自己的Session，同一个Engine可以被多个Session共享。
+ */
+
+/* 结果中一行的类型化视图，直接读取记录中的字段，只在产生它的ResultSet或回调中有效 */
+class RowView {
+    const char *rec_;
+    const std::vector<ColMeta> *cols_;
+
+   public:
+    RowView(const char *rec, const std::vector<ColMeta> *cols) : rec_(rec), cols_(cols) {}
+
+    size_t size() const { return cols_->size(); }
+
+    const std::string &name(size_t i) const { return cols_->at(i).name; }
+
+    ColType type(size_t i) const { return cols_->at(i).type; }
+
+    int get_int(size_t i) const { return get<int>(i, TYPE_INT); }
+
+    float get_float(size_t i) const { return get<float>(i, TYPE_FLOAT); }
+
+    int64_t get_bigint(size_t i) const { return get<int64_t>(i, TYPE_BIGINT); }
+
+    /* DATETIME按datetime2str的编码存放为int64 */
+    int64_t get_datetime(size_t i) const { return get<int64_t>(i, TYPE_DATETIME); }
+
+    /* CHAR(n)去掉末尾的'\0'填充 */
+    std::string_view get_string(size_t i) const {
+        auto &col = check(i, TYPE_STRING);
+        const char *val = rec_ + col.offset;
+        size_t len = 0;
+        while (len < static_cast<size_t>(col.len) && val[len] != '\0') {
+            len++;
+        }
+        return std::string_view(val, len);
+    }
+
+    /* 记录的原始数据，字段按cols的offset存放 */
+    const char *data() const { return rec_; }
+
+   private:
+    const ColMeta &check(size_t i, ColType type) const {
+        auto &col = cols_->at(i);
+        if (col.type != type) {
+            throw IncompatibleTypeError(coltype2str(col.type), coltype2str(type));
+        }
+        return col;
+    }
+
+    template <typename T>
+    T get(size_t i, ColType type) const {
+        T val;
+        memcpy(&val, rec_ + check(i, type).offset, sizeof(T));
+        return val;
+    }
+};
+
+/* 一条语句的执行结果：select的输出记录保持存储格式连续存放，其他语句只有文本消息（show tables、explain等） */
+class ResultSet {
+    std::vector<ColMeta> cols_;
+    int rec_len_ = 0;
+    std::vector<char> data_;
+    std::string message_;
+
+   public:
+    class Iterator {
+        const ResultSet *rs_;
+        size_t idx_;
+
+       public:
+        Iterator(const ResultSet *rs, size_t idx) : rs_(rs), idx_(idx) {}
+        RowView operator*() const { return rs_->row(idx_); }
+        Iterator &operator++() {
+            idx_++;
+            return *this;
+        }
+        bool operator!=(const Iterator &other) const { return idx_ != other.idx_; }
+    };
+
+    ResultSet() = default;
+
+    ResultSet(std::vector<ColMeta> cols) : cols_(std::move(cols)) {
+        rec_len_ = cols_.empty() ? 0 : cols_.back().offset + cols_.back().len;
+    }
+
+    const std::vector<ColMeta> &cols() const { return cols_; }
+
+    size_t size() const { return rec_len_ == 0 ? 0 : data_.size() / rec_len_; }
+
+    RowView row(size_t i) const { return RowView(data_.data() + i * rec_len_, &cols_); }
+
+    Iterator begin() const { return Iterator(this, 0); }
+
+    Iterator end() const { return Iterator(this, size()); }
+
+    const std::string &message() const { return message_; }
+
+   private:
+    friend class Session;
+
+    void append(const char *rec) { data_.insert(data_.end(), rec, rec + rec_len_); }
+};
+
+/* 预编译的语句：只做一次词法和语法分析，每次执行时重新做语义分析和优化，因此能看到最新的表结构和统计信息 */
+class PreparedStatement {
+    std::shared_ptr<ast::TreeNode> parse_;
+    std::string sql_;
+
+   public:
+    PreparedStatement(std::shared_ptr<ast::TreeNode> parse, std::string sql)
+        : parse_(std::move(parse)), sql_(std::move(sql)) {}
+
+    const std::string &sql() const { return sql_; }
+
+   private:
+    friend class Session;
+};
+
+/**
+ * 一个会话，相当于服务端的一个客户端连接：不在显式事务（begin）中时每条语句自动提交。
+ * 语句失败时抛出RMDBError；事务被中止时回滚后重新抛出TransactionAbortException。
+ */
+class Session {
+    Engine *engine_;
+    txn_id_t txn_id_ = INVALID_TXN_ID;
+    std::vector<char> send_buf_;        // show tables、explain等语句输出的文本
+    int send_len_ = 0;
+
+   public:
+    explicit Session(Engine *engine) : engine_(engine), send_buf_(BUFFER_LENGTH) {}
+
+    /* 回滚未提交的显式事务 */
+    ~Session();
+
+    PreparedStatement prepare(const std::string &sql);
+
+    /* 执行语句，select的结果全部收集到ResultSet中 */
+    ResultSet execute(const PreparedStatement &stmt);
+
+    ResultSet execute(const std::string &sql) { return execute(prepare(sql)); }
+
+    /**
+     * @description: 执行语句，select的每条输出记录直接从流水线交给on_row，不复制
+     * @return {std::vector<ColMeta>} select输出的字段，其他语句为空
+     */
+    std::vector<ColMeta> execute(const PreparedStatement &stmt, const std::function<void(const RowView &)> &on_row);
+
+   private:
+    std::vector<ColMeta> run(const PreparedStatement &stmt, const std::function<void(const RowView &)> &on_row,
+                             const std::function<void(const std::vector<ColMeta> &)> &on_cols);
+};
@@ -0,0 +1,76 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "engine.h"
+
+#include "parser/parser.h"
+
+Engine::Engine() {
+    disk_manager_ = std::make_unique<DiskManager>();
+    buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_.get());
+    rm_manager_ = std::make_unique<RmManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    sm_manager_ = std::make_unique<SmManager>(disk_manager_.get(), buffer_pool_manager_.get(), rm_manager_.get(),
+                                              ix_manager_.get());
+    lock_manager_ = std::make_unique<LockManager>();
+    txn_manager_ = std::make_unique<TransactionManager>(lock_manager_.get(), sm_manager_.get());
+    ql_manager_ = std::make_unique<QlManager>(sm_manager_.get(), txn_manager_.get());
+    log_manager_ = std::make_unique<LogManager>(disk_manager_.get());
+    recovery_ = std::make_unique<RecoveryManager>(disk_manager_.get(), buffer_pool_manager_.get(), sm_manager_.get());
+    planner_ = std::make_unique<Planner>(sm_manager_.get());
+    optimizer_ = std::make_unique<Optimizer>(sm_manager_.get(), planner_.get());
+    portal_ = std::make_unique<Portal>(sm_manager_.get());
+    analyze_ = std::make_unique<Analyze>(sm_manager_.get());
+}
+
+Engine::~Engine() {
+    if (db_open_) {
+        close_db();
+    }
+}
+
+void Engine::open_db(const std::string &db_name) {
+    if (!sm_manager_->is_dir(db_name)) {
+        // Database not found, create a new one
+        sm_manager_->create_db(db_name);
+    }
+    sm_manager_->open_db(db_name);
+    db_open_ = true;
+
+    // recovery database
+    recovery_->analyze();
+    recovery_->redo();
+    recovery_->undo();
+}
+
+void Engine::close_db() {
+    log_manager_->flush_log_to_disk();
+    sm_manager_->close_db();
+    // 缓存项中的表版本只在本次打开的数据库中有意义
+    if (result_cache_ != nullptr) {
+        result_cache_->clear();
+    }
+    db_open_ = false;
+}
+
+std::shared_ptr<ast::TreeNode> Engine::parse(const std::string &sql) {
+    std::lock_guard<std::mutex> lock(parser_latch_);
+    ast::parse_tree = nullptr;
+    YY_BUFFER_STATE buf = yy_scan_string(sql.c_str());
+    int ret = yyparse();
+    yy_delete_buffer(buf);
+    // 语法树由返回值持有，解析下一条语句时不受影响
+    std::shared_ptr<ast::TreeNode> tree = std::move(ast::parse_tree);
+    ast::parse_tree = nullptr;
+    if (ret != 0) {
+        throw SyntaxError(sql);
+    }
+    return tree;
+}
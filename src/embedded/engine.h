@@ -0,0 +1,73 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "analyze/analyze.h"
+#include "execution/execution_manager.h"
+#include "execution/result_cache.h"
+#include "optimizer/optimizer.h"
+#include "optimizer/planner.h"
+#include "portal.h"
+#include "recovery/log_recovery.h"
+
+/**
+ * 数据库引擎：进程内唯一的一组管理器对象，服务端（rmdb.cpp）和嵌入式接口（embedded.h）共用。
+ * 同一进程中只能有一个Engine，它负责打开/关闭数据库和故障恢复，每条语句的事务由调用者管理。
+ */
+class Engine {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<RmManager> rm_manager_;
+    std::unique_ptr<IxManager> ix_manager_;
+    std::unique_ptr<SmManager> sm_manager_;
+    std::unique_ptr<LockManager> lock_manager_;
+    std::unique_ptr<TransactionManager> txn_manager_;
+    std::unique_ptr<QlManager> ql_manager_;
+    std::unique_ptr<LogManager> log_manager_;
+    std::unique_ptr<RecoveryManager> recovery_;
+    std::unique_ptr<Planner> planner_;
+    std::unique_ptr<Optimizer> optimizer_;
+    std::unique_ptr<Portal> portal_;
+    std::unique_ptr<Analyze> analyze_;
+    std::unique_ptr<ResultCache> result_cache_;     // 服务端的查询结果缓存，启动时指定--result-cache才创建
+
+   private:
+    std::mutex parser_latch_;       // flex/bison生成的解析器使用全局状态，同一时间只能解析一条语句
+    bool db_open_ = false;
+
+   public:
+    Engine();
+
+    ~Engine();
+
+    /* 打开数据库，不存在时先创建，打开后根据日志做故障恢复 */
+    void open_db(const std::string &db_name);
+
+    /* 刷新日志并关闭数据库 */
+    void close_db();
+
+    bool is_db_open() const { return db_open_; }
+
+    /**
+     * @description: 把一条SQL语句解析为语法树
+     * @return {std::shared_ptr<ast::TreeNode>} 空语句返回nullptr
+     * @note 语法错误时抛出SyntaxError
+     */
+    std::shared_ptr<ast::TreeNode> parse(const std::string &sql);
+
+    /* 与parse()互斥地使用解析器，服务端在解析和语义分析期间持有 */
+    std::mutex &parser_latch() { return parser_latch_; }
+};
@@ -33,6 +33,11 @@ class InternalError : public RMDBError {
     InternalError(const std::string &msg) : RMDBError(msg) {}
 };
 
+class SyntaxError : public RMDBError {
+   public:
+    SyntaxError(const std::string &sql) : RMDBError("Syntax error: " + sql) {}
+};
+
 // PF errors
 class UnixError : public RMDBError {
    public:
@@ -149,6 +154,11 @@ class IncompatibleTypeError : public RMDBError {
         : RMDBError("Incompatible type error: lhs " + lhs + ", rhs " + rhs) {}
 };
 
+class InvalidDatetimeError : public RMDBError {
+   public:
+    InvalidDatetimeError(const std::string &str) : RMDBError("Invalid datetime: " + str) {}
+};
+
 class AmbiguousColumnError : public RMDBError {
    public:
     AmbiguousColumnError(const std::string &col_name) : RMDBError("Ambiguous column: " + col_name) {}
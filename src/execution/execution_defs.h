@@ -12,3 +12,5 @@ See the Mulan PSL v2 for more details. */
 
 #include "defs.h"
 #include "errors.h"
+
+constexpr size_t ADAPTIVE_JOIN_HASH_THRESHOLD = 256;  // 自适应连接的内表超过该记录数时切换为哈希连接
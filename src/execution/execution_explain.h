@@ -0,0 +1,161 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "executor_abstract.h"
+#include "optimizer/plan.h"
+
+/* EXPLAIN ANALYZE的计数算子：包装一个火山模型算子，统计它被执行的次数（beginTuple）和产生的记录数 */
+class ExplainExecutor : public AbstractExecutor {
+   private:
+    std::unique_ptr<AbstractExecutor> exec_;
+    size_t rows_ = 0;
+    size_t loops_ = 0;
+
+   public:
+    explicit ExplainExecutor(std::unique_ptr<AbstractExecutor> exec) : exec_(std::move(exec)) {}
+
+    size_t tupleLen() const override { return exec_->tupleLen(); }
+
+    const std::vector<ColMeta> &cols() const override { return exec_->cols(); }
+
+    std::string getType() override { return exec_->getType(); }
+
+    void beginTuple() override {
+        loops_++;
+        exec_->beginTuple();
+        if (!exec_->is_end()) rows_++;
+    }
+
+    void nextTuple() override {
+        exec_->nextTuple();
+        if (!exec_->is_end()) rows_++;
+    }
+
+    bool is_end() const override { return exec_->is_end(); }
+
+    Rid &rid() override { return exec_->rid(); }
+
+    std::unique_ptr<RmRecord> Next() override { return exec_->Next(); }
+
+    ColMeta get_col_offset(const TabCol &target) override { return exec_->get_col_offset(target); }
+
+    std::string explain_detail() const override { return exec_->explain_detail(); }
+
+    size_t rows() const { return rows_; }
+
+    size_t loops() const { return loops_; }
+};
+
+/* 计划结点 -> 执行该结点的计数算子；被融合进流水线的结点没有对应的算子 */
+using ExplainStats = std::unordered_map<const Plan *, const ExplainExecutor *>;
+
+inline std::string explain_col(const TabCol &col) { return col.tab_name + "." + col.col_name; }
+
+inline std::string explain_conds(const std::vector<Condition> &conds) {
+    static const char *ops[] = {"=", "<>", "<", ">", "<=", ">=", "LIKE"};
+    std::string str;
+    for (auto &cond : conds) {
+        if (!str.empty()) str += " AND ";
+        str += explain_col(cond.lhs_col) + " " + ops[cond.op] + " ";
+        if (!cond.is_rhs_val) {
+            str += explain_col(cond.rhs_col);
+        } else if (cond.rhs_val.type == TYPE_INT) {
+            str += std::to_string(cond.rhs_val.int_val);
+        } else if (cond.rhs_val.type == TYPE_FLOAT) {
+            str += std::to_string(cond.rhs_val.float_val);
+        } else if (cond.rhs_val.type == TYPE_BIGINT) {
+            str += std::to_string(cond.rhs_val.bigint_val);
+        } else if (cond.rhs_val.type == TYPE_DATETIME) {
+            str += "'" + datetime2str(cond.rhs_val.bigint_val) + "'";
+        } else {
+            str += "'" + cond.rhs_val.str_val + "'";
+        }
+    }
+    return str;
+}
+
+/**
+ * @description: 把计划树展开为EXPLAIN的输出，每个结点一行，子结点缩进
+ * @param {ExplainStats*} stats 为nullptr时只输出计划（EXPLAIN），否则附带实际执行的统计（EXPLAIN ANALYZE）
+ * @param {size_t} pipeline_rows 流水线输出的记录数，用于被融合的结点：
+ *        流水线中的过滤在扫描时完成，排序和投影不改变记录数，所以这些结点输出的记录数都等于流水线的输出
+ */
+inline void explain_plan(const std::shared_ptr<Plan> &plan, int depth, const ExplainStats *stats, size_t pipeline_rows,
+                         std::vector<std::string> &lines) {
+    std::string line = std::string(depth * 2, ' ') + (depth > 0 ? "-> " : "");
+    std::vector<std::shared_ptr<Plan>> children;
+    if (auto x = std::dynamic_pointer_cast<ProjectionPlan>(plan)) {
+        line += "Projection";
+        children.push_back(x->subplan_);
+    } else if (auto x = std::dynamic_pointer_cast<SortPlan>(plan)) {
+        line += "Sort by " + explain_col(x->sel_col_) + (x->is_desc_ ? " DESC" : "");
+        children.push_back(x->subplan_);
+    } else if (auto x = std::dynamic_pointer_cast<LimitPlan>(plan)) {
+        line += "Limit " + std::to_string(x->limit_) + (x->offset_ > 0 ? " offset " + std::to_string(x->offset_) : "");
+        children.push_back(x->subplan_);
+    } else if (auto x = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
+        std::string aggs;
+        for (auto &agg : x->aggs_) aggs += (aggs.empty() ? "" : ", ") + agg.name();
+        if (x->group_by_.empty()) {
+            line += "Aggregate: " + aggs;
+        } else {
+            std::string keys;
+            for (auto &col : x->group_by_) keys += (keys.empty() ? "" : ", ") + explain_col(col);
+            line += "Group Aggregate by " + keys + ": " + aggs + (x->presorted_ ? " (presorted)" : " (sort on group keys)");
+        }
+        children.push_back(x->subplan_);
+    } else if (auto x = std::dynamic_pointer_cast<DistinctPlan>(plan)) {
+        std::string cols;
+        for (auto &col : x->cols_) cols += (cols.empty() ? "" : ", ") + explain_col(col);
+        line += "Distinct on " + cols + (x->presorted_ ? " (presorted)" : " (hash)");
+        children.push_back(x->subplan_);
+    } else if (auto x = std::dynamic_pointer_cast<ScanPlan>(plan)) {
+        line += (x->tag == T_SeqScan ? "Seq Scan on " : x->tag == T_TrigramScan ? "Trigram Index Scan on " : "Index Scan on ") +
+                x->tab_name_;
+        if (x->sample_.enabled()) {
+            char percent[32];
+            snprintf(percent, sizeof(percent), "%g", x->sample_.fraction * 100);
+            line += std::string(x->sample_.method == SAMPLE_SYSTEM ? " tablesample system(" : " tablesample bernoulli(") +
+                    percent + ")";
+        }
+        if (x->tag == T_IndexScan || x->tag == T_TrigramScan) {
+            std::string cols;
+            for (auto &col : x->index_col_names_) cols += (cols.empty() ? "" : ", ") + col;
+            line += " using (" + cols + ")";
+        }
+        if (!x->conds_.empty()) line += " filter: " + explain_conds(x->conds_);
+        if (x->est_rows_ >= 0) line += " est_rows=" + std::to_string(std::llround(x->est_rows_));
+    } else if (auto x = std::dynamic_pointer_cast<JoinPlan>(plan)) {
+        line += "Adaptive Join";
+        if (!x->conds_.empty()) line += " on " + explain_conds(x->conds_);
+        children.push_back(x->left_);
+        children.push_back(x->right_);
+    }
+    if (stats != nullptr) {
+        auto it = stats->find(plan.get());
+        if (it != stats->end()) {
+            line += "  (rows=" + std::to_string(it->second->rows()) + " loops=" + std::to_string(it->second->loops()) + ")";
+            std::string detail = it->second->explain_detail();
+            if (!detail.empty()) line += " " + detail;
+        } else {
+            line += "  (rows=" + std::to_string(pipeline_rows) + " loops=1 pipelined)";
+        }
+    }
+    lines.push_back(line);
+    for (auto &child : children) {
+        explain_plan(child, depth + 1, stats, pipeline_rows, lines);
+    }
+}
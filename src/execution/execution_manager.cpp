@@ -17,22 +17,35 @@ See the Mulan PSL v2 for more details. */
 #include "executor_projection.h"
 #include "executor_seq_scan.h"
 #include "executor_update.h"
+#include "execution_pipeline.h"
 #include "index/ix.h"
 #include "record_printer.h"
+#include "result_cache.h"
+#include "view_maintainer.h"
 
 const char *help_info = "Supported SQL syntax:\n"
                    "  command ;\n"
                    "command:\n"
-                   "  CREATE TABLE table_name (column_name type [, column_name type ...])\n"
+                   "  CREATE TABLE table_name (column_name type [, column_name type ...]) [ORGANIZED BY (column_name)]\n"
                    "  DROP TABLE table_name\n"
-                   "  CREATE INDEX table_name (column_name)\n"
+                   "  TRUNCATE [TABLE] table_name\n"
+                   "  CLUSTER table_name [USING (column_name [, column_name ...])]\n"
+                   "  ANALYZE table_name\n"
+                   "  CREATE INDEX [CONCURRENTLY] table_name (column_name) [WHERE where_clause]\n"
                    "  DROP INDEX table_name (column_name)\n"
+                   "  CREATE TRIGRAM INDEX table_name (column_name)\n"
+                   "  DROP TRIGRAM INDEX table_name (column_name)\n"
+                   "  CREATE MATERIALIZED VIEW view_name AS SELECT ...\n"
+                   "  DROP MATERIALIZED VIEW view_name\n"
                    "  INSERT INTO table_name VALUES (value [, value ...])\n"
                    "  DELETE FROM table_name [WHERE where_clause]\n"
                    "  UPDATE table_name SET column_name = value [, column_name = value ...] [WHERE where_clause]\n"
-                   "  SELECT selector FROM table_name [WHERE where_clause]\n"
+                   "  SELECT selector FROM table_name [TABLESAMPLE {SYSTEM | BERNOULLI} (percent)] [WHERE where_clause]\n"
+                   "    [ORDER BY column [ASC | DESC]] [LIMIT count [OFFSET offset]]\n"
+                   "  EXPLAIN [ANALYZE] SELECT ...\n"
+                   "  ADVISE INDEXES\n"
                    "type:\n"
-                   "  {INT | FLOAT | CHAR(n)}\n"
+                   "  {INT | BIGINT | FLOAT | CHAR(n) | DATETIME}\n"
                    "where_clause:\n"
                    "  condition [AND condition ...]\n"
                    "condition:\n"
@@ -40,9 +53,11 @@ const char *help_info = "Supported SQL syntax:\n"
                    "column:\n"
                    "  [table_name.]column_name\n"
                    "op:\n"
-                   "  {= | <> | < | > | <= | >=}\n"
+                   "  {= | <> | < | > | <= | >= | LIKE}\n"
                    "selector:\n"
-                   "  {* | column [, column ...]}\n";
+                   "  {* | column [, column ...] | aggregate [, aggregate ...]}\n"
+                   "aggregate:\n"
+                   "  {COUNT(*) | APPROX_COUNT_DISTINCT(column)}\n";
 
 // 主要负责执行DDL语句
 void QlManager::run_mutli_query(std::shared_ptr<Plan> plan, Context *context){
@@ -50,7 +65,7 @@ void QlManager::run_mutli_query(std::shared_ptr<Plan> plan, Context *context){
         switch(x->tag) {
             case T_CreateTable:
             {
-                sm_manager_->create_table(x->tab_name_, x->cols_, context);
+                sm_manager_->create_table(x->tab_name_, x->cols_, context, x->tab_col_names_);
                 break;
             }
             case T_DropTable:
@@ -58,9 +73,30 @@ void QlManager::run_mutli_query(std::shared_ptr<Plan> plan, Context *context){
                 sm_manager_->drop_table(x->tab_name_, context);
                 break;
             }
+            case T_TruncateTable:
+            {
+                sm_manager_->truncate_table(x->tab_name_, context);
+                ViewMaintainer::truncate(sm_manager_, x->tab_name_, context);
+                break;
+            }
+            case T_ClusterTable:
+            {
+                sm_manager_->cluster_table(x->tab_name_, x->tab_col_names_, context);
+                break;
+            }
+            case T_AnalyzeTable:
+            {
+                sm_manager_->analyze_table(x->tab_name_, context);
+                break;
+            }
             case T_CreateIndex:
             {
-                sm_manager_->create_index(x->tab_name_, x->tab_col_names_, context);
+                sm_manager_->create_index(x->tab_name_, x->tab_col_names_, context, x->conds_);
+                break;
+            }
+            case T_CreateIndexConcurrently:
+            {
+                sm_manager_->create_index_concurrently(x->tab_name_, x->tab_col_names_, context, x->conds_);
                 break;
             }
             case T_DropIndex:
@@ -68,10 +104,32 @@ void QlManager::run_mutli_query(std::shared_ptr<Plan> plan, Context *context){
                 sm_manager_->drop_index(x->tab_name_, x->tab_col_names_, context);
                 break;
             }
+            case T_CreateTrigramIndex:
+            {
+                sm_manager_->create_trigram_index(x->tab_name_, x->tab_col_names_[0], context);
+                break;
+            }
+            case T_DropTrigramIndex:
+            {
+                sm_manager_->drop_trigram_index(x->tab_name_, x->tab_col_names_[0], context);
+                break;
+            }
+            case T_CreateMaterializedView:
+            {
+                ViewMaintainer::create_view(sm_manager_, x->view_, x->cols_, context);
+                break;
+            }
+            case T_DropMaterializedView:
+            {
+                sm_manager_->drop_view(x->tab_name_, context);
+                break;
+            }
             default:
                 throw InternalError("Unexpected field type");
                 break;  
         }
+        // DDL改变了表的内容、结构或访问路径，结果缓存中引用该表的结果失效
+        sm_manager_->bump_table_version(x->tab_name_);
     }
 }
 
@@ -95,6 +153,11 @@ void QlManager::run_cmd_utility(std::shared_ptr<Plan> plan, txn_id_t *txn_id, Co
                 sm_manager_->desc_table(x->tab_name_, context);
                 break;
             }
+            case T_AdviseIndexes:
+            {
+                advise_indexes(std::dynamic_pointer_cast<AdvisePlan>(plan)->advice_, context);
+                break;
+            }
             case T_Transaction_begin:
             {
                 // 显示开启一个事务
@@ -127,42 +190,55 @@ void QlManager::run_cmd_utility(std::shared_ptr<Plan> plan, txn_id_t *txn_id, Co
     }
 }
 
-// 执行select语句，select语句的输出除了需要返回客户端外，还需要写入output.txt文件中
-void QlManager::select_from(std::unique_ptr<AbstractExecutor> executorTreeRoot, std::vector<TabCol> sel_cols, 
-                            Context *context) {
-    std::vector<std::string> captions;
-    captions.reserve(sel_cols.size());
-    for (auto &sel_col : sel_cols) {
-        captions.push_back(sel_col.col_name);
-    }
+namespace {
 
-    // Print header into buffer
-    RecordPrinter rec_printer(sel_cols.size());
-    rec_printer.print_separator(context);
-    rec_printer.print_record(captions, context);
-    rec_printer.print_separator(context);
-    // print header into file
-    std::fstream outfile;
-    outfile.open("output.txt", std::ios::out | std::ios::app);
-    outfile << "|";
-    for(int i = 0; i < captions.size(); ++i) {
-        outfile << " " << captions[i] << " |";
+/* 把select的结果输出到客户端缓冲区和output.txt */
+class SelectPrinter {
+    RecordPrinter rec_printer_;
+    std::fstream outfile_;
+    Context *context_;
+    size_t num_rec_ = 0;
+
+   public:
+    SelectPrinter(const std::vector<TabCol> &sel_cols, Context *context) : rec_printer_(sel_cols.size()), context_(context) {
+        if (context_->result_capture_ != nullptr) {
+            context_->result_capture_->sel_cols = sel_cols;
+        }
+        std::vector<std::string> captions;
+        captions.reserve(sel_cols.size());
+        for (auto &sel_col : sel_cols) {
+            captions.push_back(sel_col.col_name);
+        }
+
+        // Print header into buffer
+        rec_printer_.print_separator(context_);
+        rec_printer_.print_record(captions, context_);
+        rec_printer_.print_separator(context_);
+        // print header into file
+        outfile_.open("output.txt", std::ios::out | std::ios::app);
+        outfile_ << "|";
+        for(int i = 0; i < captions.size(); ++i) {
+            outfile_ << " " << captions[i] << " |";
+        }
+        outfile_ << "\n";
     }
-    outfile << "\n";
 
-    // Print records
-    size_t num_rec = 0;
-    // 执行query_plan
-    for (executorTreeRoot->beginTuple(); !executorTreeRoot->is_end(); executorTreeRoot->nextTuple()) {
-        auto Tuple = executorTreeRoot->Next();
+    void print(const char *rec, const std::vector<ColMeta> &cols) {
+        if (context_->result_capture_ != nullptr) {
+            capture(rec, cols);
+        }
         std::vector<std::string> columns;
-        for (auto &col : executorTreeRoot->cols()) {
+        for (auto &col : cols) {
             std::string col_str;
-            char *rec_buf = Tuple->data + col.offset;
+            const char *rec_buf = rec + col.offset;
             if (col.type == TYPE_INT) {
                 col_str = std::to_string(*(int *)rec_buf);
             } else if (col.type == TYPE_FLOAT) {
                 col_str = std::to_string(*(float *)rec_buf);
+            } else if (col.type == TYPE_BIGINT) {
+                col_str = std::to_string(*(int64_t *)rec_buf);
+            } else if (col.type == TYPE_DATETIME) {
+                col_str = datetime2str(*(int64_t *)rec_buf);
             } else if (col.type == TYPE_STRING) {
                 col_str = std::string((char *)rec_buf, col.len);
                 col_str.resize(strlen(col_str.c_str()));
@@ -170,20 +246,123 @@ void QlManager::select_from(std::unique_ptr<AbstractExecutor> executorTreeRoot,
             columns.push_back(col_str);
         }
         // print record into buffer
-        rec_printer.print_record(columns, context);
+        rec_printer_.print_record(columns, context_);
         // print record into file
-        outfile << "|";
+        outfile_ << "|";
         for(int i = 0; i < columns.size(); ++i) {
-            outfile << " " << columns[i] << " |";
+            outfile_ << " " << columns[i] << " |";
+        }
+        outfile_ << "\n";
+        num_rec_++;
+    }
+
+    void finish() {
+        outfile_.close();
+        // Print footer into buffer
+        rec_printer_.print_separator(context_);
+        // Print record count into buffer
+        RecordPrinter::print_record_count(num_rec_, context_);
+    }
+
+   private:
+    /* 输出记录同时追加到结果缓存的结果中，超过缓存容量后不再追加 */
+    void capture(const char *rec, const std::vector<ColMeta> &cols) {
+        CachedResult *result = context_->result_capture_;
+        if (result->overflow) {
+            return;
+        }
+        if (result->cols.empty()) {
+            result->cols = cols;
+            result->rec_len = cols.empty() ? 0 : cols.back().offset + cols.back().len;
+        }
+        if (result->rows.size() + result->rec_len > RESULT_CACHE_MEM_BYTES) {
+            result->overflow = true;
+            result->rows.clear();
+            result->rows.shrink_to_fit();
+            return;
+        }
+        result->rows.insert(result->rows.end(), rec, rec + result->rec_len);
+    }
+};
+
+}  // namespace
+
+// 执行select语句，select语句的输出除了需要返回客户端外，还需要写入output.txt文件中
+void QlManager::select_from(std::unique_ptr<AbstractExecutor> executorTreeRoot, std::vector<TabCol> sel_cols, 
+                            Context *context) {
+    SelectPrinter printer(sel_cols, context);
+    // 执行query_plan
+    for (executorTreeRoot->beginTuple(); !executorTreeRoot->is_end(); executorTreeRoot->nextTuple()) {
+        auto Tuple = executorTreeRoot->Next();
+        printer.print(Tuple->data, executorTreeRoot->cols());
+    }
+    printer.finish();
+}
+
+// 结果缓存命中时直接输出缓存的记录，与执行select的输出相同
+void QlManager::select_cached(const CachedResult &result, Context *context) {
+    SelectPrinter printer(result.sel_cols, context);
+    for (size_t i = 0; i < result.num_rows(); i++) {
+        printer.print(result.rows.data() + i * result.rec_len, result.cols);
+    }
+    printer.finish();
+}
+
+// 以推式流水线执行select，输出记录直接从流水线推给printer
+void QlManager::select_from(std::unique_ptr<SelectPipeline> pipeline, std::vector<TabCol> sel_cols, Context *context) {
+    SelectPrinter printer(sel_cols, context);
+    auto &cols = pipeline->cols();
+    auto sink = [&](const char *rec) { printer.print(rec, cols); };
+    pipeline->run(sink);
+    printer.finish();
+}
+
+// 执行explain [analyze]：analyze时先执行流水线并丢弃结果，再输出带有实际记录数的计划树
+void QlManager::explain(std::shared_ptr<ExplainPlan> plan, std::unique_ptr<SelectPipeline> pipeline,
+                        const ExplainStats &stats, Context *context) {
+    size_t num_rec = 0;
+    if (plan->analyze_) {
+        auto sink = [&](const char *) { num_rec++; };
+        pipeline->run(sink);
+    }
+    std::vector<std::string> lines;
+    auto select = std::dynamic_pointer_cast<DMLPlan>(plan->subplan_);
+    explain_plan(select->subplan_, 0, plan->analyze_ ? &stats : nullptr, num_rec, lines);
+
+    std::string str = "QUERY PLAN\n";
+    for (auto &line : lines) {
+        str += line + "\n";
+    }
+    if (*context->offset_ + RECORD_COUNT_LENGTH + str.length() < BUFFER_LENGTH) {
+        memcpy(context->data_send_ + *(context->offset_), str.c_str(), str.length());
+        *(context->offset_) = *(context->offset_) + str.length();
+    } else {
+        context->ellipsis_ = true;
+    }
+}
+
+/**
+ * @description: 输出ADVISE INDEXES推荐的索引
+ * @param {vector<IndexAdvice>&} advice 按估计收益从大到小排列的索引
+ */
+void QlManager::advise_indexes(const std::vector<IndexAdvice> &advice, Context *context) {
+    std::vector<std::string> captions = {"Table", "Index", "Scans", "Scan ms", "Benefit"};
+    RecordPrinter printer(captions.size());
+    printer.print_separator(context);
+    printer.print_record(captions, context);
+    printer.print_separator(context);
+    for (auto &index : advice) {
+        std::string col_names;
+        for (auto &col_name : index.col_names) {
+            col_names += (col_names.empty() ? "" : ",") + col_name;
         }
-        outfile << "\n";
-        num_rec++;
+        char scan_ms[32], benefit[32];
+        snprintf(scan_ms, sizeof(scan_ms), "%.3f", index.scan_ms);
+        snprintf(benefit, sizeof(benefit), "%.1f", index.benefit);
+        printer.print_record({index.tab_name, "(" + col_names + ")", std::to_string(index.scans), scan_ms, benefit},
+                             context);
     }
-    outfile.close();
-    // Print footer into buffer
-    rec_printer.print_separator(context);
-    // Print record count into buffer
-    RecordPrinter::print_record_count(num_rec, context);
+    printer.print_separator(context);
 }
 
 // 执行DML语句
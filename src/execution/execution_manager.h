@@ -23,9 +23,13 @@ See the Mulan PSL v2 for more details. */
 #include "common/common.h"
 #include "optimizer/plan.h"
 #include "executor_abstract.h"
+#include "execution_explain.h"
 #include "transaction/transaction_manager.h"
 
 
+class SelectPipeline;
+struct CachedResult;
+
 class QlManager {
    private:
     SmManager *sm_manager_;
@@ -39,6 +43,14 @@ class QlManager {
     void run_cmd_utility(std::shared_ptr<Plan> plan, txn_id_t *txn_id, Context *context);
     void select_from(std::unique_ptr<AbstractExecutor> executorTreeRoot, std::vector<TabCol> sel_cols,
                         Context *context);
+    void select_from(std::unique_ptr<SelectPipeline> pipeline, std::vector<TabCol> sel_cols, Context *context);
+
+    void select_cached(const CachedResult &result, Context *context);
+
+    void explain(std::shared_ptr<ExplainPlan> plan, std::unique_ptr<SelectPipeline> pipeline, const ExplainStats &stats,
+                 Context *context);
 
     void run_dml(std::unique_ptr<AbstractExecutor> exec);
+
+    void advise_indexes(const std::vector<IndexAdvice> &advice, Context *context);
 };
@@ -0,0 +1,1029 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include <unordered_set>
+
+#include "execution_defs.h"
+#include "executor_abstract.h"
+#include "executor_index_scan.h"
+#include "optimizer/plan.h"
+#include "record/rm.h"
+#include "storage/external_sort.h"
+#include "system/sm.h"
+
+/**
+ * 推式流水线：在物化点（排序）处把select的执行计划切分为若干条流水线，
+ * 每条流水线中的扫描、过滤、投影和sink被融合成一个循环：
+ *   源算子把记录的地址逐条推给下游，记录在算子之间以指针传递，不再为每个算子分配和复制RmRecord；
+ *   每个中间算子提供 template <typename Next> void consume(const char *rec, Next &next)，
+ *   fuse()在编译期把算子串联成一个可调用对象，整条调用链可以被内联，不经过虚函数。
+ * 源算子的run()可以传入一个stop标志，下游（limit）不再需要记录时置位，源算子随即停止扫描。
+ */
+
+/* 把算子和sink串联成一个可调用对象：fuse(op1, op2, sink)(rec) 等价于 op1 -> op2 -> sink */
+template <typename Sink>
+auto fuse(Sink &sink) {
+    return [&sink](const char *rec) { sink(rec); };
+}
+
+template <typename Op, typename... Rest>
+auto fuse(Op &op, Rest &...rest) {
+    return [&op, next = fuse(rest...)](const char *rec) mutable { op.consume(rec, next); };
+}
+
+/* 比较两个字段值，返回负数、0、正数 */
+inline int pipeline_compare(ColType type, const char *lhs, const char *rhs, int len) {
+    switch (type) {
+        case TYPE_INT: {
+            int a = *reinterpret_cast<const int *>(lhs);
+            int b = *reinterpret_cast<const int *>(rhs);
+            return (a < b) ? -1 : ((a > b) ? 1 : 0);
+        }
+        case TYPE_FLOAT: {
+            float a = *reinterpret_cast<const float *>(lhs);
+            float b = *reinterpret_cast<const float *>(rhs);
+            return (a < b) ? -1 : ((a > b) ? 1 : 0);
+        }
+        case TYPE_BIGINT:
+        case TYPE_DATETIME: {
+            int64_t a = *reinterpret_cast<const int64_t *>(lhs);
+            int64_t b = *reinterpret_cast<const int64_t *>(rhs);
+            return (a < b) ? -1 : ((a > b) ? 1 : 0);
+        }
+        case TYPE_STRING:
+            return memcmp(lhs, rhs, len);
+        default:
+            throw InternalError("Unexpected data type");
+    }
+}
+
+/* 过滤：构造时把条件中的字段解析为偏移量，求值时不再按名字查找字段 */
+class PipelineFilter {
+    struct Pred {
+        ColType type;
+        int len;
+        int lhs_offset;
+        int rhs_offset;         // 右侧为字段时的偏移量
+        const char *rhs_val;    // 右侧为常量时指向常量，否则为nullptr
+        CompOp op;
+    };
+
+    std::vector<Condition> conds_;  // 持有条件中的常量
+    std::vector<Pred> preds_;
+
+   public:
+    PipelineFilter(const std::vector<ColMeta> &cols, std::vector<Condition> conds) : conds_(std::move(conds)) {
+        auto find_col = [&](const TabCol &target) {
+            auto pos = std::find_if(cols.begin(), cols.end(), [&](const ColMeta &col) {
+                return col.tab_name == target.tab_name && col.name == target.col_name;
+            });
+            if (pos == cols.end()) {
+                throw ColumnNotFoundError(target.tab_name + '.' + target.col_name);
+            }
+            return pos;
+        };
+        for (auto &cond : conds_) {
+            auto lhs = find_col(cond.lhs_col);
+            Pred pred{lhs->type, lhs->len, lhs->offset, 0, nullptr, cond.op};
+            if (cond.is_rhs_val) {
+                pred.rhs_val = cond.rhs_val.raw->data;
+            } else {
+                pred.rhs_offset = find_col(cond.rhs_col)->offset;
+            }
+            preds_.push_back(pred);
+        }
+    }
+
+    bool eval(const char *rec) const {
+        for (auto &pred : preds_) {
+            const char *rhs = pred.rhs_val != nullptr ? pred.rhs_val : rec + pred.rhs_offset;
+            if (pred.op == OP_LIKE) {
+                if (!like_match(rec + pred.lhs_offset, pred.len, rhs)) return false;
+                continue;
+            }
+            int c = pipeline_compare(pred.type, rec + pred.lhs_offset, rhs, pred.len);
+            bool ok;
+            switch (pred.op) {
+                case OP_EQ: ok = c == 0; break;
+                case OP_NE: ok = c != 0; break;
+                case OP_LT: ok = c < 0; break;
+                case OP_GT: ok = c > 0; break;
+                case OP_LE: ok = c <= 0; break;
+                case OP_GE: ok = c >= 0; break;
+                default: throw InternalError("Unexpected comparison operator");
+            }
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+    template <typename Next>
+    void consume(const char *rec, Next &next) {
+        if (eval(rec)) next(rec);
+    }
+};
+
+/* 投影：把选中的字段复制到一块复用的输出缓冲区中 */
+class PipelineProject {
+    std::vector<ColMeta> cols_;         // 投影后的字段，offset为在输出记录中的偏移
+    std::vector<int> src_offsets_;      // 每个字段在输入记录中的偏移
+    std::vector<char> buf_;
+
+   public:
+    PipelineProject(const std::vector<ColMeta> &src_cols, const std::vector<TabCol> &sel_cols) {
+        int curr_offset = 0;
+        for (auto &sel_col : sel_cols) {
+            auto pos = std::find_if(src_cols.begin(), src_cols.end(), [&](const ColMeta &col) {
+                return col.tab_name == sel_col.tab_name && col.name == sel_col.col_name;
+            });
+            if (pos == src_cols.end()) {
+                throw ColumnNotFoundError(sel_col.tab_name + '.' + sel_col.col_name);
+            }
+            src_offsets_.push_back(pos->offset);
+            auto col = *pos;
+            col.offset = curr_offset;
+            curr_offset += col.len;
+            cols_.push_back(col);
+        }
+        buf_.resize(curr_offset);
+    }
+
+    const std::vector<ColMeta> &cols() const { return cols_; }
+
+    template <typename Next>
+    void consume(const char *rec, Next &next) {
+        for (size_t i = 0; i < cols_.size(); ++i) {
+            memcpy(buf_.data() + cols_[i].offset, rec + src_offsets_[i], cols_[i].len);
+        }
+        next(buf_.data());
+    }
+};
+
+/* 排序（物化点）：作为上游流水线的sink收集记录，排序后作为下游流水线的源，多个排序字段时依次比较 */
+class PipelineSortBuffer {
+    int rec_len_;
+    std::vector<ColMeta> keys_;
+    bool is_desc_;
+    std::vector<char> data_;
+    std::vector<size_t> order_;
+
+   public:
+    PipelineSortBuffer(int rec_len, const ColMeta &key, bool is_desc)
+        : PipelineSortBuffer(rec_len, std::vector<ColMeta>{key}, is_desc) {}
+
+    PipelineSortBuffer(int rec_len, std::vector<ColMeta> keys, bool is_desc)
+        : rec_len_(rec_len), keys_(std::move(keys)), is_desc_(is_desc) {}
+
+    void operator()(const char *rec) { data_.insert(data_.end(), rec, rec + rec_len_); }
+
+    void sort() {
+        order_.resize(data_.size() / rec_len_);
+        std::iota(order_.begin(), order_.end(), 0);
+        auto less = [&](size_t a, size_t b) {
+            for (auto &key : keys_) {
+                int c = pipeline_compare(key.type, data_.data() + a * rec_len_ + key.offset,
+                                         data_.data() + b * rec_len_ + key.offset, key.len);
+                if (c != 0) {
+                    return is_desc_ ? c > 0 : c < 0;
+                }
+            }
+            return false;
+        };
+        // 记录较多时每个线程先排序一段，再逐轮两两归并相邻的段，结果与单线程的稳定排序相同
+        size_t num_chunks = order_.size() < PARALLEL_SORT_MIN_RECS ? 1 : ParallelSorter::threads_for(order_.size());
+        std::vector<size_t> bounds;
+        for (size_t i = 0; i <= num_chunks; i++) {
+            bounds.push_back(i * order_.size() / num_chunks);
+        }
+        auto begin = order_.begin();
+        auto parallel = [](size_t n, const std::function<void(size_t)> &fn) {
+            std::vector<std::thread> threads;
+            for (size_t i = 1; i < n; i++) {
+                threads.emplace_back(fn, i);
+            }
+            fn(0);
+            for (auto &thread : threads) thread.join();
+        };
+        parallel(num_chunks, [&](size_t i) { std::stable_sort(begin + bounds[i], begin + bounds[i + 1], less); });
+        for (size_t width = 1; width < num_chunks; width *= 2) {
+            parallel((num_chunks + 2 * width - 1) / (2 * width), [&](size_t i) {
+                size_t lo = 2 * width * i;
+                size_t mid = std::min(lo + width, num_chunks);
+                size_t hi = std::min(lo + 2 * width, num_chunks);
+                std::inplace_merge(begin + bounds[lo], begin + bounds[mid], begin + bounds[hi], less);
+            });
+        }
+    }
+
+    template <typename Consumer>
+    void run(Consumer &consume, const bool *stop = nullptr) {
+        for (size_t idx : order_) {
+            if (stop != nullptr && *stop) {
+                return;
+            }
+            consume(data_.data() + idx * rec_len_);
+        }
+    }
+};
+
+/* 不分组的聚集（物化点）：作为上游流水线的sink累积每个聚集函数的状态，结束后作为下游流水线的源输出一条记录 */
+class PipelineAggregate {
+    struct State {
+        AggFunc func;
+        int offset;         // 参数字段在输入记录中的偏移
+        int len;
+        HyperLogLog distinct;
+    };
+
+    std::vector<State> states_;
+    int64_t num_rows_ = 0;          // count(*)
+    std::vector<ColMeta> cols_;     // 输出记录的字段，每个聚集函数一个
+    std::vector<char> buf_;
+
+   public:
+    PipelineAggregate(const std::vector<ColMeta> &src_cols, const std::vector<AggExpr> &aggs) {
+        int curr_offset = 0;
+        for (auto &agg : aggs) {
+            if (agg.func == AGG_COUNT_STAR) {
+                states_.push_back(State{agg.func, 0, 0, HyperLogLog()});
+            } else {
+                auto pos = std::find_if(src_cols.begin(), src_cols.end(), [&](const ColMeta &col) {
+                    return col.tab_name == agg.arg.tab_name && col.name == agg.arg.col_name;
+                });
+                if (pos == src_cols.end()) {
+                    throw ColumnNotFoundError(agg.arg.tab_name + '.' + agg.arg.col_name);
+                }
+                states_.push_back(State{agg.func, pos->offset, pos->len, HyperLogLog()});
+            }
+            cols_.push_back(ColMeta{"", agg.name(), TYPE_BIGINT, sizeof(int64_t), curr_offset, false});
+            curr_offset += sizeof(int64_t);
+        }
+        buf_.resize(curr_offset);
+    }
+
+    const std::vector<ColMeta> &cols() const { return cols_; }
+
+    /* 所有聚集函数都是count(*)时可以不扫描记录，由索引直接给出记录数 */
+    bool only_count() const {
+        return std::all_of(states_.begin(), states_.end(), [](const State &state) { return state.func == AGG_COUNT_STAR; });
+    }
+
+    void add_rows(int64_t num_rows) { num_rows_ += num_rows; }
+
+    /* 清空累积的状态，分组聚集开始下一个分组时调用 */
+    void reset() {
+        num_rows_ = 0;
+        for (auto &state : states_) {
+            state.distinct.clear();
+        }
+    }
+
+    void operator()(const char *rec) {
+        num_rows_++;
+        for (auto &state : states_) {
+            if (state.func == AGG_APPROX_COUNT_DISTINCT) {
+                state.distinct.add_hash(ColumnStats::stats_hash(rec + state.offset, state.len));
+            }
+        }
+    }
+
+    template <typename Consumer>
+    void run(Consumer &consume, const bool *stop = nullptr) {
+        if (stop != nullptr && *stop) {
+            return;
+        }
+        for (size_t i = 0; i < states_.size(); ++i) {
+            int64_t val = states_[i].func == AGG_COUNT_STAR ? num_rows_ : std::llround(states_[i].distinct.estimate());
+            memcpy(buf_.data() + cols_[i].offset, &val, sizeof(val));
+        }
+        consume(buf_.data());
+    }
+};
+
+/**
+ * 分组聚集：输入按分组字段有序，同一分组的记录连续到达。分组字段的值变化时立即输出上一个分组，
+ * 只保存当前分组的状态，内存占用与分组数无关；作为流水线的中间算子，下游的limit满足后源算子随即停止扫描。
+ * 输出记录为分组字段加上每个聚集函数的结果，输入结束后调用finish()输出最后一个分组。
+ */
+class PipelineGroupAggregate {
+    std::vector<ColMeta> group_keys_;   // 分组字段在输入记录中的位置
+    PipelineAggregate aggregate_;       // 当前分组的聚集状态
+    bool has_group_ = false;
+    int group_len_ = 0;
+    std::vector<ColMeta> cols_;         // 输出记录的字段，分组字段在前
+    std::vector<char> buf_;             // 当前分组的输出记录
+
+   public:
+    PipelineGroupAggregate(const std::vector<ColMeta> &src_cols, const std::vector<TabCol> &group_by,
+                           const std::vector<AggExpr> &aggs)
+        : aggregate_(src_cols, aggs) {
+        for (auto &group_col : group_by) {
+            auto pos = std::find_if(src_cols.begin(), src_cols.end(), [&](const ColMeta &col) {
+                return col.tab_name == group_col.tab_name && col.name == group_col.col_name;
+            });
+            if (pos == src_cols.end()) {
+                throw ColumnNotFoundError(group_col.tab_name + '.' + group_col.col_name);
+            }
+            group_keys_.push_back(*pos);
+            auto col = *pos;
+            col.offset = group_len_;
+            group_len_ += col.len;
+            cols_.push_back(col);
+        }
+        for (auto col : aggregate_.cols()) {
+            col.offset += group_len_;
+            cols_.push_back(col);
+        }
+        buf_.resize(cols_.back().offset + cols_.back().len);
+    }
+
+    const std::vector<ColMeta> &cols() const { return cols_; }
+
+    const std::vector<ColMeta> &group_keys() const { return group_keys_; }
+
+    template <typename Next>
+    void consume(const char *rec, Next &next) {
+        if (has_group_ && !same_group(rec)) {
+            emit(next);
+        }
+        if (!has_group_) {
+            for (size_t i = 0; i < group_keys_.size(); ++i) {
+                memcpy(buf_.data() + cols_[i].offset, rec + group_keys_[i].offset, group_keys_[i].len);
+            }
+            has_group_ = true;
+        }
+        aggregate_(rec);
+    }
+
+    /* 输入结束，输出最后一个分组；没有输入记录时不输出 */
+    template <typename Next>
+    void finish(Next &next) {
+        if (has_group_) {
+            emit(next);
+        }
+    }
+
+   private:
+    bool same_group(const char *rec) const {
+        for (size_t i = 0; i < group_keys_.size(); ++i) {
+            if (pipeline_compare(group_keys_[i].type, rec + group_keys_[i].offset, buf_.data() + cols_[i].offset,
+                                 group_keys_[i].len) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename Next>
+    void emit(Next &next) {
+        auto copy_aggs = [&](const char *aggs) { memcpy(buf_.data() + group_len_, aggs, buf_.size() - group_len_); };
+        aggregate_.run(copy_aggs);
+        aggregate_.reset();
+        has_group_ = false;
+        next(buf_.data());
+    }
+};
+
+/**
+ * select distinct：输出记录只包含去重字段，每个键值第一次出现时立即输出。
+ * 输入中相等的记录相邻时（presorted）只与上一条记录比较，内存占用为常数；
+ * 否则用哈希表记录输出过的键值，哈希表超过内存预算后不再增长，之后不在哈希表中的键值按哈希划分写入临时文件，
+ * 输入结束后调用finish()逐个分区去重输出，分区仍超过预算时换一个哈希函数再次划分。
+ * 相等按字段的字节比较，浮点数的-0和+0视为相等。
+ */
+class PipelineDistinct {
+    /* 一个溢出分区的临时文件 */
+    struct SpillFile {
+        std::string name;
+        int fd = -1;
+        size_t num_recs = 0;
+        std::vector<char> out;
+    };
+
+    std::vector<ColMeta> keys_;         // 去重字段在输入记录中的位置
+    std::vector<ColMeta> cols_;         // 输出记录的字段
+    size_t key_len_ = 0;
+    bool presorted_;
+    std::vector<char> buf_;             // 当前记录的键值，也是输出记录
+    std::vector<char> last_;            // presorted时上一条输出的键值
+    bool has_last_ = false;
+
+    size_t mem_bytes_;
+    size_t used_bytes_ = 0;
+    std::unordered_set<std::string> seen_;
+    std::vector<SpillFile> spills_;     // 不为空表示哈希表已满
+    std::string spill_prefix_;
+
+   public:
+    PipelineDistinct(const std::vector<ColMeta> &src_cols, const std::vector<TabCol> &cols, bool presorted,
+                     size_t mem_bytes = DISTINCT_MEM_BYTES)
+        : presorted_(presorted), mem_bytes_(mem_bytes) {
+        for (auto &distinct_col : cols) {
+            auto pos = std::find_if(src_cols.begin(), src_cols.end(), [&](const ColMeta &col) {
+                return col.tab_name == distinct_col.tab_name && col.name == distinct_col.col_name;
+            });
+            if (pos == src_cols.end()) {
+                throw ColumnNotFoundError(distinct_col.tab_name + '.' + distinct_col.col_name);
+            }
+            keys_.push_back(*pos);
+            auto col = *pos;
+            col.offset = static_cast<int>(key_len_);
+            key_len_ += col.len;
+            cols_.push_back(col);
+        }
+        buf_.resize(key_len_);
+        static std::atomic<uint64_t> next_id{0};
+        spill_prefix_ = "distinct" + std::to_string(next_id++);
+    }
+
+    ~PipelineDistinct() {
+        for (auto &spill : spills_) {
+            discard(spill);
+        }
+    }
+
+    const std::vector<ColMeta> &cols() const { return cols_; }
+
+    bool presorted() const { return presorted_; }
+
+    template <typename Next>
+    void consume(const char *rec, Next &next) {
+        for (size_t i = 0; i < keys_.size(); ++i) {
+            memcpy(buf_.data() + cols_[i].offset, rec + keys_[i].offset, keys_[i].len);
+            if (keys_[i].type == TYPE_FLOAT && *reinterpret_cast<float *>(buf_.data() + cols_[i].offset) == 0) {
+                *reinterpret_cast<float *>(buf_.data() + cols_[i].offset) = 0;
+            }
+        }
+        if (presorted_) {
+            if (has_last_ && memcmp(last_.data(), buf_.data(), key_len_) == 0) {
+                return;
+            }
+            last_ = buf_;
+            has_last_ = true;
+            next(buf_.data());
+            return;
+        }
+        std::string key(buf_.data(), key_len_);
+        if (seen_.count(key) > 0) {
+            return;
+        }
+        if (spills_.empty() && used_bytes_ < mem_bytes_) {
+            used_bytes_ += key_len_ + sizeof(std::string) + 2 * sizeof(void *);
+            seen_.insert(std::move(key));
+            next(buf_.data());
+            return;
+        }
+        // 哈希表已满，不在哈希表中的键值一定还没有输出过，留到finish()时去重
+        if (spills_.empty()) {
+            spills_ = make_spills(0);
+        }
+        append(spills_[partition_of(key, 0)], buf_.data());
+    }
+
+    /* 输入结束，逐个分区输出溢出的键值 */
+    template <typename Next>
+    void finish(Next &next) {
+        seen_.clear();
+        drain(spills_, 1, next);
+        spills_.clear();
+    }
+
+   private:
+    static uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        return h ^ (h >> 33);
+    }
+
+    /* 第level次划分使用的哈希函数 */
+    size_t partition_of(const std::string &key, size_t level) const {
+        return mix(std::hash<std::string>{}(key) + level * 0x9e3779b97f4a7c15ULL) % DISTINCT_SPILL_PARTITIONS;
+    }
+
+    std::vector<SpillFile> make_spills(size_t level) {
+        std::vector<SpillFile> spills(DISTINCT_SPILL_PARTITIONS);
+        for (size_t i = 0; i < spills.size(); i++) {
+            spills[i].name = spill_prefix_ + ".level" + std::to_string(level) + ".part" + std::to_string(i);
+            spills[i].fd = open(spills[i].name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+            if (spills[i].fd < 0) {
+                for (auto &spill : spills) discard(spill);
+                throw UnixError();
+            }
+        }
+        return spills;
+    }
+
+    void append(SpillFile &spill, const char *key) {
+        spill.out.insert(spill.out.end(), key, key + key_len_);
+        spill.num_recs++;
+        if (spill.out.size() >= PAGE_SIZE * 16) {
+            flush(spill);
+        }
+    }
+
+    void flush(SpillFile &spill) {
+        if (spill.out.empty()) {
+            return;
+        }
+        off_t offset = static_cast<off_t>(spill.num_recs * key_len_ - spill.out.size());
+        if (pwrite(spill.fd, spill.out.data(), spill.out.size(), offset) != static_cast<ssize_t>(spill.out.size())) {
+            throw UnixError();
+        }
+        spill.out.clear();
+    }
+
+    static void discard(SpillFile &spill) {
+        if (spill.fd >= 0) {
+            close(spill.fd);
+            unlink(spill.name.c_str());
+            spill.fd = -1;
+        }
+    }
+
+    /* 每个分区单独用哈希表去重，哈希表再次超过预算时用第level个哈希函数把剩余的键值重新划分 */
+    template <typename Next>
+    void drain(std::vector<SpillFile> &spills, size_t level, Next &next) {
+        size_t batch_recs = std::max<size_t>(SEQ_IO_PAGES * PAGE_SIZE / key_len_, 1);
+        std::vector<char> batch(batch_recs * key_len_);
+        for (auto &spill : spills) {
+            flush(spill);
+            std::unordered_set<std::string> seen;
+            size_t used = 0;
+            std::vector<SpillFile> sub;
+            try {
+                for (size_t pos = 0; pos < spill.num_recs; pos += batch_recs) {
+                    size_t n = std::min(batch_recs, spill.num_recs - pos);
+                    ssize_t bytes = static_cast<ssize_t>(n * key_len_);
+                    if (pread(spill.fd, batch.data(), bytes, static_cast<off_t>(pos * key_len_)) != bytes) {
+                        throw UnixError();
+                    }
+                    for (size_t i = 0; i < n; i++) {
+                        const char *rec = batch.data() + i * key_len_;
+                        std::string key(rec, key_len_);
+                        if (seen.count(key) > 0) {
+                            continue;
+                        }
+                        if (sub.empty() && used < mem_bytes_) {
+                            used += key_len_ + sizeof(std::string) + 2 * sizeof(void *);
+                            seen.insert(std::move(key));
+                            memcpy(buf_.data(), rec, key_len_);
+                            next(buf_.data());
+                            continue;
+                        }
+                        if (sub.empty()) {
+                            sub = make_spills(level);
+                        }
+                        append(sub[partition_of(key, level)], rec);
+                    }
+                }
+                discard(spill);
+                seen.clear();
+                drain(sub, level + 1, next);
+            } catch (...) {
+                for (auto &sub_spill : sub) discard(sub_spill);
+                throw;
+            }
+        }
+    }
+};
+
+/* limit/offset：跳过前offset条记录，输出limit条后置位done，源算子看到后提前结束 */
+class PipelineLimit {
+    size_t limit_;
+    size_t offset_;
+    size_t num_output_ = 0;
+    bool done_;
+
+   public:
+    PipelineLimit(size_t limit, size_t offset) : limit_(limit), offset_(offset), done_(limit == 0) {}
+
+    /* 传给源算子的stop标志 */
+    const bool *done() const { return &done_; }
+
+    /* offset已经下推到源算子时清零 */
+    void clear_offset() { offset_ = 0; }
+
+    template <typename Next>
+    void consume(const char *rec, Next &next) {
+        if (done_) {
+            return;
+        }
+        if (offset_ > 0) {
+            offset_--;
+            return;
+        }
+        next(rec);
+        done_ = ++num_output_ == limit_;
+    }
+};
+
+/* 顺序扫描源：逐页扫描，把页面中记录的地址直接推给下游 */
+class PipelineTableScan {
+    RmFileHandle *fh_;
+    Context *context_;
+    std::vector<ColMeta> cols_;
+    TableSample sample_;
+    WorkloadEntry *workload_;   // 不为空时统计扫描次数和耗时，下游算子与扫描融合执行，耗时中也包括下游算子
+
+   public:
+    PipelineTableScan(SmManager *sm_manager, const std::string &tab_name, Context *context,
+                      TableSample sample = TableSample(), WorkloadEntry *workload = nullptr)
+        : context_(context), sample_(sample), workload_(workload) {
+        fh_ = sm_manager->fhs_.at(tab_name).get();
+        cols_ = sm_manager->db_.get_table(tab_name).cols;
+    }
+
+    const std::vector<ColMeta> &cols() const { return cols_; }
+
+    int tupleLen() const { return cols_.back().offset + cols_.back().len; }
+
+    template <typename Consumer>
+    void run(Consumer &consume, const bool *stop = nullptr) {
+        WorkloadTimer timer(workload_);
+        if (workload_ != nullptr) {
+            workload_->executions++;
+        }
+        bool locking = context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr;
+        int fd = fh_->GetFd();
+        // 与SeqScanExecutor相同：表上加IS锁，扫描到的每条记录加S锁
+        if (locking && !context_->lock_mgr_->lock_IS_on_table(context_->txn_, fd)) {
+            throw std::runtime_error("Failed to acquire IS lock on table");
+        }
+        if (sample_.enabled()) {
+            scan_sampled(locking, consume, stop);
+            return;
+        }
+        // 大表与并发的扫描同步：先扫描[start, num_pages)，再扫描[RM_FIRST_RECORD_PAGE, start)
+        int num_pages = fh_->get_file_hdr().num_pages;
+        bool sync = fh_->use_sync_scan();
+        int start = sync ? fh_->sync_scan_start() : RM_FIRST_RECORD_PAGE;
+        scan_pages(start, num_pages, sync, locking, consume, stop);
+        scan_pages(RM_FIRST_RECORD_PAGE, start, sync, locking, consume, stop);
+    }
+
+   private:
+    /* 扫描[begin, end)：扫描协程在缺页时挂起，调度器等待读取完成后恢复它 */
+    template <typename Consumer>
+    void scan_pages(int begin, int end, bool sync, bool locking, Consumer &consume, const bool *stop) {
+        if (begin >= end) {
+            return;
+        }
+        CoScheduler scheduler;
+        scheduler.spawn(scan_pages_async(begin, end, sync, locking, consume, stop, &scheduler));
+        scheduler.run();
+    }
+
+    /**
+     * 扫描协程：窗口中保持最多RM_SCAN_PREFETCH_PAGES个页面的异步读请求在途，页面直接读入缓冲池的帧，
+     * 按页号顺序把页面中的记录推给下游，下一个页面还没有读入时挂起
+     */
+    template <typename Consumer>
+    CoTask scan_pages_async(int begin, int end, bool sync, bool locking, Consumer &consume, const bool *stop,
+                            CoScheduler *scheduler) {
+        int fd = fh_->GetFd();
+        auto on_record = [&](const Rid &rid, const char *rec) {
+            if (locking && !context_->lock_mgr_->lock_shared_on_record(context_->txn_, rid, fd)) {
+                throw std::runtime_error("Failed to acquire shared lock on record");
+            }
+            consume(rec);
+        };
+        // 协程提前结束时，窗口中没有处理的页面在析构时等待读取完成并unpin
+        std::deque<PageFetch> window;
+        int next = begin;
+        for (int page_no = begin; page_no < end; ++page_no) {
+            if (stop != nullptr && *stop) {
+                co_return;
+            }
+            if (sync && (page_no - begin) % RM_SCAN_PREFETCH_PAGES == 0) {
+                fh_->report_scan_position(page_no);
+            }
+            // 每次请求半个窗口的页面，连续的缺页合并为一个读请求
+            while (next < end && next < page_no + RM_SCAN_PREFETCH_PAGES) {
+                int count = std::min(RM_SCAN_PREFETCH_PAGES / 2, end - next);
+                for (auto &fetch : fh_->fetch_pages_async(next, count, scheduler)) {
+                    window.push_back(std::move(fetch));
+                }
+                next += count;
+            }
+            Page *page = co_await window.front();
+            window.pop_front();
+            if (page == nullptr) {
+                // 缓冲池中没有可用的帧，改为同步读取
+                fh_->scan_page(page_no, on_record);
+            } else {
+                fh_->scan_fetched_page(page, on_record);
+            }
+        }
+    }
+
+    /* tablesample：只读取和预读采样器选中的页面，BERNOULLI在页面中再逐条采样 */
+    template <typename Consumer>
+    void scan_sampled(bool locking, Consumer &consume, const bool *stop) {
+        int fd = fh_->GetFd();
+        RmSampler sampler(sample_.page_fraction(), sample_.row_fraction());
+        std::vector<int> pages = sampler.pages(fh_->get_file_hdr().num_pages);
+        for (size_t i = 0; i < pages.size(); ++i) {
+            if (stop != nullptr && *stop) {
+                return;
+            }
+            if (i % RM_SCAN_PREFETCH_PAGES == 0) {
+                fh_->prefetch_page_list(pages, i, std::min(i + RM_SCAN_PREFETCH_PAGES, pages.size()));
+            }
+            fh_->scan_page(pages[i], [&](const Rid &rid, const char *rec) {
+                if (!sampler.keep_row()) {
+                    return;
+                }
+                if (locking && !context_->lock_mgr_->lock_shared_on_record(context_->txn_, rid, fd)) {
+                    throw std::runtime_error("Failed to acquire shared lock on record");
+                }
+                consume(rec);
+            });
+        }
+    }
+};
+
+/* 算子源：流水线无法融合的子树（索引扫描、连接）仍由火山模型算子执行，结果推给流水线的下游 */
+class PipelineExecutorSource {
+    std::unique_ptr<AbstractExecutor> exec_;
+
+   public:
+    explicit PipelineExecutorSource(std::unique_ptr<AbstractExecutor> exec) : exec_(std::move(exec)) {}
+
+    const std::vector<ColMeta> &cols() const { return exec_->cols(); }
+
+    int tupleLen() const { return static_cast<int>(exec_->tupleLen()); }
+
+    AbstractExecutor *executor() const { return exec_.get(); }
+
+    template <typename Consumer>
+    void run(Consumer &consume, const bool *stop = nullptr) {
+        for (exec_->beginTuple(); !exec_->is_end() && (stop == nullptr || !*stop); exec_->nextTuple()) {
+            auto rec = exec_->Next();
+            if (rec != nullptr) {
+                consume(rec->data);
+            }
+        }
+    }
+};
+
+/**
+ * @description: select语句的流水线：源 -> [过滤] -> [排序 | 聚集 | 分组聚集] -> [去重] -> [limit] -> 投影 -> sink
+ *               有排序时切分为两条流水线：源 -> 过滤 -> 排序缓冲区，排序缓冲区 -> limit -> 投影 -> sink，聚集同理
+ *               源为计数的B+树上的索引扫描时，count(*)和offset直接由子树计数回答
+ */
+class SelectPipeline {
+    std::unique_ptr<PipelineTableScan> table_scan_;
+    std::unique_ptr<PipelineExecutorSource> exec_source_;
+    std::unique_ptr<PipelineFilter> filter_;        // 只有顺序扫描源需要，其他源自己完成过滤
+    std::shared_ptr<SortPlan> sort_;
+    std::unique_ptr<PipelineAggregate> aggregate_;
+    std::unique_ptr<PipelineGroupAggregate> group_aggregate_;
+    bool group_presorted_ = false;                  // 源已按分组字段有序（索引扫描），分组聚集不需要排序
+    std::unique_ptr<PipelineDistinct> distinct_;
+    IndexScanExecutor *index_count_ = nullptr;      // 不为空时count(*)由该索引扫描的范围计数得到，不扫描记录
+    std::unique_ptr<PipelineLimit> limit_;
+    std::unique_ptr<PipelineProject> project_;
+
+   public:
+    /**
+     * @param make_executor 为无法融合的子树生成火山模型算子
+     * @param distinct_mem_bytes 去重哈希表的内存预算
+     */
+    SelectPipeline(SmManager *sm_manager, std::shared_ptr<ProjectionPlan> plan, Context *context,
+                   const std::function<std::unique_ptr<AbstractExecutor>(std::shared_ptr<Plan>)> &make_executor,
+                   size_t distinct_mem_bytes = DISTINCT_MEM_BYTES) {
+        auto child = plan->subplan_;
+        std::shared_ptr<LimitPlan> limit = std::dynamic_pointer_cast<LimitPlan>(child);
+        if (limit != nullptr) {
+            child = limit->subplan_;
+        }
+        std::shared_ptr<AggregatePlan> agg = std::dynamic_pointer_cast<AggregatePlan>(child);
+        if (agg != nullptr) {
+            child = agg->subplan_;
+        }
+        std::shared_ptr<DistinctPlan> distinct = std::dynamic_pointer_cast<DistinctPlan>(child);
+        if (distinct != nullptr) {
+            child = distinct->subplan_;
+        }
+        if (auto x = std::dynamic_pointer_cast<SortPlan>(child)) {
+            sort_ = x;
+            child = x->subplan_;
+        }
+        auto scan = std::dynamic_pointer_cast<ScanPlan>(child);
+        if (scan != nullptr && scan->tag == T_SeqScan) {
+            table_scan_ = std::make_unique<PipelineTableScan>(sm_manager, scan->tab_name_, context, scan->sample_,
+                                                              scan->workload_);
+            filter_ = std::make_unique<PipelineFilter>(table_scan_->cols(), scan->conds_);
+        } else {
+            exec_source_ = std::make_unique<PipelineExecutorSource>(make_executor(child));
+        }
+        // explain analyze中的索引扫描被计数算子包装，dynamic_cast失败，仍然逐条扫描
+        auto index_scan = exec_source_ != nullptr ? dynamic_cast<IndexScanExecutor *>(exec_source_->executor()) : nullptr;
+        if (agg != nullptr && !agg->group_by_.empty()) {
+            group_aggregate_ = std::make_unique<PipelineGroupAggregate>(source_cols(), agg->group_by_, agg->aggs_);
+            group_presorted_ = agg->presorted_;
+        } else if (agg != nullptr) {
+            aggregate_ = std::make_unique<PipelineAggregate>(source_cols(), agg->aggs_);
+            if (index_scan != nullptr && sort_ == nullptr && aggregate_->only_count() && index_scan->is_counted_range()) {
+                index_count_ = index_scan;
+            }
+        }
+        if (distinct != nullptr) {
+            distinct_ = std::make_unique<PipelineDistinct>(source_cols(), distinct->cols_, distinct->presorted_,
+                                                           distinct_mem_bytes);
+        }
+        if (limit != nullptr) {
+            limit_ = std::make_unique<PipelineLimit>(limit->limit_, limit->offset_);
+            if (limit->offset_ > 0 && index_scan != nullptr && sort_ == nullptr && agg == nullptr && distinct == nullptr &&
+                index_scan->push_offset(limit->offset_)) {
+                limit_->clear_offset();
+            }
+        }
+        auto &project_src = group_aggregate_ != nullptr ? group_aggregate_->cols()
+                            : aggregate_ != nullptr     ? aggregate_->cols()
+                            : distinct_ != nullptr      ? distinct_->cols()
+                                                        : source_cols();
+        project_ = std::make_unique<PipelineProject>(project_src, plan->sel_cols_);
+    }
+
+    /* 输出记录的字段 */
+    const std::vector<ColMeta> &cols() const { return project_->cols(); }
+
+    /* 执行流水线，把每条输出记录交给sink(const char *rec) */
+    template <typename Sink>
+    void run(Sink &sink) {
+        if (group_aggregate_ != nullptr) {
+            run_grouped(sink);
+            return;
+        }
+        if (distinct_ != nullptr) {
+            run_distinct(sink);
+            return;
+        }
+        if (aggregate_ != nullptr) {
+            // 聚集只输出一条记录，输入不需要排序
+            if (index_count_ != nullptr) {
+                aggregate_->add_rows(static_cast<int64_t>(index_count_->count()));
+            } else {
+                run_source(nullptr, *aggregate_);
+            }
+            run_output(*aggregate_, sink);
+            return;
+        }
+        if (sort_ == nullptr) {
+            if (limit_ != nullptr) {
+                run_source(limit_->done(), *limit_, *project_, sink);
+            } else {
+                run_source(nullptr, *project_, sink);
+            }
+            return;
+        }
+        PipelineSortBuffer sort_buffer = make_sort_buffer();
+        run_source(nullptr, sort_buffer);
+        sort_buffer.sort();
+        run_output(sort_buffer, sink);
+    }
+
+   private:
+    const std::vector<ColMeta> &source_cols() const {
+        return table_scan_ != nullptr ? table_scan_->cols() : exec_source_->cols();
+    }
+
+    int source_len() const { return table_scan_ != nullptr ? table_scan_->tupleLen() : exec_source_->tupleLen(); }
+
+    PipelineSortBuffer make_sort_buffer() const { return make_sort_buffer(source_cols(), source_len()); }
+
+    /* 按排序字段排序字段为cols、长度为rec_len的记录 */
+    PipelineSortBuffer make_sort_buffer(const std::vector<ColMeta> &cols, int rec_len) const {
+        auto key = std::find_if(cols.begin(), cols.end(), [&](const ColMeta &col) {
+            return col.tab_name == sort_->sel_col_.tab_name && col.name == sort_->sel_col_.col_name;
+        });
+        if (key == cols.end()) {
+            throw ColumnNotFoundError(sort_->sel_col_.tab_name + '.' + sort_->sel_col_.col_name);
+        }
+        return PipelineSortBuffer(rec_len, *key, sort_->is_desc_);
+    }
+
+    template <typename... Ops>
+    void run_source(const bool *stop, Ops &...ops) {
+        if (table_scan_ != nullptr) {
+            auto pipeline = fuse(*filter_, ops...);
+            table_scan_->run(pipeline, stop);
+        } else {
+            auto pipeline = fuse(ops...);
+            exec_source_->run(pipeline, stop);
+        }
+    }
+
+    /**
+     * 分组聚集：源已按分组字段有序时为 源 -> 分组聚集 -> [limit] -> 投影 -> sink 一条流水线，
+     * 否则先按分组字段排序，排序缓冲区 -> 分组聚集 -> [limit] -> 投影 -> sink
+     */
+    template <typename Sink>
+    void run_grouped(Sink &sink) {
+        const bool *stop = limit_ != nullptr ? limit_->done() : nullptr;
+        if (group_presorted_) {
+            if (limit_ != nullptr) {
+                run_source(stop, *group_aggregate_, *limit_, *project_, sink);
+            } else {
+                run_source(stop, *group_aggregate_, *project_, sink);
+            }
+        } else {
+            PipelineSortBuffer sort_buffer(source_len(), group_aggregate_->group_keys(), false);
+            run_source(nullptr, sort_buffer);
+            sort_buffer.sort();
+            if (limit_ != nullptr) {
+                auto pipeline = fuse(*group_aggregate_, *limit_, *project_, sink);
+                sort_buffer.run(pipeline, stop);
+            } else {
+                auto pipeline = fuse(*group_aggregate_, *project_, sink);
+                sort_buffer.run(pipeline, stop);
+            }
+        }
+        if (limit_ != nullptr) {
+            auto pipeline = fuse(*limit_, *project_, sink);
+            group_aggregate_->finish(pipeline);
+        } else {
+            auto pipeline = fuse(*project_, sink);
+            group_aggregate_->finish(pipeline);
+        }
+    }
+
+    /**
+     * 去重：源 -> [过滤] -> 去重 -> [limit] -> 投影 -> sink，新的键值立即输出，limit满足后源随即停止；
+     * 溢出到临时文件的键值在输入结束后输出。有排序时：
+     * 排序结果中重复的记录相邻（presorted）则排序缓冲区作为去重的源，只与上一条比较；
+     * 否则先去重（包括溢出的键值）再排序，源 -> 去重 -> 排序缓冲区 -> [limit] -> 投影 -> sink，排序的只是去重后的键值
+     */
+    template <typename Sink>
+    void run_distinct(Sink &sink) {
+        const bool *stop = limit_ != nullptr ? limit_->done() : nullptr;
+        if (sort_ != nullptr && !distinct_->presorted()) {
+            auto &cols = distinct_->cols();
+            PipelineSortBuffer sort_buffer = make_sort_buffer(cols, cols.back().offset + cols.back().len);
+            run_source(nullptr, *distinct_, sort_buffer);
+            distinct_->finish(sort_buffer);
+            sort_buffer.sort();
+            run_output(sort_buffer, sink);
+            return;
+        }
+        if (sort_ == nullptr) {
+            if (limit_ != nullptr) {
+                run_source(stop, *distinct_, *limit_, *project_, sink);
+            } else {
+                run_source(stop, *distinct_, *project_, sink);
+            }
+        } else {
+            PipelineSortBuffer sort_buffer = make_sort_buffer();
+            run_source(nullptr, sort_buffer);
+            sort_buffer.sort();
+            if (limit_ != nullptr) {
+                auto pipeline = fuse(*distinct_, *limit_, *project_, sink);
+                sort_buffer.run(pipeline, stop);
+            } else {
+                auto pipeline = fuse(*distinct_, *project_, sink);
+                sort_buffer.run(pipeline, stop);
+            }
+        }
+        if (stop != nullptr && *stop) {
+            return;
+        }
+        if (limit_ != nullptr) {
+            auto pipeline = fuse(*limit_, *project_, sink);
+            distinct_->finish(pipeline);
+        } else {
+            auto pipeline = fuse(*project_, sink);
+            distinct_->finish(pipeline);
+        }
+    }
+
+    /* 物化点之后的流水线：物化点 -> [limit] -> 投影 -> sink */
+    template <typename Source, typename Sink>
+    void run_output(Source &source, Sink &sink) {
+        if (limit_ != nullptr) {
+            auto pipeline = fuse(*limit_, *project_, sink);
+            source.run(pipeline, limit_->done());
+        } else {
+            auto pipeline = fuse(*project_, sink);
+            source.run(pipeline);
+        }
+    }
+};
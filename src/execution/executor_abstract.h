@@ -32,6 +32,9 @@ class AbstractExecutor {
 
     virtual std::string getType() { return "AbstractExecutor"; };
 
+    // explain analyze中附加输出的运行时信息
+    virtual std::string explain_detail() const { return ""; }
+
     virtual void beginTuple(){};
 
     virtual void nextTuple(){};
@@ -0,0 +1,231 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+#include <unordered_map>
+
+#include "execution_defs.h"
+#include "execution_manager.h"
+#include "execution_pipeline.h"
+#include "executor_abstract.h"
+#include "index/ix.h"
+#include "system/sm.h"
+
+/**
+ * 自适应连接：不在计划阶段决定连接算法，而是根据运行时观察到的内表（右儿子）记录数选择。
+ * 内表只扫描一次并缓存在内存中：
+ *   缓存的记录数不超过ADAPTIVE_JOIN_HASH_THRESHOLD时按嵌套循环逐条比较，省去建哈希表的开销；
+ *   超过阈值且存在等值连接条件时，对已缓存的记录建哈希表，之后的内表记录直接插入哈希表，
+ *   外表的每条记录只探测一个桶，查询无需重新开始。
+ * 切换发生的位置和观察到的记录数通过explain_detail()在EXPLAIN ANALYZE中输出。
+ */
+class AdaptiveJoinExecutor : public AbstractExecutor {
+   private:
+    std::unique_ptr<AbstractExecutor> left_;    // 左儿子节点（外表）
+    std::unique_ptr<AbstractExecutor> right_;   // 右儿子节点（内表）
+    size_t len_;                                // join后获得的每条记录的长度
+    std::vector<ColMeta> cols_;                 // join后获得的记录的字段
+    std::vector<Condition> fed_conds_;          // join条件
+    std::unique_ptr<PipelineFilter> filter_;    // 在拼接后的记录上求值全部join条件
+
+    bool has_hash_key_;                         // 是否存在可用于哈希的等值条件
+    ColMeta outer_key_;                         // 等值条件在外表记录中的字段
+    ColMeta inner_key_;                         // 等值条件在内表记录中的字段
+
+    std::vector<char> inner_;                   // 缓存的内表记录，每条right_->tupleLen()字节
+    size_t inner_rows_;
+    bool hash_mode_;
+    size_t switch_rows_;                        // 切换为哈希连接时已缓存的内表记录数
+    std::unordered_map<std::string, std::vector<size_t>> hash_table_;   // 连接键 -> 内表记录下标
+
+    std::unique_ptr<RmRecord> outer_rec_;       // 当前外表记录
+    const std::vector<size_t> *bucket_;         // 哈希模式下当前外表记录对应的桶
+    size_t cursor_;                             // 当前外表记录下一个待比较的内表记录（嵌套循环为下标，哈希为桶内位置）
+    std::unique_ptr<RmRecord> joined_;          // 当前输出的连接结果
+    size_t outer_rows_;
+    bool executed_;
+    bool isend;
+
+   public:
+    AdaptiveJoinExecutor(std::unique_ptr<AbstractExecutor> left, std::unique_ptr<AbstractExecutor> right,
+                         std::vector<Condition> conds) {
+        left_ = std::move(left);
+        right_ = std::move(right);
+        len_ = left_->tupleLen() + right_->tupleLen();
+        cols_ = left_->cols();
+        auto right_cols = right_->cols();
+        for (auto &col : right_cols) {
+            col.offset += left_->tupleLen();
+        }
+        cols_.insert(cols_.end(), right_cols.begin(), right_cols.end());
+        fed_conds_ = std::move(conds);
+        filter_ = std::make_unique<PipelineFilter>(cols_, fed_conds_);
+        has_hash_key_ = find_hash_key();
+        inner_rows_ = 0;
+        hash_mode_ = false;
+        switch_rows_ = 0;
+        bucket_ = nullptr;
+        cursor_ = 0;
+        joined_ = std::make_unique<RmRecord>(static_cast<int>(len_));
+        outer_rows_ = 0;
+        executed_ = false;
+        isend = false;
+    }
+
+    size_t tupleLen() const override { return len_; }
+
+    const std::vector<ColMeta> &cols() const override { return cols_; }
+
+    std::string getType() override { return "AdaptiveJoinExecutor"; }
+
+    bool is_end() const override { return isend; }
+
+    ColMeta get_col_offset(const TabCol &target) override { return *get_col(cols_, target); }
+
+    void beginTuple() override {
+        build_inner();
+        outer_rows_ = 0;
+        isend = false;
+        left_->beginTuple();
+        if (inner_rows_ == 0) {
+            isend = true;
+            return;
+        }
+        open_outer();
+        find_match();
+    }
+
+    void nextTuple() override {
+        if (isend) return;
+        find_match();
+    }
+
+    std::unique_ptr<RmRecord> Next() override {
+        if (isend) {
+            return nullptr;
+        }
+        return std::make_unique<RmRecord>(*joined_);
+    }
+
+    Rid &rid() override { return _abstract_rid; }
+
+    std::string explain_detail() const override {
+        if (!executed_) return "";
+        std::string detail = hash_mode_ ? "mode=hash" : "mode=nested loop";
+        if (hash_mode_) {
+            detail += " switched_at=" + std::to_string(switch_rows_);
+        }
+        detail += " inner_rows=" + std::to_string(inner_rows_) + " outer_rows=" + std::to_string(outer_rows_);
+        return detail;
+    }
+
+   private:
+    /* 在join条件中找一个外表字段 = 内表字段的等值条件，两侧类型和长度相同时才能按字节哈希 */
+    bool find_hash_key() {
+        auto find = [](const std::vector<ColMeta> &cols, const TabCol &target) {
+            return std::find_if(cols.begin(), cols.end(), [&](const ColMeta &col) {
+                return col.tab_name == target.tab_name && col.name == target.col_name;
+            });
+        };
+        auto &left_cols = left_->cols();
+        auto &right_cols = right_->cols();
+        for (auto &cond : fed_conds_) {
+            if (cond.is_rhs_val || cond.op != OP_EQ) continue;
+            auto outer = find(left_cols, cond.lhs_col);
+            auto inner = find(right_cols, cond.rhs_col);
+            if (outer == left_cols.end() || inner == right_cols.end()) {
+                outer = find(left_cols, cond.rhs_col);
+                inner = find(right_cols, cond.lhs_col);
+            }
+            if (outer == left_cols.end() || inner == right_cols.end()) continue;
+            if (outer->type != inner->type || outer->len != inner->len) continue;
+            outer_key_ = *outer;
+            inner_key_ = *inner;
+            return true;
+        }
+        return false;
+    }
+
+    /* 连接键的字节串，浮点数把-0.0规范化为0.0，保证相等的值落在同一个桶 */
+    std::string hash_key(const char *rec, const ColMeta &col) const {
+        if (col.type == TYPE_FLOAT && *reinterpret_cast<const float *>(rec + col.offset) == 0) {
+            float zero = 0;
+            return std::string(reinterpret_cast<const char *>(&zero), sizeof(float));
+        }
+        return std::string(rec + col.offset, col.len);
+    }
+
+    const char *inner_rec(size_t idx) const { return inner_.data() + idx * right_->tupleLen(); }
+
+    /* 扫描并缓存内表，缓存的记录数超过阈值时切换为哈希连接 */
+    void build_inner() {
+        size_t inner_len = right_->tupleLen();
+        inner_.clear();
+        hash_table_.clear();
+        inner_rows_ = 0;
+        hash_mode_ = false;
+        switch_rows_ = 0;
+        executed_ = true;
+        for (right_->beginTuple(); !right_->is_end(); right_->nextTuple()) {
+            auto rec = right_->Next();
+            if (rec == nullptr) continue;
+            inner_.insert(inner_.end(), rec->data, rec->data + inner_len);
+            if (hash_mode_) {
+                hash_table_[hash_key(rec->data, inner_key_)].push_back(inner_rows_);
+            }
+            inner_rows_++;
+            if (!hash_mode_ && has_hash_key_ && inner_rows_ > ADAPTIVE_JOIN_HASH_THRESHOLD) {
+                hash_mode_ = true;
+                switch_rows_ = inner_rows_;
+                for (size_t i = 0; i < inner_rows_; i++) {
+                    hash_table_[hash_key(inner_rec(i), inner_key_)].push_back(i);
+                }
+            }
+        }
+    }
+
+    /* 读取当前外表记录，并定位需要比较的内表记录 */
+    void open_outer() {
+        cursor_ = 0;
+        bucket_ = nullptr;
+        if (left_->is_end()) return;
+        outer_rec_ = left_->Next();
+        if (outer_rec_ == nullptr) return;
+        outer_rows_++;
+        memcpy(joined_->data, outer_rec_->data, left_->tupleLen());
+        if (hash_mode_) {
+            auto it = hash_table_.find(hash_key(outer_rec_->data, outer_key_));
+            if (it != hash_table_.end()) {
+                bucket_ = &it->second;
+            }
+        }
+    }
+
+    /* 从当前位置开始找下一对满足连接条件的记录，结果拼接在joined_中 */
+    void find_match() {
+        size_t inner_len = right_->tupleLen();
+        while (!left_->is_end()) {
+            if (outer_rec_ != nullptr) {
+                size_t end = hash_mode_ ? (bucket_ == nullptr ? 0 : bucket_->size()) : inner_rows_;
+                while (cursor_ < end) {
+                    size_t idx = hash_mode_ ? (*bucket_)[cursor_] : cursor_;
+                    cursor_++;
+                    memcpy(joined_->data + left_->tupleLen(), inner_rec(idx), inner_len);
+                    if (filter_->eval(joined_->data)) {
+                        return;
+                    }
+                }
+            }
+            left_->nextTuple();
+            open_outer();
+        }
+        isend = true;
+    }
+};
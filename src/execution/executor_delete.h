@@ -9,11 +9,15 @@ MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
 See the Mulan PSL v2 for more details. */
 
 #pragma once
+#include <algorithm>
+
 #include "execution_defs.h"
 #include "execution_manager.h"
 #include "executor_abstract.h"
 #include "index/ix.h"
+#include "parallel_dml.h"
 #include "system/sm.h"
+#include "view_maintainer.h"
 
 class DeleteExecutor : public AbstractExecutor {
    private:
@@ -44,49 +48,242 @@ class DeleteExecutor : public AbstractExecutor {
                 throw std::runtime_error("Failed to acquire IX lock on table");
             }
         }
-        
-        for (Rid &rid : rids_) {
-            auto rec = fh_->get_record(rid, context_);
-            // record a delete operation into the transaction (must be before deleting index/record)
-            WriteRecord *wr = new WriteRecord(WType::DELETE_TUPLE, tab_name_, rid, *rec);
-            context_->txn_->append_write_record(wr);
-            // Delete index and record index undo log
-            for (size_t i = 0; i < tab_.indexes.size(); ++i) {
-                auto &index = tab_.indexes[i];
-                auto ih =
-                    sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols)).get();
-                char *key = new char[index.col_tot_len];
-                int offset = 0;
-                for (int j = 0; j < index.col_num; ++j) {
-                    memcpy(key + offset, rec->data + index.cols[j].offset, index.cols[j].len);
-                    offset += index.cols[j].len;
+
+        // 与CREATE INDEX CONCURRENTLY注册/切换索引互斥，并重新读取表上当前的索引
+        std::shared_lock<std::shared_mutex> build_lock(sm_manager_->index_build_latch_);
+        tab_ = sm_manager_->db_.get_table(tab_name_);
+        // 依赖该表的物化视图在释放build_lock后再维护，视图表的修改同样要获取该锁
+        bool maintain_views = sm_manager_->db_.has_views_on(tab_name_);
+        std::vector<RmRecord> deleted;
+
+        if ((rids_.size() < RANGE_DELETE_MIN_ROWS || !delete_range(maintain_views, deleted)) &&
+            !delete_parallel(maintain_views, deleted)) {
+            for (Rid &rid : rids_) {
+                auto rec = fh_->get_record(rid, context_);
+                // record a delete operation into the transaction (must be before deleting index/record)
+                WriteRecord *wr = new WriteRecord(WType::DELETE_TUPLE, tab_name_, rid, *rec);
+                context_->txn_->append_write_record(wr);
+                // Delete index and record index undo log
+                for (auto &index : tab_.indexes) {
+                    delete_index_entry(index, rec->data, rid, wr);
                 }
-                
-                // 对于单列INT索引，加排它间隙锁：删除操作会改变键空间
-                if (context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr &&
-                    index.col_num == 1 && index.cols[0].type == TYPE_INT) {
-                    int tab_fd = fh_->GetFd();
-                    int delete_key = *reinterpret_cast<int*>(key);
-                    // 尝试获取排它间隙锁
-                    if (!context_->lock_mgr_->lock_exclusive_on_gap(context_->txn_, tab_fd, delete_key, delete_key)) {
-                        delete[] key;
-                        throw std::runtime_error("Failed to acquire exclusive gap lock for delete");
-                    }
+                // Delete record file
+                fh_->delete_record(rid, context_);
+                sm_manager_->capture_index_build(tab_name_, rec->data, nullptr, rid);
+                sm_manager_->capture_trigram(tab_name_, rec->data, nullptr, rid);
+                sm_manager_->capture_stats(tab_name_, rec->data, nullptr);
+                if (maintain_views) {
+                    deleted.push_back(*rec);
                 }
-                
-                // 删除索引条目
-                ih->delete_entry(key, context_->txn_);
-                
-                // 记录索引删除的 undo log：如果事务 abort，需要恢复这个索引条目
-                wr->AddIndexOp(index.cols, key, index.col_tot_len, rid, IndexOpType::INDEX_DELETE);
-                
-                delete[] key;
-            }
-            // Delete record file
-            fh_->delete_record(rid, context_);
+            }
+        }
+        build_lock.unlock();
+        for (auto &old_rec : deleted) {
+            ViewMaintainer::apply(sm_manager_, tab_name_, old_rec.data, nullptr, context_);
         }
         return nullptr;
     }
 
     Rid &rid() override { return _abstract_rid; }
-};
\ No newline at end of file
+
+   private:
+    /**
+     * @description: 删除一条记录在索引中的条目，并在写记录中记录索引删除的undo
+     */
+    void delete_index_entry(const IndexMeta &index, const char *rec, const Rid &rid, WriteRecord *wr) {
+        if (!index.covers(rec)) {
+            return;
+        }
+        auto ih = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols)).get();
+        std::vector<char> key(index.col_tot_len);
+        int offset = 0;
+        for (int j = 0; j < index.col_num; ++j) {
+            memcpy(key.data() + offset, rec + index.cols[j].offset, index.cols[j].len);
+            offset += index.cols[j].len;
+        }
+
+        // 对于单列INT索引，加排它间隙锁：删除操作会改变键空间
+        if (context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr &&
+            index.col_num == 1 && index.cols[0].type == TYPE_INT) {
+            int tab_fd = fh_->GetFd();
+            int delete_key = *reinterpret_cast<int *>(key.data());
+            // 尝试获取排它间隙锁
+            if (!context_->lock_mgr_->lock_exclusive_on_gap(context_->txn_, tab_fd, delete_key, delete_key)) {
+                throw std::runtime_error("Failed to acquire exclusive gap lock for delete");
+            }
+        }
+
+        // 删除索引条目
+        ih->delete_entry(key.data(), context_->txn_);
+
+        // 记录索引删除的 undo log：如果事务 abort，需要恢复这个索引条目
+        wr->AddIndexOp(index.cols, key.data(), index.col_tot_len, rid, IndexOpType::INDEX_DELETE);
+    }
+
+    /**
+     * @description: 范围删除：要删除的记录恰好是某个全表索引上一段连续的键值对时，用IxIndexHandle::delete_range
+     *               一次删掉这段键值对（每个叶子只做一次结构修改），记录按页面批量删除。
+     *               这个索引不在写记录中记录逐条的索引undo，回滚恢复记录时由TransactionManager补回没有记录undo的索引条目
+     * @return {bool} 没有合适的索引时返回false，由调用者逐条删除
+     */
+    bool delete_range(bool maintain_views, std::vector<RmRecord> &deleted) {
+        bool locking = context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr;
+        std::vector<Rid> sorted = rids_;
+        auto rid_less = [](const Rid &a, const Rid &b) {
+            return a.page_no != b.page_no ? a.page_no < b.page_no : a.slot_no < b.slot_no;
+        };
+        std::sort(sorted.begin(), sorted.end(), rid_less);
+        if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+            return false;
+        }
+
+        std::vector<std::unique_ptr<RmRecord>> recs;
+        recs.reserve(rids_.size());
+        for (auto &rid : rids_) {
+            recs.push_back(fh_->get_record(rid, context_));
+        }
+
+        for (size_t i = 0; i < tab_.indexes.size(); ++i) {
+            auto &index = tab_.indexes[i];
+            // 有并发控制时只用加得了范围间隙锁的单列INT索引，保证检查之后没有其他事务在范围内插入
+            if (index.is_partial() || (locking && (index.col_num != 1 || index.cols[0].type != TYPE_INT))) {
+                continue;
+            }
+            auto ih = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols)).get();
+            auto make_key = [&](const char *rec) {
+                std::vector<char> key(index.col_tot_len);
+                int offset = 0;
+                for (auto &col : index.cols) {
+                    memcpy(key.data() + offset, rec + col.offset, col.len);
+                    offset += col.len;
+                }
+                return key;
+            };
+            std::vector<ColType> col_types;
+            std::vector<int> col_lens;
+            for (auto &col : index.cols) {
+                col_types.push_back(col.type);
+                col_lens.push_back(col.len);
+            }
+            auto key_less = [&](const std::vector<char> &a, const std::vector<char> &b) {
+                return ix_compare(a.data(), b.data(), col_types, col_lens) < 0;
+            };
+            std::vector<char> lower = make_key(recs[0]->data);
+            std::vector<char> upper = lower;
+            for (auto &rec : recs) {
+                auto key = make_key(rec->data);
+                if (key_less(key, lower)) lower = key;
+                if (key_less(upper, key)) upper = key;
+            }
+
+            if (locking) {
+                if (!context_->lock_mgr_->lock_exclusive_on_gap(context_->txn_, fh_->GetFd(),
+                                                                *reinterpret_cast<int *>(lower.data()),
+                                                                *reinterpret_cast<int *>(upper.data()))) {
+                    throw std::runtime_error("Failed to acquire exclusive gap lock for delete");
+                }
+            }
+            // 范围内的键值对必须恰好是要删除的记录
+            size_t in_range = 0;
+            bool exact = true;
+            IxScan scan(ih, ih->lower_bound(lower.data()), ih->upper_bound(upper.data()), sm_manager_->get_bpm());
+            for (; !scan.is_end() && exact; scan.next()) {
+                exact = ++in_range <= sorted.size() &&
+                        std::binary_search(sorted.begin(), sorted.end(), scan.rid(), rid_less);
+            }
+            if (!exact || in_range != sorted.size()) {
+                continue;
+            }
+
+            for (size_t r = 0; r < rids_.size(); ++r) {
+                WriteRecord *wr = new WriteRecord(WType::DELETE_TUPLE, tab_name_, rids_[r], *recs[r]);
+                context_->txn_->append_write_record(wr);
+                for (size_t j = 0; j < tab_.indexes.size(); ++j) {
+                    if (j != i) {
+                        delete_index_entry(tab_.indexes[j], recs[r]->data, rids_[r], wr);
+                    }
+                }
+            }
+            int removed = ih->delete_range(lower.data(), upper.data(), context_->txn_);
+            if (removed != static_cast<int>(rids_.size())) {
+                throw InternalError("DeleteExecutor::delete_range: removed " + std::to_string(removed) +
+                                    " index entries, expected " + std::to_string(rids_.size()));
+            }
+            fh_->delete_records(rids_, context_);
+            for (size_t r = 0; r < rids_.size(); ++r) {
+                sm_manager_->capture_index_build(tab_name_, recs[r]->data, nullptr, rids_[r]);
+                sm_manager_->capture_trigram(tab_name_, recs[r]->data, nullptr, rids_[r]);
+                sm_manager_->capture_stats(tab_name_, recs[r]->data, nullptr);
+                if (maintain_views) {
+                    deleted.push_back(*recs[r]);
+                }
+            }
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @description: 并行删除：记录按页面范围分给多个工作线程，共用当前事务。每个线程给分区中的记录加锁，把写记录整批加入事务，
+     *               在每个索引上按键值顺序删除索引条目，再按页面批量删除记录。记录文件的空闲页面链表由所有线程共用，批量删除记录时互斥
+     * @return {bool} 记录数或可用线程数不够时返回false，由调用者逐条删除
+     */
+    bool delete_parallel(bool maintain_views, std::vector<RmRecord> &deleted) {
+        if (rids_.size() < PARALLEL_DML_MIN_ROWS) {
+            return false;
+        }
+        ParallelDml dml(rids_);
+        if (dml.num_threads() < 2) {
+            return false;
+        }
+        bool locking = context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr;
+        int tab_fd = fh_->GetFd();
+        const std::vector<Rid> &rids = dml.rids();
+        std::mutex heap_latch;
+        std::vector<std::vector<RmRecord>> part_deleted(dml.num_partitions());
+
+        dml.run([&](size_t p, const ParallelDml::Partition &part) {
+            std::vector<std::unique_ptr<RmRecord>> recs;
+            for (size_t r = part.begin; r < part.end; r++) {
+                if (locking && !context_->lock_mgr_->lock_exclusive_on_record(context_->txn_, rids[r], tab_fd)) {
+                    throw std::runtime_error("Failed to acquire exclusive lock on record");
+                }
+                recs.push_back(fh_->get_record(rids[r], context_));
+            }
+            std::vector<WriteRecord *> wrs;
+            for (size_t i = 0; i < recs.size(); i++) {
+                wrs.push_back(new WriteRecord(WType::DELETE_TUPLE, tab_name_, rids[part.begin + i], *recs[i]));
+            }
+            context_->txn_->append_write_records(wrs);
+
+            for (auto &index : tab_.indexes) {
+                IndexOpBatch batch(index);
+                for (size_t i = 0; i < recs.size(); i++) {
+                    if (index.covers(recs[i]->data)) {
+                        batch.add(recs[i]->data, rids[part.begin + i], wrs[i]);
+                    }
+                }
+                auto ih = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols)).get();
+                batch.apply(ih, IndexOpType::INDEX_DELETE, context_, tab_fd);
+            }
+            {
+                std::scoped_lock lock{heap_latch};
+                fh_->delete_records(std::vector<Rid>(rids.begin() + part.begin, rids.begin() + part.end), context_);
+            }
+            for (size_t i = 0; i < recs.size(); i++) {
+                const Rid &rid = rids[part.begin + i];
+                sm_manager_->capture_index_build(tab_name_, recs[i]->data, nullptr, rid);
+                sm_manager_->capture_trigram(tab_name_, recs[i]->data, nullptr, rid);
+                sm_manager_->capture_stats(tab_name_, recs[i]->data, nullptr);
+                if (maintain_views) {
+                    part_deleted[p].push_back(*recs[i]);
+                }
+            }
+        });
+
+        for (auto &recs : part_deleted) {
+            deleted.insert(deleted.end(), recs.begin(), recs.end());
+        }
+        return true;
+    }
+};
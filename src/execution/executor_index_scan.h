@@ -10,6 +10,7 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <algorithm>
 #include <climits>
 #include "execution_defs.h"
 #include "execution_manager.h"
@@ -32,14 +33,17 @@ class IndexScanExecutor : public AbstractExecutor {
 
     Rid rid_;
     std::unique_ptr<RecScan> scan_;
+    size_t offset_ = 0;                         // 下推到索引的offset，beginTuple时跳过范围中的前offset_个键值对
+    WorkloadEntry *workload_;                   // 按索引顺序的全表扫描在工作负载记录中的项，不为空时统计扫描次数和耗时
 
     SmManager *sm_manager_;
 
    public:
     IndexScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds, std::vector<std::string> index_col_names,
-                    Context *context) {
+                    Context *context, WorkloadEntry *workload = nullptr) {
         sm_manager_ = sm_manager;
         context_ = context;
+        workload_ = workload;
         tab_name_ = std::move(tab_name);
         tab_ = sm_manager_->db_.get_table(tab_name_);
         conds_ = std::move(conds);
@@ -74,120 +78,25 @@ class IndexScanExecutor : public AbstractExecutor {
     ColMeta get_col_offset(const TabCol &target) override { return *get_col(cols_, target); }
 
     void beginTuple() override {
-        // 申请IS意向锁（表级）
-        if (context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr) {
-            int tab_fd = fh_->GetFd();
-            if (!context_->lock_mgr_->lock_IS_on_table(context_->txn_, tab_fd)) {
-                throw std::runtime_error("Failed to acquire IS lock on table");
-            }
+        WorkloadTimer timer(workload_);
+        if (workload_ != nullptr) {
+            workload_->executions++;
         }
+        // 申请IS意向锁（表级）
+        lock_IS_on_table();
         
         // 使用索引进行扫描，并在键空间上加“间隙共享锁”，防止幻读
         // 如果有WHERE条件匹配索引列，使用等值或范围扫描
         // 如果没有WHERE条件，使用索引进行全表扫描（保证输出顺序一致）
         if (!index_col_names_.empty()) {
-            auto ih = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index_col_names_)).get();
-            
-            // 初始化扫描范围为全表
-            Iid lower = ih->leaf_begin();
-            Iid upper = ih->leaf_end();
-            
-            // 计算间隙锁的范围（left_key, right_key）
-            int left_key = INT_MIN;
-            int right_key = INT_MAX;
-            bool has_range = false;
-            
-            // 检查第一个索引列是否有范围条件（支持单列索引的范围查询，如 id > 2 and id < 4）
-            if (index_meta_.cols.size() == 1 && index_meta_.cols[0].type == TYPE_INT) {
-                const std::string& first_col_name = index_meta_.cols[0].name;
-                char* range_key = new char[index_meta_.cols[0].len];
-                
-                for (auto &cond : conds_) {
-                    if (cond.is_rhs_val && cond.lhs_col.tab_name == tab_name_ && 
-                        cond.lhs_col.col_name == first_col_name) {
-                        memcpy(range_key, cond.rhs_val.raw->data, index_meta_.cols[0].len);
-                        int key_val = *reinterpret_cast<int*>(range_key);
-                        
-                        if (cond.op == OP_EQ) {
-                            // 等值查询：锁住 [key, key] 区间
-                            left_key = key_val;
-                            right_key = key_val;
-                            has_range = true;
-                            lower = ih->lower_bound(range_key);
-                            upper = ih->upper_bound(range_key);
-                            break;
-                        } else if (cond.op == OP_GT) {
-                            // id > key: 从第一个 > key 的位置开始
-                            left_key = key_val + 1;  // 不包含key本身
-                            has_range = true;
-                            lower = ih->upper_bound(range_key);
-                        } else if (cond.op == OP_GE) {
-                            // id >= key: 从第一个 >= key 的位置开始
-                            left_key = key_val;  // 包含key本身
-                            has_range = true;
-                            lower = ih->lower_bound(range_key);
-                        } else if (cond.op == OP_LT) {
-                            // id < key: 到第一个 >= key 的位置结束（不包含）
-                            right_key = key_val - 1;  // 不包含key本身
-                            has_range = true;
-                            upper = ih->lower_bound(range_key);
-                        } else if (cond.op == OP_LE) {
-                            // id <= key: 到第一个 > key 的位置结束（不包含）
-                            right_key = key_val;  // 包含key本身
-                            has_range = true;
-                            upper = ih->upper_bound(range_key);
-                        }
-                    }
-                }
-                delete[] range_key;
-            } else {
-                // 多列索引：检查是否有等值条件匹配所有索引列
-                bool has_eq_cond = true;
-                std::vector<char> key(index_meta_.col_tot_len, 0);
-                int off = 0;
-                for (auto &col : index_meta_.cols) {
-                    bool found = false;
-                    for (auto &cond : conds_) {
-                        if (cond.is_rhs_val && cond.op == OP_EQ &&
-                            cond.lhs_col.tab_name == tab_name_ && cond.lhs_col.col_name == col.name) {
-                            memcpy(key.data() + off, cond.rhs_val.raw->data, col.len);
-                            off += col.len;
-                            found = true;
-                            break;
-                        }
-                    }
-                    if (!found) {
-                        has_eq_cond = false;
-                        break;
-                    }
-                }
-                
-                if (has_eq_cond && off == index_meta_.col_tot_len) {
-                    // 有等值条件，使用等值扫描
-                    // 对于多列索引，暂时锁住整个表范围（简化处理）
-                    has_range = true;
-                    lower = ih->lower_bound(key.data());
-                    upper = ih->upper_bound(key.data());
-                }
-                // 否则使用全表扫描（lower和upper已经是leaf_begin和leaf_end）
+            auto ih = get_index_handle();
+            Iid lower, upper;
+            lock_index_range(ih, lower, upper);
+            if (offset_ > 0) {
+                // offset下推：按子树计数直接定位到范围中的第offset_个键值对
+                size_t begin = ih->rank(lower) + offset_;
+                lower = begin < ih->rank(upper) ? ih->iid_at(begin) : upper;
             }
-            
-            // 加间隙共享锁：锁住查询范围内的间隙，防止其他事务在该范围内插入/删除
-            if (context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr) {
-                int tab_fd = fh_->GetFd();
-                if (has_range) {
-                    // 有明确的查询范围，锁住该范围
-                    if (!context_->lock_mgr_->lock_shared_on_gap(context_->txn_, tab_fd, left_key, right_key)) {
-                        throw std::runtime_error("Failed to acquire shared gap lock");
-                    }
-                } else {
-                    // 全表扫描，锁住整个键空间
-                    if (!context_->lock_mgr_->lock_shared_on_gap(context_->txn_, tab_fd, INT_MIN, INT_MAX)) {
-                        throw std::runtime_error("Failed to acquire shared gap lock");
-                    }
-                }
-            }
-            
             scan_ = std::make_unique<IxScan>(ih, lower, upper, sm_manager_->get_bpm());
         } else {
             // 没有索引，退化为顺序扫描（使用表级S锁防止幻读）
@@ -213,6 +122,12 @@ class IndexScanExecutor : public AbstractExecutor {
                     float b = *reinterpret_cast<const float *>(rhs);
                     return (a < b) ? -1 : ((a > b) ? 1 : 0);
                 }
+                case TYPE_BIGINT:
+                case TYPE_DATETIME: {
+                    int64_t a = *reinterpret_cast<const int64_t *>(lhs);
+                    int64_t b = *reinterpret_cast<const int64_t *>(rhs);
+                    return (a < b) ? -1 : ((a > b) ? 1 : 0);
+                }
                 case TYPE_STRING:
                     return memcmp(lhs, rhs, len);
                 default:
@@ -231,6 +146,7 @@ class IndexScanExecutor : public AbstractExecutor {
                 auto rhs_it = get_col(cols_, cond.rhs_col);
                 rhs_ptr = rec.data + rhs_it->offset;
             }
+            if (cond.op == OP_LIKE) return like_match(lhs_ptr, lhs.len, rhs_ptr);
             int c = cmp(lhs.type, lhs_ptr, rhs_ptr, lhs.len);
             switch (cond.op) {
                 case OP_EQ: return c == 0;
@@ -264,6 +180,7 @@ class IndexScanExecutor : public AbstractExecutor {
         if (scan_ == nullptr || scan_->is_end()) {
             return;
         }
+        WorkloadTimer timer(workload_);
         scan_->next();
 
         auto cmp = [](ColType type, const char *lhs, const char *rhs, int len) -> int {
@@ -278,6 +195,12 @@ class IndexScanExecutor : public AbstractExecutor {
                     float b = *reinterpret_cast<const float *>(rhs);
                     return (a < b) ? -1 : ((a > b) ? 1 : 0);
                 }
+                case TYPE_BIGINT:
+                case TYPE_DATETIME: {
+                    int64_t a = *reinterpret_cast<const int64_t *>(lhs);
+                    int64_t b = *reinterpret_cast<const int64_t *>(rhs);
+                    return (a < b) ? -1 : ((a > b) ? 1 : 0);
+                }
                 case TYPE_STRING:
                     return memcmp(lhs, rhs, len);
                 default:
@@ -296,6 +219,7 @@ class IndexScanExecutor : public AbstractExecutor {
                 auto rhs_it = get_col(cols_, cond.rhs_col);
                 rhs_ptr = rec.data + rhs_it->offset;
             }
+            if (cond.op == OP_LIKE) return like_match(lhs_ptr, lhs.len, rhs_ptr);
             int c = cmp(lhs.type, lhs_ptr, rhs_ptr, lhs.len);
             switch (cond.op) {
                 case OP_EQ: return c == 0;
@@ -333,4 +257,197 @@ class IndexScanExecutor : public AbstractExecutor {
     }
 
     Rid &rid() override { return rid_; }
-};
\ No newline at end of file
+
+    /**
+     * @description: 只用索引回答count(*)：范围内的键值对个数由计数的B+树的子树计数得到，不读取叶子和记录
+     * @note 调用前需要确认is_counted_range()
+     */
+    size_t count() {
+        lock_IS_on_table();
+        auto ih = get_index_handle();
+        Iid lower, upper;
+        lock_index_range(ih, lower, upper);
+        return ih->count_range(lower, upper);
+    }
+
+    /**
+     * @description: 尝试把offset下推到索引扫描，beginTuple时直接跳到范围中的第n个键值对
+     * @return {bool} 只有扫描范围与条件完全一致且索引是计数的B+树时才能下推
+     */
+    bool push_offset(size_t n) {
+        if (!is_counted_range()) {
+            return false;
+        }
+        offset_ = n;
+        return true;
+    }
+
+    /* 扫描范围与条件完全一致，且可以由计数的B+树直接计数和定位 */
+    bool is_counted_range() const { return range_is_exact() && get_index_handle()->is_counted(); }
+
+    /**
+     * @description: 索引扫描的范围是否恰好是满足所有条件的记录，即不需要再逐条过滤
+     *               单列索引：一个等值条件，或者至多一个下界和一个上界；多列索引：每个索引列恰有一个等值条件
+     */
+    bool range_is_exact() const {
+        if (index_col_names_.empty()) {
+            return false;
+        }
+        for (auto &cond : conds_) {
+            if (!cond.is_rhs_val || cond.lhs_col.tab_name != tab_name_ || cond.op == OP_NE || cond.op == OP_LIKE) {
+                return false;
+            }
+        }
+        if (index_meta_.cols.size() == 1) {
+            int num_eq = 0, num_lower = 0, num_upper = 0;
+            for (auto &cond : conds_) {
+                if (cond.lhs_col.col_name != index_meta_.cols[0].name) {
+                    return false;
+                }
+                num_eq += cond.op == OP_EQ;
+                num_lower += cond.op == OP_GT || cond.op == OP_GE;
+                num_upper += cond.op == OP_LT || cond.op == OP_LE;
+            }
+            return num_eq > 0 ? conds_.size() == 1 : num_lower <= 1 && num_upper <= 1;
+        }
+        if (conds_.empty()) {
+            return true;
+        }
+        if (conds_.size() != index_meta_.cols.size()) {
+            return false;
+        }
+        for (auto &col : index_meta_.cols) {
+            if (std::count_if(conds_.begin(), conds_.end(), [&](const Condition &cond) {
+                    return cond.op == OP_EQ && cond.lhs_col.col_name == col.name;
+                }) != 1) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+   private:
+    IxIndexHandle *get_index_handle() const {
+        return sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index_col_names_)).get();
+    }
+
+    void lock_IS_on_table() {
+        if (context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr) {
+            int tab_fd = fh_->GetFd();
+            if (!context_->lock_mgr_->lock_IS_on_table(context_->txn_, tab_fd)) {
+                throw std::runtime_error("Failed to acquire IS lock on table");
+            }
+        }
+    }
+
+    /**
+     * @description: 根据条件计算索引扫描的范围[lower, upper)，并在该范围上加间隙共享锁
+     */
+    void lock_index_range(IxIndexHandle *ih, Iid &lower, Iid &upper) {
+        // 初始化扫描范围为全表
+        lower = ih->leaf_begin();
+        upper = ih->leaf_end();
+        
+        // 计算间隙锁的范围（left_key, right_key）
+        int left_key = INT_MIN;
+        int right_key = INT_MAX;
+        bool has_range = false;
+        
+        // 检查第一个索引列是否有范围条件（支持单列索引的范围查询，如 id > 2 and id < 4、name >= 'abc' and name < 'abd'）
+        // 间隙锁只能锁INT键，其他类型的索引在下面锁住整个键空间
+        if (index_meta_.cols.size() == 1) {
+            const std::string& first_col_name = index_meta_.cols[0].name;
+            bool int_key = index_meta_.cols[0].type == TYPE_INT;
+            char* range_key = new char[index_meta_.cols[0].len];
+            
+            for (auto &cond : conds_) {
+                if (cond.is_rhs_val && cond.lhs_col.tab_name == tab_name_ && 
+                    cond.lhs_col.col_name == first_col_name && cond.op != OP_LIKE) {
+                    memcpy(range_key, cond.rhs_val.raw->data, index_meta_.cols[0].len);
+                    int key_val = int_key ? *reinterpret_cast<int*>(range_key) : 0;
+                    
+                    if (cond.op == OP_EQ) {
+                        // 等值查询：锁住 [key, key] 区间
+                        left_key = key_val;
+                        right_key = key_val;
+                        has_range = true;
+                        lower = ih->lower_bound(range_key);
+                        upper = ih->upper_bound(range_key);
+                        break;
+                    } else if (cond.op == OP_GT) {
+                        // id > key: 从第一个 > key 的位置开始
+                        left_key = key_val + 1;  // 不包含key本身
+                        has_range = true;
+                        lower = ih->upper_bound(range_key);
+                    } else if (cond.op == OP_GE) {
+                        // id >= key: 从第一个 >= key 的位置开始
+                        left_key = key_val;  // 包含key本身
+                        has_range = true;
+                        lower = ih->lower_bound(range_key);
+                    } else if (cond.op == OP_LT) {
+                        // id < key: 到第一个 >= key 的位置结束（不包含）
+                        right_key = key_val - 1;  // 不包含key本身
+                        has_range = true;
+                        upper = ih->lower_bound(range_key);
+                    } else if (cond.op == OP_LE) {
+                        // id <= key: 到第一个 > key 的位置结束（不包含）
+                        right_key = key_val;  // 包含key本身
+                        has_range = true;
+                        upper = ih->upper_bound(range_key);
+                    }
+                }
+            }
+            delete[] range_key;
+            if (!int_key) {
+                left_key = INT_MIN;
+                right_key = INT_MAX;
+            }
+        } else {
+            // 多列索引：检查是否有等值条件匹配所有索引列
+            bool has_eq_cond = true;
+            std::vector<char> key(index_meta_.col_tot_len, 0);
+            int off = 0;
+            for (auto &col : index_meta_.cols) {
+                bool found = false;
+                for (auto &cond : conds_) {
+                    if (cond.is_rhs_val && cond.op == OP_EQ &&
+                        cond.lhs_col.tab_name == tab_name_ && cond.lhs_col.col_name == col.name) {
+                        memcpy(key.data() + off, cond.rhs_val.raw->data, col.len);
+                        off += col.len;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) {
+                    has_eq_cond = false;
+                    break;
+                }
+            }
+            
+            if (has_eq_cond && off == index_meta_.col_tot_len) {
+                // 有等值条件，使用等值扫描
+                // 对于多列索引，暂时锁住整个表范围（简化处理）
+                has_range = true;
+                lower = ih->lower_bound(key.data());
+                upper = ih->upper_bound(key.data());
+            }
+            // 否则使用全表扫描（lower和upper已经是leaf_begin和leaf_end）
+        }
+        
+        // 加间隙共享锁：锁住查询范围内的间隙，防止其他事务在该范围内插入/删除
+        if (context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr) {
+            int tab_fd = fh_->GetFd();
+            if (has_range) {
+                // 有明确的查询范围，锁住该范围
+                if (!context_->lock_mgr_->lock_shared_on_gap(context_->txn_, tab_fd, left_key, right_key)) {
+                    throw std::runtime_error("Failed to acquire shared gap lock");
+                }
+            } else {
+                // 全表扫描，锁住整个键空间
+                if (!context_->lock_mgr_->lock_shared_on_gap(context_->txn_, tab_fd, INT_MIN, INT_MAX)) {
+                    throw std::runtime_error("Failed to acquire shared gap lock");
+                }
+            }
+        }
+    }
+};
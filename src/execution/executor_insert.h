@@ -14,6 +14,7 @@ See the Mulan PSL v2 for more details. */
 #include "executor_abstract.h"
 #include "index/ix.h"
 #include "system/sm.h"
+#include "view_maintainer.h"
 
 class InsertExecutor : public AbstractExecutor {
    private:
@@ -45,7 +46,11 @@ class InsertExecutor : public AbstractExecutor {
                 throw std::runtime_error("Failed to acquire IX lock on table");
             }
         }
-        
+
+        // 与CREATE INDEX CONCURRENTLY注册/切换索引互斥，并重新读取表上当前的索引
+        std::shared_lock<std::shared_mutex> build_lock(sm_manager_->index_build_latch_);
+        tab_ = sm_manager_->db_.get_table(tab_name_);
+
         // Make record buffer
         RmRecord rec(fh_->get_file_hdr().record_size);
         for (size_t i = 0; i < values_.size(); i++) {
@@ -57,8 +62,15 @@ class InsertExecutor : public AbstractExecutor {
             val.init_raw(col.len);
             memcpy(rec.data + col.offset, val.raw->data, col.len);
         }
-        // Insert into record file
-        rid_ = fh_->insert_record(rec.data, context_);
+        // Insert into record file，聚簇表把记录放在聚簇键相邻的记录所在的页面
+        if (tab_.is_organized()) {
+            rid_ = fh_->insert_record_near(rec.data, clustered_pages(rec.data), context_);
+        } else {
+            rid_ = fh_->insert_record(rec.data, context_);
+        }
+        sm_manager_->capture_index_build(tab_name_, nullptr, rec.data, rid_);
+        sm_manager_->capture_trigram(tab_name_, nullptr, rec.data, rid_);
+        sm_manager_->capture_stats(tab_name_, nullptr, rec.data);
         // record a insert operation into the transaction
         // 保存记录数据，以便回滚时能够删除索引
         WriteRecord *wr = new WriteRecord(WType::INSERT_TUPLE, tab_name_, rid_, rec);
@@ -66,6 +78,10 @@ class InsertExecutor : public AbstractExecutor {
         // Insert into index and record index undo log
         for (size_t i = 0; i < tab_.indexes.size(); ++i) {
             auto &index = tab_.indexes[i];
+            // 部分索引只维护满足谓词的记录
+            if (!index.covers(rec.data)) {
+                continue;
+            }
             auto ih = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols)).get();
             char *key = new char[index.col_tot_len];
             int offset = 0;
@@ -95,7 +111,30 @@ class InsertExecutor : public AbstractExecutor {
             
             delete[] key;
         }
+        // 视图表的插入同样要获取build_lock，释放后再维护依赖该表的物化视图
+        build_lock.unlock();
+        ViewMaintainer::apply(sm_manager_, tab_name_, nullptr, rec.data, context_);
         return nullptr;
     }
     Rid &rid() override { return rid_; }
+
+   private:
+    /* 聚簇表中与rec的聚簇键相邻的记录（前驱、后继）所在的页面 */
+    std::vector<int> clustered_pages(const char *rec) {
+        auto &index = *tab_.get_index_meta(tab_.organized_by);
+        auto ih = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols)).get();
+        std::vector<char> key(index.col_tot_len);
+        int offset = 0;
+        for (auto &col : index.cols) {
+            memcpy(key.data() + offset, rec + col.offset, col.len);
+            offset += col.len;
+        }
+        std::vector<Rid> neighbors;
+        ih->get_neighbor_rids(key.data(), &neighbors);
+        std::vector<int> page_nos;
+        for (auto &neighbor : neighbors) {
+            page_nos.push_back(neighbor.page_no);
+        }
+        return page_nos;
+    }
 };
\ No newline at end of file
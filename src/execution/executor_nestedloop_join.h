@@ -76,6 +76,12 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
                     float b = *reinterpret_cast<const float *>(rhs);
                     return (a < b) ? -1 : ((a > b) ? 1 : 0);
                 }
+                case TYPE_BIGINT:
+                case TYPE_DATETIME: {
+                    int64_t a = *reinterpret_cast<const int64_t *>(lhs);
+                    int64_t b = *reinterpret_cast<const int64_t *>(rhs);
+                    return (a < b) ? -1 : ((a > b) ? 1 : 0);
+                }
                 case TYPE_STRING:
                     return memcmp(lhs, rhs, len);
                 default:
@@ -94,6 +100,7 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
                 auto rhs_it = get_col(cols_, cond.rhs_col);
                 rhs_ptr = rec.data + rhs_it->offset;
             }
+            if (cond.op == OP_LIKE) return like_match(lhs_ptr, lhs.len, rhs_ptr);
             int c = cmp(lhs.type, lhs_ptr, rhs_ptr, lhs.len);
             switch (cond.op) {
                 case OP_EQ: return c == 0;
@@ -155,6 +162,12 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
                     float b = *reinterpret_cast<const float *>(rhs);
                     return (a < b) ? -1 : ((a > b) ? 1 : 0);
                 }
+                case TYPE_BIGINT:
+                case TYPE_DATETIME: {
+                    int64_t a = *reinterpret_cast<const int64_t *>(lhs);
+                    int64_t b = *reinterpret_cast<const int64_t *>(rhs);
+                    return (a < b) ? -1 : ((a > b) ? 1 : 0);
+                }
                 case TYPE_STRING:
                     return memcmp(lhs, rhs, len);
                 default:
@@ -173,6 +186,7 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
                 auto rhs_it = get_col(cols_, cond.rhs_col);
                 rhs_ptr = rec.data + rhs_it->offset;
             }
+            if (cond.op == OP_LIKE) return like_match(lhs_ptr, lhs.len, rhs_ptr);
             int c = cmp(lhs.type, lhs_ptr, rhs_ptr, lhs.len);
             switch (cond.op) {
                 case OP_EQ: return c == 0;
@@ -24,6 +24,8 @@ class SeqScanExecutor : public AbstractExecutor {
     std::vector<ColMeta> cols_;         // scan后生成的记录的字段
     size_t len_;                        // scan后生成的每条记录的长度
     std::vector<Condition> fed_conds_;  // 同conds_，两个字段相同
+    TableSample sample_;                // tablesample
+    WorkloadEntry *workload_;           // 工作负载记录中的项，不为空时统计扫描次数和耗时
 
     Rid rid_;
     std::unique_ptr<RecScan> scan_;     // table_iterator
@@ -31,7 +33,8 @@ class SeqScanExecutor : public AbstractExecutor {
     SmManager *sm_manager_;
 
    public:
-    SeqScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds, Context *context) {
+    SeqScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds, Context *context,
+                    TableSample sample = TableSample(), WorkloadEntry *workload = nullptr) {
         sm_manager_ = sm_manager;
         tab_name_ = std::move(tab_name);
         conds_ = std::move(conds);
@@ -43,6 +46,8 @@ class SeqScanExecutor : public AbstractExecutor {
         context_ = context;
 
         fed_conds_ = conds_;
+        sample_ = sample;
+        workload_ = workload;
     }
 
     size_t tupleLen() const override { return len_; }
@@ -58,6 +63,10 @@ class SeqScanExecutor : public AbstractExecutor {
      *
      */
     void beginTuple() override {
+        WorkloadTimer timer(workload_);
+        if (workload_ != nullptr) {
+            workload_->executions++;
+        }
         // 申请IS意向锁（表级）
         if (context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr) {
             int tab_fd = fh_->GetFd();
@@ -66,7 +75,11 @@ class SeqScanExecutor : public AbstractExecutor {
             }
         }
         
-        scan_ = std::make_unique<RmScan>(fh_);
+        if (sample_.enabled()) {
+            scan_ = std::make_unique<RmScan>(fh_, std::make_unique<RmSampler>(sample_.page_fraction(), sample_.row_fraction()));
+        } else {
+            scan_ = std::make_unique<RmScan>(fh_, true);
+        }
 
         //比较函数
         auto cmp = [](ColType type, const char *lhs, const char *rhs, int len) -> int {
@@ -81,6 +94,12 @@ class SeqScanExecutor : public AbstractExecutor {
                     float b = *reinterpret_cast<const float *>(rhs);
                     return (a < b) ? -1 : ((a > b) ? 1 : 0);
                 }
+                case TYPE_BIGINT:
+                case TYPE_DATETIME: {
+                    int64_t a = *reinterpret_cast<const int64_t *>(lhs);
+                    int64_t b = *reinterpret_cast<const int64_t *>(rhs);
+                    return (a < b) ? -1 : ((a > b) ? 1 : 0);
+                }
                 case TYPE_STRING:
                     return memcmp(lhs, rhs, len);
                 default:
@@ -100,6 +119,7 @@ class SeqScanExecutor : public AbstractExecutor {
                 auto rhs_it = get_col(cols_, cond.rhs_col);
                 rhs_ptr = rec.data + rhs_it->offset;
             }
+            if (cond.op == OP_LIKE) return like_match(lhs_ptr, lhs.len, rhs_ptr);
             int c = cmp(lhs.type, lhs_ptr, rhs_ptr, lhs.len);
             switch (cond.op) {
                 case OP_EQ: return c == 0;
@@ -138,6 +158,7 @@ class SeqScanExecutor : public AbstractExecutor {
         if (scan_ == nullptr || scan_->is_end()) {
             return;
         }
+        WorkloadTimer timer(workload_);
         scan_->next();
 
         auto cmp = [](ColType type, const char *lhs, const char *rhs, int len) -> int {
@@ -152,6 +173,12 @@ class SeqScanExecutor : public AbstractExecutor {
                     float b = *reinterpret_cast<const float *>(rhs);
                     return (a < b) ? -1 : ((a > b) ? 1 : 0);
                 }
+                case TYPE_BIGINT:
+                case TYPE_DATETIME: {
+                    int64_t a = *reinterpret_cast<const int64_t *>(lhs);
+                    int64_t b = *reinterpret_cast<const int64_t *>(rhs);
+                    return (a < b) ? -1 : ((a > b) ? 1 : 0);
+                }
                 case TYPE_STRING:
                     return memcmp(lhs, rhs, len);
                 default:
@@ -170,6 +197,7 @@ class SeqScanExecutor : public AbstractExecutor {
                 auto rhs_it = get_col(cols_, cond.rhs_col);
                 rhs_ptr = rec.data + rhs_it->offset;
             }
+            if (cond.op == OP_LIKE) return like_match(lhs_ptr, lhs.len, rhs_ptr);
             int c = cmp(lhs.type, lhs_ptr, rhs_ptr, lhs.len);
             switch (cond.op) {
                 case OP_EQ: return c == 0;
@@ -0,0 +1,166 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "execution_defs.h"
+#include "execution_manager.h"
+#include "executor_abstract.h"
+#include "index/ix.h"
+#include "system/sm.h"
+
+/**
+ * 三元组索引扫描：用字段上LIKE模式的三元组在倒排索引中求交得到候选记录，按Rid顺序回表，再用全部条件过滤
+ */
+class TrigramScanExecutor : public AbstractExecutor {
+   private:
+    std::string tab_name_;              // 表的名称
+    std::vector<Condition> conds_;      // scan的条件
+    std::string col_name_;              // 建有三元组索引的字段
+    RmFileHandle *fh_;                  // 表的数据文件句柄
+    std::vector<ColMeta> cols_;         // scan后生成的记录的字段
+    size_t len_;                        // scan后生成的每条记录的长度
+
+    std::vector<Rid> rids_;             // 候选记录
+    size_t pos_ = 0;                    // 当前记录在rids_中的位置
+    Rid rid_;
+
+    SmManager *sm_manager_;
+
+   public:
+    TrigramScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds,
+                        std::string col_name, Context *context) {
+        sm_manager_ = sm_manager;
+        tab_name_ = std::move(tab_name);
+        conds_ = std::move(conds);
+        col_name_ = std::move(col_name);
+        TabMeta &tab = sm_manager_->db_.get_table(tab_name_);
+        fh_ = sm_manager_->fhs_.at(tab_name_).get();
+        cols_ = tab.cols;
+        len_ = cols_.back().offset + cols_.back().len;
+
+        context_ = context;
+    }
+
+    size_t tupleLen() const override { return len_; }
+
+    const std::vector<ColMeta> &cols() const override { return cols_; }
+
+    bool is_end() const override { return pos_ >= rids_.size(); }
+
+    ColMeta get_col_offset(const TabCol &target) override { return *get_col(cols_, target); }
+
+    void beginTuple() override {
+        // 申请IS意向锁（表级）
+        if (context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr) {
+            if (!context_->lock_mgr_->lock_IS_on_table(context_->txn_, fh_->GetFd())) {
+                throw std::runtime_error("Failed to acquire IS lock on table");
+            }
+        }
+
+        // 每个LIKE条件都能缩小候选范围，所有三元组一起求交
+        std::vector<uint32_t> trigrams;
+        for (auto &cond : conds_) {
+            if (cond.is_rhs_val && cond.op == OP_LIKE && cond.lhs_col.col_name == col_name_) {
+                auto pattern_trigrams = IxTrigramHandle::pattern_trigrams(cond.rhs_val.str_val);
+                trigrams.insert(trigrams.end(), pattern_trigrams.begin(), pattern_trigrams.end());
+            }
+        }
+        std::sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+        auto tg = sm_manager_->tgs_.at(sm_manager_->get_ix_manager()->get_trigram_name(tab_name_, col_name_)).get();
+        rids_ = tg->search(trigrams);
+        pos_ = 0;
+        seek();
+    }
+
+    void nextTuple() override {
+        if (is_end()) {
+            return;
+        }
+        pos_++;
+        seek();
+    }
+
+    std::unique_ptr<RmRecord> Next() override {
+        if (is_end()) {
+            return nullptr;
+        }
+        return fh_->get_record(rid_, context_);
+    }
+
+    Rid &rid() override { return rid_; }
+
+   private:
+    /* 从pos_开始找到第一条仍然存在且满足所有条件的候选记录 */
+    void seek() {
+        for (; pos_ < rids_.size(); pos_++) {
+            rid_ = rids_[pos_];
+            if (!fh_->is_record(rid_)) {
+                continue;
+            }
+            auto rec = fh_->get_record(rid_, context_);
+            if (rec != nullptr && eval_conds(*rec)) {
+                return;
+            }
+        }
+    }
+
+    bool eval_conds(const RmRecord &rec) {
+        auto cmp = [](ColType type, const char *lhs, const char *rhs, int len) -> int {
+            switch (type) {
+                case TYPE_INT: {
+                    int a = *reinterpret_cast<const int *>(lhs);
+                    int b = *reinterpret_cast<const int *>(rhs);
+                    return (a < b) ? -1 : ((a > b) ? 1 : 0);
+                }
+                case TYPE_FLOAT: {
+                    float a = *reinterpret_cast<const float *>(lhs);
+                    float b = *reinterpret_cast<const float *>(rhs);
+                    return (a < b) ? -1 : ((a > b) ? 1 : 0);
+                }
+                case TYPE_BIGINT:
+                case TYPE_DATETIME: {
+                    int64_t a = *reinterpret_cast<const int64_t *>(lhs);
+                    int64_t b = *reinterpret_cast<const int64_t *>(rhs);
+                    return (a < b) ? -1 : ((a > b) ? 1 : 0);
+                }
+                case TYPE_STRING:
+                    return memcmp(lhs, rhs, len);
+                default:
+                    throw InternalError("Unexpected data type");
+            }
+        };
+
+        for (auto &cond : conds_) {
+            auto lhs_it = get_col(cols_, cond.lhs_col);
+            const char *lhs_ptr = rec.data + lhs_it->offset;
+            const char *rhs_ptr =
+                cond.is_rhs_val ? cond.rhs_val.raw->data : rec.data + get_col(cols_, cond.rhs_col)->offset;
+            bool ok;
+            if (cond.op == OP_LIKE) {
+                ok = like_match(lhs_ptr, lhs_it->len, rhs_ptr);
+            } else {
+                int c = cmp(lhs_it->type, lhs_ptr, rhs_ptr, lhs_it->len);
+                switch (cond.op) {
+                    case OP_EQ: ok = c == 0; break;
+                    case OP_NE: ok = c != 0; break;
+                    case OP_LT: ok = c < 0; break;
+                    case OP_GT: ok = c > 0; break;
+                    case OP_LE: ok = c <= 0; break;
+                    case OP_GE: ok = c >= 0; break;
+                    default: throw InternalError("Unexpected comparison operator");
+                }
+            }
+            if (!ok) return false;
+        }
+        return true;
+    }
+};
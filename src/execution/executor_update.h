@@ -13,7 +13,9 @@ See the Mulan PSL v2 for more details. */
 #include "execution_manager.h"
 #include "executor_abstract.h"
 #include "index/ix.h"
+#include "parallel_dml.h"
 #include "system/sm.h"
+#include "view_maintainer.h"
 
 class UpdateExecutor : public AbstractExecutor {
    private:
@@ -45,111 +47,234 @@ class UpdateExecutor : public AbstractExecutor {
                 throw std::runtime_error("Failed to acquire IX lock on table");
             }
         }
-        
-        // Update each rid from record file and index file
-        for (auto& rid : rids_) {
-            // 先尝试申请X锁（如果已经持有S锁，会尝试升级为X锁）
-            // 这样可以避免先申请S锁再升级的问题
-            if (context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr) {
-                int tab_fd = fh_->GetFd();
-                if (!context_->lock_mgr_->lock_exclusive_on_record(context_->txn_, rid, tab_fd)) {
-                    throw std::runtime_error("Failed to acquire exclusive lock on record");
+
+        // 与CREATE INDEX CONCURRENTLY注册/切换索引互斥，并重新读取表上当前的索引
+        std::shared_lock<std::shared_mutex> build_lock(sm_manager_->index_build_latch_);
+        tab_ = sm_manager_->db_.get_table(tab_name_);
+        // 依赖该表的物化视图在释放build_lock后再维护，视图表的修改同样要获取该锁
+        bool maintain_views = sm_manager_->db_.has_views_on(tab_name_);
+        std::vector<std::pair<RmRecord, RmRecord>> changes;
+
+        if (!update_parallel(maintain_views, changes)) {
+            // Update each rid from record file and index file
+            for (auto& rid : rids_) {
+                // 先尝试申请X锁（如果已经持有S锁，会尝试升级为X锁）
+                // 这样可以避免先申请S锁再升级的问题
+                if (context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr) {
+                    int tab_fd = fh_->GetFd();
+                    if (!context_->lock_mgr_->lock_exclusive_on_record(context_->txn_, rid, tab_fd)) {
+                        throw std::runtime_error("Failed to acquire exclusive lock on record");
+                    }
                 }
-            }
             
-            // 现在已经有X锁了，可以安全地读取记录
-            // get_record会尝试申请S锁，但由于我们已经持有X锁，应该可以直接读取
-            auto rec = fh_->get_record(rid, context_);
-            RmRecord record = *rec;
-            for (auto& set_clause : set_clauses_) {
-                auto lhs_col = tab_.get_col(set_clause.lhs.col_name);
-                memcpy(rec->data + lhs_col->offset, set_clause.rhs.raw->data, lhs_col->len);
-            }
-            // record a update operation into the transaction (must be before modifying index/record)
-            WriteRecord* wr = new WriteRecord(WType::UPDATE_TUPLE, tab_name_, rid, record);
-            context_->txn_->append_write_record(wr);
-            
-            // Remove old entry from index and record index undo log
-            for (size_t i = 0; i < tab_.indexes.size(); ++i) {
-                auto& index = tab_.indexes[i];
-                auto ih =
-                    sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols)).get();
-                char* old_key = new char[index.col_tot_len];
-                int offset = 0;
-                for (int j = 0; j < index.col_num; ++j) {
-                    memcpy(old_key + offset, record.data + index.cols[j].offset, index.cols[j].len);
-                    offset += index.cols[j].len;
+                // 现在已经有X锁了，可以安全地读取记录
+                // get_record会尝试申请S锁，但由于我们已经持有X锁，应该可以直接读取
+                auto rec = fh_->get_record(rid, context_);
+                RmRecord record = *rec;
+                for (auto& set_clause : set_clauses_) {
+                    auto lhs_col = tab_.get_col(set_clause.lhs.col_name);
+                    memcpy(rec->data + lhs_col->offset, set_clause.rhs.raw->data, lhs_col->len);
                 }
+                // record a update operation into the transaction (must be before modifying index/record)
+                WriteRecord* wr = new WriteRecord(WType::UPDATE_TUPLE, tab_name_, rid, record);
+                context_->txn_->append_write_record(wr);
+            
+                // Remove old entry from index and record index undo log
+                for (size_t i = 0; i < tab_.indexes.size(); ++i) {
+                    auto& index = tab_.indexes[i];
+                    // 部分索引只维护满足谓词的记录，更新前后是否满足谓词可能不同
+                    if (!index.covers(record.data)) {
+                        continue;
+                    }
+                    auto ih =
+                        sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols)).get();
+                    char* old_key = new char[index.col_tot_len];
+                    int offset = 0;
+                    for (int j = 0; j < index.col_num; ++j) {
+                        memcpy(old_key + offset, record.data + index.cols[j].offset, index.cols[j].len);
+                        offset += index.cols[j].len;
+                    }
                 
-                // 对于单列INT索引，加排它间隙锁：更新操作会改变键空间
-                if (context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr &&
-                    index.col_num == 1 && index.cols[0].type == TYPE_INT) {
-                    int tab_fd = fh_->GetFd();
-                    int old_key_val = *reinterpret_cast<int*>(old_key);
-                    // 锁住旧key的间隙
-                    if (!context_->lock_mgr_->lock_exclusive_on_gap(context_->txn_, tab_fd, old_key_val, old_key_val)) {
-                        delete[] old_key;
-                        throw std::runtime_error("Failed to acquire exclusive gap lock for update (old key)");
+                    // 对于单列INT索引，加排它间隙锁：更新操作会改变键空间
+                    if (context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr &&
+                        index.col_num == 1 && index.cols[0].type == TYPE_INT) {
+                        int tab_fd = fh_->GetFd();
+                        int old_key_val = *reinterpret_cast<int*>(old_key);
+                        // 锁住旧key的间隙
+                        if (!context_->lock_mgr_->lock_exclusive_on_gap(context_->txn_, tab_fd, old_key_val, old_key_val)) {
+                            delete[] old_key;
+                            throw std::runtime_error("Failed to acquire exclusive gap lock for update (old key)");
+                        }
                     }
-                }
                 
-                // 删除旧索引条目
-                ih->delete_entry(old_key, context_->txn_);
+                    // 删除旧索引条目
+                    ih->delete_entry(old_key, context_->txn_);
                 
-                // 记录索引删除的 undo log：如果事务 abort，需要恢复这个索引条目
-                wr->AddIndexOp(index.cols, old_key, index.col_tot_len, rid, IndexOpType::INDEX_DELETE);
+                    // 记录索引删除的 undo log：如果事务 abort，需要恢复这个索引条目
+                    wr->AddIndexOp(index.cols, old_key, index.col_tot_len, rid, IndexOpType::INDEX_DELETE);
                 
-                delete[] old_key;
-            }
-            // Update record in record file
-            fh_->update_record(rid, rec->data, context_);
-            // Insert new index into index and record index undo log
-            for (size_t i = 0; i < tab_.indexes.size(); ++i) {
-                auto& index = tab_.indexes[i];
-                auto ih =
-                    sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols)).get();
-                char* new_key = new char[index.col_tot_len];
-                int offset = 0;
-                for (int j = 0; j < index.col_num; ++j) {
-                    memcpy(new_key + offset, rec->data + index.cols[j].offset, index.cols[j].len);
-                    offset += index.cols[j].len;
+                    delete[] old_key;
                 }
-                
-                // 对于单列INT索引，如果新key和旧key不同，也需要锁住新key的间隙
-                if (context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr &&
-                    index.col_num == 1 && index.cols[0].type == TYPE_INT) {
-                    int tab_fd = fh_->GetFd();
-                    int new_key_val = *reinterpret_cast<int*>(new_key);
-                    // 检查新key是否与旧key不同（更新了索引列）
-                    char* old_key_check = new char[index.col_tot_len];
-                    int offset_check = 0;
+                // Update record in record file
+                fh_->update_record(rid, rec->data, context_);
+                sm_manager_->capture_index_build(tab_name_, record.data, rec->data, rid);
+                sm_manager_->capture_trigram(tab_name_, record.data, rec->data, rid);
+                sm_manager_->capture_stats(tab_name_, record.data, rec->data);
+                // Insert new index into index and record index undo log
+                for (size_t i = 0; i < tab_.indexes.size(); ++i) {
+                    auto& index = tab_.indexes[i];
+                    if (!index.covers(rec->data)) {
+                        continue;
+                    }
+                    auto ih =
+                        sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols)).get();
+                    char* new_key = new char[index.col_tot_len];
+                    int offset = 0;
                     for (int j = 0; j < index.col_num; ++j) {
-                        memcpy(old_key_check + offset_check, record.data + index.cols[j].offset, index.cols[j].len);
-                        offset_check += index.cols[j].len;
+                        memcpy(new_key + offset, rec->data + index.cols[j].offset, index.cols[j].len);
+                        offset += index.cols[j].len;
                     }
-                    int old_key_val = *reinterpret_cast<int*>(old_key_check);
-                    delete[] old_key_check;
+                
+                    // 对于单列INT索引，如果新key和旧key不同，也需要锁住新key的间隙
+                    if (context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr &&
+                        index.col_num == 1 && index.cols[0].type == TYPE_INT) {
+                        int tab_fd = fh_->GetFd();
+                        int new_key_val = *reinterpret_cast<int*>(new_key);
+                        // 检查新key是否与旧key不同（更新了索引列）
+                        char* old_key_check = new char[index.col_tot_len];
+                        int offset_check = 0;
+                        for (int j = 0; j < index.col_num; ++j) {
+                            memcpy(old_key_check + offset_check, record.data + index.cols[j].offset, index.cols[j].len);
+                            offset_check += index.cols[j].len;
+                        }
+                        int old_key_val = *reinterpret_cast<int*>(old_key_check);
+                        delete[] old_key_check;
                     
-                    if (new_key_val != old_key_val) {
-                        // 新key和旧key不同，需要锁住新key的间隙
-                        if (!context_->lock_mgr_->lock_exclusive_on_gap(context_->txn_, tab_fd, new_key_val, new_key_val)) {
-                            delete[] new_key;
-                            throw std::runtime_error("Failed to acquire exclusive gap lock for update (new key)");
+                        if (new_key_val != old_key_val) {
+                            // 新key和旧key不同，需要锁住新key的间隙
+                            if (!context_->lock_mgr_->lock_exclusive_on_gap(context_->txn_, tab_fd, new_key_val, new_key_val)) {
+                                delete[] new_key;
+                                throw std::runtime_error("Failed to acquire exclusive gap lock for update (new key)");
+                            }
                         }
                     }
-                }
                 
-                // 插入新索引条目
-                ih->insert_entry(new_key, rid, context_->txn_);
+                    // 插入新索引条目
+                    ih->insert_entry(new_key, rid, context_->txn_);
                 
-                // 记录索引插入的 undo log：如果事务 abort，需要删除这个索引条目
-                wr->AddIndexOp(index.cols, new_key, index.col_tot_len, rid, IndexOpType::INDEX_INSERT);
+                    // 记录索引插入的 undo log：如果事务 abort，需要删除这个索引条目
+                    wr->AddIndexOp(index.cols, new_key, index.col_tot_len, rid, IndexOpType::INDEX_INSERT);
                 
-                delete[] new_key;
+                    delete[] new_key;
+                }
+                if (maintain_views) {
+                    changes.emplace_back(record, *rec);
+                }
             }
         }
+        build_lock.unlock();
+        for (auto &change : changes) {
+            ViewMaintainer::apply(sm_manager_, tab_name_, change.first.data, change.second.data, context_);
+        }
         return nullptr;
     }
 
     Rid &rid() override { return _abstract_rid; }
+
+   private:
+    /**
+     * @description: 并行更新：记录按页面范围分给多个工作线程，共用当前事务。
+     *               第一轮每个线程给分区中的记录加锁，把写记录整批加入事务，按键值顺序删除改变了的旧索引条目，再修改记录；
+     *               所有线程都完成第一轮后，第二轮再按键值顺序插入新的索引条目，这样一个线程插入的新键值不会撞上另一个线程还没删除的旧键值。
+     *               键值和部分索引谓词的结果都没有改变的索引不需要维护
+     * @return {bool} 记录数或可用线程数不够时返回false，由调用者逐条更新
+     */
+    bool update_parallel(bool maintain_views, std::vector<std::pair<RmRecord, RmRecord>> &changes) {
+        if (rids_.size() < PARALLEL_DML_MIN_ROWS) {
+            return false;
+        }
+        ParallelDml dml(rids_);
+        if (dml.num_threads() < 2) {
+            return false;
+        }
+        bool locking = context_ != nullptr && context_->txn_ != nullptr && context_->lock_mgr_ != nullptr;
+        int tab_fd = fh_->GetFd();
+        const std::vector<Rid> &rids = dml.rids();
+        auto key_changed = [](const IndexMeta &index, const char *a, const char *b) {
+            for (auto &col : index.cols) {
+                if (memcmp(a + col.offset, b + col.offset, col.len) != 0) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        auto index_handle = [&](const IndexMeta &index) {
+            return sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index.cols)).get();
+        };
+        // 每个分区的写记录（保存旧记录）和新记录，第二轮和物化视图维护使用
+        std::vector<std::vector<WriteRecord *>> wrs(dml.num_partitions());
+        std::vector<std::vector<RmRecord>> new_recs(dml.num_partitions());
+
+        dml.run([&](size_t p, const ParallelDml::Partition &part) {
+            std::vector<std::unique_ptr<RmRecord>> old_recs;
+            for (size_t r = part.begin; r < part.end; r++) {
+                if (locking && !context_->lock_mgr_->lock_exclusive_on_record(context_->txn_, rids[r], tab_fd)) {
+                    throw std::runtime_error("Failed to acquire exclusive lock on record");
+                }
+                old_recs.push_back(fh_->get_record(rids[r], context_));
+            }
+            for (size_t i = 0; i < old_recs.size(); i++) {
+                RmRecord rec = *old_recs[i];
+                for (auto &set_clause : set_clauses_) {
+                    auto lhs_col = tab_.get_col(set_clause.lhs.col_name);
+                    memcpy(rec.data + lhs_col->offset, set_clause.rhs.raw->data, lhs_col->len);
+                }
+                new_recs[p].push_back(rec);
+                wrs[p].push_back(new WriteRecord(WType::UPDATE_TUPLE, tab_name_, rids[part.begin + i], *old_recs[i]));
+            }
+            context_->txn_->append_write_records(wrs[p]);
+
+            for (auto &index : tab_.indexes) {
+                IndexOpBatch batch(index);
+                for (size_t i = 0; i < old_recs.size(); i++) {
+                    const char *old_rec = old_recs[i]->data;
+                    const char *new_rec = new_recs[p][i].data;
+                    if (index.covers(old_rec) && (!index.covers(new_rec) || key_changed(index, old_rec, new_rec))) {
+                        batch.add(old_rec, rids[part.begin + i], wrs[p][i]);
+                    }
+                }
+                batch.apply(index_handle(index), IndexOpType::INDEX_DELETE, context_, tab_fd);
+            }
+            for (size_t i = 0; i < old_recs.size(); i++) {
+                const Rid &rid = rids[part.begin + i];
+                fh_->update_record(rid, new_recs[p][i].data, context_);
+                sm_manager_->capture_index_build(tab_name_, old_recs[i]->data, new_recs[p][i].data, rid);
+                sm_manager_->capture_trigram(tab_name_, old_recs[i]->data, new_recs[p][i].data, rid);
+                sm_manager_->capture_stats(tab_name_, old_recs[i]->data, new_recs[p][i].data);
+            }
+        });
+
+        dml.run([&](size_t p, const ParallelDml::Partition &part) {
+            for (auto &index : tab_.indexes) {
+                IndexOpBatch batch(index);
+                for (size_t i = 0; i < wrs[p].size(); i++) {
+                    const char *old_rec = wrs[p][i]->GetRecord().data;
+                    const char *new_rec = new_recs[p][i].data;
+                    if (index.covers(new_rec) && (!index.covers(old_rec) || key_changed(index, old_rec, new_rec))) {
+                        batch.add(new_rec, rids[part.begin + i], wrs[p][i]);
+                    }
+                }
+                batch.apply(index_handle(index), IndexOpType::INDEX_INSERT, context_, tab_fd);
+            }
+        });
+
+        if (maintain_views) {
+            for (size_t p = 0; p < wrs.size(); p++) {
+                for (size_t i = 0; i < wrs[p].size(); i++) {
+                    changes.emplace_back(wrs[p][i]->GetRecord(), new_recs[p][i]);
+                }
+            }
+        }
+        return true;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,174 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/context.h"
+#include "execution_defs.h"
+#include "index/ix.h"
+#include "system/sm.h"
+
+/**
+ * 并行UPDATE/DELETE的分区和工作线程：
+ * 要修改的记录按记录号排序，每PARALLEL_DML_PARTITION_PAGES个页面划为一个分区，工作线程依次领取分区，不同线程修改的记录不在同一个页面上。
+ * 所有线程共用调用者的事务，写记录在修改之前整批加入事务的写集合。一个线程出错后其他线程不再领取新的分区，
+ * 所有线程结束后重新抛出第一个异常，由事务回滚撤销写集合中已经记录的修改
+ */
+class ParallelDml {
+   public:
+    /* 一个分区：rids()中[begin, end)的记录 */
+    struct Partition {
+        size_t begin;
+        size_t end;
+    };
+
+    explicit ParallelDml(const std::vector<Rid> &rids) : rids_(rids) {
+        std::sort(rids_.begin(), rids_.end(), [](const Rid &a, const Rid &b) {
+            return a.page_no != b.page_no ? a.page_no < b.page_no : a.slot_no < b.slot_no;
+        });
+        rids_.erase(std::unique(rids_.begin(), rids_.end()), rids_.end());
+        for (size_t i = 0; i < rids_.size();) {
+            int range = (rids_[i].page_no - RM_FIRST_RECORD_PAGE) / PARALLEL_DML_PARTITION_PAGES;
+            size_t j = i;
+            while (j < rids_.size() && (rids_[j].page_no - RM_FIRST_RECORD_PAGE) / PARALLEL_DML_PARTITION_PAGES == range) {
+                j++;
+            }
+            parts_.push_back(Partition{i, j});
+            i = j;
+        }
+        size_t hw = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        num_threads_ = std::max<size_t>(std::min({hw, PARALLEL_DML_MAX_THREADS, parts_.size()}), 1);
+    }
+
+    const std::vector<Rid> &rids() const { return rids_; }
+
+    size_t num_partitions() const { return parts_.size(); }
+
+    size_t num_threads() const { return num_threads_; }
+
+    /**
+     * @description: 用多个工作线程对每个分区调用work(分区序号, 分区)，任何一个分区出错时重新抛出第一个异常
+     */
+    template <typename Work>
+    void run(Work &&work) {
+        std::atomic<size_t> next{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        std::mutex error_latch;
+        auto worker = [&]() {
+            for (size_t p = next++; p < parts_.size() && !failed; p = next++) {
+                try {
+                    work(p, parts_[p]);
+                } catch (...) {
+                    std::scoped_lock lock{error_latch};
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    failed = true;
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        try {
+            for (size_t i = 1; i < num_threads_; i++) {
+                threads.emplace_back(worker);
+            }
+        } catch (const std::system_error &) {
+            // 创建不了更多线程时由已经启动的线程完成所有分区
+        }
+        worker();
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+   private:
+    std::vector<Rid> rids_;         // 排好序、去掉重复的记录号
+    std::vector<Partition> parts_;  // 按页面范围划分的分区
+    size_t num_threads_;
+};
+
+/**
+ * 一个工作线程在一个索引上的一批插入或删除，按键值排序后执行，相邻的操作落在相邻的叶子上。
+ * 每执行一个操作就在对应记录的写记录中记录索引undo，出错时写记录中只有已经执行了的操作
+ */
+class IndexOpBatch {
+   public:
+    explicit IndexOpBatch(const IndexMeta &index) : index_(index) {
+        for (auto &col : index.cols) {
+            col_types_.push_back(col.type);
+            col_lens_.push_back(col.len);
+        }
+    }
+
+    /* 加入记录rec在索引上的键值 */
+    void add(const char *rec, const Rid &rid, WriteRecord *wr) {
+        size_t key_offset = keys_.size();
+        keys_.resize(key_offset + index_.col_tot_len);
+        int offset = 0;
+        for (auto &col : index_.cols) {
+            memcpy(keys_.data() + key_offset + offset, rec + col.offset, col.len);
+            offset += col.len;
+        }
+        ops_.push_back(Op{key_offset, rid, wr});
+    }
+
+    /**
+     * @description: 按键值顺序执行这批操作，单列INT索引上先对每个键值加排它间隙锁，与逐条修改时相同
+     * @param {IndexOpType} op_type INDEX_DELETE删除键值对，INDEX_INSERT插入键值对
+     */
+    void apply(IxIndexHandle *ih, IndexOpType op_type, Context *context, int tab_fd) {
+        std::sort(ops_.begin(), ops_.end(), [&](const Op &a, const Op &b) {
+            return ix_compare(keys_.data() + a.key_offset, keys_.data() + b.key_offset, col_types_, col_lens_) < 0;
+        });
+        bool gap_lock = context != nullptr && context->txn_ != nullptr && context->lock_mgr_ != nullptr &&
+                        index_.col_num == 1 && index_.cols[0].type == TYPE_INT;
+        for (auto &op : ops_) {
+            char *key = keys_.data() + op.key_offset;
+            if (gap_lock) {
+                int key_val = *reinterpret_cast<int *>(key);
+                if (!context->lock_mgr_->lock_exclusive_on_gap(context->txn_, tab_fd, key_val, key_val)) {
+                    throw std::runtime_error("Failed to acquire exclusive gap lock");
+                }
+            }
+            if (op_type == IndexOpType::INDEX_DELETE) {
+                ih->delete_entry(key, context->txn_);
+            } else {
+                ih->insert_entry(key, op.rid, context->txn_);
+            }
+            op.wr->AddIndexOp(index_.cols, key, index_.col_tot_len, op.rid, op_type);
+        }
+        ops_.clear();
+        keys_.clear();
+    }
+
+   private:
+    struct Op {
+        size_t key_offset;  // 键值在keys_中的位置
+        Rid rid;
+        WriteRecord *wr;
+    };
+
+    const IndexMeta &index_;
+    std::vector<ColType> col_types_;
+    std::vector<int> col_lens_;
+    std::vector<char> keys_;
+    std::vector<Op> ops_;
+};
@@ -0,0 +1,95 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "result_cache.h"
+
+#include <cctype>
+#include <cstring>
+#include <strings.h>
+
+std::string ResultCache::normalize(const char *sql) {
+    auto is_punct = [](char c) { return c != '\0' && strchr(",()=<>;*.", c) != nullptr; };
+    std::string key;
+    bool in_quote = false;
+    bool pending_space = false;
+    for (const char *p = sql; *p != '\0'; p++) {
+        char c = *p;
+        if (in_quote) {
+            key.push_back(c);
+            in_quote = c != '\'';
+            continue;
+        }
+        if (isspace(static_cast<unsigned char>(c))) {
+            pending_space = !key.empty();
+            continue;
+        }
+        if (pending_space && !is_punct(c) && !is_punct(key.back())) {
+            key.push_back(' ');
+        }
+        pending_space = false;
+        key.push_back(c);
+        in_quote = c == '\'';
+    }
+    while (!key.empty() && key.back() == ';') {
+        key.pop_back();
+    }
+    if (key.size() < 7 || strncasecmp(key.c_str(), "select", 6) != 0 || !(key[6] == ' ' || is_punct(key[6]))) {
+        return "";
+    }
+    return key;
+}
+
+std::shared_ptr<const CachedResult> ResultCache::lookup(const std::string &key, SmManager *sm_manager) {
+    std::scoped_lock lock{latch_};
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        return nullptr;
+    }
+    auto entry = it->second;
+    for (auto &version : entry->result->versions) {
+        if (sm_manager->table_version(version.first) != version.second) {
+            erase(entry);
+            return nullptr;
+        }
+    }
+    lru_.splice(lru_.begin(), lru_, entry);
+    return entry->result;
+}
+
+void ResultCache::insert(const std::string &key, std::shared_ptr<const CachedResult> result) {
+    size_t bytes = result->bytes() + key.size();
+    if (result->overflow || bytes > capacity_) {
+        return;
+    }
+    std::scoped_lock lock{latch_};
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        erase(it->second);
+    }
+    while (size_ + bytes > capacity_ && !lru_.empty()) {
+        erase(std::prev(lru_.end()));
+    }
+    lru_.push_front(Entry{key, std::move(result)});
+    entries_.emplace(key, lru_.begin());
+    size_ += bytes;
+}
+
+void ResultCache::clear() {
+    std::scoped_lock lock{latch_};
+    lru_.clear();
+    entries_.clear();
+    size_ = 0;
+}
+
+void ResultCache::erase(std::list<Entry>::iterator it) {
+    size_ -= it->result->bytes() + it->key.size();
+    entries_.erase(it->key);
+    lru_.erase(it);
+}
@@ -0,0 +1,75 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/common.h"
+#include "system/sm.h"
+
+/* 一条select的结果：输出字段和按记录格式紧密排列的所有输出记录，以及执行前读取的所引用表的版本 */
+struct CachedResult {
+    std::vector<TabCol> sel_cols;
+    std::vector<ColMeta> cols;
+    int rec_len = 0;
+    std::vector<char> rows;
+    std::vector<std::pair<std::string, uint64_t>> versions;
+    bool overflow = false;      // 结果超过了缓存容量，不放入缓存
+
+    size_t num_rows() const { return rec_len == 0 ? 0 : rows.size() / rec_len; }
+
+    size_t bytes() const { return sizeof(CachedResult) + rows.size() + cols.size() * sizeof(ColMeta); }
+};
+
+/**
+ * 服务端的查询结果缓存，按规范化后的语句文本查找，命中时不再解析、优化和执行。
+ * 表上的事务提交、回滚或DDL都会增加表的版本（SmManager::bump_table_version），
+ * 缓存项中任一表的版本与当前不同时失效。缓存项按LRU淘汰，总大小不超过容量。
+ */
+class ResultCache {
+   public:
+    explicit ResultCache(size_t capacity) : capacity_(capacity) {}
+
+    /**
+     * @description: 规范化语句文本作为缓存的键：去掉首尾和分号前后的空白，引号外的连续空白合并为一个空格，
+     *               标点前后的空白去掉。只有select语句可以缓存，其他语句返回空串
+     */
+    static std::string normalize(const char *sql);
+
+    /* 查找缓存项，所引用表的版本都未变化时返回结果，否则删除该项 */
+    std::shared_ptr<const CachedResult> lookup(const std::string &key, SmManager *sm_manager);
+
+    void insert(const std::string &key, std::shared_ptr<const CachedResult> result);
+
+    void clear();
+
+    size_t size() const { return size_; }
+
+   private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const CachedResult> result;
+    };
+
+    void erase(std::list<Entry>::iterator it);
+
+    std::mutex latch_;
+    size_t capacity_;
+    size_t size_ = 0;
+    std::list<Entry> lru_;          // 头部为最近使用的缓存项
+    std::unordered_map<std::string, std::list<Entry>::iterator> entries_;
+};
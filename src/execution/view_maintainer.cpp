@@ -0,0 +1,410 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "view_maintainer.h"
+
+#include <functional>
+
+#include "executor_delete.h"
+#include "executor_insert.h"
+#include "executor_update.h"
+#include "index/ix.h"
+
+namespace {
+
+/* 记录中字段的值转换为Value，通过InsertExecutor写入视图表 */
+Value col_value(const ColMeta &col, const char *rec) {
+    Value val;
+    const char *ptr = rec + col.offset;
+    switch (col.type) {
+        case TYPE_INT: {
+            int v;
+            memcpy(&v, ptr, sizeof(int));
+            val.set_int(v);
+            break;
+        }
+        case TYPE_FLOAT: {
+            float v;
+            memcpy(&v, ptr, sizeof(float));
+            val.set_float(v);
+            break;
+        }
+        case TYPE_BIGINT:
+        case TYPE_DATETIME: {
+            int64_t v;
+            memcpy(&v, ptr, sizeof(int64_t));
+            val.set_bigint(v);
+            val.type = col.type;
+            break;
+        }
+        default:
+            val.set_str(std::string(ptr, strnlen(ptr, col.len)));
+    }
+    return val;
+}
+
+/**
+ * 视图定义查询的连接：可以先固定一张基表的记录（发生变更的记录），再按FROM的顺序为其余基表选择记录，
+ * 每个条件在它涉及的表都选定后检查。每个连接结果按视图表的格式投影后交给回调。
+ */
+class ViewJoin {
+    struct BoundCond {
+        const Condition *cond;
+        int lhs_tab;
+        const ColMeta *lhs;
+        int rhs_tab;                    // 右侧为常量时为-1
+        const ColMeta *rhs;
+    };
+
+    SmManager *sm_manager_;
+    const ViewMeta &view_;
+    Context *context_;
+    std::vector<TabMeta *> tabs_;
+    std::vector<RmFileHandle *> fhs_;
+    std::vector<BoundCond> conds_;
+    std::vector<int> order_;                    // 选择记录的顺序
+    std::vector<std::vector<const BoundCond *>> step_conds_;  // 第k步选定记录后需要检查的条件
+    std::vector<const char *> bound_;           // 每张基表当前选中的记录
+    std::vector<std::pair<int, const ColMeta *>> proj_;       // 视图表每个字段来自的基表和字段
+    std::vector<ColMeta> view_cols_;
+    int view_len_ = 0;
+
+   public:
+    ViewJoin(SmManager *sm_manager, const ViewMeta &view, Context *context)
+        : sm_manager_(sm_manager), view_(view), context_(context) {
+        for (auto &tab_name : view_.tables) {
+            tabs_.push_back(&sm_manager_->db_.get_table(tab_name));
+            fhs_.push_back(sm_manager_->fhs_.at(tab_name).get());
+        }
+        for (auto &cond : view_.conds) {
+            BoundCond bc{&cond, tab_no(cond.lhs_col.tab_name), nullptr, -1, nullptr};
+            bc.lhs = &*tabs_[bc.lhs_tab]->get_col(cond.lhs_col.col_name);
+            if (!cond.is_rhs_val) {
+                bc.rhs_tab = tab_no(cond.rhs_col.tab_name);
+                bc.rhs = &*tabs_[bc.rhs_tab]->get_col(cond.rhs_col.col_name);
+            }
+            conds_.push_back(bc);
+        }
+        for (auto &col : view_.cols) {
+            int t = tab_no(col.tab_name);
+            proj_.emplace_back(t, &*tabs_[t]->get_col(col.col_name));
+        }
+        if (sm_manager_->db_.is_table(view_.name)) {
+            view_cols_ = sm_manager_->db_.get_table(view_.name).cols;
+        } else {
+            // 建立视图时视图表还不存在，按投影列紧密排列
+            int offset = 0;
+            for (auto &p : proj_) {
+                ColMeta col = *p.second;
+                col.offset = offset;
+                offset += col.len;
+                view_cols_.push_back(col);
+            }
+        }
+        view_len_ = view_cols_.empty() ? 0 : view_cols_.back().offset + view_cols_.back().len;
+    }
+
+    /**
+     * @description: 执行连接
+     * @param {int} fixed_tab 固定记录的基表下标，-1表示所有基表都需要扫描
+     * @param {char*} fixed_rec 固定的记录
+     * @param {function} on_row 每个连接结果投影到视图表格式后的记录
+     */
+    void run(int fixed_tab, const char *fixed_rec, const std::function<void(const char *)> &on_row) {
+        order_.clear();
+        if (fixed_tab >= 0) order_.push_back(fixed_tab);
+        for (int t = 0; t < static_cast<int>(tabs_.size()); t++) {
+            if (t != fixed_tab) order_.push_back(t);
+        }
+        std::vector<int> pos(tabs_.size());
+        for (size_t k = 0; k < order_.size(); k++) pos[order_[k]] = k;
+        step_conds_.assign(order_.size(), {});
+        for (auto &bc : conds_) {
+            int step = bc.rhs_tab < 0 ? pos[bc.lhs_tab] : std::max(pos[bc.lhs_tab], pos[bc.rhs_tab]);
+            step_conds_[step].push_back(&bc);
+        }
+        // 其他基表上的读与select一样申请IS锁，记录的S锁由get_record申请
+        for (int t : order_) {
+            if (t == fixed_tab || context_ == nullptr || context_->txn_ == nullptr || context_->lock_mgr_ == nullptr) {
+                continue;
+            }
+            if (!context_->lock_mgr_->lock_IS_on_table(context_->txn_, fhs_[t]->GetFd())) {
+                throw std::runtime_error("Failed to acquire IS lock on table");
+            }
+        }
+        bound_.assign(tabs_.size(), nullptr);
+        std::vector<char> row(view_len_);
+        auto emit = [&]() {
+            for (size_t j = 0; j < proj_.size(); j++) {
+                memcpy(row.data() + view_cols_[j].offset, bound_[proj_[j].first] + proj_[j].second->offset,
+                       view_cols_[j].len);
+            }
+            on_row(row.data());
+        };
+        if (fixed_tab >= 0) {
+            bound_[fixed_tab] = fixed_rec;
+            if (check(0)) join(1, emit);
+        } else {
+            join(0, emit);
+        }
+    }
+
+   private:
+    int tab_no(const std::string &tab_name) const {
+        return std::find(view_.tables.begin(), view_.tables.end(), tab_name) - view_.tables.begin();
+    }
+
+    bool check(size_t step) const {
+        for (auto bc : step_conds_[step]) {
+            const char *lhs_ptr = bound_[bc->lhs_tab] + bc->lhs->offset;
+            const char *rhs_ptr =
+                bc->rhs_tab < 0 ? bc->cond->rhs_val.raw->data : bound_[bc->rhs_tab] + bc->rhs->offset;
+            bool ok;
+            if (bc->cond->op == OP_LIKE) {
+                ok = like_match(lhs_ptr, bc->lhs->len, rhs_ptr);
+            } else {
+                int c = ix_compare(lhs_ptr, rhs_ptr, bc->lhs->type, bc->lhs->len);
+                switch (bc->cond->op) {
+                    case OP_EQ: ok = c == 0; break;
+                    case OP_NE: ok = c != 0; break;
+                    case OP_LT: ok = c < 0; break;
+                    case OP_GT: ok = c > 0; break;
+                    case OP_LE: ok = c <= 0; break;
+                    case OP_GE: ok = c >= 0; break;
+                    default: throw InternalError("Unexpected comparison operator");
+                }
+            }
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+    /* 第step步的基表上与常量或已选定记录的等值条件，该字段上有单列完整索引时返回查找的键值 */
+    const char *index_key(size_t step, IxIndexHandle **ih) const {
+        int t = order_[step];
+        for (auto &bc : conds_) {
+            if (bc.cond->op != OP_EQ) continue;
+            const ColMeta *col = nullptr;
+            const char *key = nullptr;
+            if (bc.lhs_tab == t && bc.rhs_tab < 0) {
+                col = bc.lhs;
+                key = bc.cond->rhs_val.raw->data;
+            } else if (bc.lhs_tab == t && bc.rhs_tab != t && bound_[bc.rhs_tab] != nullptr &&
+                       bc.rhs->len == bc.lhs->len) {
+                col = bc.lhs;
+                key = bound_[bc.rhs_tab] + bc.rhs->offset;
+            } else if (bc.rhs_tab == t && bc.lhs_tab != t && bound_[bc.lhs_tab] != nullptr &&
+                       bc.rhs->len == bc.lhs->len) {
+                col = bc.rhs;
+                key = bound_[bc.lhs_tab] + bc.lhs->offset;
+            } else {
+                continue;
+            }
+            TabMeta &tab = *tabs_[t];
+            std::vector<std::string> col_names = {col->name};
+            if (!tab.is_index(col_names) || tab.get_index_meta(col_names)->is_partial()) continue;
+            *ih = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab.name, col_names)).get();
+            return key;
+        }
+        return nullptr;
+    }
+
+    void join(size_t step, const std::function<void()> &emit) {
+        if (step == order_.size()) {
+            emit();
+            return;
+        }
+        int t = order_[step];
+        RmFileHandle *fh = fhs_[t];
+        auto visit = [&](const Rid &rid) {
+            auto rec = fh->get_record(rid, context_);
+            bound_[t] = rec->data;
+            if (check(step)) join(step + 1, emit);
+            bound_[t] = nullptr;
+        };
+        IxIndexHandle *ih = nullptr;
+        const char *key = index_key(step, &ih);
+        if (key != nullptr) {
+            std::vector<Rid> rids;
+            for (IxScan scan(ih, ih->lower_bound(key), ih->upper_bound(key), sm_manager_->get_bpm()); !scan.is_end();
+                 scan.next()) {
+                rids.push_back(scan.rid());
+            }
+            for (auto &rid : rids) visit(rid);
+        } else {
+            for (RmScan scan(fh); !scan.is_end(); scan.next()) visit(scan.rid());
+        }
+    }
+};
+
+/* 在视图表中找一条与row完全相同的记录，视图表上有完整索引时按索引查找 */
+bool find_view_row(SmManager *sm_manager, TabMeta &tab, const char *row, Rid *rid) {
+    RmFileHandle *fh = sm_manager->fhs_.at(tab.name).get();
+    int len = fh->get_file_hdr().record_size;
+    auto same = [&](const Rid &candidate) {
+        return fh->is_record(candidate) && memcmp(fh->get_record(candidate, nullptr)->data, row, len) == 0;
+    };
+    for (auto &index : tab.indexes) {
+        if (index.is_partial()) continue;
+        auto ih = sm_manager->ihs_.at(sm_manager->get_ix_manager()->get_index_name(tab.name, index.cols)).get();
+        std::vector<char> key(index.col_tot_len);
+        int offset = 0;
+        for (auto &col : index.cols) {
+            memcpy(key.data() + offset, row + col.offset, col.len);
+            offset += col.len;
+        }
+        for (IxScan scan(ih, ih->lower_bound(key.data()), ih->upper_bound(key.data()), sm_manager->get_bpm());
+             !scan.is_end(); scan.next()) {
+            if (same(scan.rid())) {
+                *rid = scan.rid();
+                return true;
+            }
+        }
+        return false;
+    }
+    for (RmScan scan(fh); !scan.is_end(); scan.next()) {
+        if (same(scan.rid())) {
+            *rid = scan.rid();
+            return true;
+        }
+    }
+    return false;
+}
+
+void insert_view_row(SmManager *sm_manager, const std::string &view_name, const char *row, Context *context) {
+    std::vector<Value> values;
+    for (auto &col : sm_manager->db_.get_table(view_name).cols) {
+        values.push_back(col_value(col, row));
+    }
+    InsertExecutor(sm_manager, view_name, std::move(values), context).Next();
+}
+
+void insert_count_row(SmManager *sm_manager, const std::string &view_name, int64_t count, Context *context) {
+    Value val;
+    val.set_bigint(count);
+    InsertExecutor(sm_manager, view_name, {val}, context).Next();
+}
+
+/* count(*)视图的计数加上delta */
+void add_count(SmManager *sm_manager, const ViewMeta &view, int64_t delta, Context *context) {
+    RmFileHandle *fh = sm_manager->fhs_.at(view.name).get();
+    RmScan scan(fh);
+    if (scan.is_end()) {
+        throw InternalError("ViewMaintainer: count row of materialized view " + view.name + " is missing");
+    }
+    Rid rid = scan.rid();
+    auto &col = sm_manager->db_.get_table(view.name).cols[0];
+    int64_t count;
+    memcpy(&count, fh->get_record(rid, context)->data + col.offset, sizeof(int64_t));
+    SetClause set_clause = {.lhs = {.tab_name = view.name, .col_name = col.name}, .rhs = Value()};
+    set_clause.rhs.set_bigint(count + delta);
+    set_clause.rhs.init_raw(col.len);
+    UpdateExecutor(sm_manager, view.name, {set_clause}, {}, {rid}, context).Next();
+}
+
+/* 基表上的修改是否涉及视图用到的字段，不涉及时视图不变 */
+bool touches_view(TabMeta &tab, const ViewMeta &view, const char *old_rec, const char *new_rec) {
+    auto changed = [&](const TabCol &col) {
+        if (col.tab_name != tab.name) return false;
+        auto meta = tab.get_col(col.col_name);
+        return memcmp(old_rec + meta->offset, new_rec + meta->offset, meta->len) != 0;
+    };
+    for (auto &col : view.cols) {
+        if (changed(col)) return true;
+    }
+    for (auto &cond : view.conds) {
+        if (changed(cond.lhs_col) || (!cond.is_rhs_val && changed(cond.rhs_col))) return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+void ViewMaintainer::create_view(SmManager *sm_manager, const ViewMeta &view, const std::vector<ColDef> &col_defs,
+                                 Context *context) {
+    // 先计算结果再建表，计算过程中加锁失败时不会留下不完整的视图
+    std::vector<char> rows;
+    size_t row_len = 0;
+    int64_t count = 0;
+    {
+        ViewJoin join(sm_manager, view, context);
+        for (auto &col_def : col_defs) row_len += col_def.len;
+        join.run(-1, nullptr, [&](const char *row) {
+            count++;
+            if (!view.count_star) rows.insert(rows.end(), row, row + row_len);
+        });
+    }
+    sm_manager->create_view(view, col_defs, context);
+    if (view.count_star) {
+        insert_count_row(sm_manager, view.name, count, context);
+        return;
+    }
+    for (size_t offset = 0; offset < rows.size(); offset += row_len) {
+        insert_view_row(sm_manager, view.name, rows.data() + offset, context);
+    }
+}
+
+void ViewMaintainer::apply(SmManager *sm_manager, const std::string &tab_name, const char *old_rec,
+                           const char *new_rec, Context *context) {
+    for (auto &entry : sm_manager->db_.views()) {
+        const ViewMeta &view = entry.second;
+        if (!view.depends_on(tab_name)) continue;
+        TabMeta &tab = sm_manager->db_.get_table(tab_name);
+        if (old_rec != nullptr && new_rec != nullptr && !touches_view(tab, view, old_rec, new_rec)) continue;
+
+        // 先算出全部增量再写视图表，写视图表时会递归维护视图上的视图
+        ViewJoin join(sm_manager, view, context);
+        int t = std::find(view.tables.begin(), view.tables.end(), tab_name) - view.tables.begin();
+        int row_len = sm_manager->fhs_.at(view.name)->get_file_hdr().record_size;
+        std::vector<std::vector<char>> deleted, inserted;
+        int64_t delta = 0;
+        if (old_rec != nullptr) {
+            join.run(t, old_rec, [&](const char *row) {
+                delta--;
+                if (!view.count_star) deleted.emplace_back(row, row + row_len);
+            });
+        }
+        if (new_rec != nullptr) {
+            join.run(t, new_rec, [&](const char *row) {
+                delta++;
+                if (!view.count_star) inserted.emplace_back(row, row + row_len);
+            });
+        }
+        if (view.count_star) {
+            if (delta != 0) add_count(sm_manager, view, delta, context);
+            continue;
+        }
+        TabMeta &view_tab = sm_manager->db_.get_table(view.name);
+        for (auto &row : deleted) {
+            Rid rid;
+            if (!find_view_row(sm_manager, view_tab, row.data(), &rid)) {
+                throw InternalError("ViewMaintainer: row to delete is missing from materialized view " + view.name);
+            }
+            DeleteExecutor(sm_manager, view.name, {}, {rid}, context).Next();
+        }
+        for (auto &row : inserted) {
+            insert_view_row(sm_manager, view.name, row.data(), context);
+        }
+    }
+}
+
+void ViewMaintainer::truncate(SmManager *sm_manager, const std::string &tab_name, Context *context) {
+    std::vector<ViewMeta> views;
+    for (auto &entry : sm_manager->db_.views()) {
+        if (entry.second.depends_on(tab_name)) views.push_back(entry.second);
+    }
+    for (auto &view : views) {
+        sm_manager->truncate_table(view.name, context);
+        truncate(sm_manager, view.name, context);
+        if (view.count_star) {
+            insert_count_row(sm_manager, view.name, 0, context);
+        }
+    }
+}
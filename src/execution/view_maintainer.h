@@ -0,0 +1,42 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/context.h"
+#include "system/sm.h"
+
+/**
+ * 物化视图的增量维护。基表上一条记录的变更（old_rec -> new_rec）对视图的影响为：
+ *   ΔV = (old_rec ⋈ 其他基表) 删除，(new_rec ⋈ 其他基表) 插入
+ * 与其他基表的连接使用它们的当前内容，有单列索引的等值连接条件时按索引查找，否则顺序扫描。
+ * 视图表的修改通过Insert/Delete/UpdateExecutor完成，与基表的修改在同一个事务中，写记录和索引undo也一样，
+ * 事务回滚时一起撤销；视图上的视图由这些执行器递归维护。
+ */
+class ViewMaintainer {
+   public:
+    /* 计算视图定义的结果，建立视图表并插入 */
+    static void create_view(SmManager *sm_manager, const ViewMeta &view, const std::vector<ColDef> &col_defs,
+                            Context *context);
+
+    /**
+     * @description: DML修改基表记录后调用，维护依赖该表的所有物化视图
+     * @param {char*} old_rec 修改前的记录，插入时为nullptr
+     * @param {char*} new_rec 修改后的记录，删除时为nullptr
+     */
+    static void apply(SmManager *sm_manager, const std::string &tab_name, const char *old_rec, const char *new_rec,
+                      Context *context);
+
+    /* 基表被清空后，与它的连接为空：清空依赖它的视图，count(*)视图的计数置为0 */
+    static void truncate(SmManager *sm_manager, const std::string &tab_name, Context *context);
+};
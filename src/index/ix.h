@@ -12,3 +12,5 @@ See the Mulan PSL v2 for more details. */
 
 #include "ix_scan.h"
 #include "ix_manager.h"
+#include "ix_bulk_builder.h"
+#include "ix_trigram.h"
@@ -0,0 +1,171 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "ix_bulk_builder.h"
+
+/**
+ * @brief 根据条目总数算出每一层的结点个数和页号
+ *
+ * @param ih 刚创建的空索引
+ * @param num_entries 之后通过append加入的键值对个数
+ */
+IxBulkBuilder::IxBulkBuilder(IxIndexHandle *ih, size_t num_entries) : ih_(ih), file_hdr_(ih->file_hdr_) {
+    page_id_t next_page = IX_INIT_ROOT_PAGE;
+    size_t n = num_entries;
+    do {
+        size_t num_nodes = count_nodes(n);
+        levels_.push_back(Level{n, num_nodes, next_page});
+        next_page += static_cast<page_id_t>(num_nodes);
+        n = num_nodes;
+    } while (n > 1);
+    batch_.resize(SEQ_IO_PAGES * PAGE_SIZE);
+    batch_first_page_ = IX_INIT_ROOT_PAGE;
+}
+
+/**
+ * @brief 按升序加入一个叶子结点中的键值对
+ */
+void IxBulkBuilder::append(const char *key, const Rid &rid) {
+    assert(level_ == 0 && num_added_ < levels_[0].num_entries);
+    num_added_++;
+    add_entry(key, rid);
+}
+
+/**
+ * @brief 叶子层完成后逐层构建内部结点，写出所有页面并更新文件头
+ * @note 文件头只修改了内存中的file_hdr_，由IxManager::close_index写回磁盘
+ */
+void IxBulkBuilder::finish() {
+    assert(num_added_ == levels_[0].num_entries);
+    if (num_added_ == 0) {
+        return;  // 保持create_index初始化的空树
+    }
+    int key_len = file_hdr_->col_tot_len_;
+    // 下一层每个结点的子树大小，计数的B+树把它存放在内部结点的rid的slot_no中
+    std::vector<int> child_counts(levels_[0].num_nodes);
+    for (size_t i = 0; i < levels_[0].num_nodes; i++) {
+        child_counts[i] = static_cast<int>(node_size(levels_[0], i));
+    }
+    for (size_t l = 1; l < levels_.size(); l++) {
+        std::vector<char> child_keys;
+        child_keys.swap(node_keys_);
+        page_id_t child_first_page = levels_[l - 1].first_page;
+        std::vector<int> counts(levels_[l].num_nodes, 0);
+        level_ = l;
+        node_ = 0;
+        pos_ = 0;
+        for (size_t i = 0; i < levels_[l - 1].num_nodes; i++) {
+            int count = file_hdr_->counted_ ? child_counts[i] : -1;
+            counts[node_of(levels_[l], i)] += child_counts[i];
+            add_entry(child_keys.data() + i * key_len, Rid{child_first_page + static_cast<page_id_t>(i), count});
+        }
+        child_counts.swap(counts);
+    }
+    flush();
+
+    // 叶子链表的头结点指向第一个和最后一个叶子
+    page_id_t first_leaf = levels_[0].first_page;
+    page_id_t last_leaf = first_leaf + static_cast<page_id_t>(levels_[0].num_nodes) - 1;
+    std::vector<char> page(PAGE_SIZE, 0);
+    *reinterpret_cast<IxPageHdr *>(page.data()) = {
+        .next_free_page_no = IX_NO_PAGE,
+        .parent = IX_NO_PAGE,
+        .num_key = 0,
+        .is_leaf = true,
+        .prev_leaf = last_leaf,
+        .next_leaf = first_leaf,
+    };
+    ih_->disk_manager_->write_page(ih_->fd_, IX_LEAF_HEADER_PAGE, page.data(), PAGE_SIZE);
+
+    file_hdr_->root_page_ = levels_.back().first_page;
+    file_hdr_->first_leaf_ = first_leaf;
+    file_hdr_->last_leaf_ = last_leaf;
+    file_hdr_->num_pages_ = batch_first_page_;
+    ih_->disk_manager_->set_fd2pageno(ih_->fd_, batch_first_page_);
+}
+
+/**
+ * @brief 一层有num_entries个条目时的结点个数：按填充率计算，但除根结点外每个结点不少于min_size个条目
+ */
+size_t IxBulkBuilder::count_nodes(size_t num_entries) const {
+    int max_size = file_hdr_->btree_order_ + 1;
+    size_t min_size = max_size / 2;
+    size_t fill = std::max(min_size, static_cast<size_t>(file_hdr_->btree_order_ * IX_BULK_FILL_FACTOR));
+    size_t num_nodes = std::max<size_t>((num_entries + fill - 1) / fill, 1);
+    // 此时num_entries > (num_nodes - 1) * fill，减少一个结点后平均每个结点不超过1.5倍min_size，或只剩一个结点且不会分裂
+    if (num_nodes > 1 && num_entries / num_nodes < min_size) {
+        num_nodes--;
+    }
+    return num_nodes;
+}
+
+/* 条目平均分配：前num_entries % num_nodes个结点各多一个条目 */
+size_t IxBulkBuilder::node_size(const Level &level, size_t node) const {
+    return level.num_entries / level.num_nodes + (node < level.num_entries % level.num_nodes ? 1 : 0);
+}
+
+/* 第entry个条目所在的结点 */
+size_t IxBulkBuilder::node_of(const Level &level, size_t entry) const {
+    size_t base = level.num_entries / level.num_nodes;
+    size_t larger = level.num_entries % level.num_nodes;
+    size_t cutoff = (base + 1) * larger;
+    return entry < cutoff ? entry / (base + 1) : larger + (entry - cutoff) / base;
+}
+
+/**
+ * @brief 向当前层的当前结点追加一个条目，结点的第一个条目到来时初始化页头
+ */
+void IxBulkBuilder::add_entry(const char *key, const Rid &rid) {
+    const Level &level = levels_[level_];
+    int key_len = file_hdr_->col_tot_len_;
+    if (pos_ == 0) {
+        if (batch_pages_ == SEQ_IO_PAGES) {
+            flush();
+        }
+        page_id_t page_no = level.first_page + static_cast<page_id_t>(node_);
+        assert(page_no == batch_first_page_ + batch_pages_);
+        char *page = batch_.data() + batch_pages_ * PAGE_SIZE;
+        memset(page, 0, PAGE_SIZE);
+        batch_pages_++;
+
+        bool is_leaf = level_ == 0;
+        bool is_last = node_ + 1 == level.num_nodes;
+        page_id_t parent = IX_NO_PAGE;
+        if (level_ + 1 < levels_.size()) {
+            const Level &parent_level = levels_[level_ + 1];
+            parent = parent_level.first_page + static_cast<page_id_t>(node_of(parent_level, node_));
+        }
+        *reinterpret_cast<IxPageHdr *>(page) = {
+            .next_free_page_no = IX_NO_PAGE,
+            .parent = parent,
+            .num_key = static_cast<int>(node_size(level, node_)),
+            .is_leaf = is_leaf,
+            .prev_leaf = !is_leaf ? IX_NO_PAGE : (node_ == 0 ? IX_LEAF_HEADER_PAGE : page_no - 1),
+            .next_leaf = !is_leaf ? IX_NO_PAGE : (is_last ? IX_LEAF_HEADER_PAGE : page_no + 1),
+        };
+        node_keys_.insert(node_keys_.end(), key, key + key_len);
+    }
+    char *page = batch_.data() + (batch_pages_ - 1) * PAGE_SIZE;
+    memcpy(page + sizeof(IxPageHdr) + pos_ * key_len, key, key_len);
+    memcpy(page + sizeof(IxPageHdr) + file_hdr_->keys_size_ + pos_ * sizeof(Rid), &rid, sizeof(Rid));
+    if (++pos_ == node_size(level, node_)) {
+        pos_ = 0;
+        node_++;
+    }
+}
+
+void IxBulkBuilder::flush() {
+    if (batch_pages_ == 0) {
+        return;
+    }
+    ih_->disk_manager_->write_page(ih_->fd_, batch_first_page_, batch_.data(), batch_pages_ * PAGE_SIZE);
+    batch_first_page_ += batch_pages_;
+    batch_pages_ = 0;
+}
@@ -0,0 +1,61 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "ix_index_handle.h"
+
+/**
+ * 自底向上批量构建B+树：键值对按升序给出，条目总数事先已知，因此树的形状可以直接算出，
+ * 每一层的条目平均分到该层的各个结点中（填充率IX_BULK_FILL_FACTOR，且不少于min_size）。
+ * 页面按叶子层、各内部结点层、根结点的顺序连续编号，绕过缓冲池每SEQ_IO_PAGES个页面顺序写一次磁盘。
+ * 只能用于刚创建、还没有任何页面进入缓冲池的空索引。
+ */
+class IxBulkBuilder {
+   private:
+    /* 树的一层 */
+    struct Level {
+        size_t num_entries;         // 该层所有结点的键值对总数
+        size_t num_nodes;           // 该层的结点个数
+        page_id_t first_page;       // 该层第一个结点的页号，同一层结点的页号连续
+    };
+
+    IxIndexHandle *ih_;
+    IxFileHdr *file_hdr_;
+    std::vector<Level> levels_;     // levels_[0]为叶子层，最后一层为根结点
+    size_t num_added_ = 0;          // 已加入叶子层的键值对个数
+
+    size_t level_ = 0;              // 当前正在构建的层
+    size_t node_ = 0;               // 当前结点在层中的下标
+    size_t pos_ = 0;                // 当前结点中下一个键值对的位置
+    std::vector<char> node_keys_;   // 当前层每个结点的最小键，作为上一层的键
+
+    std::vector<char> batch_;       // 尚未写入磁盘的页面
+    page_id_t batch_first_page_;
+    int batch_pages_ = 0;
+
+   public:
+    IxBulkBuilder(IxIndexHandle *ih, size_t num_entries);
+
+    void append(const char *key, const Rid &rid);
+
+    void finish();
+
+   private:
+    size_t count_nodes(size_t num_entries) const;
+
+    size_t node_size(const Level &level, size_t node) const;
+
+    size_t node_of(const Level &level, size_t entry) const;
+
+    void add_entry(const char *key, const Rid &rid);
+
+    void flush();
+};
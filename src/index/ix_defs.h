@@ -21,6 +21,13 @@ constexpr int IX_LEAF_HEADER_PAGE = 1;
 constexpr int IX_INIT_ROOT_PAGE = 2;
 constexpr int IX_INIT_NUM_PAGES = 3;
 constexpr int IX_MAX_COL_LEN = 512;
+constexpr double IX_BULK_FILL_FACTOR = 0.9;     // 自底向上批量构建时结点的填充率，留出少量空间给之后的插入
+constexpr bool IX_COUNTED_BTREE = true;         // 新建的索引是否在内部结点中维护每棵子树的键值对个数
+
+// 三元组倒排索引：第0页为文件头，其余每页存放一个三元组的一段倒排表
+constexpr int TGM_FILE_HDR_PAGE = 0;
+constexpr int TGM_INIT_NUM_PAGES = 1;
+constexpr uint32_t TGM_FREE_PAGE = 0xffffffff;  // 空闲页面的三元组标记，三元组编码只用低24位
 
 class IxFileHdr {
 public: 
@@ -37,6 +44,7 @@ public:
     page_id_t first_leaf_;              // 首叶节点对应的页号，在上层IxManager的open函数进行初始化，初始化为root page_no
     page_id_t last_leaf_;               // 尾叶节点对应的页号
     int tot_len_;                       // 记录结构体的整体长度
+    bool counted_ = false;              // 内部结点的每个rid的slot_no是否为对应子树中的键值对个数，旧的索引文件中没有该字段
 
     IxFileHdr() {
         tot_len_ = col_num_ = 0;
@@ -51,7 +59,7 @@ public:
 
     void update_tot_len() {
         tot_len_ = 0;
-        tot_len_ += sizeof(page_id_t) * 4 + sizeof(int) * 6;
+        tot_len_ += sizeof(page_id_t) * 4 + sizeof(int) * 7;
         tot_len_ += sizeof(ColType) * col_num_ + sizeof(int) * col_num_;
     }
 
@@ -85,6 +93,9 @@ public:
         offset += sizeof(page_id_t);
         memcpy(dest + offset, &last_leaf_, sizeof(page_id_t));
         offset += sizeof(page_id_t);
+        int counted = counted_;
+        memcpy(dest + offset, &counted, sizeof(int));
+        offset += sizeof(int);
         assert(offset == tot_len_);
     }
 
@@ -122,6 +133,10 @@ public:
         offset += sizeof(page_id_t);
         last_leaf_ = *reinterpret_cast<const page_id_t*>(src + offset);
         offset += sizeof(page_id_t);
+        if (offset < tot_len_) {
+            counted_ = *reinterpret_cast<const int*>(src + offset) != 0;
+            offset += sizeof(int);
+        }
         assert(offset == tot_len_);
     }
 };
@@ -144,4 +159,18 @@ public:
     friend bool operator==(const Iid &x, const Iid &y) { return x.page_no == y.page_no && x.slot_no == y.slot_no; }
 
     friend bool operator!=(const Iid &x, const Iid &y) { return !(x == y); }
-};
\ No newline at end of file
+};
+
+/* 三元组倒排索引的文件头 */
+struct TgmFileHdr {
+    int num_pages;      // 文件中页面的数量，包括文件头
+    int col_len;        // 被索引的CHAR字段的长度
+};
+
+/* 倒排页面的页头，其后紧跟num_rids个Rid */
+struct TgmPageHdr {
+    uint32_t trigram;   // 页面所属的三元组，空闲页面为TGM_FREE_PAGE
+    int num_rids;
+};
+
+constexpr int TGM_RIDS_PER_PAGE = static_cast<int>((PAGE_SIZE - sizeof(TgmPageHdr)) / sizeof(Rid));
@@ -161,26 +161,27 @@ int IxNodeHandle::insert(const char *key, const Rid &value) {
 }
 
 /**
- * @brief 用于在结点中的指定位置删除单个键值对
+ * @brief 用于在结点中的指定位置删除连续的n个键值对
  *
- * @param pos 要删除键值对的位置
+ * @param pos 要删除的第一个键值对的位置
+ * @param n 要删除的键值对个数
  */
-void IxNodeHandle::erase_pair(int pos) {
-    assert(pos >= 0 && pos < page_hdr->num_key);
+void IxNodeHandle::erase_pairs(int pos, int n) {
+    assert(pos >= 0 && n >= 0 && pos + n <= page_hdr->num_key);
     //计算需要移动的剩余键值对数
     int key_size = file_hdr->col_tot_len_;
-    int move_key_bytes = (page_hdr->num_key - pos - 1) * key_size;
+    int move_key_bytes = (page_hdr->num_key - pos - n) * key_size;
     //移动key
     if (move_key_bytes > 0) {
-        memmove(keys + pos * key_size, keys + (pos + 1) * key_size, move_key_bytes);
+        memmove(keys + pos * key_size, keys + (pos + n) * key_size, move_key_bytes);
     }
     //移动rid
-    int move_rid_bytes = (page_hdr->num_key - pos - 1) * sizeof(Rid);
+    int move_rid_bytes = (page_hdr->num_key - pos - n) * sizeof(Rid);
     if (move_rid_bytes > 0) {
-        memmove(&rids[pos], &rids[pos + 1], move_rid_bytes);
+        memmove(&rids[pos], &rids[pos + n], move_rid_bytes);
     }
     //更新键值对数
-    page_hdr->num_key--;
+    page_hdr->num_key -= n;
 }
 
 /**
@@ -212,9 +213,11 @@ IxIndexHandle::IxIndexHandle(DiskManager *disk_manager, BufferPoolManager *buffe
     file_hdr_->deserialize(buf);
     delete[] buf;
 
-    // disk_manager管理的fd对应的文件中，设置从file_hdr_->num_pages开始分配page_no
+    // disk_manager管理的fd对应的文件中，设置从文件末尾开始分配page_no
+    // 删除结点后file_hdr_->num_pages会减少但页面不回收，批量构建的索引也可能远大于初始的3个页面，因此以文件大小为准
     int now_page_no = disk_manager_->get_fd2pageno(fd);
-    disk_manager_->set_fd2pageno(fd, now_page_no + 1);
+    int file_pages = disk_manager_->get_file_size(disk_manager_->get_file_name(fd)) / PAGE_SIZE;
+    disk_manager_->set_fd2pageno(fd, std::max(now_page_no + 1, file_pages));
 }
 
 /**
@@ -292,6 +295,97 @@ bool IxIndexHandle::get_value(const char *key, std::vector<Rid> *result, Transac
     return found;
 }
 
+/**
+ * @brief 查找与key相邻的已有键值对（前驱和后继）的rid，只在key所在的叶子结点中查找
+ * 聚簇表插入时用它决定新记录存放的页面
+ *
+ * @param key 目标key值
+ * @param rids 用于存放相邻键值对的rid，前驱在前
+ */
+void IxIndexHandle::get_neighbor_rids(const char *key, std::vector<Rid> *rids) {
+    auto [leaf, root_is_latched] = find_leaf_page(key, Operation::FIND, nullptr);
+    if (leaf == nullptr) {
+        return;
+    }
+
+    int pos = leaf->lower_bound(key);
+    if (pos > 0) {
+        rids->push_back(*leaf->get_rid(pos - 1));
+    }
+    if (pos < leaf->get_size()) {
+        rids->push_back(*leaf->get_rid(pos));
+    }
+
+    buffer_pool_manager_->unpin_page(leaf->get_page_id(), false);
+    delete leaf;
+    if (root_is_latched) {
+        root_latch_.unlock();
+    }
+}
+
+/**
+ * @description: 批量点查询，用于连接、IN列表等需要大量查找索引的场景
+ *               组内的查找按层交错执行：每一层先为所有查找取出结点并预取结点头部，再读取结点大小并预取
+ *               二分查找最先比较的key，最后才在结点内查找。这样一个查找的缓存缺失可以与组内其他查找重叠
+ * @return 找到的key的个数
+ * @param {vector<const char*>&} keys 需要查找的key
+ * @param {vector<Rid>*} result 传出参数，与keys一一对应，found中对应位置为false时无意义
+ * @param {vector<bool>*} found 传出参数，记录每个key是否存在
+ * @param {Transaction*} transaction 事务指针
+ * @param {int} group_size 交错执行的查找个数
+ */
+int IxIndexHandle::get_values(const std::vector<const char *> &keys, std::vector<Rid> *result, std::vector<bool> *found,
+                              Transaction *transaction, int group_size) {
+    result->assign(keys.size(), Rid{INVALID_PAGE_ID, -1});
+    found->assign(keys.size(), false);
+    if (file_hdr_->root_page_ == IX_NO_PAGE) {
+        return 0;
+    }
+
+    group_size = std::max(group_size, 1);
+    int num_found = 0;
+    std::vector<page_id_t> page_nos(group_size);
+    std::vector<IxNodeHandle> nodes(group_size);
+    for (size_t begin = 0; begin < keys.size(); begin += group_size) {
+        int n = static_cast<int>(std::min(keys.size() - begin, static_cast<size_t>(group_size)));
+        std::fill_n(page_nos.begin(), n, file_hdr_->root_page_);
+        int active = n;
+        while (active > 0) {
+            // 1. 取出各个查找的下一层结点，预取结点头部
+            for (int i = 0; i < n; ++i) {
+                if (page_nos[i] == INVALID_PAGE_ID) continue;
+                nodes[i] = IxNodeHandle(file_hdr_, buffer_pool_manager_->fetch_page(PageId{fd_, page_nos[i]}));
+                nodes[i].prefetch_header();
+            }
+            // 2. 结点头部已在途，读取结点大小并预取二分查找用到的key
+            for (int i = 0; i < n; ++i) {
+                if (page_nos[i] == INVALID_PAGE_ID) continue;
+                nodes[i].prefetch_keys();
+            }
+            // 3. 结点内查找，叶子结点上得到结果，内部结点上得到下一层的页面
+            for (int i = 0; i < n; ++i) {
+                if (page_nos[i] == INVALID_PAGE_ID) continue;
+                IxNodeHandle &node = nodes[i];
+                const char *key = keys[begin + i];
+                if (node.is_leaf_page()) {
+                    Rid *value = nullptr;
+                    if (node.leaf_lookup(key, &value)) {
+                        (*result)[begin + i] = *value;
+                        (*found)[begin + i] = true;
+                        ++num_found;
+                    }
+                    page_nos[i] = INVALID_PAGE_ID;
+                    --active;
+                } else {
+                    page_nos[i] = node.internal_lookup(key);
+                }
+                buffer_pool_manager_->unpin_page(node.get_page_id(), false);
+            }
+        }
+    }
+    return num_found;
+}
+
 /**
  * @brief  将传入的一个node拆分(Split)成两个结点，在node的右边生成一个新结点new node
  * @param node 需要拆分的结点
@@ -365,8 +459,8 @@ void IxIndexHandle::insert_into_parent(IxNodeHandle *old_node, const char *key,
         new_root->page_hdr->is_leaf = false;
         new_root->set_parent_page_no(IX_NO_PAGE);
 
-        new_root->insert_pair(0, old_node->get_key(0), {old_node->get_page_no(), -1});
-        new_root->insert_pair(1, key, {new_node->get_page_no(), -1});
+        new_root->insert_pair(0, old_node->get_key(0), child_rid(old_node));
+        new_root->insert_pair(1, key, child_rid(new_node));
 
         old_node->set_parent_page_no(new_root->get_page_no());
         new_node->set_parent_page_no(new_root->get_page_no());
@@ -387,8 +481,9 @@ void IxIndexHandle::insert_into_parent(IxNodeHandle *old_node, const char *key,
     IxNodeHandle *parent = fetch_node(old_node->get_parent_page_no());
     //获取key对应的rid
     int index = parent->find_child(old_node);
-    //并将(key, rid)插入到父亲结点
-    parent->insert_pair(index + 1, key, {new_node->get_page_no(), -1});
+    //并将(key, rid)插入到父亲结点，old_node分裂后子树大小也变了
+    parent->insert_pair(index + 1, key, child_rid(new_node));
+    *parent->get_rid(index) = child_rid(old_node);
     new_node->set_parent_page_no(parent->get_page_no());
 
     //如果父亲结点仍需要继续分裂，则进行递归插入
@@ -447,6 +542,8 @@ page_id_t IxIndexHandle::insert_entry(const char *key, const Rid &value, Transac
     } else {
         maintain_parent(leaf);
     }
+    // 分裂产生的结点在插入父结点时已经记录了子树大小，这里更新leaf到根结点路径上的计数
+    maintain_counts(leaf);
 
     buffer_pool_manager_->unpin_page(leaf->get_page_id(), true);
     delete leaf;
@@ -485,6 +582,7 @@ bool IxIndexHandle::delete_entry(const char *key, Transaction *transaction) {
             leaf_deleted = coalesce_or_redistribute(leaf, transaction, &root_is_latched);
         } else {
             maintain_parent(leaf);
+            maintain_counts(leaf);
         }
     }
 
@@ -500,6 +598,70 @@ bool IxIndexHandle::delete_entry(const char *key, Transaction *transaction) {
     return removed;
 }
 
+/**
+ * @brief 删除key在[lower, upper]中的所有键值对
+ * 每次找到范围内第一个键值对所在的叶子，用一次移动删除该叶子中落在范围内的所有键值对，再做一次合并或重分配；
+ * 完全落在范围内的叶子被删空，与兄弟结点合并后从叶子链表和父结点中摘除。结构修改的次数与涉及的叶子数相同，而不是与键值对数相同
+ *
+ * @param lower 范围的下界（包含）
+ * @param upper 范围的上界（包含）
+ * @param transaction 事务指针
+ * @return int 删除的键值对个数
+ */
+int IxIndexHandle::delete_range(const char *lower, const char *upper, Transaction *transaction) {
+    int removed = 0;
+    bool done = false;
+    while (!done) {
+        auto [leaf, root_is_latched] = find_leaf_page(lower, Operation::DELETE, transaction);
+        if (leaf == nullptr) {
+            if (root_is_latched) {
+                root_latch_.unlock();
+            }
+            break;
+        }
+        int begin = leaf->lower_bound(lower);
+        // lower大于叶子中所有的key时，范围从下一个叶子开始
+        if (begin == leaf->get_size() && leaf->get_next_leaf() != IX_NO_PAGE &&
+            leaf->get_next_leaf() != IX_LEAF_HEADER_PAGE) {
+            IxNodeHandle *next = fetch_node(leaf->get_next_leaf());
+            buffer_pool_manager_->unpin_page(leaf->get_page_id(), false);
+            delete leaf;
+            leaf = next;
+            begin = 0;
+        }
+        int old_size = leaf->get_size();
+        int end = leaf->upper_bound(upper);
+        // 叶子中还有大于upper的key，或者已经是最后一个叶子，删除后范围内不再有键值对
+        done = end < old_size || leaf->get_next_leaf() == IX_NO_PAGE || leaf->get_next_leaf() == IX_LEAF_HEADER_PAGE;
+
+        bool leaf_deleted = false;
+        if (end > begin) {
+            leaf->erase_pairs(begin, end - begin);
+            removed += end - begin;
+            int new_size = leaf->get_size();
+            if (leaf->is_root_page()) {
+                adjust_root(leaf);
+            } else if (new_size < leaf->get_min_size()) {
+                leaf_deleted = coalesce_or_redistribute(leaf, transaction, &root_is_latched);
+            } else {
+                maintain_parent(leaf);
+                maintain_counts(leaf);
+            }
+        } else {
+            done = true;
+        }
+
+        if (!leaf_deleted) {
+            buffer_pool_manager_->unpin_page(leaf->get_page_id(), end > begin);
+            delete leaf;
+        }
+        if (root_is_latched) {
+            root_latch_.unlock();
+        }
+    }
+    return removed;
+}
+
 /**
  * @brief 用于处理合并和重分配的逻辑，用于删除键值对后调用
  *
@@ -527,10 +689,12 @@ bool IxIndexHandle::coalesce_or_redistribute(IxNodeHandle *node, Transaction *tr
 
     bool node_removed = false;
     bool neighbor_removed = false;
+    bool parent_removed = false;
 
     //如果node结点和兄弟结点的键值对数量之和，能够支撑两个B+树结点（即node.size+neighbor.size >=
     //NodeMinSize*2)
-    if (neighbor->get_size() + node->get_size() <= neighbor->get_max_size()) {
+    //结点在插入后达到max_size时立即分裂，合并后的结点也必须小于max_size，否则下一次插入会越过页面末尾
+    if (neighbor->get_size() + node->get_size() < neighbor->get_max_size()) {
         //否则需要合并两个结点，将右边的结点合并到左边的结点（调用Coalesce函数）
         if (neighbor_is_left) {
             coalesce(&neighbor, &node, &parent, index, transaction, root_is_latched);
@@ -543,22 +707,28 @@ bool IxIndexHandle::coalesce_or_redistribute(IxNodeHandle *node, Transaction *tr
         if (parent->is_root_page()) {
             adjust_root(parent);
         } else if (parent->get_size() < parent->get_min_size()) {
-            coalesce_or_redistribute(parent, transaction, root_is_latched);
+            // parent被合并到左兄弟时，其句柄已在coalesce中释放
+            parent_removed = coalesce_or_redistribute(parent, transaction, root_is_latched);
         } else {
             maintain_parent(parent);
+            maintain_counts(parent);
         }
     } else {
         //则只需要重新分配键值对（调用Redistribute函数）
         redistribute(neighbor, node, parent, index);
         maintain_parent(parent);
+        set_child_count(parent, neighbor);
+        maintain_counts(node);
     }
 
     if (!neighbor_removed) {
         buffer_pool_manager_->unpin_page(neighbor->get_page_id(), true);
         delete neighbor;
     }
-    buffer_pool_manager_->unpin_page(parent->get_page_id(), true);
-    delete parent;
+    if (!parent_removed) {
+        buffer_pool_manager_->unpin_page(parent->get_page_id(), true);
+        delete parent;
+    }
 
     return node_removed;
 }
@@ -581,14 +751,7 @@ bool IxIndexHandle::adjust_root(IxNodeHandle *old_root_node) {
         return true;
     }
 
-    //如果old_root_node是叶结点，且大小为0，则直接更新root page
-    if (old_root_node->is_leaf_page() && old_root_node->get_size() == 0) {
-        update_root_page_no(IX_NO_PAGE);
-        file_hdr_->first_leaf_ = IX_NO_PAGE;
-        file_hdr_->last_leaf_ = IX_NO_PAGE;
-        return true;
-    }
-
+    //如果old_root_node是叶结点，即使大小为0也保留为根结点，与新建索引时一样，之后的插入仍然从这个叶子开始
     return false;
 }
 
@@ -682,6 +845,7 @@ bool IxIndexHandle::coalesce(IxNodeHandle **neighbor_node, IxNodeHandle **node,
     //删除parent中node结点的信息
     int parent_index = (*parent)->find_child(right);
     (*parent)->erase_pair(parent_index);
+    set_child_count(*parent, left);
 
     maintain_parent(left);
 
@@ -706,10 +870,13 @@ Rid IxIndexHandle::get_rid(const Iid &iid) const {
     IxNodeHandle *node = fetch_node(iid.page_no);
     if (iid.slot_no >= node->get_size()) {
         buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+        delete node;
         throw IndexEntryNotFoundError();
     }
+    Rid rid = *node->get_rid(iid.slot_no);
     buffer_pool_manager_->unpin_page(node->get_page_id(), false);  // unpin it!
-    return *node->get_rid(iid.slot_no);
+    delete node;
+    return rid;
 }
 
 /**
@@ -886,4 +1053,122 @@ void IxIndexHandle::maintain_child(IxNodeHandle *node, int child_idx) {
         child->set_parent_page_no(node->get_page_no());
         buffer_pool_manager_->unpin_page(child->get_page_id(), true);
     }
-}
\ No newline at end of file
+}
+/**
+ * @brief 子树中的键值对个数：叶子结点为结点大小，内部结点为各个孩子的计数之和
+ */
+int IxIndexHandle::subtree_count(IxNodeHandle *node) const {
+    if (node->is_leaf_page()) {
+        return node->get_size();
+    }
+    int count = 0;
+    for (int i = 0; i < node->get_size(); i++) {
+        count += node->get_rid(i)->slot_no;
+    }
+    return count;
+}
+
+/**
+ * @brief 内部结点中指向child的rid，计数的B+树在slot_no中存放子树大小，否则为-1
+ */
+Rid IxIndexHandle::child_rid(IxNodeHandle *child) const {
+    return Rid{child->get_page_no(), file_hdr_->counted_ ? subtree_count(child) : -1};
+}
+
+/**
+ * @brief 重新计算parent中child的子树大小
+ */
+void IxIndexHandle::set_child_count(IxNodeHandle *parent, IxNodeHandle *child) {
+    if (file_hdr_->counted_) {
+        parent->get_rid(parent->find_child(child))->slot_no = subtree_count(child);
+    }
+}
+
+/**
+ * @brief 从node开始向上重新计算每个结点在其父结点中的子树大小，直到根结点
+ * @note node的子树大小必须已经正确，路径外的结点的计数不受影响
+ */
+void IxIndexHandle::maintain_counts(IxNodeHandle *node) {
+    if (!file_hdr_->counted_) {
+        return;
+    }
+    IxNodeHandle *curr = node;
+    while (!curr->is_root_page()) {
+        IxNodeHandle *parent = fetch_node(curr->get_parent_page_no());
+        set_child_count(parent, curr);
+        if (curr != node) {
+            buffer_pool_manager_->unpin_page(curr->get_page_id(), true);
+            delete curr;
+        }
+        curr = parent;
+    }
+    if (curr != node) {
+        buffer_pool_manager_->unpin_page(curr->get_page_id(), true);
+        delete curr;
+    }
+}
+
+/**
+ * @brief iid之前的键值对个数：iid的slot_no加上从叶子到根结点路径上每一层左侧兄弟子树的大小
+ * @note 只能用于计数的B+树，iid可以是slot_no等于结点大小的末尾位置
+ */
+size_t IxIndexHandle::rank(const Iid &iid) const {
+    assert(file_hdr_->counted_);
+    if (is_empty() || iid.page_no == IX_NO_PAGE) {
+        return 0;
+    }
+    size_t rank = iid.slot_no;
+    IxNodeHandle *node = fetch_node(iid.page_no);
+    while (!node->is_root_page()) {
+        IxNodeHandle *parent = fetch_node(node->get_parent_page_no());
+        int child_idx = parent->find_child(node);
+        for (int i = 0; i < child_idx; i++) {
+            rank += parent->get_rid(i)->slot_no;
+        }
+        buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+        delete node;
+        node = parent;
+    }
+    buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+    delete node;
+    return rank;
+}
+
+/**
+ * @brief 第n个（从0开始）键值对的位置，按子树大小从根结点直接下降到叶子
+ * @return n不小于键值对总数时返回leaf_end()
+ */
+Iid IxIndexHandle::iid_at(size_t n) const {
+    assert(file_hdr_->counted_);
+    if (is_empty()) {
+        return Iid{-1, -1};
+    }
+    IxNodeHandle *node = fetch_node(file_hdr_->root_page_);
+    while (!node->is_leaf_page()) {
+        int child_idx = 0;
+        for (; child_idx + 1 < node->get_size(); child_idx++) {
+            size_t count = node->get_rid(child_idx)->slot_no;
+            if (n < count) {
+                break;
+            }
+            n -= count;
+        }
+        IxNodeHandle *child = fetch_node(node->value_at(child_idx));
+        buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+        delete node;
+        node = child;
+    }
+    Iid iid = {.page_no = node->get_page_no(), .slot_no = static_cast<int>(std::min<size_t>(n, node->get_size()))};
+    buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+    delete node;
+    return iid;
+}
+
+/**
+ * @brief [lower, upper)中的键值对个数，两次从叶子到根结点的遍历，不扫描叶子
+ */
+size_t IxIndexHandle::count_range(const Iid &lower, const Iid &upper) const {
+    size_t begin = rank(lower);
+    size_t end = rank(upper);
+    return end > begin ? end - begin : 0;
+}
@@ -17,6 +17,8 @@ enum class Operation { FIND = 0, INSERT, DELETE };  // 三种操作：查找、
 
 static const bool binary_search = false;
 
+static constexpr int IX_PROBE_GROUP_SIZE = 16;  // 批量查找时交错执行的查找个数
+
 inline int ix_compare(const char *a, const char *b, ColType type, int col_len) {
     switch (type) {
         case TYPE_INT: {
@@ -29,6 +31,12 @@ inline int ix_compare(const char *a, const char *b, ColType type, int col_len) {
             float fb = *(float *)b;
             return (fa < fb) ? -1 : ((fa > fb) ? 1 : 0);
         }
+        case TYPE_BIGINT:
+        case TYPE_DATETIME: {
+            int64_t la = *(int64_t *)a;
+            int64_t lb = *(int64_t *)b;
+            return (la < lb) ? -1 : ((la > lb) ? 1 : 0);
+        }
         case TYPE_STRING:
             return memcmp(a, b, col_len);
         default:
@@ -112,6 +120,17 @@ class IxNodeHandle {
 
     int upper_bound(const char *target) const;
 
+    /* 预取结点头部所在的缓存行 */
+    void prefetch_header() const { __builtin_prefetch(page_hdr); }
+
+    /* 预取二分查找最先比较的key：中点和两个四分位点，调用前应已预取结点头部 */
+    void prefetch_keys() const {
+        int n = page_hdr->num_key;
+        __builtin_prefetch(get_key(n / 2));
+        __builtin_prefetch(get_key(n / 4));
+        __builtin_prefetch(get_key(n * 3 / 4));
+    }
+
     void insert_pairs(int pos, const char *key, const Rid *rid, int n);
 
     page_id_t internal_lookup(const char *key);
@@ -123,7 +142,10 @@ class IxNodeHandle {
     // 用于在结点中的指定位置插入单个键值对
     void insert_pair(int pos, const char *key, const Rid &rid) { insert_pairs(pos, key, &rid, 1); }
 
-    void erase_pair(int pos);
+    void erase_pairs(int pos, int n);
+
+    // 用于在结点中的指定位置删除单个键值对
+    void erase_pair(int pos) { erase_pairs(pos, 1); }
 
     int remove(const char *key);
 
@@ -161,6 +183,7 @@ class IxNodeHandle {
 class IxIndexHandle {
     friend class IxScan;
     friend class IxManager;
+    friend class IxBulkBuilder;
 
    private:
     DiskManager *disk_manager_;
@@ -172,9 +195,16 @@ class IxIndexHandle {
    public:
     IxIndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd);
 
+    int get_fd() const { return fd_; }
+
     // for search
     bool get_value(const char *key, std::vector<Rid> *result, Transaction *transaction);
 
+    int get_values(const std::vector<const char *> &keys, std::vector<Rid> *result, std::vector<bool> *found,
+                   Transaction *transaction, int group_size = IX_PROBE_GROUP_SIZE);
+
+    void get_neighbor_rids(const char *key, std::vector<Rid> *rids);
+
     std::pair<IxNodeHandle *, bool> find_leaf_page(const char *key, Operation operation, Transaction *transaction,
                                                  bool find_first = false);
 
@@ -188,6 +218,8 @@ class IxIndexHandle {
     // for delete
     bool delete_entry(const char *key, Transaction *transaction);
 
+    int delete_range(const char *lower, const char *upper, Transaction *transaction);
+
     bool coalesce_or_redistribute(IxNodeHandle *node, Transaction *transaction = nullptr,
                                 bool *root_is_latched = nullptr);
     bool adjust_root(IxNodeHandle *old_root_node);
@@ -205,6 +237,15 @@ class IxIndexHandle {
 
     Iid leaf_begin() const;
 
+    // for counted b+tree
+    bool is_counted() const { return file_hdr_->counted_; }
+
+    size_t rank(const Iid &iid) const;
+
+    Iid iid_at(size_t n) const;
+
+    size_t count_range(const Iid &lower, const Iid &upper) const;
+
    private:
     // 辅助函数
     void update_root_page_no(page_id_t root) { file_hdr_->root_page_ = root; }
@@ -225,6 +266,15 @@ class IxIndexHandle {
 
     void maintain_child(IxNodeHandle *node, int child_idx);
 
+    // for counted b+tree
+    int subtree_count(IxNodeHandle *node) const;
+
+    Rid child_rid(IxNodeHandle *child) const;
+
+    void set_child_count(IxNodeHandle *parent, IxNodeHandle *child);
+
+    void maintain_counts(IxNodeHandle *node);
+
     // for index test
     Rid get_rid(const Iid &iid) const;
 };
\ No newline at end of file
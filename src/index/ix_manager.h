@@ -16,6 +16,7 @@ See the Mulan PSL v2 for more details. */
 #include "system/sm_meta.h"
 #include "ix_defs.h"
 #include "ix_index_handle.h"
+#include "ix_trigram.h"
 
 class IxManager {
    private:
@@ -86,6 +87,7 @@ class IxManager {
             fhdr->col_types_.push_back(index_cols[i].type);
             fhdr->col_lens_.push_back(index_cols[i].len);
         }
+        fhdr->counted_ = IX_COUNTED_BTREE;
         fhdr->update_tot_len();
         
         char* data = new char[fhdr->tot_len_];
@@ -164,4 +166,39 @@ class IxManager {
         buffer_pool_manager_->flush_all_pages(ih->fd_);
         disk_manager_->close_file(ih->fd_);
     }
+
+    /* 字段上的三元组倒排索引文件名 */
+    std::string get_trigram_name(const std::string &filename, const std::string &col_name) {
+        return filename + "_" + col_name + ".tgm";
+    }
+
+    void create_trigram(const std::string &filename, const ColMeta &col) {
+        std::string tgm_name = get_trigram_name(filename, col.name);
+        disk_manager_->create_file(tgm_name);
+        int fd = disk_manager_->open_file(tgm_name);
+        char page_buf[PAGE_SIZE];
+        memset(page_buf, 0, PAGE_SIZE);
+        TgmFileHdr fhdr = {.num_pages = TGM_INIT_NUM_PAGES, .col_len = col.len};
+        memcpy(page_buf, &fhdr, sizeof(TgmFileHdr));
+        disk_manager_->write_page(fd, TGM_FILE_HDR_PAGE, page_buf, PAGE_SIZE);
+        disk_manager_->close_file(fd);
+    }
+
+    void destroy_trigram(const std::string &filename, const std::string &col_name) {
+        disk_manager_->destroy_file(get_trigram_name(filename, col_name));
+    }
+
+    std::unique_ptr<IxTrigramHandle> open_trigram(const std::string &filename, const std::string &col_name) {
+        int fd = disk_manager_->open_file(get_trigram_name(filename, col_name));
+        return std::make_unique<IxTrigramHandle>(disk_manager_, buffer_pool_manager_, fd);
+    }
+
+    void close_trigram(const IxTrigramHandle *th) {
+        char page_buf[PAGE_SIZE];
+        memset(page_buf, 0, PAGE_SIZE);
+        memcpy(page_buf, &th->file_hdr_, sizeof(TgmFileHdr));
+        disk_manager_->write_page(th->fd_, TGM_FILE_HDR_PAGE, page_buf, PAGE_SIZE);
+        buffer_pool_manager_->flush_all_pages(th->fd_);
+        disk_manager_->close_file(th->fd_);
+    }
 };
\ No newline at end of file
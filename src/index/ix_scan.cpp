@@ -26,6 +26,8 @@ void IxScan::next() {
         iid_.slot_no = 0;
         iid_.page_no = node->get_next_leaf();
     }
+    ih_->buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+    delete node;
 }
 
 Rid IxScan::rid() const {
@@ -0,0 +1,236 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "ix_trigram.h"
+
+#include <algorithm>
+
+static bool rid_less(const Rid &x, const Rid &y) {
+    return x.page_no < y.page_no || (x.page_no == y.page_no && x.slot_no < y.slot_no);
+}
+
+static uint32_t make_trigram(const char *s) {
+    return (static_cast<uint32_t>(static_cast<unsigned char>(s[0])) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(s[1])) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(s[2]));
+}
+
+static TgmPageHdr *page_hdr(Page *page) { return reinterpret_cast<TgmPageHdr *>(page->get_data()); }
+
+static Rid *page_rids(Page *page) { return reinterpret_cast<Rid *>(page->get_data() + sizeof(TgmPageHdr)); }
+
+IxTrigramHandle::IxTrigramHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd)
+    : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), fd_(fd) {
+    char buf[PAGE_SIZE];
+    disk_manager_->read_page(fd, TGM_FILE_HDR_PAGE, buf, PAGE_SIZE);
+    memcpy(&file_hdr_, buf, sizeof(TgmFileHdr));
+
+    // 与IxIndexHandle相同，从文件末尾开始分配新页面
+    int now_page_no = disk_manager_->get_fd2pageno(fd);
+    int file_pages = disk_manager_->get_file_size(disk_manager_->get_file_name(fd)) / PAGE_SIZE;
+    disk_manager_->set_fd2pageno(fd, std::max(now_page_no + 1, std::max(file_pages, file_hdr_.num_pages)));
+
+    // 扫描所有倒排页面重建目录
+    for (page_id_t page_no = TGM_INIT_NUM_PAGES; page_no < file_hdr_.num_pages; page_no++) {
+        Page *page = buffer_pool_manager_->fetch_page(PageId{fd_, page_no});
+        TgmPageHdr *hdr = page_hdr(page);
+        if (hdr->trigram == TGM_FREE_PAGE) {
+            free_pages_.push_back(page_no);
+        } else {
+            Postings &postings = dir_[hdr->trigram];
+            postings.pages.push_back(page_no);
+            postings.num_rids += hdr->num_rids;
+        }
+        buffer_pool_manager_->unpin_page(page->get_page_id(), false);
+    }
+    // 追加总是写到每个倒排表的最后一页，让未写满的页面排在最后
+    for (auto &entry : dir_) {
+        auto &pages = entry.second.pages;
+        for (size_t i = 0; i + 1 < pages.size(); i++) {
+            Page *page = buffer_pool_manager_->fetch_page(PageId{fd_, pages[i]});
+            bool full = page_hdr(page)->num_rids == TGM_RIDS_PER_PAGE;
+            buffer_pool_manager_->unpin_page(page->get_page_id(), false);
+            if (!full) {
+                std::swap(pages[i], pages.back());
+                break;
+            }
+        }
+    }
+}
+
+std::vector<uint32_t> IxTrigramHandle::value_trigrams(const char *val, int len) {
+    int n = 0;
+    while (n < len && val[n] != '\0') n++;
+    std::vector<uint32_t> trigrams;
+    for (int i = 0; i + 3 <= n; i++) {
+        trigrams.push_back(make_trigram(val + i));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+std::vector<uint32_t> IxTrigramHandle::pattern_trigrams(const std::string &pattern) {
+    std::vector<uint32_t> trigrams;
+    size_t begin = 0;
+    while (begin < pattern.size()) {
+        size_t end = pattern.find_first_of("%_", begin);
+        if (end == std::string::npos) end = pattern.size();
+        for (size_t i = begin; i + 3 <= end; i++) {
+            trigrams.push_back(make_trigram(pattern.c_str() + i));
+        }
+        begin = end + 1;
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+/**
+ * @description: 把rid加入值中每个三元组的倒排表，追加到倒排表的最后一页，写满时换一个新页面
+ */
+void IxTrigramHandle::insert_entry(const char *val, const Rid &rid) {
+    std::scoped_lock lock{latch_};
+    for (uint32_t trigram : value_trigrams(val, file_hdr_.col_len)) {
+        Postings &postings = dir_[trigram];
+        Page *page = nullptr;
+        if (!postings.pages.empty()) {
+            page = buffer_pool_manager_->fetch_page(PageId{fd_, postings.pages.back()});
+            if (page_hdr(page)->num_rids == TGM_RIDS_PER_PAGE) {
+                buffer_pool_manager_->unpin_page(page->get_page_id(), false);
+                page = nullptr;
+            }
+        }
+        if (page == nullptr) {
+            postings.pages.push_back(new_posting_page(trigram));
+            page = buffer_pool_manager_->fetch_page(PageId{fd_, postings.pages.back()});
+        }
+        TgmPageHdr *hdr = page_hdr(page);
+        page_rids(page)[hdr->num_rids++] = rid;
+        postings.num_rids++;
+        buffer_pool_manager_->unpin_page(page->get_page_id(), true);
+    }
+}
+
+/**
+ * @description: 从值中每个三元组的倒排表里删除rid，用页面中最后一个Rid填补空位，页面删空后释放
+ */
+void IxTrigramHandle::delete_entry(const char *val, const Rid &rid) {
+    std::scoped_lock lock{latch_};
+    for (uint32_t trigram : value_trigrams(val, file_hdr_.col_len)) {
+        auto it = dir_.find(trigram);
+        if (it == dir_.end()) {
+            continue;
+        }
+        Postings &postings = it->second;
+        for (size_t i = 0; i < postings.pages.size(); i++) {
+            Page *page = buffer_pool_manager_->fetch_page(PageId{fd_, postings.pages[i]});
+            TgmPageHdr *hdr = page_hdr(page);
+            Rid *rids = page_rids(page);
+            Rid *pos = std::find(rids, rids + hdr->num_rids, rid);
+            if (pos == rids + hdr->num_rids) {
+                buffer_pool_manager_->unpin_page(page->get_page_id(), false);
+                continue;
+            }
+            *pos = rids[--hdr->num_rids];
+            postings.num_rids--;
+            if (hdr->num_rids == 0) {
+                free_posting_page(page, postings, i);
+            }
+            buffer_pool_manager_->unpin_page(page->get_page_id(), true);
+            break;
+        }
+        if (postings.pages.empty()) {
+            dir_.erase(it);
+        }
+    }
+}
+
+/**
+ * @description: 从最短的倒排表开始求交集，交集为空时提前结束
+ */
+std::vector<Rid> IxTrigramHandle::search(const std::vector<uint32_t> &trigrams) {
+    std::scoped_lock lock{latch_};
+    std::vector<const Postings *> lists;
+    for (uint32_t trigram : trigrams) {
+        auto it = dir_.find(trigram);
+        if (it == dir_.end()) {
+            return {};
+        }
+        lists.push_back(&it->second);
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const Postings *x, const Postings *y) { return x->num_rids < y->num_rids; });
+    std::vector<Rid> result, rids, merged;
+    for (size_t i = 0; i < lists.size(); i++) {
+        rids.clear();
+        read_postings(*lists[i], rids);
+        std::sort(rids.begin(), rids.end(), rid_less);
+        if (i == 0) {
+            result.swap(rids);
+        } else {
+            merged.clear();
+            std::set_intersection(result.begin(), result.end(), rids.begin(), rids.end(), std::back_inserter(merged),
+                                  rid_less);
+            result.swap(merged);
+        }
+        if (result.empty()) {
+            break;
+        }
+    }
+    return result;
+}
+
+void IxTrigramHandle::clear() {
+    std::scoped_lock lock{latch_};
+    for (auto &entry : dir_) {
+        for (page_id_t page_no : entry.second.pages) {
+            Page *page = buffer_pool_manager_->fetch_page(PageId{fd_, page_no});
+            *page_hdr(page) = {.trigram = TGM_FREE_PAGE, .num_rids = 0};
+            buffer_pool_manager_->unpin_page(page->get_page_id(), true);
+            free_pages_.push_back(page_no);
+        }
+    }
+    dir_.clear();
+}
+
+/* 分配一个倒排页面，优先复用空闲页面；调用者持有latch_ */
+page_id_t IxTrigramHandle::new_posting_page(uint32_t trigram) {
+    Page *page;
+    if (!free_pages_.empty()) {
+        page = buffer_pool_manager_->fetch_page(PageId{fd_, free_pages_.back()});
+        free_pages_.pop_back();
+    } else {
+        PageId page_id = {.fd = fd_, .page_no = INVALID_PAGE_ID};
+        page = buffer_pool_manager_->new_page(&page_id);
+        file_hdr_.num_pages = std::max(file_hdr_.num_pages, page_id.page_no + 1);
+    }
+    *page_hdr(page) = {.trigram = trigram, .num_rids = 0};
+    page_id_t page_no = page->get_page_id().page_no;
+    buffer_pool_manager_->unpin_page(page->get_page_id(), true);
+    return page_no;
+}
+
+/* 把已删空的第idx个页面从倒排表中移除并标记为空闲，页面仍由调用者unpin */
+void IxTrigramHandle::free_posting_page(Page *page, Postings &postings, size_t idx) {
+    page_hdr(page)->trigram = TGM_FREE_PAGE;
+    free_pages_.push_back(postings.pages[idx]);
+    postings.pages.erase(postings.pages.begin() + idx);
+}
+
+void IxTrigramHandle::read_postings(const Postings &postings, std::vector<Rid> &rids) {
+    rids.reserve(rids.size() + postings.num_rids);
+    for (page_id_t page_no : postings.pages) {
+        Page *page = buffer_pool_manager_->fetch_page(PageId{fd_, page_no});
+        Rid *begin = page_rids(page);
+        rids.insert(rids.end(), begin, begin + page_hdr(page)->num_rids);
+        buffer_pool_manager_->unpin_page(page->get_page_id(), false);
+    }
+}
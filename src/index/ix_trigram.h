@@ -0,0 +1,70 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ix_defs.h"
+
+/**
+ * 三元组倒排索引：CHAR字段值中每个连续的三字节子串（三元组）对应一个倒排表，记录包含它的记录的Rid。
+ * LIKE '%abc%'的候选记录为模式中各三元组倒排表的交集，候选记录仍需回表按LIKE检查。
+ * 倒排表存放在缓冲池管理的页面中，每页只属于一个三元组；三元组到页面的目录只在内存中，打开文件时扫描所有页面重建。
+ * 与B+树索引一样，修改由DML和事务回滚维护，不单独记录日志。
+ */
+class IxTrigramHandle {
+    friend class IxManager;
+
+    /* 一个三元组的倒排表 */
+    struct Postings {
+        std::vector<page_id_t> pages;   // 倒排表所在的页面，最后一页用于追加
+        size_t num_rids = 0;
+    };
+
+    DiskManager *disk_manager_;
+    BufferPoolManager *buffer_pool_manager_;
+    int fd_;
+    TgmFileHdr file_hdr_;
+    std::mutex latch_;
+    std::unordered_map<uint32_t, Postings> dir_;    // 三元组 -> 倒排表
+    std::vector<page_id_t> free_pages_;             // 倒排表删空后释放的页面
+
+   public:
+    IxTrigramHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd);
+
+    int get_fd() const { return fd_; }
+
+    /* 字段值（到'\0'或第len个字节为止）中所有不同的三元组，短于3个字节的值没有三元组 */
+    static std::vector<uint32_t> value_trigrams(const char *val, int len);
+
+    /* LIKE模式中通配符之间的每段字面量包含的三元组，满足模式的值一定包含它们；为空时索引不能缩小范围 */
+    static std::vector<uint32_t> pattern_trigrams(const std::string &pattern);
+
+    void insert_entry(const char *val, const Rid &rid);
+
+    void delete_entry(const char *val, const Rid &rid);
+
+    /* 同时包含所有三元组的记录，按Rid排序，回表时按页面顺序访问 */
+    std::vector<Rid> search(const std::vector<uint32_t> &trigrams);
+
+    /* 清空索引，页面留作之后插入时复用 */
+    void clear();
+
+   private:
+    page_id_t new_posting_page(uint32_t trigram);
+
+    void free_posting_page(Page *page, Postings &postings, size_t idx);
+
+    void read_postings(const Postings &postings, std::vector<Rid> &rids);
+};
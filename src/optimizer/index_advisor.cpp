@@ -0,0 +1,119 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "index_advisor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+/**
+ * @description: 根据工作负载记录推荐索引
+ * @return {vector<IndexAdvice>} 按估计节省的代价从大到小排列，最多ADVISOR_MAX_INDEXES个
+ */
+std::vector<IndexAdvice> IndexAdvisor::advise() {
+    // (表名, 索引字段) -> 推荐
+    std::map<std::pair<std::string, std::vector<std::string>>, IndexAdvice> candidates;
+    for (auto &shape : sm_manager_->workload_.snapshot()) {
+        if (!sm_manager_->db_.is_table(shape.tab_name)) {
+            continue;
+        }
+        TabMeta &tab = sm_manager_->db_.get_table(shape.tab_name);
+        std::vector<std::string> index_col_names;
+        // 登记之后已经建立了可用的索引
+        if (Planner::match_index_cols(tab, shape.conds, index_col_names)) {
+            continue;
+        }
+        double num_rows = sm_manager_->estimate_rows(tab.name, {});
+        if (num_rows < 0) {
+            continue;
+        }
+        auto fh = sm_manager_->fhs_.find(tab.name);
+        if (fh == sm_manager_->fhs_.end()) {
+            continue;
+        }
+        double num_pages = std::max(fh->second->get_file_hdr().num_pages - RM_FIRST_RECORD_PAGE, 1);
+        double seq_cost = seq_scan_cost(num_rows, num_pages);
+
+        std::vector<std::vector<std::string>> col_lists;
+        if (!shape.eq_cols.empty()) {
+            col_lists.push_back(shape.eq_cols);
+        }
+        for (auto *cols : {&shape.range_cols, &shape.join_cols}) {
+            for (auto &col_name : *cols) {
+                col_lists.push_back({col_name});
+            }
+        }
+        for (auto &col_names : col_lists) {
+            if (tab.is_index(col_names) ||
+                !std::all_of(col_names.begin(), col_names.end(), [&](const std::string &col_name) { return tab.is_col(col_name); })) {
+                continue;
+            }
+            IndexMeta index;
+            index.tab_name = tab.name;
+            index.col_num = col_names.size();
+            index.col_tot_len = 0;
+            for (auto &col_name : col_names) {
+                index.cols.push_back(*tab.get_col(col_name));
+                index.col_tot_len += index.cols.back().len;
+            }
+            // what-if：只有规划器会选择这个假想索引时才有收益，例如连接字段上的索引不会被使用
+            TabMeta what_if;
+            what_if = tab;      // TabMeta的拷贝构造函数不复制索引，这里用赋值
+            what_if.indexes.push_back(index);
+            if (!Planner::match_index_cols(what_if, shape.conds, index_col_names) || index_col_names != col_names) {
+                continue;
+            }
+            double saved = seq_cost - index_scan_cost(index, shape, num_rows, num_pages);
+            if (saved <= 0) {
+                continue;
+            }
+            auto &advice = candidates[{tab.name, col_names}];
+            advice.tab_name = tab.name;
+            advice.col_names = col_names;
+            advice.scans += shape.executions;
+            advice.scan_ms += shape.scan_ns / 1e6;
+            advice.benefit += saved * shape.executions;
+        }
+    }
+
+    std::vector<IndexAdvice> advice;
+    for (auto &entry : candidates) {
+        advice.push_back(std::move(entry.second));
+    }
+    std::sort(advice.begin(), advice.end(), [](const IndexAdvice &a, const IndexAdvice &b) { return a.benefit > b.benefit; });
+    if (advice.size() > ADVISOR_MAX_INDEXES) {
+        advice.resize(ADVISOR_MAX_INDEXES);
+    }
+    return advice;
+}
+
+/* 顺序读全部页面并处理每条记录 */
+double IndexAdvisor::seq_scan_cost(double num_rows, double num_pages) {
+    return num_pages + ADVISOR_CPU_TUPLE_COST * num_rows;
+}
+
+/**
+ * @description: 从根结点下降到叶子，再逐条随机读取索引条件选中的记录，读取的页面数不超过表的页面数
+ */
+double IndexAdvisor::index_scan_cost(const IndexMeta &index, const WorkloadShape &shape, double num_rows, double num_pages) {
+    std::vector<Condition> index_conds;
+    for (auto &cond : shape.conds) {
+        bool index_col = std::any_of(index.cols.begin(), index.cols.end(),
+                                     [&](const ColMeta &col) { return col.name == cond.lhs_col.col_name; });
+        if (cond.is_rhs_val && index_col && cond.op != OP_NE && cond.op != OP_LIKE) {
+            index_conds.push_back(cond);
+        }
+    }
+    double fetched = std::max(sm_manager_->estimate_rows(index.tab_name, index_conds), 0.0);
+    double fanout = std::max<double>(PAGE_SIZE / (index.col_tot_len + sizeof(Rid)), 2);
+    double height = std::max(std::ceil(std::log(std::max(num_rows, 2.0)) / std::log(fanout)), 1.0);
+    return ADVISOR_RANDOM_PAGE_COST * (height + std::min(fetched, num_pages)) + ADVISOR_CPU_TUPLE_COST * fetched;
+}
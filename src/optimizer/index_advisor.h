@@ -0,0 +1,36 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "planner.h"
+
+/**
+ * 索引推荐：对工作负载记录中的每种全表扫描，用每个候选索引的等值字段序列、范围字段和连接字段生成假想索引，
+ * 把假想索引加入表元数据的副本后按规划器的索引匹配规则判断能否使用（what-if规划，不建立任何索引），
+ * 能使用时用代价模型估计节省的代价，同一个候选索引在所有扫描上的节省累加后排序
+ */
+class IndexAdvisor {
+   private:
+    SmManager *sm_manager_;
+
+   public:
+    explicit IndexAdvisor(SmManager *sm_manager) : sm_manager_(sm_manager) {}
+
+    std::vector<IndexAdvice> advise();
+
+   private:
+    double seq_scan_cost(double num_rows, double num_pages);
+
+    double index_scan_cost(const IndexMeta &index, const WorkloadShape &shape, double num_rows, double num_pages);
+};
@@ -18,6 +18,7 @@ See the Mulan PSL v2 for more details. */
 #include "system/sm.h"
 #include "common/context.h"
 #include "transaction/transaction_manager.h"
+#include "index_advisor.h"
 #include "planner.h"
 #include "plan.h"
 
@@ -38,6 +39,9 @@ class Optimizer {
         } else if (auto x = std::dynamic_pointer_cast<ast::ShowTables>(query->parse)) {
             // show tables;
             return std::make_shared<OtherPlan>(T_ShowTable, std::string());
+        } else if (auto x = std::dynamic_pointer_cast<ast::AdviseIndexes>(query->parse)) {
+            // advise indexes; 规划时完成what-if评估，执行时只输出结果
+            return std::make_shared<AdvisePlan>(IndexAdvisor(sm_manager_).advise());
         } else if (auto x = std::dynamic_pointer_cast<ast::DescTable>(query->parse)) {
             // desc table;
             return std::make_shared<OtherPlan>(T_DescTable, x->tab_name);
@@ -26,8 +26,16 @@ typedef enum PlanTag{
     T_DescTable,
     T_CreateTable,
     T_DropTable,
+    T_TruncateTable,
+    T_ClusterTable,
+    T_AnalyzeTable,
     T_CreateIndex,
+    T_CreateIndexConcurrently,
     T_DropIndex,
+    T_CreateTrigramIndex,
+    T_DropTrigramIndex,
+    T_CreateMaterializedView,
+    T_DropMaterializedView,
     T_Insert,
     T_Update,
     T_Delete,
@@ -38,9 +46,15 @@ typedef enum PlanTag{
     T_Transaction_rollback,
     T_SeqScan,
     T_IndexScan,
+    T_TrigramScan,
     T_NestLoop,
     T_Sort,
-    T_Projection
+    T_Projection,
+    T_Aggregate,
+    T_Distinct,
+    T_Limit,
+    T_Explain,
+    T_AdviseIndexes
 } PlanTag;
 
 // 查询执行计划
@@ -54,7 +68,8 @@ public:
 class ScanPlan : public Plan
 {
     public:
-        ScanPlan(PlanTag tag, SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds, std::vector<std::string> index_col_names)
+        ScanPlan(PlanTag tag, SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds, std::vector<std::string> index_col_names,
+                 TableSample sample = TableSample())
         {
             Plan::tag = tag;
             tab_name_ = std::move(tab_name);
@@ -64,7 +79,11 @@ class ScanPlan : public Plan
             len_ = cols_.back().offset + cols_.back().len;
             fed_conds_ = conds_;
             index_col_names_ = index_col_names;
-        
+            sample_ = sample;
+            est_rows_ = sm_manager->estimate_rows(tab_name_, conds_);
+            if (est_rows_ >= 0 && sample_.enabled()) {
+                est_rows_ *= sample_.fraction;
+            }
         }
         ~ScanPlan(){}
         // 以下变量同ScanExecutor中的变量
@@ -74,7 +93,9 @@ class ScanPlan : public Plan
         size_t len_;                               
         std::vector<Condition> fed_conds_;
         std::vector<std::string> index_col_names_;
-    
+        double est_rows_;                           // 由统计信息估计的输出记录数，没有统计信息时为-1
+        TableSample sample_;                        // tablesample，只用于顺序扫描
+        WorkloadEntry *workload_ = nullptr;         // 全表扫描在工作负载记录中的项，其他扫描为空
 };
 
 class JoinPlan : public Plan
@@ -115,6 +136,61 @@ class ProjectionPlan : public Plan
         
 };
 
+// 聚集：不分组时输出一条记录，每个聚集函数的结果为一个字段；
+// 分组时每组输出一条记录，字段为分组字段和聚集结果，输入按分组字段有序，相同分组的记录连续到达
+class AggregatePlan : public Plan
+{
+    public:
+        AggregatePlan(PlanTag tag, std::shared_ptr<Plan> subplan, std::vector<AggExpr> aggs,
+                      std::vector<TabCol> group_by = {}, bool presorted = false)
+        {
+            Plan::tag = tag;
+            subplan_ = std::move(subplan);
+            aggs_ = std::move(aggs);
+            group_by_ = std::move(group_by);
+            presorted_ = presorted;
+        }
+        ~AggregatePlan(){}
+        std::shared_ptr<Plan> subplan_;
+        std::vector<AggExpr> aggs_;
+        std::vector<TabCol> group_by_;
+        bool presorted_;        // 子计划（索引扫描）的输出已经按分组字段有序，否则先按分组字段排序
+};
+
+// select distinct：去掉在cols上重复的记录，输出记录只包含cols
+class DistinctPlan : public Plan
+{
+    public:
+        DistinctPlan(PlanTag tag, std::shared_ptr<Plan> subplan, std::vector<TabCol> cols, bool presorted)
+        {
+            Plan::tag = tag;
+            subplan_ = std::move(subplan);
+            cols_ = std::move(cols);
+            presorted_ = presorted;
+        }
+        ~DistinctPlan(){}
+        std::shared_ptr<Plan> subplan_;
+        std::vector<TabCol> cols_;
+        bool presorted_;        // 子计划的输出中重复的记录相邻，只需与上一条比较，否则用哈希表去重
+};
+
+// limit/offset：跳过前offset条记录，最多输出limit条
+class LimitPlan : public Plan
+{
+    public:
+        LimitPlan(PlanTag tag, std::shared_ptr<Plan> subplan, int limit, int offset)
+        {
+            Plan::tag = tag;
+            subplan_ = std::move(subplan);
+            limit_ = limit;
+            offset_ = offset;
+        }
+        ~LimitPlan(){}
+        std::shared_ptr<Plan> subplan_;
+        int limit_;
+        int offset_;
+};
+
 class SortPlan : public Plan
 {
     public:
@@ -155,21 +231,25 @@ class DMLPlan : public Plan
         std::vector<SetClause> set_clauses_;
 };
 
-// ddl语句, 包括create/drop table; create/drop index;
+// ddl语句, 包括create/drop/truncate table; create/drop index;
 class DDLPlan : public Plan
 {
     public:
-        DDLPlan(PlanTag tag, std::string tab_name, std::vector<std::string> col_names, std::vector<ColDef> cols)
+        DDLPlan(PlanTag tag, std::string tab_name, std::vector<std::string> col_names, std::vector<ColDef> cols,
+                std::vector<Condition> conds = {})
         {
             Plan::tag = tag;
             tab_name_ = std::move(tab_name);
             cols_ = std::move(cols);
             tab_col_names_ = std::move(col_names);
+            conds_ = std::move(conds);
         }
         ~DDLPlan(){}
         std::string tab_name_;
-        std::vector<std::string> tab_col_names_;
+        std::vector<std::string> tab_col_names_;    // 索引的字段，create table时为聚簇键
         std::vector<ColDef> cols_;
+        std::vector<Condition> conds_;      // create index的部分索引谓词
+        ViewMeta view_;                     // create materialized view的视图定义，cols_为视图表的字段
 };
 
 // help; show tables; desc tables; begin; abort; commit; rollback语句对应的plan
@@ -185,6 +265,42 @@ class OtherPlan : public Plan
         std::string tab_name_;
 };
 
+// ADVISE INDEXES推荐的一个索引
+struct IndexAdvice {
+    std::string tab_name;
+    std::vector<std::string> col_names;
+    uint64_t scans = 0;     // 建立索引后不再需要的全表扫描次数
+    double scan_ms = 0;     // 这些全表扫描实际花费的时间
+    double benefit = 0;     // 代价模型估计的这些扫描节省的总代价
+};
+
+// advise indexes语句，规划时已经根据工作负载记录得到推荐的索引，按benefit从大到小排列
+class AdvisePlan : public OtherPlan
+{
+    public:
+        AdvisePlan(std::vector<IndexAdvice> advice) : OtherPlan(T_AdviseIndexes, std::string())
+        {
+            advice_ = std::move(advice);
+        }
+        ~AdvisePlan(){}
+        std::vector<IndexAdvice> advice_;
+};
+
+// explain [analyze]语句，subplan为被解释的select语句的DMLPlan
+class ExplainPlan : public Plan
+{
+    public:
+        ExplainPlan(PlanTag tag, std::shared_ptr<Plan> subplan, bool analyze)
+        {
+            Plan::tag = tag;
+            subplan_ = std::move(subplan);
+            analyze_ = analyze;
+        }
+        ~ExplainPlan(){}
+        std::shared_ptr<Plan> subplan_;
+        bool analyze_;      // 是否真正执行并统计每个算子输出的记录数
+};
+
 class plannerInfo{
     public:
     std::shared_ptr<ast::SelectStmt> parse;
@@ -18,19 +18,98 @@ See the Mulan PSL v2 for more details. */
 #include "execution/executor_nestedloop_join.h"
 #include "execution/executor_projection.h"
 #include "execution/executor_seq_scan.h"
+#include "execution/executor_trigram_scan.h"
 #include "execution/executor_update.h"
 #include "index/ix.h"
 #include "record_printer.h"
 
-// 目前的索引匹配规则为：完全匹配索引字段，且全部为单点查询，不会自动调整where条件的顺序
+// 判断表上的条件是否蕴含部分索引的所有谓词，只有这样索引中才包含全部满足条件的记录
+static bool implies_index_preds(const std::string& tab_name, const std::vector<Condition>& conds, const IndexMeta& index) {
+    for(auto& pred: index.preds) {
+        bool implied = false;
+        for(auto& cond: conds) {
+            if(cond.is_rhs_val && cond.lhs_col.tab_name == tab_name && cond.lhs_col.col_name == pred.col.name &&
+               pred.implied_by(cond.op, cond.rhs_val.raw->data)) {
+                implied = true;
+                break;
+            }
+        }
+        if(!implied) return false;
+    }
+    return true;
+}
+
 bool Planner::get_index_cols(std::string tab_name, std::vector<Condition> curr_conds, std::vector<std::string>& index_col_names) {
+    return match_index_cols(sm_manager_->db_.get_table(tab_name), curr_conds, index_col_names);
+}
+
+// 目前的索引匹配规则为：完全匹配索引字段，且全部为单点查询，不会自动调整where条件的顺序
+// 部分索引只有在条件蕴含其谓词时才能使用，此时只出现在谓词中的字段上的等值条件不参与匹配
+// tab可以是加入了假想索引的元数据副本，ADVISE INDEXES据此判断规划器会不会使用某个尚未建立的索引
+bool Planner::match_index_cols(TabMeta& tab, const std::vector<Condition>& curr_conds, std::vector<std::string>& index_col_names) {
+    const std::string& tab_name = tab.name;
     index_col_names.clear();
     for(auto& cond: curr_conds) {
         if(cond.is_rhs_val && cond.op == OP_EQ && cond.lhs_col.tab_name.compare(tab_name) == 0)
             index_col_names.push_back(cond.lhs_col.col_name);
     }
+    if(tab.is_index(index_col_names)) {
+        auto index = tab.get_index_meta(index_col_names);
+        if(!index->is_partial() || implies_index_preds(tab_name, curr_conds, *index)) return true;
+    }
+    for(auto& index: tab.indexes) {
+        if(!index.is_partial() || !implies_index_preds(tab_name, curr_conds, index)) continue;
+        auto is_index_col = [&](const std::string& col_name) {
+            return std::any_of(index.cols.begin(), index.cols.end(),
+                               [&](const ColMeta& col) { return col.name == col_name; });
+        };
+        auto is_pred_col = [&](const std::string& col_name) {
+            return std::any_of(index.preds.begin(), index.preds.end(),
+                               [&](const IndexPredicate& pred) { return pred.col.name == col_name; });
+        };
+        std::vector<std::string> col_names;
+        for(auto& col_name: index_col_names) {
+            if(is_index_col(col_name) || !is_pred_col(col_name))
+                col_names.push_back(col_name);
+        }
+        if(col_names.size() == index.cols.size() &&
+           std::equal(col_names.begin(), col_names.end(), index.cols.begin(),
+                      [](const std::string& name, const ColMeta& col) { return name == col.name; })) {
+            index_col_names = std::move(col_names);
+            return true;
+        }
+    }
+    // 没有等值条件可用时，单列索引字段上的范围条件（包括LIKE前缀改写得到的范围）也能缩小扫描范围
+    for(auto& index: tab.indexes) {
+        if(index.is_partial() || index.cols.size() != 1) continue;
+        for(auto& cond: curr_conds) {
+            if(cond.is_rhs_val && cond.lhs_col.tab_name == tab_name && cond.lhs_col.col_name == index.cols[0].name &&
+               (cond.op == OP_LT || cond.op == OP_GT || cond.op == OP_LE || cond.op == OP_GE)) {
+                index_col_names = {index.cols[0].name};
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// 登记一次全表扫描（顺序扫描，或者按不匹配条件的索引扫描整张表），执行时由扫描算子累计次数和耗时
+void Planner::record_full_scan(const std::shared_ptr<Plan>& plan, const std::vector<std::string>& join_cols) {
+    auto scan = std::static_pointer_cast<ScanPlan>(plan);
+    scan->workload_ = sm_manager_->workload_.record(scan->tab_name_, scan->conds_, join_cols);
+}
+
+// 表上建有三元组索引的字段上的LIKE条件，模式中至少有一个三元组时才能用索引缩小范围
+bool Planner::get_trigram_col(std::string tab_name, const std::vector<Condition>& curr_conds, std::string& col_name) {
     TabMeta& tab = sm_manager_->db_.get_table(tab_name);
-    if(tab.is_index(index_col_names)) return true;
+    for(auto& cond: curr_conds) {
+        if(cond.is_rhs_val && cond.op == OP_LIKE && cond.lhs_col.tab_name == tab_name &&
+           tab.is_trigram_index(cond.lhs_col.col_name) &&
+           !IxTrigramHandle::pattern_trigrams(cond.rhs_val.str_val).empty()) {
+            col_name = cond.lhs_col.col_name;
+            return true;
+        }
+    }
     return false;
 }
 
@@ -145,23 +224,55 @@ std::shared_ptr<Plan> Planner::make_one_rel(std::shared_ptr<Query> query)
     std::vector<std::string> tables = query->tables;
     // // Scan table , 生成表算子列表tab_nodes
     std::vector<std::shared_ptr<Plan>> table_scan_executors(tables.size());
+    // 每张表上与其他表连接的字段，随全表扫描一起登记到工作负载记录
+    std::map<std::string, std::vector<std::string>> join_cols;
+    for (auto& cond : query->conds) {
+        if (!cond.is_rhs_val && cond.lhs_col.tab_name != cond.rhs_col.tab_name) {
+            join_cols[cond.lhs_col.tab_name].push_back(cond.lhs_col.col_name);
+            join_cols[cond.rhs_col.tab_name].push_back(cond.rhs_col.col_name);
+        }
+    }
     for (size_t i = 0; i < tables.size(); i++) {
         auto curr_conds = pop_conds(query->conds, tables[i]);
         // int index_no = get_indexNo(tables[i], curr_conds);
         std::vector<std::string> index_col_names;
         bool index_exist = get_index_cols(tables[i], curr_conds, index_col_names);
+        std::string trigram_col;
         
-        // 如果WHERE条件匹配索引，使用IndexScan
-        if (index_exist) {
+        // tablesample只能在顺序扫描中按页面或记录采样
+        if (query->sample.enabled()) {
+            table_scan_executors[i] = std::make_shared<ScanPlan>(T_SeqScan, sm_manager_, tables[i], curr_conds,
+                                                                 std::vector<std::string>(), query->sample);
+        } else if (index_exist) {
+            // 如果WHERE条件匹配索引，使用IndexScan
             table_scan_executors[i] =
                 std::make_shared<ScanPlan>(T_IndexScan, sm_manager_, tables[i], curr_conds, index_col_names);
+        } else if (get_trigram_col(tables[i], curr_conds, trigram_col)) {
+            // LIKE '%abc%'通过三元组索引找到候选记录
+            table_scan_executors[i] = std::make_shared<ScanPlan>(T_TrigramScan, sm_manager_, tables[i], curr_conds,
+                                                                 std::vector<std::string>{trigram_col});
         } else {
             // 即使没有WHERE条件，如果表有索引，也使用IndexScan来保证输出顺序一致（防止幻读）
             TabMeta& tab = sm_manager_->db_.get_table(tables[i]);
-            if (!tab.indexes.empty()) {
-                // 使用第一个索引的列名
+            // 部分索引不包含全部记录，不能用来做全表扫描
+            auto full_index = std::find_if(tab.indexes.begin(), tab.indexes.end(),
+                                           [](const IndexMeta& index) { return !index.is_partial(); });
+            // 有group by或distinct时优先选择前缀为分组（去重）字段的索引，相等的记录连续输出，不需要排序或哈希
+            const auto& key_cols = !query->group_by.empty() ? query->group_by : query->cols;
+            if (!query->group_by.empty() || query->distinct) {
+                auto group_index = std::find_if(tab.indexes.begin(), tab.indexes.end(), [&](const IndexMeta& index) {
+                    std::vector<std::string> names;
+                    for (const auto& col : index.cols) names.push_back(col.name);
+                    return !index.is_partial() && index_groups(names, key_cols);
+                });
+                if (group_index != tab.indexes.end()) {
+                    full_index = group_index;
+                }
+            }
+            if (full_index != tab.indexes.end()) {
+                // 使用第一个非部分索引的列名
                 index_col_names.clear();
-                for (const auto& col : tab.indexes[0].cols) {
+                for (const auto& col : full_index->cols) {
                     index_col_names.push_back(col.name);
                 }
                 table_scan_executors[i] =
@@ -172,6 +283,7 @@ std::shared_ptr<Plan> Planner::make_one_rel(std::shared_ptr<Query> query)
                 table_scan_executors[i] = 
                     std::make_shared<ScanPlan>(T_SeqScan, sm_manager_, tables[i], curr_conds, index_col_names);
             }
+            record_full_scan(table_scan_executors[i], join_cols[tables[i]]);
         }
     }
     // 只有一个表，不需要join。
@@ -287,6 +399,43 @@ std::shared_ptr<Plan> Planner::generate_sort_plan(std::shared_ptr<Query> query,
 }
 
 
+/**
+ * @brief 索引的前若干个字段恰好是全部分组（去重）字段时，按索引顺序扫描，这些字段相等的记录连续出现
+ */
+bool Planner::index_groups(const std::vector<std::string>& index_col_names, const std::vector<TabCol>& group_by) {
+    if (group_by.empty() || index_col_names.size() < group_by.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < group_by.size(); i++) {
+        auto same_col = [&](const TabCol& col) { return col.col_name == index_col_names[i]; };
+        if (std::none_of(group_by.begin(), group_by.end(), same_col)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 在cols上相等的记录在plan的输出中是否连续出现：单表上的索引扫描按索引字段输出，排序按排序字段输出
+ */
+bool Planner::adjacent_on(const std::shared_ptr<Plan>& plan, const std::vector<TabCol>& cols) {
+    if (auto sort = std::dynamic_pointer_cast<SortPlan>(plan)) {
+        return !cols.empty() && std::all_of(cols.begin(), cols.end(), [&](const TabCol& col) {
+            return col.tab_name == sort->sel_col_.tab_name && col.col_name == sort->sel_col_.col_name;
+        });
+    }
+    auto scan = std::dynamic_pointer_cast<ScanPlan>(plan);
+    if (scan == nullptr || scan->tag != T_IndexScan) {
+        return false;
+    }
+    for (auto& col : cols) {
+        if (col.tab_name != scan->tab_name_) {
+            return false;
+        }
+    }
+    return index_groups(scan->index_col_names_, cols);
+}
+
 /**
  * @brief select plan 生成
  *
@@ -301,6 +450,18 @@ std::shared_ptr<Plan> Planner::generate_select_plan(std::shared_ptr<Query> query
     //物理优化
     auto sel_cols = query->cols;
     std::shared_ptr<Plan> plannerRoot = physical_optimization(query, context);
+    if (!query->aggs.empty()) {
+        bool presorted = adjacent_on(plannerRoot, query->group_by);
+        plannerRoot = std::make_shared<AggregatePlan>(T_Aggregate, std::move(plannerRoot), query->aggs,
+                                                      query->group_by, presorted);
+    }
+    if (query->distinct) {
+        bool presorted = adjacent_on(plannerRoot, sel_cols);
+        plannerRoot = std::make_shared<DistinctPlan>(T_Distinct, std::move(plannerRoot), sel_cols, presorted);
+    }
+    if (query->limit >= 0) {
+        plannerRoot = std::make_shared<LimitPlan>(T_Limit, std::move(plannerRoot), query->limit, query->offset);
+    }
     plannerRoot = std::make_shared<ProjectionPlan>(T_Projection, std::move(plannerRoot), 
                                                         std::move(sel_cols));
 
@@ -311,7 +472,11 @@ std::shared_ptr<Plan> Planner::generate_select_plan(std::shared_ptr<Query> query
 std::shared_ptr<Plan> Planner::do_planner(std::shared_ptr<Query> query, Context *context)
 {
     std::shared_ptr<Plan> plannerRoot;
-    if (auto x = std::dynamic_pointer_cast<ast::CreateTable>(query->parse)) {
+    if (auto x = std::dynamic_pointer_cast<ast::ExplainStmt>(query->parse)) {
+        // explain [analyze]; 先为其中的select语句生成计划
+        query->parse = x->stmt;
+        plannerRoot = std::make_shared<ExplainPlan>(T_Explain, do_planner(std::move(query), context), x->analyze);
+    } else if (auto x = std::dynamic_pointer_cast<ast::CreateTable>(query->parse)) {
         // create table;
         std::vector<ColDef> col_defs;
         for (auto &field : x->fields) {
@@ -324,16 +489,61 @@ std::shared_ptr<Plan> Planner::do_planner(std::shared_ptr<Query> query, Context
                 throw InternalError("Unexpected field type");
             }
         }
-        plannerRoot = std::make_shared<DDLPlan>(T_CreateTable, x->tab_name, std::vector<std::string>(), col_defs);
+        plannerRoot = std::make_shared<DDLPlan>(T_CreateTable, x->tab_name, x->organized_by, col_defs);
     } else if (auto x = std::dynamic_pointer_cast<ast::DropTable>(query->parse)) {
         // drop table;
         plannerRoot = std::make_shared<DDLPlan>(T_DropTable, x->tab_name, std::vector<std::string>(), std::vector<ColDef>());
+    } else if (auto x = std::dynamic_pointer_cast<ast::TruncateTable>(query->parse)) {
+        // truncate table;
+        plannerRoot = std::make_shared<DDLPlan>(T_TruncateTable, x->tab_name, std::vector<std::string>(), std::vector<ColDef>());
+    } else if (auto x = std::dynamic_pointer_cast<ast::ClusterTable>(query->parse)) {
+        // cluster table [using (cols)];
+        plannerRoot = std::make_shared<DDLPlan>(T_ClusterTable, x->tab_name, x->col_names, std::vector<ColDef>());
+    } else if (auto x = std::dynamic_pointer_cast<ast::AnalyzeTable>(query->parse)) {
+        // analyze table;
+        plannerRoot = std::make_shared<DDLPlan>(T_AnalyzeTable, x->tab_name, std::vector<std::string>(), std::vector<ColDef>());
     } else if (auto x = std::dynamic_pointer_cast<ast::CreateIndex>(query->parse)) {
-        // create index;
-        plannerRoot = std::make_shared<DDLPlan>(T_CreateIndex, x->tab_name, x->col_names, std::vector<ColDef>());
+        // create index [concurrently] [where ...];
+        plannerRoot = std::make_shared<DDLPlan>(x->concurrently ? T_CreateIndexConcurrently : T_CreateIndex,
+                                                x->tab_name, x->col_names, std::vector<ColDef>(), query->conds);
     } else if (auto x = std::dynamic_pointer_cast<ast::DropIndex>(query->parse)) {
         // drop index
         plannerRoot = std::make_shared<DDLPlan>(T_DropIndex, x->tab_name, x->col_names, std::vector<ColDef>());
+    } else if (auto x = std::dynamic_pointer_cast<ast::CreateTrigramIndex>(query->parse)) {
+        // create trigram index
+        plannerRoot = std::make_shared<DDLPlan>(T_CreateTrigramIndex, x->tab_name, std::vector<std::string>{x->col_name},
+                                                std::vector<ColDef>());
+    } else if (auto x = std::dynamic_pointer_cast<ast::DropTrigramIndex>(query->parse)) {
+        // drop trigram index
+        plannerRoot = std::make_shared<DDLPlan>(T_DropTrigramIndex, x->tab_name, std::vector<std::string>{x->col_name},
+                                                std::vector<ColDef>());
+    } else if (auto x = std::dynamic_pointer_cast<ast::CreateMaterializedView>(query->parse)) {
+        // create materialized view，视图表的字段为投影列，不同表的同名字段加上表名前缀
+        ViewMeta view;
+        view.name = x->view_name;
+        view.tables = query->tables;
+        view.conds = query->conds;
+        view.count_star = !query->aggs.empty();
+        std::vector<ColDef> col_defs;
+        if (view.count_star) {
+            col_defs.push_back(ColDef{.name = query->aggs[0].name(), .type = TYPE_BIGINT, .len = sizeof(int64_t)});
+        } else {
+            view.cols = query->cols;
+            for (auto &sel_col : view.cols) {
+                auto col = sm_manager_->db_.get_table(sel_col.tab_name).get_col(sel_col.col_name);
+                int same_name = std::count_if(view.cols.begin(), view.cols.end(),
+                                              [&](const TabCol &other) { return other.col_name == sel_col.col_name; });
+                std::string name = same_name > 1 ? sel_col.tab_name + "_" + sel_col.col_name : sel_col.col_name;
+                col_defs.push_back(ColDef{.name = name, .type = col->type, .len = col->len});
+            }
+        }
+        auto ddl = std::make_shared<DDLPlan>(T_CreateMaterializedView, x->view_name, std::vector<std::string>(), col_defs);
+        ddl->view_ = std::move(view);
+        plannerRoot = ddl;
+    } else if (auto x = std::dynamic_pointer_cast<ast::DropMaterializedView>(query->parse)) {
+        // drop materialized view
+        plannerRoot = std::make_shared<DDLPlan>(T_DropMaterializedView, x->view_name, std::vector<std::string>(),
+                                                std::vector<ColDef>());
     } else if (auto x = std::dynamic_pointer_cast<ast::InsertStmt>(query->parse)) {
         // insert;
         plannerRoot = std::make_shared<DMLPlan>(T_Insert, std::shared_ptr<Plan>(),  x->tab_name,  
@@ -347,10 +557,15 @@ std::shared_ptr<Plan> Planner::do_planner(std::shared_ptr<Query> query, Context
         std::vector<std::string> index_col_names;
         bool index_exist = get_index_cols(x->tab_name, query->conds, index_col_names);
         
-        if (index_exist == false) {  // 该表没有索引
+        std::string trigram_col;
+        if (!index_exist && get_trigram_col(x->tab_name, query->conds, trigram_col)) {
+            table_scan_executors = std::make_shared<ScanPlan>(T_TrigramScan, sm_manager_, x->tab_name, query->conds,
+                                                              std::vector<std::string>{trigram_col});
+        } else if (index_exist == false) {  // 该表没有索引
             index_col_names.clear();
             table_scan_executors = 
                 std::make_shared<ScanPlan>(T_SeqScan, sm_manager_, x->tab_name, query->conds, index_col_names);
+            record_full_scan(table_scan_executors);
         } else {  // 存在索引
             table_scan_executors =
                 std::make_shared<ScanPlan>(T_IndexScan, sm_manager_, x->tab_name, query->conds, index_col_names);
@@ -367,10 +582,15 @@ std::shared_ptr<Plan> Planner::do_planner(std::shared_ptr<Query> query, Context
         std::vector<std::string> index_col_names;
         bool index_exist = get_index_cols(x->tab_name, query->conds, index_col_names);
 
-        if (index_exist == false) {  // 该表没有索引
+        std::string trigram_col;
+        if (!index_exist && get_trigram_col(x->tab_name, query->conds, trigram_col)) {
+            table_scan_executors = std::make_shared<ScanPlan>(T_TrigramScan, sm_manager_, x->tab_name, query->conds,
+                                                              std::vector<std::string>{trigram_col});
+        } else if (index_exist == false) {  // 该表没有索引
         index_col_names.clear();
             table_scan_executors = 
                 std::make_shared<ScanPlan>(T_SeqScan, sm_manager_, x->tab_name, query->conds, index_col_names);
+            record_full_scan(table_scan_executors);
         } else {  // 存在索引
             table_scan_executors =
                 std::make_shared<ScanPlan>(T_IndexScan, sm_manager_, x->tab_name, query->conds, index_col_names);
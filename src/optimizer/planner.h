@@ -36,6 +36,8 @@ class Planner {
 
     std::shared_ptr<Plan> do_planner(std::shared_ptr<Query> query, Context *context);
 
+    static bool match_index_cols(TabMeta& tab, const std::vector<Condition>& curr_conds, std::vector<std::string>& index_col_names);
+
    private:
     std::shared_ptr<Query> logical_optimization(std::shared_ptr<Query> query, Context *context);
     std::shared_ptr<Plan> physical_optimization(std::shared_ptr<Query> query, Context *context);
@@ -50,9 +52,18 @@ class Planner {
     // int get_indexNo(std::string tab_name, std::vector<Condition> curr_conds);
     bool get_index_cols(std::string tab_name, std::vector<Condition> curr_conds, std::vector<std::string>& index_col_names);
 
+    bool get_trigram_col(std::string tab_name, const std::vector<Condition>& curr_conds, std::string& col_name);
+
+    void record_full_scan(const std::shared_ptr<Plan>& plan, const std::vector<std::string>& join_cols = {});
+
+    bool index_groups(const std::vector<std::string>& index_col_names, const std::vector<TabCol>& group_by);
+
+    bool adjacent_on(const std::shared_ptr<Plan>& plan, const std::vector<TabCol>& cols);
+
     ColType interp_sv_type(ast::SvType sv_type) {
         std::map<ast::SvType, ColType> m = {
-            {ast::SV_TYPE_INT, TYPE_INT}, {ast::SV_TYPE_FLOAT, TYPE_FLOAT}, {ast::SV_TYPE_STRING, TYPE_STRING}};
+            {ast::SV_TYPE_INT, TYPE_INT}, {ast::SV_TYPE_FLOAT, TYPE_FLOAT}, {ast::SV_TYPE_STRING, TYPE_STRING},
+            {ast::SV_TYPE_BIGINT, TYPE_BIGINT}, {ast::SV_TYPE_DATETIME, TYPE_DATETIME}};
         return m.at(sv_type);
     }
 };
@@ -9,6 +9,7 @@ MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
 See the Mulan PSL v2 for more details. */
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <memory>
@@ -19,11 +20,19 @@ enum JoinType {
 namespace ast {
 
 enum SvType {
-    SV_TYPE_INT, SV_TYPE_FLOAT, SV_TYPE_STRING
+    SV_TYPE_INT, SV_TYPE_FLOAT, SV_TYPE_STRING, SV_TYPE_BIGINT, SV_TYPE_DATETIME
 };
 
 enum SvCompOp {
-    SV_OP_EQ, SV_OP_NE, SV_OP_LT, SV_OP_GT, SV_OP_LE, SV_OP_GE
+    SV_OP_EQ, SV_OP_NE, SV_OP_LT, SV_OP_GT, SV_OP_LE, SV_OP_GE, SV_OP_LIKE
+};
+
+enum SvSampleMethod {
+    SV_SAMPLE_SYSTEM, SV_SAMPLE_BERNOULLI
+};
+
+enum SvAggFunc {
+    SV_AGG_APPROX_COUNT_DISTINCT, SV_AGG_COUNT_STAR
 };
 
 enum OrderByDir {
@@ -43,6 +52,10 @@ struct Help : public TreeNode {
 struct ShowTables : public TreeNode {
 };
 
+// advise indexes：根据执行过的全表扫描推荐索引
+struct AdviseIndexes : public TreeNode {
+};
+
 struct TxnBegin : public TreeNode {
 };
 
@@ -76,9 +89,11 @@ struct ColDef : public Field {
 struct CreateTable : public TreeNode {
     std::string tab_name;
     std::vector<std::shared_ptr<Field>> fields;
+    std::vector<std::string> organized_by;      // 聚簇键，为空表示普通堆表
 
-    CreateTable(std::string tab_name_, std::vector<std::shared_ptr<Field>> fields_) :
-            tab_name(std::move(tab_name_)), fields(std::move(fields_)) {}
+    CreateTable(std::string tab_name_, std::vector<std::shared_ptr<Field>> fields_,
+                std::vector<std::string> organized_by_ = {}) :
+            tab_name(std::move(tab_name_)), fields(std::move(fields_)), organized_by(std::move(organized_by_)) {}
 };
 
 struct DropTable : public TreeNode {
@@ -87,18 +102,44 @@ struct DropTable : public TreeNode {
     DropTable(std::string tab_name_) : tab_name(std::move(tab_name_)) {}
 };
 
+struct TruncateTable : public TreeNode {
+    std::string tab_name;
+
+    TruncateTable(std::string tab_name_) : tab_name(std::move(tab_name_)) {}
+};
+
+struct ClusterTable : public TreeNode {
+    std::string tab_name;
+    std::vector<std::string> col_names;     // 为空时按建表时的ORGANIZED BY字段
+
+    ClusterTable(std::string tab_name_, std::vector<std::string> col_names_) :
+            tab_name(std::move(tab_name_)), col_names(std::move(col_names_)) {}
+};
+
+struct AnalyzeTable : public TreeNode {
+    std::string tab_name;
+
+    AnalyzeTable(std::string tab_name_) : tab_name(std::move(tab_name_)) {}
+};
+
 struct DescTable : public TreeNode {
     std::string tab_name;
 
     DescTable(std::string tab_name_) : tab_name(std::move(tab_name_)) {}
 };
 
+struct BinaryExpr;
+
 struct CreateIndex : public TreeNode {
     std::string tab_name;
     std::vector<std::string> col_names;
+    bool concurrently;
+    std::vector<std::shared_ptr<BinaryExpr>> conds;     // 部分索引的谓词，为空表示索引覆盖全表
 
-    CreateIndex(std::string tab_name_, std::vector<std::string> col_names_) :
-            tab_name(std::move(tab_name_)), col_names(std::move(col_names_)) {}
+    CreateIndex(std::string tab_name_, std::vector<std::string> col_names_, bool concurrently_ = false,
+                std::vector<std::shared_ptr<BinaryExpr>> conds_ = {}) :
+            tab_name(std::move(tab_name_)), col_names(std::move(col_names_)), concurrently(concurrently_),
+            conds(std::move(conds_)) {}
 };
 
 struct DropIndex : public TreeNode {
@@ -109,6 +150,23 @@ struct DropIndex : public TreeNode {
             tab_name(std::move(tab_name_)), col_names(std::move(col_names_)) {}
 };
 
+/* 字段上的三元组倒排索引，用于LIKE '%abc%'这类不能用B+树的子串匹配 */
+struct CreateTrigramIndex : public TreeNode {
+    std::string tab_name;
+    std::string col_name;
+
+    CreateTrigramIndex(std::string tab_name_, std::string col_name_) :
+            tab_name(std::move(tab_name_)), col_name(std::move(col_name_)) {}
+};
+
+struct DropTrigramIndex : public TreeNode {
+    std::string tab_name;
+    std::string col_name;
+
+    DropTrigramIndex(std::string tab_name_, std::string col_name_) :
+            tab_name(std::move(tab_name_)), col_name(std::move(col_name_)) {}
+};
+
 struct Expr : public TreeNode {
 };
 
@@ -121,6 +179,13 @@ struct IntLit : public Value {
     IntLit(int val_) : val(val_) {}
 };
 
+/* 超出INT范围的整数常量 */
+struct BigintLit : public Value {
+    int64_t val;
+
+    BigintLit(int64_t val_) : val(val_) {}
+};
+
 struct FloatLit : public Value {
     float val;
 
@@ -166,6 +231,30 @@ struct OrderBy : public TreeNode
        cols(std::move(cols_)), orderby_dir(std::move(orderby_dir_)) {}
 };
 
+// tbName TABLESAMPLE {SYSTEM | BERNOULLI} (percent)
+struct TableSample : public TreeNode {
+    SvSampleMethod method;
+    float percent;
+
+    TableSample(SvSampleMethod method_, float percent_) : method(method_), percent(percent_) {}
+};
+
+// 聚集函数，例如 approx_count_distinct(col)，count(*)的arg为空
+struct AggCall : public TreeNode {
+    SvAggFunc func;
+    std::shared_ptr<Col> arg;
+
+    AggCall(SvAggFunc func_, std::shared_ptr<Col> arg_) : func(func_), arg(std::move(arg_)) {}
+};
+
+// limit <count> [offset <offset>]
+struct Limit : public TreeNode {
+    int count;
+    int offset;
+
+    Limit(int count_, int offset_) : count(count_), offset(offset_) {}
+};
+
 struct InsertStmt : public TreeNode {
     std::string tab_name;
     std::vector<std::shared_ptr<Value>> vals;
@@ -209,6 +298,11 @@ struct SelectStmt : public TreeNode {
     std::vector<std::string> tabs;
     std::vector<std::shared_ptr<BinaryExpr>> conds;
     std::vector<std::shared_ptr<JoinExpr>> jointree;
+    std::vector<std::shared_ptr<AggCall>> aggs;     // select列表中有聚集函数时不为空，此时cols只能是分组字段
+    std::shared_ptr<TableSample> sample;            // 为空表示不采样
+    std::shared_ptr<Limit> limit;                   // 为空表示不限制结果行数
+    std::vector<std::shared_ptr<Col>> group_by;     // group by的字段，为空表示不分组
+    bool distinct = false;                          // select distinct
 
     
     bool has_sort;
@@ -218,16 +312,45 @@ struct SelectStmt : public TreeNode {
     SelectStmt(std::vector<std::shared_ptr<Col>> cols_,
                std::vector<std::string> tabs_,
                std::vector<std::shared_ptr<BinaryExpr>> conds_,
-               std::shared_ptr<OrderBy> order_) :
+               std::shared_ptr<OrderBy> order_,
+               std::shared_ptr<TableSample> sample_ = nullptr,
+               std::vector<std::shared_ptr<AggCall>> aggs_ = {},
+               std::shared_ptr<Limit> limit_ = nullptr,
+               std::vector<std::shared_ptr<Col>> group_by_ = {}) :
             cols(std::move(cols_)), tabs(std::move(tabs_)), conds(std::move(conds_)), 
-            order(std::move(order_)) {
+            aggs(std::move(aggs_)), sample(std::move(sample_)), limit(std::move(limit_)),
+            group_by(std::move(group_by_)), order(std::move(order_)) {
                 has_sort = (bool)order;
             }
 };
 
+// explain [analyze] <stmt>，目前只支持select语句
+struct ExplainStmt : public TreeNode {
+    std::shared_ptr<TreeNode> stmt;
+    bool analyze;
+
+    ExplainStmt(std::shared_ptr<TreeNode> stmt_, bool analyze_) : stmt(std::move(stmt_)), analyze(analyze_) {}
+};
+
+// create materialized view <name> as <select>，视图内容存放在同名的表中，随基表的修改增量维护
+struct CreateMaterializedView : public TreeNode {
+    std::string view_name;
+    std::shared_ptr<TreeNode> query;
+
+    CreateMaterializedView(std::string view_name_, std::shared_ptr<TreeNode> query_) :
+            view_name(std::move(view_name_)), query(std::move(query_)) {}
+};
+
+struct DropMaterializedView : public TreeNode {
+    std::string view_name;
+
+    DropMaterializedView(std::string view_name_) : view_name(std::move(view_name_)) {}
+};
+
 // Semantic value
 struct SemValue {
     int sv_int;
+    int64_t sv_bigint;
     float sv_float;
     std::string sv_str;
     OrderByDir sv_orderby_dir;
@@ -257,6 +380,14 @@ struct SemValue {
     std::vector<std::shared_ptr<BinaryExpr>> sv_conds;
 
     std::shared_ptr<OrderBy> sv_orderby;
+
+    std::shared_ptr<TableSample> sv_sample;
+    SvSampleMethod sv_sample_method;
+
+    std::shared_ptr<AggCall> sv_agg;
+    std::vector<std::shared_ptr<AggCall>> sv_aggs;
+
+    std::shared_ptr<Limit> sv_limit;
 };
 
 extern std::shared_ptr<ast::TreeNode> parse_tree;
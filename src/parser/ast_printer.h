@@ -46,6 +46,8 @@ private:
                 {SV_TYPE_INT,    "INT"},
                 {SV_TYPE_FLOAT,  "FLOAT"},
                 {SV_TYPE_STRING, "STRING"},
+                {SV_TYPE_BIGINT, "BIGINT"},
+                {SV_TYPE_DATETIME, "DATETIME"},
         };
         return m.at(type);
     }
@@ -58,6 +60,7 @@ private:
                 {SV_OP_GT, ">"},
                 {SV_OP_LE, "<="},
                 {SV_OP_GE, ">="},
+                {SV_OP_LIKE, "LIKE"},
         };
         return m.at(op);
     }
@@ -79,28 +82,51 @@ private:
             std::cout << "HELP\n";
         } else if (auto x = std::dynamic_pointer_cast<ShowTables>(node)) {
             std::cout << "SHOW_TABLES\n";
+        } else if (auto x = std::dynamic_pointer_cast<AdviseIndexes>(node)) {
+            std::cout << "ADVISE_INDEXES\n";
         } else if (auto x = std::dynamic_pointer_cast<CreateTable>(node)) {
             std::cout << "CREATE_TABLE\n";
             print_val(x->tab_name, offset);
             print_node_list(x->fields, offset);
+            if (!x->organized_by.empty()) print_val_list(x->organized_by, offset);
         } else if (auto x = std::dynamic_pointer_cast<DropTable>(node)) {
             std::cout << "DROP_TABLE\n";
             print_val(x->tab_name, offset);
+        } else if (auto x = std::dynamic_pointer_cast<TruncateTable>(node)) {
+            std::cout << "TRUNCATE_TABLE\n";
+            print_val(x->tab_name, offset);
+        } else if (auto x = std::dynamic_pointer_cast<ClusterTable>(node)) {
+            std::cout << "CLUSTER_TABLE\n";
+            print_val(x->tab_name, offset);
+            if (!x->col_names.empty()) print_val_list(x->col_names, offset);
+        } else if (auto x = std::dynamic_pointer_cast<AnalyzeTable>(node)) {
+            std::cout << "ANALYZE_TABLE\n";
+            print_val(x->tab_name, offset);
         } else if (auto x = std::dynamic_pointer_cast<DescTable>(node)) {
             std::cout << "DESC_TABLE\n";
             print_val(x->tab_name, offset);
         } else if (auto x = std::dynamic_pointer_cast<CreateIndex>(node)) {
             std::cout << "CREATE_INDEX\n";
+            if (x->concurrently) print_val("CONCURRENTLY", offset);
             print_val(x->tab_name, offset);
             // print_val(x->col_name, offset);
             for(auto col_name: x->col_names)
                 print_val(col_name, offset);
+            print_node_list(x->conds, offset);
         } else if (auto x = std::dynamic_pointer_cast<DropIndex>(node)) {
             std::cout << "DROP_INDEX\n";
             print_val(x->tab_name, offset);
             // print_val(x->col_name, offset);
             for(auto col_name: x->col_names)
                 print_val(col_name, offset);
+        } else if (auto x = std::dynamic_pointer_cast<CreateTrigramIndex>(node)) {
+            std::cout << "CREATE_TRIGRAM_INDEX\n";
+            print_val(x->tab_name, offset);
+            print_val(x->col_name, offset);
+        } else if (auto x = std::dynamic_pointer_cast<DropTrigramIndex>(node)) {
+            std::cout << "DROP_TRIGRAM_INDEX\n";
+            print_val(x->tab_name, offset);
+            print_val(x->col_name, offset);
         } else if (auto x = std::dynamic_pointer_cast<ColDef>(node)) {
             std::cout << "COL_DEF\n";
             print_val(x->col_name, offset);
@@ -109,6 +135,18 @@ private:
             std::cout << "COL\n";
             print_val(x->tab_name, offset);
             print_val(x->col_name, offset);
+        } else if (auto x = std::dynamic_pointer_cast<AggCall>(node)) {
+            std::cout << "AGG_CALL\n";
+            print_val(x->func == SV_AGG_COUNT_STAR ? "COUNT" : "APPROX_COUNT_DISTINCT", offset);
+            if (x->arg) print_node(x->arg, offset);
+        } else if (auto x = std::dynamic_pointer_cast<TableSample>(node)) {
+            std::cout << "TABLESAMPLE\n";
+            print_val(x->method == SV_SAMPLE_SYSTEM ? "SYSTEM" : "BERNOULLI", offset);
+            print_val(x->percent, offset);
+        } else if (auto x = std::dynamic_pointer_cast<Limit>(node)) {
+            std::cout << "LIMIT\n";
+            print_val(x->count, offset);
+            print_val(x->offset, offset);
         } else if (auto x = std::dynamic_pointer_cast<TypeLen>(node)) {
             std::cout << "TYPE_LEN\n";
             print_val(type2str(x->type), offset);
@@ -116,6 +154,9 @@ private:
         } else if (auto x = std::dynamic_pointer_cast<IntLit>(node)) {
             std::cout << "INT_LIT\n";
             print_val(x->val, offset);
+        } else if (auto x = std::dynamic_pointer_cast<BigintLit>(node)) {
+            std::cout << "BIGINT_LIT\n";
+            print_val(x->val, offset);
         } else if (auto x = std::dynamic_pointer_cast<FloatLit>(node)) {
             std::cout << "FLOAT_LIT\n";
             print_val(x->val, offset);
@@ -146,9 +187,25 @@ private:
             print_node_list(x->conds, offset);
         } else if (auto x = std::dynamic_pointer_cast<SelectStmt>(node)) {
             std::cout << "SELECT\n";
+            if (x->distinct) print_val("DISTINCT", offset);
             print_node_list(x->cols, offset);
+            if (!x->aggs.empty()) print_node_list(x->aggs, offset);
             print_val_list(x->tabs, offset);
+            if (x->sample) print_node(x->sample, offset);
             print_node_list(x->conds, offset);
+            if (!x->group_by.empty()) print_node_list(x->group_by, offset);
+            if (x->limit) print_node(x->limit, offset);
+        } else if (auto x = std::dynamic_pointer_cast<ExplainStmt>(node)) {
+            std::cout << "EXPLAIN\n";
+            if (x->analyze) print_val("ANALYZE", offset);
+            print_node(x->stmt, offset);
+        } else if (auto x = std::dynamic_pointer_cast<CreateMaterializedView>(node)) {
+            std::cout << "CREATE_MATERIALIZED_VIEW\n";
+            print_val(x->view_name, offset);
+            print_node(x->query, offset);
+        } else if (auto x = std::dynamic_pointer_cast<DropMaterializedView>(node)) {
+            std::cout << "DROP_MATERIALIZED_VIEW\n";
+            print_val(x->view_name, offset);
         } else if (auto x = std::dynamic_pointer_cast<TxnBegin>(node)) {
             std::cout << "BEGIN\n";
         } else if (auto x = std::dynamic_pointer_cast<TxnCommit>(node)) {
@@ -18,18 +18,40 @@ int main() {
         "show tables;",
         "desc tb;",
         "create table tb (a int, b float, c char(4));",
+        "create table tb (a int, b float, c char(4)) organized by (a);",
+        "create table tb (id bigint, ts datetime);",
         "drop table tb;",
+        "truncate table tb;",
+        "truncate tb;",
+        "cluster tb using (a, b);",
+        "cluster tb;",
+        "analyze tb;",
         "create index tb(a);",
         "create index tb(a, b, c);",
+        "create index concurrently tb(a, b);",
+        "create index tb(a) where b = 1 and c > 2.5;",
         "drop index tb(a, b, c);",
         "drop index tb(b);",
+        "create trigram index tb(name);",
+        "drop trigram index tb(name);",
+        "create materialized view v as select x.a, y.b from x, y where x.a = y.b and y.c > 0;",
+        "create materialized view cnt as select count(*) from x, y where x.a = y.b;",
+        "drop materialized view v;",
         "insert into tb values (1, 3.14, 'pi');",
+        "insert into tb values (9223372036854775807, '2023-05-18 09:30:00');",
         "delete from tb where a = 1;",
         "update tb set a = 1, b = 2.2, c = 'xyz' where x = 2 and y < 1.1 and z > 'abc';",
         "select * from tb;",
         "select * from tb where x <> 2 and y >= 3. and z <= '123' and b < tb.a;",
         "select x.a, y.b from x, y where x.a = y.b and c = d;",
         "select x.a, y.b from x join y where x.a = y.b and c = d;",
+        "select * from tb tablesample system(1) where a > 0;",
+        "select approx_count_distinct(a), approx_count_distinct(tb.b) from tb tablesample bernoulli(2.5);",
+        "select count(*) from tb where a >= 1 and a <= 100;",
+        "select * from tb where a > 0 limit 10 offset 5000;",
+        "select * from tb where name like 'abc%' and note like '%x_z%';",
+        "explain select * from x, y where x.a = y.b;",
+        "explain analyze select x.a from x, y where x.a = y.b order by x.a desc;",
         "exit;",
         "help;",
         "",
@@ -21,14 +21,16 @@ using namespace ast;
 %define parse.error verbose
 
 // keywords
-%token SHOW TABLES CREATE TABLE DROP DESC INSERT INTO VALUES DELETE FROM ASC ORDER BY
-WHERE UPDATE SET SELECT INT CHAR FLOAT INDEX AND JOIN EXIT HELP TXN_BEGIN TXN_COMMIT TXN_ABORT TXN_ROLLBACK ORDER_BY
+%token SHOW TABLES CREATE TABLE DROP TRUNCATE DESC INSERT INTO VALUES DELETE FROM ASC ORDER BY
+WHERE UPDATE SET SELECT INT BIGINT CHAR FLOAT DATETIME INDEX CONCURRENTLY AND JOIN EXIT HELP TXN_BEGIN TXN_COMMIT TXN_ABORT TXN_ROLLBACK ORDER_BY EXPLAIN ANALYZE ORGANIZED CLUSTER USING
+TABLESAMPLE SYSTEM BERNOULLI APPROX_COUNT_DISTINCT COUNT LIMIT OFFSET LIKE TRIGRAM MATERIALIZED VIEW AS GROUP DISTINCT ADVISE INDEXES
 // non-keywords
 %token LEQ NEQ GEQ T_EOF
 
 // type-specific tokens
 %token <sv_str> IDENTIFIER VALUE_STRING
 %token <sv_int> VALUE_INT
+%token <sv_bigint> VALUE_BIGINT
 %token <sv_float> VALUE_FLOAT
 
 // specify types for non-terminal symbol
@@ -43,13 +45,19 @@ WHERE UPDATE SET SELECT INT CHAR FLOAT INDEX AND JOIN EXIT HELP TXN_BEGIN TXN_CO
 %type <sv_str> tbName colName
 %type <sv_strs> tableList colNameList
 %type <sv_col> col
-%type <sv_cols> colList selector
+%type <sv_cols> colList selector opt_group_by
 %type <sv_set_clause> setClause
 %type <sv_set_clauses> setClauses
 %type <sv_cond> condition
 %type <sv_conds> whereClause optWhereClause
 %type <sv_orderby>  order_clause opt_order_clause
 %type <sv_orderby_dir> opt_asc_desc
+%type <sv_sample> opt_tablesample
+%type <sv_sample_method> sampleMethod
+%type <sv_float> samplePercent
+%type <sv_agg> aggCall
+%type <sv_aggs> aggList
+%type <sv_limit> opt_limit
 
 %%
 start:
@@ -80,6 +88,14 @@ stmt:
     |   ddl
     |   dml
     |   txnStmt
+    |   EXPLAIN dml
+    {
+        $$ = std::make_shared<ExplainStmt>($2, false);
+    }
+    |   EXPLAIN ANALYZE dml
+    {
+        $$ = std::make_shared<ExplainStmt>($3, true);
+    }
     ;
 
 txnStmt:
@@ -106,6 +122,10 @@ dbStmt:
     {
         $$ = std::make_shared<ShowTables>();
     }
+    |   ADVISE INDEXES
+    {
+        $$ = std::make_shared<AdviseIndexes>();
+    }
     ;
 
 ddl:
@@ -113,22 +133,66 @@ ddl:
     {
         $$ = std::make_shared<CreateTable>($3, $5);
     }
+    |   CREATE TABLE tbName '(' fieldList ')' ORGANIZED BY '(' colNameList ')'
+    {
+        $$ = std::make_shared<CreateTable>($3, $5, $10);
+    }
     |   DROP TABLE tbName
     {
         $$ = std::make_shared<DropTable>($3);
     }
+    |   TRUNCATE TABLE tbName
+    {
+        $$ = std::make_shared<TruncateTable>($3);
+    }
+    |   TRUNCATE tbName
+    {
+        $$ = std::make_shared<TruncateTable>($2);
+    }
+    |   CLUSTER tbName USING '(' colNameList ')'
+    {
+        $$ = std::make_shared<ClusterTable>($2, $5);
+    }
+    |   CLUSTER tbName
+    {
+        $$ = std::make_shared<ClusterTable>($2, std::vector<std::string>());
+    }
+    |   ANALYZE tbName
+    {
+        $$ = std::make_shared<AnalyzeTable>($2);
+    }
     |   DESC tbName
     {
         $$ = std::make_shared<DescTable>($2);
     }
-    |   CREATE INDEX tbName '(' colNameList ')'
+    |   CREATE INDEX tbName '(' colNameList ')' optWhereClause
     {
-        $$ = std::make_shared<CreateIndex>($3, $5);
+        $$ = std::make_shared<CreateIndex>($3, $5, false, $7);
+    }
+    |   CREATE INDEX CONCURRENTLY tbName '(' colNameList ')' optWhereClause
+    {
+        $$ = std::make_shared<CreateIndex>($4, $6, true, $8);
     }
     |   DROP INDEX tbName '(' colNameList ')'
     {
         $$ = std::make_shared<DropIndex>($3, $5);
     }
+    |   CREATE TRIGRAM INDEX tbName '(' colName ')'
+    {
+        $$ = std::make_shared<CreateTrigramIndex>($4, $6);
+    }
+    |   DROP TRIGRAM INDEX tbName '(' colName ')'
+    {
+        $$ = std::make_shared<DropTrigramIndex>($4, $6);
+    }
+    |   CREATE MATERIALIZED VIEW tbName AS dml
+    {
+        $$ = std::make_shared<CreateMaterializedView>($4, $6);
+    }
+    |   DROP MATERIALIZED VIEW tbName
+    {
+        $$ = std::make_shared<DropMaterializedView>($4);
+    }
     ;
 
 dml:
@@ -144,9 +208,23 @@ dml:
     {
         $$ = std::make_shared<UpdateStmt>($2, $4, $5);
     }
-    |   SELECT selector FROM tableList optWhereClause opt_order_clause
+    |   SELECT selector FROM tableList opt_tablesample optWhereClause opt_order_clause opt_limit
+    {
+        $$ = std::make_shared<SelectStmt>($2, $4, $6, $7, $5, std::vector<std::shared_ptr<AggCall>>(), $8);
+    }
+    |   SELECT DISTINCT selector FROM tableList opt_tablesample optWhereClause opt_order_clause opt_limit
+    {
+        auto select = std::make_shared<SelectStmt>($3, $5, $7, $8, $6, std::vector<std::shared_ptr<AggCall>>(), $9);
+        select->distinct = true;
+        $$ = select;
+    }
+    |   SELECT aggList FROM tableList opt_tablesample optWhereClause opt_group_by opt_order_clause opt_limit
+    {
+        $$ = std::make_shared<SelectStmt>(std::vector<std::shared_ptr<Col>>(), $4, $6, $8, $5, $2, $9, $7);
+    }
+    |   SELECT colList ',' aggList FROM tableList opt_tablesample optWhereClause opt_group_by opt_order_clause opt_limit
     {
-        $$ = std::make_shared<SelectStmt>($2, $4, $5, $6);
+        $$ = std::make_shared<SelectStmt>($2, $6, $8, $10, $7, $4, $11, $9);
     }
     ;
 
@@ -192,6 +270,14 @@ type:
     {
         $$ = std::make_shared<TypeLen>(SV_TYPE_FLOAT, sizeof(float));
     }
+    |   BIGINT
+    {
+        $$ = std::make_shared<TypeLen>(SV_TYPE_BIGINT, sizeof(int64_t));
+    }
+    |   DATETIME
+    {
+        $$ = std::make_shared<TypeLen>(SV_TYPE_DATETIME, sizeof(int64_t));
+    }
     ;
 
 valueList:
@@ -210,6 +296,10 @@ value:
     {
         $$ = std::make_shared<IntLit>($1);
     }
+    |   VALUE_BIGINT
+    {
+        $$ = std::make_shared<BigintLit>($1);
+    }
     |   VALUE_FLOAT
     {
         $$ = std::make_shared<FloatLit>($1);
@@ -293,6 +383,10 @@ op:
     {
         $$ = SV_OP_GE;
     }
+    |   LIKE
+    {
+        $$ = SV_OP_LIKE;
+    }
     ;
 
 expr:
@@ -332,6 +426,55 @@ selector:
     |   colList
     ;
 
+aggList:
+        aggCall
+    {
+        $$ = std::vector<std::shared_ptr<AggCall>>{$1};
+    }
+    |   aggList ',' aggCall
+    {
+        $$.push_back($3);
+    }
+    ;
+
+aggCall:
+        APPROX_COUNT_DISTINCT '(' col ')'
+    {
+        $$ = std::make_shared<AggCall>(SV_AGG_APPROX_COUNT_DISTINCT, $3);
+    }
+    |   COUNT '(' '*' ')'
+    {
+        $$ = std::make_shared<AggCall>(SV_AGG_COUNT_STAR, nullptr);
+    }
+    ;
+
+opt_tablesample:
+        TABLESAMPLE sampleMethod '(' samplePercent ')'
+    {
+        $$ = std::make_shared<TableSample>($2, $4);
+    }
+    |   /* epsilon */ { $$ = nullptr; }
+    ;
+
+sampleMethod:
+        SYSTEM
+    {
+        $$ = SV_SAMPLE_SYSTEM;
+    }
+    |   BERNOULLI
+    {
+        $$ = SV_SAMPLE_BERNOULLI;
+    }
+    ;
+
+samplePercent:
+        VALUE_INT
+    {
+        $$ = $1;
+    }
+    |   VALUE_FLOAT
+    ;
+
 tableList:
         tbName
     {
@@ -347,6 +490,14 @@ tableList:
     }
     ;
 
+opt_group_by:
+        GROUP BY colList
+    {
+        $$ = $3;
+    }
+    |   /* epsilon */ { $$ = {}; }
+    ;
+
 opt_order_clause:
     ORDER BY order_clause      
     { 
@@ -362,6 +513,18 @@ order_clause:
     }
     ;   
 
+opt_limit:
+        LIMIT VALUE_INT
+    {
+        $$ = std::make_shared<Limit>($2, 0);
+    }
+    |   LIMIT VALUE_INT OFFSET VALUE_INT
+    {
+        $$ = std::make_shared<Limit>($2, $4);
+    }
+    |   /* epsilon */ { $$ = nullptr; }
+    ;
+
 opt_asc_desc:
     ASC          { $$ = OrderBy_ASC;     }
     |  DESC      { $$ = OrderBy_DESC;    }
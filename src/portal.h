@@ -16,13 +16,17 @@ See the Mulan PSL v2 for more details. */
 #include "optimizer/plan.h"
 #include "execution/executor_abstract.h"
 #include "execution/executor_nestedloop_join.h"
+#include "execution/executor_adaptive_join.h"
 #include "execution/executor_projection.h"
 #include "execution/executor_seq_scan.h"
 #include "execution/executor_index_scan.h"
+#include "execution/executor_trigram_scan.h"
 #include "execution/executor_update.h"
 #include "execution/executor_insert.h"
 #include "execution/executor_delete.h"
 #include "execution/execution_sort.h"
+#include "execution/execution_pipeline.h"
+#include "execution/execution_explain.h"
 #include "common/common.h"
 
 typedef enum portalTag{
@@ -30,7 +34,8 @@ typedef enum portalTag{
     PORTAL_ONE_SELECT,
     PORTAL_DML_WITHOUT_SELECT,
     PORTAL_MULTI_QUERY,
-    PORTAL_CMD_UTILITY
+    PORTAL_CMD_UTILITY,
+    PORTAL_EXPLAIN
 } portalTag;
 
 
@@ -39,7 +44,9 @@ struct PortalStmt {
     
     std::vector<TabCol> sel_cols;
     std::unique_ptr<AbstractExecutor> root;
+    std::unique_ptr<SelectPipeline> pipeline;   // select语句以流水线执行，此时root为空
     std::shared_ptr<Plan> plan;
+    ExplainStats explain_stats;                 // explain analyze时每个计划结点的执行统计
     
     PortalStmt(portalTag tag_, std::vector<TabCol> sel_cols_, std::unique_ptr<AbstractExecutor> root_, std::shared_ptr<Plan> plan_) :
             tag(tag_), sel_cols(std::move(sel_cols_)), root(std::move(root_)), plan(std::move(plan_)) {}
@@ -63,13 +70,29 @@ class Portal
             return std::make_shared<PortalStmt>(PORTAL_CMD_UTILITY, std::vector<TabCol>(), std::unique_ptr<AbstractExecutor>(),plan);
         } else if (auto x = std::dynamic_pointer_cast<DDLPlan>(plan)) {
             return std::make_shared<PortalStmt>(PORTAL_MULTI_QUERY, std::vector<TabCol>(), std::unique_ptr<AbstractExecutor>(),plan);
+        } else if (auto x = std::dynamic_pointer_cast<ExplainPlan>(plan)) {
+            // explain analyze用计数算子包装流水线中的火山模型算子，explain只输出计划，不执行
+            auto select = std::dynamic_pointer_cast<DMLPlan>(x->subplan_);
+            std::shared_ptr<ProjectionPlan> p = std::dynamic_pointer_cast<ProjectionPlan>(select->subplan_);
+            auto portal = std::make_shared<PortalStmt>(PORTAL_EXPLAIN, std::vector<TabCol>(), nullptr, plan);
+            if (x->analyze_) {
+                ExplainStats *stats = &portal->explain_stats;
+                portal->pipeline = std::make_unique<SelectPipeline>(sm_manager_, p, context, [&](std::shared_ptr<Plan> subplan) {
+                    return convert_plan_executor(subplan, context, stats);
+                });
+            }
+            return portal;
         } else if (auto x = std::dynamic_pointer_cast<DMLPlan>(plan)) {
             switch(x->tag) {
                 case T_select:
                 {
                     std::shared_ptr<ProjectionPlan> p = std::dynamic_pointer_cast<ProjectionPlan>(x->subplan_);
-                    std::unique_ptr<AbstractExecutor> root= convert_plan_executor(p, context);
-                    return std::make_shared<PortalStmt>(PORTAL_ONE_SELECT, std::move(p->sel_cols_), std::move(root), plan);
+                    auto pipeline = std::make_unique<SelectPipeline>(sm_manager_, p, context, [&](std::shared_ptr<Plan> subplan) {
+                        return convert_plan_executor(subplan, context);
+                    });
+                    auto portal = std::make_shared<PortalStmt>(PORTAL_ONE_SELECT, std::move(p->sel_cols_), nullptr, plan);
+                    portal->pipeline = std::move(pipeline);
+                    return portal;
                 }
                     
                 case T_Update:
@@ -121,7 +144,11 @@ class Portal
         switch(portal->tag) {
             case PORTAL_ONE_SELECT:
             {
-                ql->select_from(std::move(portal->root), std::move(portal->sel_cols), context);
+                if (portal->pipeline != nullptr) {
+                    ql->select_from(std::move(portal->pipeline), std::move(portal->sel_cols), context);
+                } else {
+                    ql->select_from(std::move(portal->root), std::move(portal->sel_cols), context);
+                }
                 break;
             }
 
@@ -140,6 +167,12 @@ class Portal
                 ql->run_cmd_utility(portal->plan, txn_id, context);
                 break;
             }
+            case PORTAL_EXPLAIN:
+            {
+                ql->explain(std::dynamic_pointer_cast<ExplainPlan>(portal->plan), std::move(portal->pipeline),
+                            portal->explain_stats, context);
+                break;
+            }
             default:
             {
                 throw InternalError("Unexpected field type");
@@ -151,30 +184,44 @@ class Portal
     void drop(){}
 
 
-    std::unique_ptr<AbstractExecutor> convert_plan_executor(std::shared_ptr<Plan> plan, Context *context)
+    /**
+     * @description: 把计划树转换为火山模型的算子树
+     * @param {ExplainStats*} stats 不为空时（explain analyze）用计数算子包装每个算子，并记录计划结点对应的计数算子
+     */
+    std::unique_ptr<AbstractExecutor> convert_plan_executor(std::shared_ptr<Plan> plan, Context *context,
+                                                            ExplainStats *stats = nullptr)
     {
+        std::unique_ptr<AbstractExecutor> exec;
         if(auto x = std::dynamic_pointer_cast<ProjectionPlan>(plan)){
-            return std::make_unique<ProjectionExecutor>(convert_plan_executor(x->subplan_, context), 
+            exec = std::make_unique<ProjectionExecutor>(convert_plan_executor(x->subplan_, context, stats), 
                                                         x->sel_cols_);
         } else if(auto x = std::dynamic_pointer_cast<ScanPlan>(plan)) {
             if(x->tag == T_SeqScan) {
-                return std::make_unique<SeqScanExecutor>(sm_manager_, x->tab_name_, x->conds_, context);
+                exec = std::make_unique<SeqScanExecutor>(sm_manager_, x->tab_name_, x->conds_, context, x->sample_,
+                                                         x->workload_);
+            }
+            else if(x->tag == T_TrigramScan) {
+                exec = std::make_unique<TrigramScanExecutor>(sm_manager_, x->tab_name_, x->conds_, x->index_col_names_[0], context);
             }
             else {
-                return std::make_unique<IndexScanExecutor>(sm_manager_, x->tab_name_, x->conds_, x->index_col_names_, context);
+                exec = std::make_unique<IndexScanExecutor>(sm_manager_, x->tab_name_, x->conds_, x->index_col_names_, context,
+                                                           x->workload_);
             } 
         } else if(auto x = std::dynamic_pointer_cast<JoinPlan>(plan)) {
-            std::unique_ptr<AbstractExecutor> left = convert_plan_executor(x->left_, context);
-            std::unique_ptr<AbstractExecutor> right = convert_plan_executor(x->right_, context);
-            std::unique_ptr<AbstractExecutor> join = std::make_unique<NestedLoopJoinExecutor>(
-                                std::move(left), 
-                                std::move(right), std::move(x->conds_));
-            return join;
+            std::unique_ptr<AbstractExecutor> left = convert_plan_executor(x->left_, context, stats);
+            std::unique_ptr<AbstractExecutor> right = convert_plan_executor(x->right_, context, stats);
+            // 运行时根据内表的实际记录数在嵌套循环和哈希连接之间选择
+            exec = std::make_unique<AdaptiveJoinExecutor>(std::move(left), std::move(right), x->conds_);
         } else if(auto x = std::dynamic_pointer_cast<SortPlan>(plan)) {
-            return std::make_unique<SortExecutor>(convert_plan_executor(x->subplan_, context), 
+            exec = std::make_unique<SortExecutor>(convert_plan_executor(x->subplan_, context, stats), 
                                             x->sel_col_, x->is_desc_);
         }
-        return nullptr;
+        if (stats != nullptr && exec != nullptr) {
+            auto explain = std::make_unique<ExplainExecutor>(std::move(exec));
+            (*stats)[plan.get()] = explain.get();
+            exec = std::move(explain);
+        }
+        return exec;
     }
 
 };
\ No newline at end of file
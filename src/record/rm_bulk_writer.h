@@ -0,0 +1,92 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <vector>
+
+#include "bitmap.h"
+#include "rm_defs.h"
+
+/**
+ * 绕过缓冲池顺序写一个刚由RmManager::create_file创建的表数据文件：
+ * 记录依次紧密存放，页面写满后才使用下一个页面，每SEQ_IO_PAGES个页面写一次磁盘。
+ * 写完后只有最后一个未满的页面在空闲页链表中。
+ */
+class RmBulkWriter {
+   private:
+    DiskManager *disk_manager_;
+    int fd_;
+    RmFileHdr file_hdr_;
+    std::vector<char> batch_;           // 尚未写入磁盘的页面
+    page_id_t batch_first_page_;        // batch_中第一个页面的页号
+    int batch_pages_ = 0;               // batch_中已使用的页面个数
+    int slot_no_;                       // 当前页面中下一个空闲的slot
+
+   public:
+    RmBulkWriter(DiskManager *disk_manager, int fd) : disk_manager_(disk_manager), fd_(fd) {
+        disk_manager_->read_page(fd_, RM_FILE_HDR_PAGE, (char *)&file_hdr_, sizeof(file_hdr_));
+        batch_.resize(SEQ_IO_PAGES * PAGE_SIZE);
+        batch_first_page_ = file_hdr_.num_pages;
+        slot_no_ = file_hdr_.num_records_per_page;
+    }
+
+    /**
+     * @description: 在文件末尾追加一条记录
+     * @return {Rid} 记录在新文件中的位置
+     */
+    Rid append(const char *rec) {
+        if (slot_no_ == file_hdr_.num_records_per_page) {
+            new_page();
+        }
+        char *page = batch_.data() + (batch_pages_ - 1) * PAGE_SIZE;
+        auto page_hdr = reinterpret_cast<RmPageHdr *>(page + Page::OFFSET_PAGE_HDR);
+        char *bitmap = page + Page::OFFSET_PAGE_HDR + sizeof(RmPageHdr);
+        char *slots = bitmap + file_hdr_.bitmap_size;
+        memcpy(slots + slot_no_ * file_hdr_.record_size, rec, file_hdr_.record_size);
+        Bitmap::set(bitmap, slot_no_);
+        page_hdr->num_records++;
+        return Rid{batch_first_page_ + batch_pages_ - 1, slot_no_++};
+    }
+
+    /* 写出剩余的页面和文件头，之后文件可以由RmManager::open_file打开 */
+    void finish() {
+        // 只有最后一个页面可能未满
+        page_id_t last_page = batch_first_page_ + batch_pages_ - 1;
+        bool last_page_free = slot_no_ < file_hdr_.num_records_per_page;
+        flush();
+        file_hdr_.num_pages = batch_first_page_;
+        file_hdr_.first_free_page_no = last_page_free ? last_page : RM_NO_PAGE;
+        disk_manager_->write_page(fd_, RM_FILE_HDR_PAGE, (char *)&file_hdr_, sizeof(file_hdr_));
+    }
+
+   private:
+    void new_page() {
+        if (batch_pages_ == SEQ_IO_PAGES) {
+            flush();
+        }
+        char *page = batch_.data() + batch_pages_ * PAGE_SIZE;
+        memset(page, 0, PAGE_SIZE);
+        auto page_hdr = reinterpret_cast<RmPageHdr *>(page + Page::OFFSET_PAGE_HDR);
+        page_hdr->next_free_page_no = RM_NO_PAGE;
+        page_hdr->num_records = 0;
+        batch_pages_++;
+        slot_no_ = 0;
+    }
+
+    void flush() {
+        if (batch_pages_ == 0) {
+            return;
+        }
+        disk_manager_->write_page(fd_, batch_first_page_, batch_.data(), batch_pages_ * PAGE_SIZE);
+        batch_first_page_ += batch_pages_;
+        batch_pages_ = 0;
+    }
+};
@@ -17,6 +17,9 @@ constexpr int RM_NO_PAGE = -1;
 constexpr int RM_FILE_HDR_PAGE = 0;
 constexpr int RM_FIRST_RECORD_PAGE = 1;
 constexpr int RM_MAX_RECORD_SIZE = 512;
+constexpr int RM_SCAN_PREFETCH_PAGES = 32;   // 顺序扫描时预读的页面个数
+constexpr int RM_SYNC_SCAN_MIN_PAGES = BUFFER_POOL_SIZE / 4;    // 页面数不少于该值的表，并发的顺序扫描同步扫描位置
+constexpr double RM_CLUSTER_FILL_FACTOR = 0.75;  // 聚簇表不按相邻键插入时页面的填充率
 
 /* 文件头，记录表数据文件的元信息，写入磁盘中文件的第0号页面 */
 struct RmFileHdr {
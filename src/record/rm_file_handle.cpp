@@ -10,6 +10,8 @@ See the Mulan PSL v2 for more details. */
 
 #include "rm_file_handle.h"
 
+#include <algorithm>
+
 /**
  * @description: 获取当前表中记录号为rid的记录
  * @param {Rid&} rid 记录号，指定记录的位置
@@ -101,6 +103,66 @@ Rid RmFileHandle::insert_record(char* buf, Context* context) {
     return Rid{page_no, slot_no};
 }
 
+/**
+ * @description: 在当前表中插入一条记录，依次尝试放在page_nos中的页面上，这些页面都已满时退化为insert_record(buf, context)
+ *               聚簇表用它把记录放在键值相邻的记录所在的页面，使按键的范围扫描访问连续的页面
+ * @param {char*} buf 要插入的记录的数据
+ * @param {vector<int>&} page_nos 希望插入的页面
+ * @param {Context*} context
+ * @return {Rid} 插入的记录的记录号（位置）
+ */
+Rid RmFileHandle::insert_record_near(char* buf, const std::vector<int>& page_nos, Context* context) {
+    for (int page_no : page_nos) {
+        if (page_no < RM_FIRST_RECORD_PAGE || page_no >= file_hdr_.num_pages) {
+            continue;
+        }
+        RmPageHandle page_handle = fetch_page_handle(page_no);
+        if (page_handle.page_hdr->num_records == file_hdr_.num_records_per_page) {
+            buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+            continue;
+        }
+
+        int slot_no = Bitmap::first_bit(false, page_handle.bitmap, file_hdr_.num_records_per_page);
+        memcpy(page_handle.get_slot(slot_no), buf, file_hdr_.record_size);
+        Bitmap::set(page_handle.bitmap, slot_no);
+        page_handle.page_hdr->num_records++;
+
+        // 页面已满，从空闲链表中移除；该页不一定是链表头，需要找到它的前驱
+        if (page_handle.page_hdr->num_records == file_hdr_.num_records_per_page) {
+            int next_no = page_handle.page_hdr->next_free_page_no;
+            if (file_hdr_.first_free_page_no == page_no) {
+                file_hdr_.first_free_page_no = next_no;
+                disk_manager_->write_page(fd_, RM_FILE_HDR_PAGE, (char*)&file_hdr_, sizeof(file_hdr_));
+            } else {
+                int prev_no = free_list_prev(page_no);
+                if (prev_no != RM_NO_PAGE) {
+                    RmPageHandle prev = fetch_page_handle(prev_no);
+                    prev.page_hdr->next_free_page_no = next_no;
+                    buffer_pool_manager_->unpin_page(prev.page->get_page_id(), true);
+                    if (next_no != RM_NO_PAGE) {
+                        free_prev_[next_no] = prev_no;
+                    }
+                }
+            }
+            free_prev_.erase(page_no);
+            page_handle.page_hdr->next_free_page_no = RM_NO_PAGE;
+        }
+
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), true);
+        return Rid{page_no, slot_no};
+    }
+    // 相邻页面都已满：只把空闲链表头部的页面填到RM_CLUSTER_FILL_FACTOR，剩余空间留给之后与其中记录相邻的记录
+    if (file_hdr_.first_free_page_no != RM_NO_PAGE) {
+        RmPageHandle head = fetch_page_handle(file_hdr_.first_free_page_no);
+        bool has_room = head.page_hdr->num_records < file_hdr_.num_records_per_page * RM_CLUSTER_FILL_FACTOR;
+        buffer_pool_manager_->unpin_page(head.page->get_page_id(), false);
+        if (!has_room) {
+            buffer_pool_manager_->unpin_page(create_new_page_handle().page->get_page_id(), true);
+        }
+    }
+    return insert_record(buf, context);
+}
+
 /**
  * @description: 在当前表中的指定位置插入一条记录
  * @param {Rid&} rid 要插入记录的位置
@@ -200,6 +262,63 @@ void RmFileHandle::delete_record(const Rid& rid, Context* context) {
     buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), true);
 }
 
+/**
+ * @description: 批量删除记录，先对所有记录申请行级排他锁，再按页面分组，每个页面只获取一次并一次性清除所有要删除的slot。
+ *               记录号不能改变，删空的页面不能归还，只是和其他有空闲slot的页面一样挂在空闲页面链表上
+ * @param {vector<Rid>&} rids 要删除的记录的记录号
+ * @param {Context*} context
+ */
+void RmFileHandle::delete_records(const std::vector<Rid>& rids, Context* context) {
+    // 申请行级排他锁
+    if (context != nullptr && context->txn_ != nullptr && context->lock_mgr_ != nullptr) {
+        for (auto& rid : rids) {
+            if (!context->lock_mgr_->lock_exclusive_on_record(context->txn_, rid, fd_)) {
+                throw std::runtime_error("Failed to acquire exclusive lock on record");
+            }
+        }
+    }
+
+    std::vector<Rid> sorted = rids;
+    std::sort(sorted.begin(), sorted.end(), [](const Rid& a, const Rid& b) {
+        return a.page_no != b.page_no ? a.page_no < b.page_no : a.slot_no < b.slot_no;
+    });
+    for (size_t i = 0; i < sorted.size();) {
+        int page_no = sorted[i].page_no;
+        size_t j = i;
+        while (j < sorted.size() && sorted[j].page_no == page_no) {
+            j++;
+        }
+        if (page_no < RM_FIRST_RECORD_PAGE || page_no >= file_hdr_.num_pages) {
+            throw std::runtime_error("Invalid page number");
+        }
+        RmPageHandle page_handle = fetch_page_handle(page_no);
+        // 先检查这个页面上所有要删除的记录，出错时页面保持不变
+        for (size_t k = i; k < j; k++) {
+            int slot_no = sorted[k].slot_no;
+            if (slot_no < 0 || slot_no >= file_hdr_.num_records_per_page) {
+                buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+                throw std::runtime_error("Invalid slot number");
+            }
+            if (!Bitmap::is_set(page_handle.bitmap, slot_no) || (k > i && sorted[k - 1].slot_no == slot_no)) {
+                buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+                throw std::runtime_error("Record not exists");
+            }
+        }
+
+        bool was_full = (page_handle.page_hdr->num_records == file_hdr_.num_records_per_page);
+        for (size_t k = i; k < j; k++) {
+            Bitmap::reset(page_handle.bitmap, sorted[k].slot_no);
+        }
+        page_handle.page_hdr->num_records -= static_cast<int>(j - i);
+        // 页面从满变成未满，挂到空闲页面链表上
+        if (was_full) {
+            release_page_handle(page_handle);
+        }
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), true);
+        i = j;
+    }
+}
+
 /**
  * @description: 更新记录文件中记录号为rid的记录
  * @param {Rid&} rid 要更新的记录的记录号（位置）
@@ -299,6 +418,9 @@ RmPageHandle RmFileHandle::create_new_page_handle() {
     
     // 将新页面加入到空闲链表头部
     page_handle.page_hdr->next_free_page_no = file_hdr_.first_free_page_no;
+    if (file_hdr_.first_free_page_no != RM_NO_PAGE) {
+        free_prev_[file_hdr_.first_free_page_no] = page_no;
+    }
     file_hdr_.first_free_page_no = page_no;
     
     // 将文件头写回磁盘
@@ -337,9 +459,48 @@ void RmFileHandle::release_page_handle(RmPageHandle& page_handle) {
     // 2. file_hdr_.first_free_page_no
     
     // 将当前页面加入到空闲链表头部
+    int page_no = page_handle.page->get_page_id().page_no;
     page_handle.page_hdr->next_free_page_no = file_hdr_.first_free_page_no;
-    file_hdr_.first_free_page_no = page_handle.page->get_page_id().page_no;
+    if (file_hdr_.first_free_page_no != RM_NO_PAGE) {
+        free_prev_[file_hdr_.first_free_page_no] = page_no;
+    }
+    file_hdr_.first_free_page_no = page_no;
     
     // 将文件头写回磁盘
     disk_manager_->write_page(fd_, RM_FILE_HDR_PAGE, (char*)&file_hdr_, sizeof(file_hdr_));
-}
\ No newline at end of file
+}
+
+/**
+ * @description: 查找空闲链表中page_no的前驱。缓存中的前驱仍指向page_no时直接返回，只需读一个页面；
+ *               否则从链表头遍历一次，同时缓存经过的每个页面的前驱，之后的查找不再遍历
+ *               不在链表中的页面next_free_page_no都为RM_NO_PAGE，所以指向page_no的页面一定是它在链表中的前驱
+ * @param {int} page_no 空闲链表中的页面
+ * @return {int} 前驱的页号，page_no是链表头或不在链表中时为RM_NO_PAGE
+ */
+int RmFileHandle::free_list_prev(int page_no) {
+    auto cached = free_prev_.find(page_no);
+    if (cached != free_prev_.end() && cached->second >= RM_FIRST_RECORD_PAGE && cached->second < file_hdr_.num_pages) {
+        RmPageHandle prev = fetch_page_handle(cached->second);
+        bool valid = prev.page_hdr->next_free_page_no == page_no;
+        buffer_pool_manager_->unpin_page(prev.page->get_page_id(), false);
+        if (valid) {
+            return cached->second;
+        }
+    }
+    int found = RM_NO_PAGE;
+    int prev_no = file_hdr_.first_free_page_no;
+    while (prev_no != RM_NO_PAGE) {
+        RmPageHandle prev = fetch_page_handle(prev_no);
+        int next_no = prev.page_hdr->next_free_page_no;
+        buffer_pool_manager_->unpin_page(prev.page->get_page_id(), false);
+        if (next_no == RM_NO_PAGE) {
+            break;
+        }
+        free_prev_[next_no] = prev_no;
+        if (next_no == page_no) {
+            found = prev_no;
+        }
+        prev_no = next_no;
+    }
+    return found;
+}
@@ -12,7 +12,10 @@ See the Mulan PSL v2 for more details. */
 
 #include <assert.h>
 
+#include <atomic>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "bitmap.h"
 #include "common/context.h"
@@ -50,6 +53,8 @@ class RmFileHandle {
     BufferPoolManager *buffer_pool_manager_;
     int fd_;        // 打开文件后产生的文件句柄
     RmFileHdr file_hdr_;    // 文件头，维护当前表文件的元数据
+    mutable std::atomic<int> sync_scan_page_{RM_FIRST_RECORD_PAGE};  // 同步扫描最近报告的位置
+    std::unordered_map<int, int> free_prev_;  // page_no -> 空闲链表中前驱的页号，只是缓存，使用前检查前驱是否仍指向该页
 
    public:
     RmFileHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd)
@@ -68,25 +73,93 @@ class RmFileHandle {
     /* 判断指定位置上是否已经存在一条记录，通过Bitmap来判断 */
     bool is_record(const Rid &rid) const {
         RmPageHandle page_handle = fetch_page_handle(rid.page_no);
-        return Bitmap::is_set(page_handle.bitmap, rid.slot_no);  // page的slot_no位置上是否有record
+        bool exists = Bitmap::is_set(page_handle.bitmap, rid.slot_no);  // page的slot_no位置上是否有record
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+        return exists;
     }
 
     std::unique_ptr<RmRecord> get_record(const Rid &rid, Context *context) const;
 
     Rid insert_record(char *buf, Context *context);
 
+    Rid insert_record_near(char *buf, const std::vector<int> &page_nos, Context *context);
+
     void insert_record(const Rid &rid, char *buf);
 
     void delete_record(const Rid &rid, Context *context);
 
+    void delete_records(const std::vector<Rid> &rids, Context *context);
+
     void update_record(const Rid &rid, char *buf, Context *context);
 
     RmPageHandle create_new_page_handle();
 
     RmPageHandle fetch_page_handle(int page_no) const;
 
+    /**
+     * @description: 同步扫描：大表上的顺序扫描从正在进行的扫描最近报告的位置开始，读到文件末尾后回到开头读完之前跳过的页面。
+     *               并发的扫描读同一批页面，每个页面只需从磁盘读一次，由其他扫描从缓冲池中命中
+     * @return {int} 扫描的起始页面，没有报告过位置时为RM_FIRST_RECORD_PAGE
+     */
+    int sync_scan_start() const {
+        int page_no = sync_scan_page_.load(std::memory_order_relaxed);
+        return page_no < file_hdr_.num_pages ? page_no : RM_FIRST_RECORD_PAGE;
+    }
+
+    /* 只有大表的顺序扫描才同步，小表的扫描保持从头到尾的顺序 */
+    bool use_sync_scan() const { return file_hdr_.num_pages - RM_FIRST_RECORD_PAGE >= RM_SYNC_SCAN_MIN_PAGES; }
+
+    /* 同步扫描报告当前读到的位置，每个预读窗口报告一次 */
+    void report_scan_position(int page_no) const { sync_scan_page_.store(page_no, std::memory_order_relaxed); }
+
+    /* 预读pages[begin, end)中的页面，页号连续的页面合并为一次预读 */
+    void prefetch_page_list(const std::vector<int> &pages, size_t begin, size_t end) const {
+        while (begin < end) {
+            size_t run = begin + 1;
+            while (run < end && pages[run] == pages[run - 1] + 1) {
+                run++;
+            }
+            buffer_pool_manager_->prefetch_pages(fd_, pages[begin], static_cast<int>(run - begin));
+            begin = run;
+        }
+    }
+
+    /**
+     * @description: 依次把page_no页上的每条记录交给consumer(rid, 记录地址)，记录不复制，
+     *               consumer返回前页面一直被pin住，因此consumer不能保留记录地址
+     */
+    template <typename Consumer>
+    void scan_page(int page_no, Consumer &&consumer) const {
+        scan_fetched_page(fetch_page_handle(page_no).page, std::forward<Consumer>(consumer));
+    }
+
+    /* 与scan_page相同，页面已经被pin住（例如由fetch_page_async得到），处理完后unpin */
+    template <typename Consumer>
+    void scan_fetched_page(Page *page, Consumer &&consumer) const {
+        RmPageHandle page_handle(&file_hdr_, page);
+        int page_no = page->get_page_id().page_no;
+        int num_slots = file_hdr_.num_records_per_page;
+        try {
+            for (int slot_no = Bitmap::first_bit(true, page_handle.bitmap, num_slots); slot_no < num_slots;
+                 slot_no = Bitmap::next_bit(true, page_handle.bitmap, num_slots, slot_no)) {
+                consumer(Rid{page_no, slot_no}, static_cast<const char *>(page_handle.get_slot(slot_no)));
+            }
+        } catch (...) {
+            buffer_pool_manager_->unpin_page(page->get_page_id(), false);
+            throw;
+        }
+        buffer_pool_manager_->unpin_page(page->get_page_id(), false);
+    }
+
+    /* 在协程中获取从page_no开始的num_pages个页面，见BufferPoolManager::fetch_pages_async */
+    std::vector<PageFetch> fetch_pages_async(int page_no, int num_pages, CoScheduler *scheduler) const {
+        return buffer_pool_manager_->fetch_pages_async(fd_, page_no, num_pages, scheduler);
+    }
+
    private:
     RmPageHandle create_page_handle();
 
     void release_page_handle(RmPageHandle &page_handle);
+
+    int free_list_prev(int page_no);
 };
\ No newline at end of file
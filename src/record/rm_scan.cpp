@@ -14,8 +14,12 @@ See the Mulan PSL v2 for more details. */
 /**
  * @brief 初始化file_handle和rid
  * @param file_handle
+ * @param sync 是否与表上并发的顺序扫描同步扫描位置，记录的输出顺序因此不固定
  */
-RmScan::RmScan(const RmFileHandle *file_handle) : file_handle_(file_handle) {
+RmScan::RmScan(const RmFileHandle *file_handle, bool sync)
+    : file_handle_(file_handle), sync_(sync && file_handle->use_sync_scan()) {
+    start_page_ = sync_ ? file_handle_->sync_scan_start() : RM_FIRST_RECORD_PAGE;
+    prefetch_end_ = start_page_;
     // 初始化file_handle，rid设置为无效值
     rid_.page_no = RM_NO_PAGE;
     rid_.slot_no = -1;
@@ -24,6 +28,20 @@ RmScan::RmScan(const RmFileHandle *file_handle) : file_handle_(file_handle) {
     next();
 }
 
+/**
+ * @brief 采样扫描：只读取采样器选中的页面，不与其他扫描同步
+ * @param file_handle
+ * @param sampler tablesample的采样器
+ */
+RmScan::RmScan(const RmFileHandle *file_handle, std::unique_ptr<RmSampler> sampler)
+    : file_handle_(file_handle), sync_(false), start_page_(RM_FIRST_RECORD_PAGE), sampler_(std::move(sampler)) {
+    prefetch_end_ = start_page_;
+    sample_pages_ = sampler_->pages(file_handle_->file_hdr_.num_pages);
+    rid_.page_no = RM_NO_PAGE;
+    rid_.slot_no = -1;
+    next();
+}
+
 /**
  * @brief 找到文件中下一个存放了记录的位置
  */
@@ -32,6 +50,10 @@ void RmScan::next() {
     if (is_end()) {
         return;
     }
+    if (sampler_ != nullptr) {
+        next_sampled();
+        return;
+    }
     
     // 获取文件中的页数
     int num_pages = file_handle_->file_hdr_.num_pages;
@@ -39,8 +61,8 @@ void RmScan::next() {
     // 确定起始搜索位置
     int start_page, start_slot;
     if (rid_.page_no == RM_NO_PAGE || rid_.slot_no == -1) {
-        // 第一次调用，从第一页第一个slot开始
-        start_page = RM_FIRST_RECORD_PAGE;
+        // 第一次调用，从起始页面第一个slot开始
+        start_page = start_page_;
         start_slot = 0;
     } else {
         // 从当前rid的下一个位置开始
@@ -48,8 +70,28 @@ void RmScan::next() {
         start_slot = rid_.slot_no + 1;
     }
     
-    // 遍历所有页面寻找下一个有效记录
-    for (int page_no = start_page; page_no < num_pages; ++page_no) {
+    // 遍历所有页面寻找下一个有效记录，从中间开始的扫描读到文件末尾后回到开头
+    for (int page_no = start_page;; ++page_no) {
+        int end_page = wrapped_ ? start_page_ : num_pages;
+        if (page_no >= end_page) {
+            if (wrapped_ || start_page_ == RM_FIRST_RECORD_PAGE) {
+                break;
+            }
+            wrapped_ = true;
+            prefetch_end_ = RM_FIRST_RECORD_PAGE;
+            page_no = RM_FIRST_RECORD_PAGE;
+            end_page = start_page_;
+            if (page_no >= end_page) {
+                break;
+            }
+        }
+        // 预读窗口消耗过半时，继续预读后面的页面，使磁盘上始终有多个读请求在途
+        if (page_no + RM_SCAN_PREFETCH_PAGES / 2 >= prefetch_end_) {
+            if (sync_) {
+                file_handle_->report_scan_position(page_no);
+            }
+            prefetch(page_no, end_page);
+        }
         // 获取当前页的句柄
         RmPageHandle page_handle = file_handle_->fetch_page_handle(page_no);
         if (page_handle.page == nullptr) {
@@ -80,14 +122,14 @@ void RmScan::next() {
     // 没有找到更多记录，设置rid为文件末尾
     rid_.page_no = num_pages;
     rid_.slot_no = 0;
+    end_ = true;
 }
 
 /**
- * @brief 判断是否到达文件末尾
+ * @brief 判断是否已扫描完所有页面
  */
 bool RmScan::is_end() const {
-    // 如果rid指向的页号大于等于文件总页数，说明到达文件末尾
-    return rid_.page_no >= file_handle_->file_hdr_.num_pages;
+    return end_;
 }
 
 /**
@@ -95,4 +137,44 @@ bool RmScan::is_end() const {
  */
 Rid RmScan::rid() const {
     return rid_;
-}
\ No newline at end of file
+}
+/**
+ * @brief 从page_no开始预读RM_SCAN_PREFETCH_PAGES个页面，不超过本轮扫描的终点end_page，已预读过的页面不再重复预读
+ */
+void RmScan::prefetch(int page_no, int end_page) {
+    int begin = std::max(page_no, prefetch_end_);
+    int end = std::min(page_no + RM_SCAN_PREFETCH_PAGES, end_page);
+    if (begin < end) {
+        file_handle_->buffer_pool_manager_->prefetch_pages(file_handle_->fd_, begin, end - begin);
+    }
+    prefetch_end_ = std::max(prefetch_end_, end);
+}
+
+/**
+ * @brief 在采样选中的页面中找到下一条被采样的记录
+ */
+void RmScan::next_sampled() {
+    int num_slots = file_handle_->file_hdr_.num_records_per_page;
+    int slot_no = rid_.slot_no;
+    for (; sample_idx_ < sample_pages_.size(); sample_idx_++, slot_no = -1) {
+        // 与全表扫描相同，预读窗口消耗过半时继续预读后面被选中的页面
+        if (sample_idx_ + RM_SCAN_PREFETCH_PAGES / 2 >= sample_prefetch_end_) {
+            size_t end = std::min(sample_idx_ + RM_SCAN_PREFETCH_PAGES, sample_pages_.size());
+            file_handle_->prefetch_page_list(sample_pages_, std::max(sample_idx_, sample_prefetch_end_), end);
+            sample_prefetch_end_ = std::max(sample_prefetch_end_, end);
+        }
+        int page_no = sample_pages_[sample_idx_];
+        RmPageHandle page_handle = file_handle_->fetch_page_handle(page_no);
+        while ((slot_no = Bitmap::next_bit(true, page_handle.bitmap, num_slots, slot_no)) < num_slots) {
+            if (sampler_->keep_row()) {
+                rid_ = Rid{page_no, slot_no};
+                file_handle_->buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+                return;
+            }
+        }
+        file_handle_->buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+    }
+    rid_.page_no = file_handle_->file_hdr_.num_pages;
+    rid_.slot_no = 0;
+    end_ = true;
+}
@@ -10,15 +10,73 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <memory>
+#include <random>
+#include <vector>
+
 #include "rm_defs.h"
 
 class RmFileHandle;
 
+/**
+ * TABLESAMPLE的采样器：SYSTEM以page_fraction的概率选取页面，未选中的页面既不读取也不预读；
+ * BERNOULLI读取所有页面，以row_fraction的概率选取每条记录
+ */
+class RmSampler {
+    std::mt19937_64 rng_;
+    double page_fraction_;
+    double row_fraction_;
+
+   public:
+    RmSampler(double page_fraction, double row_fraction)
+        : rng_(std::random_device{}()), page_fraction_(page_fraction), row_fraction_(row_fraction) {}
+
+    /**
+     * @description: 选出[RM_FIRST_RECORD_PAGE, num_pages)中被采样的页面，按页号升序返回
+     *               相邻两个选中页面的间隔服从几何分布，直接抽取间隔，代价与选中的页面数而不是表的页面数成正比
+     */
+    std::vector<int> pages(int num_pages) {
+        std::vector<int> pages;
+        if (page_fraction_ >= 1) {
+            for (int page_no = RM_FIRST_RECORD_PAGE; page_no < num_pages; page_no++) {
+                pages.push_back(page_no);
+            }
+        } else if (page_fraction_ > 0) {
+            std::geometric_distribution<int64_t> gap(page_fraction_);
+            for (int64_t page_no = RM_FIRST_RECORD_PAGE + gap(rng_); page_no < num_pages; page_no += gap(rng_) + 1) {
+                pages.push_back(static_cast<int>(page_no));
+            }
+        }
+        return pages;
+    }
+
+    /* 当前记录是否被采样 */
+    bool keep_row() {
+        return row_fraction_ >= 1 || std::uniform_real_distribution<double>(0, 1)(rng_) < row_fraction_;
+    }
+};
+
 class RmScan : public RecScan {
     const RmFileHandle *file_handle_;
     Rid rid_;
+    bool sync_;                 // 是否为同步扫描
+    int start_page_;            // 扫描的起始页面，同步扫描时可能不是RM_FIRST_RECORD_PAGE
+    bool wrapped_ = false;      // 已读到文件末尾，正在扫描start_page_之前的页面
+    bool end_ = false;
+    int prefetch_end_;          // 当前一轮中[起点, prefetch_end_)的页面已经发出过预读
+
+    std::unique_ptr<RmSampler> sampler_;    // tablesample，为空表示扫描全表
+    std::vector<int> sample_pages_;         // 采样扫描只读取这些页面
+    size_t sample_idx_ = 0;                 // 当前页面在sample_pages_中的下标
+    size_t sample_prefetch_end_ = 0;        // sample_pages_中下标小于该值的页面已经发出过预读
+
+    void prefetch(int page_no, int end_page);
+
+    void next_sampled();
 public:
-    RmScan(const RmFileHandle *file_handle);
+    RmScan(const RmFileHandle *file_handle, bool sync = false);
+
+    RmScan(const RmFileHandle *file_handle, std::unique_ptr<RmSampler> sampler);
 
     void next() override;
 
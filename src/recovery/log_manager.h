@@ -24,7 +24,8 @@ enum LogType: int {
     DELETE,
     begin,
     commit,
-    ABORT
+    ABORT,
+    TRUNCATE
 };
 static std::string LogTypeStr[] = {
     "UPDATE",
@@ -32,7 +33,8 @@ static std::string LogTypeStr[] = {
     "DELETE",
     "BEGIN",
     "COMMIT",
-    "ABORT"
+    "ABORT",
+    "TRUNCATE"
 };
 
 class LogRecord {
@@ -189,6 +191,59 @@ class UpdateLogRecord: public LogRecord {
 
 };
 
+/**
+ * TRUNCATE操作的日志记录，整张表只记录一条日志，不记录被清空的记录
+ * 旧的表文件和索引文件在事务提交前保留，回滚时直接换回
+ */
+class TruncateLogRecord: public LogRecord {
+public:
+    TruncateLogRecord() {
+        log_type_ = LogType::TRUNCATE;
+        lsn_ = INVALID_LSN;
+        log_tot_len_ = LOG_HEADER_SIZE;
+        log_tid_ = INVALID_TXN_ID;
+        prev_lsn_ = INVALID_LSN;
+        table_name_ = nullptr;
+        table_name_size_ = 0;
+    }
+    TruncateLogRecord(txn_id_t txn_id, std::string table_name) 
+        : TruncateLogRecord() {
+        log_tid_ = txn_id;
+        table_name_size_ = table_name.length();
+        table_name_ = new char[table_name_size_];
+        memcpy(table_name_, table_name.c_str(), table_name_size_);
+        log_tot_len_ += sizeof(size_t) + table_name_size_;
+    }
+    ~TruncateLogRecord() { delete[] table_name_; }
+
+    // 把truncate日志记录序列化到dest中
+    void serialize(char* dest) const override {
+        LogRecord::serialize(dest);
+        int offset = OFFSET_LOG_DATA;
+        memcpy(dest + offset, &table_name_size_, sizeof(size_t));
+        offset += sizeof(size_t);
+        memcpy(dest + offset, table_name_, table_name_size_);
+    }
+    // 从src中反序列化出一条Truncate日志记录
+    void deserialize(const char* src) override {
+        LogRecord::deserialize(src);
+        int offset = OFFSET_LOG_DATA;
+        table_name_size_ = *reinterpret_cast<const size_t*>(src + offset);
+        offset += sizeof(size_t);
+        delete[] table_name_;
+        table_name_ = new char[table_name_size_];
+        memcpy(table_name_, src + offset, table_name_size_);
+    }
+    void format_print() override {
+        printf("truncate table\n");
+        LogRecord::format_print();
+        printf("table name: %.*s\n", (int)table_name_size_, table_name_);
+    }
+
+    char* table_name_;          // 被清空的表名称
+    size_t table_name_size_;    // 表名称的大小
+};
+
 /* 日志缓冲区，只有一个buffer，因此需要阻塞地去把日志写入缓冲区中 */
 
 class LogBuffer {
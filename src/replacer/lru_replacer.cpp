@@ -10,11 +10,20 @@ See the Mulan PSL v2 for more details. */
 
 #include "lru_replacer.h"
 
-LRUReplacer::LRUReplacer(size_t num_pages) { 
-    max_size_ = num_pages; 
+#include <functional>
+#include <thread>
+
+LRUReplacer::LRUReplacer(size_t num_pages) {
+    max_size_ = num_pages;
+    LRUpos_.resize(max_size_, LRUlist_.end());
+    states_ = std::make_unique<std::atomic<uint8_t>[]>(max_size_);
+    for (size_t i = 0; i < max_size_; i++) {
+        states_[i].store(FRAME_ABSENT, std::memory_order_relaxed);
+    }
+    buffers_ = std::make_unique<AccessBuffer[]>(LRU_ACCESS_BUFFER_STRIPES);
 }
 
-LRUReplacer::~LRUReplacer() = default;  
+LRUReplacer::~LRUReplacer() = default;
 
 /**
  * @description: 使用LRU策略删除一个victim frame，并返回该frame的id
@@ -26,20 +35,23 @@ bool LRUReplacer::victim(frame_id_t* frame_id) {
     // 它能够避免死锁发生，其构造函数能够自动进行上锁操作，析构函数会对互斥量进行解锁操作，保证线程安全。
     std::scoped_lock lock{latch_};  //  如果编译报错可以替换成其他lock
 
-    // Todo:
-    //  利用lru_replacer中的LRUlist_,LRUHash_实现LRU策略
-    //  选择合适的frame指定为淘汰页面,赋值给*frame_id
+    // 先把缓冲区中记录的访问应用到链表上
+    drain_buffers();
 
-    if (LRUlist_.empty()) {
-        return false;
+    // 从链表尾部开始找第一个可淘汰的frame，被固定的frame正在使用，移到首部，下次不必再跳过
+    for (size_t n = LRUlist_.size(); n > 0; n--) {
+        frame_id_t candidate = LRUlist_.back();
+        uint8_t expected = FRAME_EVICTABLE;
+        if (states_[candidate].compare_exchange_strong(expected, FRAME_ABSENT)) {
+            LRUlist_.pop_back();
+            LRUpos_[candidate] = LRUlist_.end();
+            num_evictable_.fetch_sub(1);
+            *frame_id = candidate;
+            return true;
+        }
+        LRUlist_.splice(LRUlist_.begin(), LRUlist_, std::prev(LRUlist_.end()));
     }
-
-    // 淘汰链表尾部的frame
-    *frame_id = LRUlist_.back();
-    LRUlist_.pop_back();
-    LRUhash_.erase(*frame_id);
-
-    return true;
+    return false;
 }
 
 /**
@@ -47,17 +59,10 @@ bool LRUReplacer::victim(frame_id_t* frame_id) {
  * @param {frame_id_t} 需要固定的frame的id
  */
 void LRUReplacer::pin(frame_id_t frame_id) {
-    std::scoped_lock lock{latch_};
-    
-    // Todo:
-    // 固定指定id的frame
-    // 在数据结构中移除该frame
-
-    // 如果frame在LRU中，将其移除
-    auto it = LRUhash_.find(frame_id);
-    if (it != LRUhash_.end()) {
-        LRUlist_.erase(it->second);
-        LRUhash_.erase(it);
+    // 只修改状态，frame留在链表中，不在链表中的frame不受影响
+    uint8_t expected = FRAME_EVICTABLE;
+    if (states_[frame_id].compare_exchange_strong(expected, FRAME_PINNED)) {
+        num_evictable_.fetch_sub(1);
     }
 }
 
@@ -66,32 +71,79 @@ void LRUReplacer::pin(frame_id_t frame_id) {
  * @param {frame_id_t} frame_id 取消固定的frame的id
  */
 void LRUReplacer::unpin(frame_id_t frame_id) {
-    // Todo:
-    //  支持并发锁
-    //  选择一个frame取消固定
-    std::scoped_lock lock{latch_};
-    
-    // 如果frame已经在LRU中，不进行任何操作，这样第二次unpin同一个frame不会改变它的位置
-    if (LRUhash_.find(frame_id) != LRUhash_.end()) {
+    // 已经可以淘汰的frame不进行任何操作，这样第二次unpin同一个frame不会改变它的位置
+    uint8_t expected = FRAME_PINNED;
+    if (states_[frame_id].compare_exchange_strong(expected, FRAME_EVICTABLE)) {
+        num_evictable_.fetch_add(1);
+        record_access(frame_id);
         return;
     }
-    
-    // 如果LRU已满，淘汰最久未使用的frame
-    if (LRUlist_.size() >= max_size_) {
-        frame_id_t victim_frame = LRUlist_.back();
-        LRUlist_.pop_back();
-        LRUhash_.erase(victim_frame);
+    if (expected == FRAME_EVICTABLE) {
+        return;
+    }
+
+    // frame不在链表中，加入链表首部。先应用缓冲区中更早的访问，保持访问顺序
+    std::scoped_lock lock{latch_};
+    drain_buffers();
+    // 不在链表中的frame只能由持有latch_的unpin加入链表，已经被其他线程加入时不再重复加入
+    expected = FRAME_ABSENT;
+    if (!states_[frame_id].compare_exchange_strong(expected, FRAME_EVICTABLE)) {
+        return;
     }
-    
-    // 将frame添加到链表头部（最近使用）
     LRUlist_.push_front(frame_id);
-    LRUhash_[frame_id] = LRUlist_.begin();
+    LRUpos_[frame_id] = LRUlist_.begin();
+    num_evictable_.fetch_add(1);
 }
 
 /**
  * @description: 获取当前replacer中可以被淘汰的页面数量
  */
-size_t LRUReplacer::Size() { 
-    std::scoped_lock lock{latch_};
-    return LRUlist_.size(); 
-}
\ No newline at end of file
+size_t LRUReplacer::Size() {
+    return num_evictable_.load();
+}
+
+/**
+ * @description: 把一次访问记入当前线程所在条带的缓冲区，缓冲区写满时尝试获取latch_应用所有缓冲区，获取不到则丢弃这次访问
+ * @param {frame_id_t} frame_id 被访问的frame的id
+ */
+void LRUReplacer::record_access(frame_id_t frame_id) {
+    static thread_local size_t stripe =
+        std::hash<std::thread::id>{}(std::this_thread::get_id()) % LRU_ACCESS_BUFFER_STRIPES;
+    AccessBuffer &buf = buffers_[stripe];
+    uint32_t tail = buf.tail.load(std::memory_order_relaxed);
+    if (tail - buf.head.load(std::memory_order_acquire) >= LRU_ACCESS_BUFFER_SIZE) {
+        std::unique_lock<std::mutex> lock(latch_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return;
+        }
+        drain_buffers();
+        tail = buf.tail.load(std::memory_order_relaxed);
+    }
+    // 同一条带上的其他线程同时写入时放弃这次访问
+    if (!buf.tail.compare_exchange_strong(tail, tail + 1, std::memory_order_relaxed)) {
+        return;
+    }
+    buf.slots[tail % LRU_ACCESS_BUFFER_SIZE].store(frame_id, std::memory_order_release);
+}
+
+/**
+ * @description: 按记录顺序把缓冲区中的访问应用到链表上，调用者持有latch_
+ */
+void LRUReplacer::drain_buffers() {
+    for (size_t s = 0; s < LRU_ACCESS_BUFFER_STRIPES; s++) {
+        AccessBuffer &buf = buffers_[s];
+        uint32_t head = buf.head.load(std::memory_order_relaxed);
+        uint32_t tail = buf.tail.load(std::memory_order_acquire);
+        for (; head != tail; head++) {
+            frame_id_t frame_id =
+                buf.slots[head % LRU_ACCESS_BUFFER_SIZE].exchange(INVALID_FRAME_ID, std::memory_order_acquire);
+            if (frame_id == INVALID_FRAME_ID) {
+                break;  // 写入的线程已经占用了这个位置但还没有写入，下次再应用
+            }
+            if (LRUpos_[frame_id] != LRUlist_.end()) {
+                LRUlist_.splice(LRUlist_.begin(), LRUlist_, LRUpos_[frame_id]);
+            }
+        }
+        buf.head.store(head, std::memory_order_release);
+    }
+}
@@ -10,16 +10,22 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <atomic>
 #include <list>
-#include <mutex>  
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "common/config.h"
 #include "replacer/replacer.h"
-#include "unordered_map"
 
 /*
 LRUReplacer实现了LRU替换策略
+
+每个frame的状态（不在链表中、被固定、可淘汰）用原子变量记录，pin/unpin已在链表中的frame时只修改状态，不获取latch_。
+unpin时把frame记入访问缓冲区，持有latch_的线程（victim、第一次unpin某个frame、缓冲区写满时）按顺序把缓冲区中的
+frame移到链表首部。缓冲区按线程分成多个条带，条带写满且latch_被占用时丢弃这次访问，只影响淘汰顺序的精确程度。
+被固定的frame留在链表中，victim时跳过。
 */
 class LRUReplacer : public Replacer {
    public:
@@ -40,8 +46,30 @@ class LRUReplacer : public Replacer {
     size_t Size();
 
    private:
-    std::mutex latch_;                  // 互斥锁
-    std::list<frame_id_t> LRUlist_;     // 按加入的时间顺序存放unpinned pages的frame id，首部表示最近被访问
-    std::unordered_map<frame_id_t, std::list<frame_id_t>::iterator> LRUhash_;   // frame_id_t -> unpinned pages的frame id
+    enum FrameState : uint8_t { FRAME_ABSENT, FRAME_PINNED, FRAME_EVICTABLE };
+
+    /* 一个条带的访问缓冲区，tail由写入的线程推进，head只在持有latch_时推进 */
+    struct alignas(64) AccessBuffer {
+        std::atomic<uint32_t> head{0};
+        std::atomic<uint32_t> tail{0};
+        std::atomic<frame_id_t> slots[LRU_ACCESS_BUFFER_SIZE];
+
+        AccessBuffer() {
+            for (auto &slot : slots) {
+                slot.store(INVALID_FRAME_ID, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    void record_access(frame_id_t frame_id);
+
+    void drain_buffers();
+
+    std::mutex latch_;                  // 互斥锁，保护LRUlist_、LRUpos_和缓冲区的head
+    std::list<frame_id_t> LRUlist_;     // 按访问时间排列的frame id，首部表示最近被访问
+    std::vector<std::list<frame_id_t>::iterator> LRUpos_;   // frame_id_t -> frame在LRUlist_中的位置
+    std::unique_ptr<std::atomic<uint8_t>[]> states_;        // frame_id_t -> FrameState
+    std::atomic<size_t> num_evictable_{0};                  // 可淘汰的frame数量
+    std::unique_ptr<AccessBuffer[]> buffers_;               // LRU_ACCESS_BUFFER_STRIPES个条带
     size_t max_size_;   // 最大容量（与缓冲池的容量相同）
 };
@@ -17,34 +17,22 @@ See the Mulan PSL v2 for more details. */
 #include <atomic>
 
 #include "errors.h"
-#include "optimizer/optimizer.h"
-#include "recovery/log_recovery.h"
-#include "optimizer/plan.h"
-#include "optimizer/planner.h"
-#include "portal.h"
-#include "analyze/analyze.h"
+#include "embedded/engine.h"
 
 #define SOCK_PORT 8765
 #define MAX_CONN_LIMIT 8
 
 static bool should_exit = false;
 
-// 构建全局所需的管理器对象
-auto disk_manager = std::make_unique<DiskManager>();
-auto buffer_pool_manager = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager.get());
-auto rm_manager = std::make_unique<RmManager>(disk_manager.get(), buffer_pool_manager.get());
-auto ix_manager = std::make_unique<IxManager>(disk_manager.get(), buffer_pool_manager.get());
-auto sm_manager = std::make_unique<SmManager>(disk_manager.get(), buffer_pool_manager.get(), rm_manager.get(), ix_manager.get());
-auto lock_manager = std::make_unique<LockManager>();
-auto txn_manager = std::make_unique<TransactionManager>(lock_manager.get(), sm_manager.get());
-auto ql_manager = std::make_unique<QlManager>(sm_manager.get(), txn_manager.get());
-auto log_manager = std::make_unique<LogManager>(disk_manager.get());
-auto recovery = std::make_unique<RecoveryManager>(disk_manager.get(), buffer_pool_manager.get(), sm_manager.get());
-auto planner = std::make_unique<Planner>(sm_manager.get());
-auto optimizer = std::make_unique<Optimizer>(sm_manager.get(), planner.get());
-auto portal = std::make_unique<Portal>(sm_manager.get());
-auto analyze = std::make_unique<Analyze>(sm_manager.get());
-pthread_mutex_t *buffer_mutex;
+// 构建全局所需的管理器对象，与嵌入式接口共用同一个Engine
+auto engine = std::make_unique<Engine>();
+auto &lock_manager = engine->lock_manager_;
+auto &txn_manager = engine->txn_manager_;
+auto &ql_manager = engine->ql_manager_;
+auto &log_manager = engine->log_manager_;
+auto &optimizer = engine->optimizer_;
+auto &portal = engine->portal_;
+auto &analyze = engine->analyze_;
 pthread_mutex_t *sockfd_mutex;
 
 static jmp_buf jmpbuf;
@@ -120,9 +108,26 @@ void *client_handler(void *sock_fd) {
         // Lab 4 need to restart transaction
         SetTransaction(&txn_id, context);
 
+        // 单条语句的select先查结果缓存，命中时不再解析和执行；显式事务中可能读到自己未提交的修改，不使用缓存
+        std::string cache_key;
+        if (engine->result_cache_ != nullptr && !context->txn_->get_txn_mode()) {
+            cache_key = ResultCache::normalize(data_recv);
+        }
+        if (!cache_key.empty()) {
+            if (auto result = engine->result_cache_->lookup(cache_key, engine->sm_manager_.get())) {
+                ql_manager->select_cached(*result, context);
+                if (write(fd, data_send, offset + 1) == -1) {
+                    break;
+                }
+                txn_manager->commit(context->txn_, context->log_mgr_);
+                continue;
+            }
+        }
+        std::shared_ptr<CachedResult> cache_result;
+
         // 用于判断是否已经调用了yy_delete_buffer来删除buf
         bool finish_analyze = false;
-        pthread_mutex_lock(buffer_mutex);
+        engine->parser_latch().lock();
         YY_BUFFER_STATE buf = yy_scan_string(data_recv);
         if (yyparse() == 0) {
             if (ast::parse_tree != nullptr) {
@@ -131,13 +136,25 @@ void *client_handler(void *sock_fd) {
                     std::shared_ptr<Query> query = analyze->do_analyze(ast::parse_tree);
                     yy_delete_buffer(buf);
                     finish_analyze = true;
-                    pthread_mutex_unlock(buffer_mutex);
+                    engine->parser_latch().unlock();
+                    // 缓存的结果记录执行前所引用表的版本，执行期间有事务提交时该结果下次查找即失效；采样的结果是随机的，不缓存
+                    if (!cache_key.empty() && std::dynamic_pointer_cast<ast::SelectStmt>(query->parse) &&
+                        !query->sample.enabled()) {
+                        cache_result = std::make_shared<CachedResult>();
+                        for (auto &tab_name : query->tables) {
+                            cache_result->versions.emplace_back(tab_name, engine->sm_manager_->table_version(tab_name));
+                        }
+                        context->result_capture_ = cache_result.get();
+                    }
                     // 优化器
                     std::shared_ptr<Plan> plan = optimizer->plan_query(query, context);
                     // portal
                     std::shared_ptr<PortalStmt> portalStmt = portal->start(plan, context);
                     portal->run(portalStmt, ql_manager.get(), &txn_id, context);
                     portal->drop();
+                    if (cache_result != nullptr) {
+                        engine->result_cache_->insert(cache_key, cache_result);
+                    }
                 } catch (TransactionAbortException &e) {
                     // 事务需要回滚，需要把abort信息返回给客户端并写入output.txt文件中
                     std::string str = "abort\n";
@@ -172,7 +189,7 @@ void *client_handler(void *sock_fd) {
         }
         if(finish_analyze == false) {
             yy_delete_buffer(buf);
-            pthread_mutex_unlock(buffer_mutex);
+            engine->parser_latch().unlock();
         }
         // future TODO: 格式化 sql_handler.result, 传给客户端
         // send result with fixed format, use protobuf in the future
@@ -194,9 +211,7 @@ void *client_handler(void *sock_fd) {
 
 void start_server() {
     // init mutex
-    buffer_mutex = (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t));
     sockfd_mutex = (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t));
-    pthread_mutex_init(buffer_mutex, nullptr);
     pthread_mutex_init(sockfd_mutex, nullptr);
 
     int sockfd_server;
@@ -258,17 +273,20 @@ void start_server() {
     int ret = shutdown(sockfd_server, SHUT_WR);  // shut down the all or part of a full-duplex connection.
     if(ret == -1) { printf("%s\n", strerror(errno)); }
 //    assert(ret != -1);
-    sm_manager->close_db();
+    engine->close_db();
     std::cout << " DB has been closed.\n";
     std::cout << "Server shuts down." << std::endl;
 }
 
 int main(int argc, char **argv) {
-    if (argc != 2) {
+    if (argc != 2 && !(argc == 3 && strcmp(argv[2], "--result-cache") == 0)) {
         // 需要指定数据库名称
-        std::cerr << "Usage: " << argv[0] << " <database>" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <database> [--result-cache]" << std::endl;
         exit(1);
     }
+    if (argc == 3) {
+        engine->result_cache_ = std::make_unique<ResultCache>(RESULT_CACHE_MEM_BYTES);
+    }
 
     signal(SIGINT, sigint_handler);
     try {
@@ -283,20 +301,10 @@ int main(int argc, char **argv) {
                      "Welcome to RMDB!\n"
                      "Type 'help;' for help.\n"
                      "\n";
-        // Database name is passed by args
+        // Database name is passed by args, open (or create) it and recover from the log
         std::string db_name = argv[1];
-        if (!sm_manager->is_dir(db_name)) {
-            // Database not found, create a new one
-            sm_manager->create_db(db_name);
-        }
-        // Open database
-        sm_manager->open_db(db_name);
+        engine->open_db(db_name);
 
-        // recovery database
-        recovery->analyze();
-        recovery->redo();
-        recovery->undo();
-        
         // 开启服务端，开始接受客户端连接
         start_server();
     } catch (RMDBError &e) {
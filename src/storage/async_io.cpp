@@ -0,0 +1,117 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "async_io.h"
+
+/**
+ * @description: 销毁没有执行完的协程，只在run()因为异常提前结束时才会有
+ */
+CoScheduler::~CoScheduler() {
+    for (void *address : tasks_) {
+        CoTask::Handle::from_address(address).destroy();
+    }
+}
+
+/**
+ * @description: 加入一个协程，run()时开始执行
+ * @param {CoTask} task 协程
+ */
+void CoScheduler::spawn(CoTask task) {
+    CoTask::Handle handle = task.release();
+    tasks_.insert(handle.address());
+    ready_.push_back(handle);
+}
+
+/**
+ * @description: 把挂起的协程放回就绪队列，可以在其他线程中调用
+ * @param {Handle} handle 挂起的协程
+ */
+void CoScheduler::wake(CoTask::Handle handle) {
+    {
+        std::scoped_lock lock{latch_};
+        woken_.push_back(handle);
+    }
+    cv_.notify_one();
+}
+
+/**
+ * @description: 执行所有协程直到结束。某个协程抛出异常时其他协程仍然执行到结束，之后重新抛出第一个异常；
+ *               协程挂起时必须已经把自己交给了会调用wake()的一方，否则run()会一直等待
+ */
+void CoScheduler::run() {
+    std::exception_ptr error;
+    while (!tasks_.empty()) {
+        if (ready_.empty()) {
+            std::unique_lock lock{latch_};
+            cv_.wait(lock, [&] { return !woken_.empty(); });
+            ready_.insert(ready_.end(), woken_.begin(), woken_.end());
+            woken_.clear();
+        }
+        CoTask::Handle handle = ready_.front();
+        ready_.pop_front();
+        handle.resume();
+        if (!handle.done()) {
+            continue;
+        }
+        if (handle.promise().exception != nullptr && error == nullptr) {
+            error = handle.promise().exception;
+        }
+        tasks_.erase(handle.address());
+        handle.destroy();
+    }
+    if (error != nullptr) {
+        std::rethrow_exception(error);
+    }
+}
+
+AsyncIoPool::~AsyncIoPool() {
+    {
+        std::scoped_lock lock{latch_};
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+/**
+ * @description: 提交一个读请求，由工作线程异步执行
+ * @param {function<void()>} request 读请求，完成后由请求自己通知提交者
+ */
+void AsyncIoPool::submit(std::function<void()> request) {
+    {
+        std::scoped_lock lock{latch_};
+        if (workers_.empty()) {
+            for (size_t i = 0; i < num_threads_; i++) {
+                workers_.emplace_back(&AsyncIoPool::work, this);
+            }
+        }
+        requests_.push_back(std::move(request));
+    }
+    cv_.notify_one();
+}
+
+/* 工作线程：依次取出请求执行，析构时执行完已提交的请求后退出 */
+void AsyncIoPool::work() {
+    while (true) {
+        std::function<void()> request;
+        {
+            std::unique_lock lock{latch_};
+            cv_.wait(lock, [&] { return stop_ || !requests_.empty(); });
+            if (requests_.empty()) {
+                return;
+            }
+            request = std::move(requests_.front());
+            requests_.pop_front();
+        }
+        request();
+    }
+}
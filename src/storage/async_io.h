@@ -0,0 +1,123 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * 协程执行模式：算子写成CoTask协程，交给CoScheduler执行。
+ * 缓冲池缺页时协程挂起，读请求交给AsyncIoPool的工作线程，调度器随即恢复其他就绪的协程；
+ * 读取完成后工作线程把挂起的协程放回调度器的就绪队列。
+ * 协程只在调用CoScheduler::run()的线程上执行，彼此之间不需要同步；
+ * 一个线程上的协程可以同时有多个读请求在途，执行读取的工作线程数固定，不为每个读请求或每个会话占用一个线程。
+ */
+
+/* 由CoScheduler驱动的协程，创建后不立即执行，结束后由调度器回收 */
+class CoTask {
+   public:
+    struct promise_type {
+        std::exception_ptr exception;   // 协程中抛出的异常，由CoScheduler::run()重新抛出
+
+        CoTask get_return_object() { return CoTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    CoTask(CoTask &&other) noexcept : handle_(other.handle_) { other.handle_ = nullptr; }
+
+    CoTask(const CoTask &) = delete;
+
+    CoTask &operator=(const CoTask &) = delete;
+
+    ~CoTask() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    /* 交出协程的所有权 */
+    Handle release() {
+        Handle handle = handle_;
+        handle_ = nullptr;
+        return handle;
+    }
+
+   private:
+    explicit CoTask(Handle handle) : handle_(handle) {}
+
+    Handle handle_;
+};
+
+/* 在一个线程上执行多个协程：依次恢复就绪的协程，没有就绪的协程时等待读请求完成 */
+class CoScheduler {
+    std::deque<CoTask::Handle> ready_;              // 就绪的协程，只由run()的线程访问
+    std::unordered_set<void *> tasks_;              // 尚未结束的协程
+    std::mutex latch_;
+    std::condition_variable cv_;
+    std::vector<CoTask::Handle> woken_;             // 其他线程唤醒的协程，受latch_保护
+
+   public:
+    CoScheduler() = default;
+
+    CoScheduler(const CoScheduler &) = delete;
+
+    CoScheduler &operator=(const CoScheduler &) = delete;
+
+    ~CoScheduler();
+
+    void spawn(CoTask task);
+
+    void wake(CoTask::Handle handle);
+
+    void run();
+};
+
+/**
+ * 异步读盘的工作线程池：请求按提交顺序由空闲的工作线程执行，第一次提交请求时才启动线程，
+ * 同时执行的请求数不超过线程数，其余请求排队，提交请求的线程不等待
+ */
+class AsyncIoPool {
+    size_t num_threads_;
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> requests_;    // 受latch_保护
+    std::mutex latch_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+
+    void work();
+
+   public:
+    explicit AsyncIoPool(size_t num_threads) : num_threads_(num_threads) {}
+
+    AsyncIoPool(const AsyncIoPool &) = delete;
+
+    AsyncIoPool &operator=(const AsyncIoPool &) = delete;
+
+    ~AsyncIoPool();
+
+    void submit(std::function<void()> request);
+};
@@ -62,10 +62,10 @@ void BufferPoolManager::update_page(Page *page, PageId new_page_id, frame_id_t n
  * @param {PageId} page_id 需要获取的页的PageId
  */
 Page* BufferPoolManager::fetch_page(PageId page_id) {
-    std::scoped_lock lock{latch_};
+    std::unique_lock lock{latch_};
     
-    // 从page_table_中搜寻目标页
-    auto it = page_table_.find(page_id);
+    // 从page_table_中搜寻目标页，目标页正在异步读入时等待读取完成
+    auto it = find_loaded(lock, page_id);
     if (it != page_table_.end()) {
         // 若目标页有被page_table_记录
         frame_id_t frame_id = it->second;
@@ -110,6 +110,120 @@ Page* BufferPoolManager::fetch_page(PageId page_id) {
     return page;
 }
 
+/**
+ * @description: 在协程中获取页面。页面在缓冲池中时与fetch_page相同，co_await不挂起；
+ *              缺页时预留一个帧并pin住，标记为正在读入，把读请求交给磁盘管理器的工作线程后立即返回，不持有latch_读盘，
+ *              co_await挂起协程直到读取完成。读取完成前其他线程获取该页面时等待，读取失败时帧被释放，co_await抛出异常
+ * @return {PageFetch} co_await得到被pin住的页面，没有可用的帧时为nullptr
+ * @param {PageId} page_id 需要获取的页的PageId
+ * @param {CoScheduler*} scheduler 执行当前协程的调度器，读取完成后由它恢复协程
+ */
+PageFetch BufferPoolManager::fetch_page_async(PageId page_id, CoScheduler* scheduler) {
+    return std::move(fetch_pages_async(page_id.fd, page_id.page_no, 1, scheduler).front());
+}
+
+/**
+ * @description: 在协程中获取文件中从page_no开始的连续num_pages个页面，每个页面与fetch_page_async相同；
+ *              页号连续的缺页由一个读请求读入，减少读请求的个数和唤醒协程的次数
+ * @return {vector<PageFetch>} 依次对应每个页面
+ * @param {int} fd 文件句柄
+ * @param {page_id_t} page_no 第一个页面的编号
+ * @param {int} num_pages 页面个数
+ * @param {CoScheduler*} scheduler 执行当前协程的调度器，读取完成后由它恢复协程
+ */
+std::vector<PageFetch> BufferPoolManager::fetch_pages_async(int fd, page_id_t page_no, int num_pages,
+                                                            CoScheduler* scheduler) {
+    std::vector<PageFetch> fetches;
+    fetches.reserve(num_pages);
+    std::vector<Page*> run;     // 正在累积的页号连续的缺页
+    std::shared_ptr<PageFetch::State> state;
+
+    // 提交run中缺页的读请求。持有latch_提交，等待其他线程读入的页面之前已经提交了自己预留的页面，不会互相等待
+    auto submit_run = [&]() {
+        if (run.empty()) {
+            return;
+        }
+        std::vector<char*> bufs;
+        for (Page* page : run) {
+            bufs.push_back(page->data_);
+        }
+        disk_manager_->read_pages_async(
+            fd, run.front()->id_.page_no, std::move(bufs), [this, pages = run, state](std::exception_ptr error) {
+                {
+                    std::scoped_lock lock{latch_};
+                    for (Page* page : pages) {
+                        page->is_loading_ = false;
+                        if (error != nullptr) {
+                            // 与delete_page相同，把帧放回free_list_
+                            page_table_.erase(page->id_);
+                            page->id_.page_no = INVALID_PAGE_ID;
+                            page->pin_count_ = 0;
+                            free_list_.push_back(static_cast<frame_id_t>(page - pages_));
+                        }
+                    }
+                }
+                load_cv_.notify_all();
+                state->complete(error);
+            });
+        run.clear();
+    };
+
+    std::unique_lock lock{latch_};
+    for (page_id_t i = page_no; i < page_no + num_pages; ++i) {
+        PageId page_id{fd, i};
+        auto it = page_table_.find(page_id);
+        if (it != page_table_.end()) {
+            submit_run();
+            it = find_loaded(lock, page_id);
+        }
+        if (it != page_table_.end()) {
+            Page* page = &pages_[it->second];
+            page->pin_count_++;
+            replacer_->pin(it->second);
+            fetches.emplace_back(this, page);
+            continue;
+        }
+        frame_id_t frame_id;
+        if (!find_victim_page(&frame_id)) {
+            submit_run();
+            fetches.emplace_back(this, nullptr);
+            continue;
+        }
+        Page* page = &pages_[frame_id];
+        // 写回脏页，在page_table_中换成目标页
+        update_page(page, page_id, frame_id);
+        page->pin_count_ = 1;
+        page->is_dirty_ = false;
+        page->is_loading_ = true;
+        replacer_->pin(frame_id);
+        if (run.empty()) {
+            state = std::make_shared<PageFetch::State>();
+            state->scheduler = scheduler;
+        }
+        run.push_back(page);
+        fetches.emplace_back(this, page);
+        fetches.back().state_ = state;
+    }
+    submit_run();
+    return fetches;
+}
+
+/**
+ * @description: 在page_table_中查找页面，页面正在异步读入时释放latch_等待读取完成
+ * @return 页面在page_table_中的位置，页面不在缓冲池中（包括读取失败）时为page_table_.end()
+ * @param {unique_lock} lock 持有latch_的锁
+ * @param {PageId} page_id 目标页
+ */
+std::unordered_map<PageId, frame_id_t, PageIdHash>::iterator BufferPoolManager::find_loaded(
+    std::unique_lock<std::mutex>& lock, PageId page_id) {
+    auto it = page_table_.find(page_id);
+    while (it != page_table_.end() && pages_[it->second].is_loading_) {
+        load_cv_.wait(lock);
+        it = page_table_.find(page_id);
+    }
+    return it;
+}
+
 /**
  * @description: 取消固定pin_count>0的在缓冲池中的page
  * @return {bool} 如果目标页的pin_count<=0则返回false，否则返回true
@@ -157,10 +271,10 @@ bool BufferPoolManager::unpin_page(PageId page_id, bool is_dirty) {
  */
 bool BufferPoolManager::flush_page(PageId page_id) {
     // lock latch
-    std::scoped_lock lock{latch_};
+    std::unique_lock lock{latch_};
     
-    // 查找页表,尝试获取目标页P
-    auto it = page_table_.find(page_id);
+    // 查找页表,尝试获取目标页P，正在异步读入的页面内容无效，等待读取完成
+    auto it = find_loaded(lock, page_id);
     // 目标页P没有被page_table_记录 ，返回false
     if (it == page_table_.end()) {
         return false; 
@@ -279,4 +393,104 @@ void BufferPoolManager::flush_all_pages(int fd) {
             }
         }
     }
-}
\ No newline at end of file
+}
+/**
+ * @description: 将buffer_pool中属于fd的所有页直接丢弃，脏页也不写回磁盘，用于整个文件被废弃的场景（如TRUNCATE）
+ * @return {bool} 若fd的所有页都被丢弃则返回true，若存在仍被固定(pin)的页面则返回false（被固定的页面保留）
+ * @param {int} fd 文件句柄
+ */
+bool BufferPoolManager::discard_all_pages(int fd) {
+    std::scoped_lock lock{latch_};
+
+    bool all_discarded = true;
+    for (size_t i = 0; i < pool_size_; ++i) {
+        Page* page = &pages_[i];
+        if (page->id_.fd != fd || page->id_.page_no == INVALID_PAGE_ID) {
+            continue;
+        }
+        if (page->pin_count_ > 0) {
+            all_discarded = false;
+            continue;
+        }
+        frame_id_t frame_id = static_cast<frame_id_t>(i);
+        page_table_.erase(page->id_);
+
+        // 与delete_page相同，重置页面元数据后放回free_list_，但不写回磁盘
+        page->id_.page_no = INVALID_PAGE_ID;
+        page->reset_memory();
+        page->is_dirty_ = false;
+        page->pin_count_ = 0;
+        free_list_.push_back(frame_id);
+        replacer_->pin(frame_id);
+    }
+    return all_discarded;
+}
+
+/**
+ * @description: 异步预读[page_no, page_no + num_pages)中不在缓冲池里的页面，不占用缓冲池的帧
+ *               顺序扫描提前发出预读，使多个读请求同时在途，缺页时的读取不再每次都等待磁盘
+ * @param {int} fd 文件句柄
+ * @param {page_id_t} page_no 第一个页面的编号
+ * @param {int} num_pages 页面个数
+ */
+void BufferPoolManager::prefetch_pages(int fd, page_id_t page_no, int num_pages) {
+    // 只在持有latch_时找出连续的缺页区间，向操作系统发出预读时不持有latch_
+    std::vector<std::pair<page_id_t, int>> runs;
+    {
+        std::scoped_lock lock{latch_};
+        for (page_id_t i = page_no; i < page_no + num_pages; ++i) {
+            if (page_table_.count(PageId{fd, i}) != 0) {
+                continue;
+            }
+            if (!runs.empty() && runs.back().first + runs.back().second == i) {
+                ++runs.back().second;
+            } else {
+                runs.emplace_back(i, 1);
+            }
+        }
+    }
+    for (auto &[first, count] : runs) {
+        disk_manager_->prefetch_pages(fd, first, count);
+    }
+}
+
+PageFetch::~PageFetch() {
+    if (awaited_ || page_ == nullptr) {
+        return;
+    }
+    if (state_ != nullptr) {
+        std::unique_lock lock{state_->latch};
+        state_->cv.wait(lock, [&] { return state_->done; });
+        if (state_->error != nullptr) {
+            return;
+        }
+    }
+    bpm_->unpin_page(page_->get_page_id(), false);
+}
+
+/* 页面已经在缓冲池中，或者读取已经完成 */
+bool PageFetch::ready() {
+    if (state_ == nullptr) {
+        return true;
+    }
+    std::scoped_lock lock{state_->latch};
+    return state_->done;
+}
+
+/* 读取还没有完成时挂起协程，由完成读取的工作线程唤醒；挂起前读取已经完成则不挂起 */
+bool PageFetch::suspend(CoTask::Handle handle) {
+    std::scoped_lock lock{state_->latch};
+    if (state_->done) {
+        return false;
+    }
+    state_->waiters.push_back(handle);
+    return true;
+}
+
+Page* PageFetch::result() {
+    awaited_ = true;
+    if (state_ != nullptr && state_->error != nullptr) {
+        std::rethrow_exception(state_->error);
+    }
+    return page_;
+}
@@ -13,16 +13,91 @@ See the Mulan PSL v2 for more details. */
 #include <unistd.h>
 
 #include <cassert>
+#include <condition_variable>
 #include <list>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
+#include "async_io.h"
 #include "disk_manager.h"
 #include "errors.h"
 #include "page.h"
 #include "replacer/lru_replacer.h"
 #include "replacer/replacer.h"
 
+class BufferPoolManager;
+
+/**
+ * @description: fetch_page_async的结果，co_await得到被pin住的页面（与fetch_page相同，没有可用的帧时为nullptr），由调用者unpin
+ *               创建时已经提交读请求，可以先创建多个再依次co_await，使多个读请求同时在途；
+ *               同一个读请求读入的多个页面共享一个状态。没有被co_await就析构时等待读请求完成并unpin页面
+ */
+class PageFetch {
+    /* 与完成读取的工作线程共享的状态 */
+    struct State {
+        std::mutex latch;
+        std::condition_variable cv;
+        bool done = false;
+        std::exception_ptr error;
+        CoScheduler *scheduler = nullptr;
+        std::vector<CoTask::Handle> waiters;    // 等待读取完成的协程
+
+        /* 工作线程读取完成后调用，唤醒等待的协程 */
+        void complete(std::exception_ptr e) {
+            std::scoped_lock lock{latch};
+            done = true;
+            error = e;
+            for (auto waiter : waiters) {
+                scheduler->wake(waiter);
+            }
+            cv.notify_all();
+        }
+    };
+
+    BufferPoolManager *bpm_ = nullptr;
+    Page *page_ = nullptr;
+    std::shared_ptr<State> state_;      // 页面已经在缓冲池中时为空
+    bool awaited_ = false;
+
+    friend class BufferPoolManager;
+
+   public:
+    PageFetch(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+    PageFetch(PageFetch &&other) noexcept
+        : bpm_(other.bpm_), page_(other.page_), state_(std::move(other.state_)), awaited_(other.awaited_) {
+        other.state_ = nullptr;
+        other.page_ = nullptr;
+    }
+
+    PageFetch(const PageFetch &) = delete;
+
+    PageFetch &operator=(const PageFetch &) = delete;
+
+    ~PageFetch();
+
+    /* co_await时使用的等待对象，PageFetch本身不能复制 */
+    struct Awaiter {
+        PageFetch *fetch;
+
+        bool await_ready() { return fetch->ready(); }
+
+        bool await_suspend(CoTask::Handle handle) { return fetch->suspend(handle); }
+
+        Page *await_resume() { return fetch->result(); }
+    };
+
+    Awaiter operator co_await() & { return Awaiter{this}; }
+
+   private:
+    bool ready();
+
+    bool suspend(CoTask::Handle handle);
+
+    Page *result();
+};
+
 class BufferPoolManager {
    private:
     size_t pool_size_;      // buffer_pool中可容纳页面的个数，即帧的个数
@@ -32,6 +107,7 @@ class BufferPoolManager {
     DiskManager *disk_manager_;
     Replacer *replacer_;    // buffer_pool的置换策略，当前赛题中为LRU置换策略
     std::mutex latch_;      // 用于共享数据结构的并发控制
+    std::condition_variable load_cv_;   // 异步读盘完成时通知，与latch_一起使用
 
    public:
     BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
@@ -66,6 +142,10 @@ class BufferPoolManager {
    public: 
     Page* fetch_page(PageId page_id);
 
+    PageFetch fetch_page_async(PageId page_id, CoScheduler* scheduler);
+
+    std::vector<PageFetch> fetch_pages_async(int fd, page_id_t page_no, int num_pages, CoScheduler* scheduler);
+
     bool unpin_page(PageId page_id, bool is_dirty);
 
     bool flush_page(PageId page_id);
@@ -76,8 +156,15 @@ class BufferPoolManager {
 
     void flush_all_pages(int fd);
 
+    bool discard_all_pages(int fd);
+
+    void prefetch_pages(int fd, page_id_t page_no, int num_pages);
+
    private:
     bool find_victim_page(frame_id_t* frame_id);
 
+    std::unordered_map<PageId, frame_id_t, PageIdHash>::iterator find_loaded(std::unique_lock<std::mutex>& lock,
+                                                                              PageId page_id);
+
     void update_page(Page* page, PageId new_page_id, frame_id_t new_frame_id);
 };
\ No newline at end of file
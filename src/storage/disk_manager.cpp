@@ -11,8 +11,10 @@ See the Mulan PSL v2 for more details. */
 #include "storage/disk_manager.h"
 
 #include <assert.h>    // for assert
+#include <fcntl.h>     // for posix_fadvise
 #include <string.h>    // for memset
 #include <sys/stat.h>  // for stat
+#include <sys/uio.h>   // for preadv
 #include <unistd.h>    // for lseek
 
 #include "defs.h"
@@ -33,14 +35,9 @@ DiskManager::DiskManager() {
 void DiskManager::write_page(int fd, page_id_t page_no, const char *offset, int num_bytes) {
     // 计算页面在文件中的偏移量
     off_t file_offset = static_cast<off_t>(page_no) * PAGE_SIZE;
-    
-    // 定位到指定偏移量
-    if (lseek(fd, file_offset, SEEK_SET) == -1) {
-        throw UnixError();
-    }
-    
-    // 写入数据
-    ssize_t bytes_written = write(fd, offset, num_bytes);
+
+    // 使用pwrite，不修改共享的文件偏移量，多个会话可以同时读写同一个文件
+    ssize_t bytes_written = pwrite(fd, offset, num_bytes, file_offset);
     if (bytes_written != num_bytes) {
         throw InternalError("DiskManager::write_page Error");
     }
@@ -56,19 +53,52 @@ void DiskManager::write_page(int fd, page_id_t page_no, const char *offset, int
 void DiskManager::read_page(int fd, page_id_t page_no, char *offset, int num_bytes) {
     // 计算页面在文件中的偏移量
     off_t file_offset = static_cast<off_t>(page_no) * PAGE_SIZE;
-    
-    // 定位到指定偏移量
-    if (lseek(fd, file_offset, SEEK_SET) == -1) {
-        throw UnixError();
-    }
-    
-    // 读取数据
-    ssize_t bytes_read = read(fd, offset, num_bytes);
+
+    // 使用pread，不修改共享的文件偏移量，多个会话的读请求可以同时在途
+    ssize_t bytes_read = pread(fd, offset, num_bytes, file_offset);
     if (bytes_read != num_bytes) {
         throw InternalError("DiskManager::read_page Error");
     }
 }
 
+/**
+ * @description: 异步读取文件中从page_no开始的连续bufs.size()个页面，由工作线程用一次preadv读入，调用者不等待
+ * @param {int} fd 磁盘文件的文件句柄
+ * @param {page_id_t} page_no 第一个页面的编号
+ * @param {vector<char*>} bufs 依次存放每个页面的内容，每个大小为PAGE_SIZE，读取完成前不能释放，个数不超过IOV_MAX
+ * @param {function} callback 读取完成后在工作线程中调用，参数为读取失败时的异常，成功时为空
+ */
+void DiskManager::read_pages_async(int fd, page_id_t page_no, std::vector<char *> bufs,
+                                   std::function<void(std::exception_ptr)> callback) {
+    io_pool_.submit([fd, page_no, bufs = std::move(bufs), callback = std::move(callback)] {
+        std::vector<iovec> iov(bufs.size());
+        for (size_t i = 0; i < bufs.size(); i++) {
+            iov[i].iov_base = bufs[i];
+            iov[i].iov_len = PAGE_SIZE;
+        }
+        off_t file_offset = static_cast<off_t>(page_no) * PAGE_SIZE;
+        ssize_t bytes_read = preadv(fd, iov.data(), static_cast<int>(iov.size()), file_offset);
+        std::exception_ptr error;
+        if (bytes_read != static_cast<ssize_t>(bufs.size()) * PAGE_SIZE) {
+            error = std::make_exception_ptr(InternalError("DiskManager::read_pages_async Error"));
+        }
+        callback(error);
+    });
+}
+
+/**
+ * @description: 提示操作系统异步预读文件中连续的若干页面，不等待读取完成
+ *               之后这些页面的read_page可以直接命中操作系统的页缓存
+ * @param {int} fd 磁盘文件的文件句柄
+ * @param {page_id_t} page_no 第一个页面的编号
+ * @param {int} num_pages 页面个数
+ */
+void DiskManager::prefetch_pages(int fd, page_id_t page_no, int num_pages) {
+    off_t file_offset = static_cast<off_t>(page_no) * PAGE_SIZE;
+    // 预读只是提示，失败不影响正确性，忽略返回值
+    posix_fadvise(fd, file_offset, static_cast<off_t>(num_pages) * PAGE_SIZE, POSIX_FADV_WILLNEED);
+}
+
 /**
  * @description: 分配一个新的页号
  * @return {page_id_t} 分配的新页号
@@ -205,6 +235,60 @@ void DiskManager::close_file(int fd) {
     fd2path_.erase(fd);
 }
 
+/**
+ * @description: 重命名指定路径文件，若文件已打开，其文件句柄保持有效并随之记录到新路径下
+ * @param {string} &old_path 原文件路径
+ * @param {string} &new_path 新文件路径
+ */
+void DiskManager::rename_file(const std::string &old_path, const std::string &new_path) {
+    if (!is_file(old_path)) {
+        throw FileNotFoundError(old_path);
+    }
+    if (is_file(new_path)) {
+        throw FileExistsError(new_path);
+    }
+
+    if (rename(old_path.c_str(), new_path.c_str()) < 0) {
+        throw UnixError();
+    }
+
+    // 更新文件打开列表
+    auto it = path2fd_.find(old_path);
+    if (it != path2fd_.end()) {
+        int fd = it->second;
+        path2fd_.erase(it);
+        path2fd_[new_path] = fd;
+        fd2path_[fd] = new_path;
+    }
+}
+
+/**
+ * @description: 用old_path原子地替换new_path：new_path存在时被覆盖，任何时刻new_path要么是旧文件要么是新文件
+ * @param {string} &old_path 新内容所在的文件路径
+ * @param {string} &new_path 被替换的文件路径，不能处于打开状态
+ */
+void DiskManager::replace_file(const std::string &old_path, const std::string &new_path) {
+    if (!is_file(old_path)) {
+        throw FileNotFoundError(old_path);
+    }
+    if (path2fd_.count(new_path)) {
+        throw FileNotClosedError(new_path);
+    }
+
+    if (rename(old_path.c_str(), new_path.c_str()) < 0) {
+        throw UnixError();
+    }
+
+    // 更新文件打开列表
+    auto it = path2fd_.find(old_path);
+    if (it != path2fd_.end()) {
+        int fd = it->second;
+        path2fd_.erase(it);
+        path2fd_[new_path] = fd;
+        fd2path_[fd] = new_path;
+    }
+}
+
 /**
  * @description: 获得文件的大小
  * @return {int} 文件的大小
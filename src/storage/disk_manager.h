@@ -15,13 +15,17 @@ See the Mulan PSL v2 for more details. */
 #include <unistd.h>    
 
 #include <atomic>
+#include <exception>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "common/config.h"
 #include "errors.h"  
+#include "storage/async_io.h"
 
 /**
  * @description: DiskManager的作用主要是根据上层的需要对磁盘文件进行操作
@@ -36,6 +40,11 @@ class DiskManager {
 
     void read_page(int fd, page_id_t page_no, char *offset, int num_bytes);
 
+    void read_pages_async(int fd, page_id_t page_no, std::vector<char *> bufs,
+                          std::function<void(std::exception_ptr)> callback);
+
+    void prefetch_pages(int fd, page_id_t page_no, int num_pages);
+
     page_id_t allocate_page(int fd);
 
     void deallocate_page(page_id_t page_id);
@@ -58,6 +67,10 @@ class DiskManager {
 
     void close_file(int fd);
 
+    void rename_file(const std::string &old_path, const std::string &new_path);
+
+    void replace_file(const std::string &old_path, const std::string &new_path);
+
     int get_file_size(const std::string &file_name);
 
     std::string get_file_name(int fd);
@@ -96,4 +109,5 @@ class DiskManager {
 
     int log_fd_ = -1;                             // WAL日志文件的文件句柄，默认为-1，代表未打开日志文件
     std::atomic<page_id_t> fd2pageno_[MAX_FD]{};  // 文件中已经分配的页面个数，初始值为0
+    AsyncIoPool io_pool_{ASYNC_IO_THREADS};       // 执行read_page_async的工作线程
 };
\ No newline at end of file
@@ -0,0 +1,596 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/config.h"
+#include "errors.h"
+
+/**
+ * 定长记录的外部排序：记录先缓存在内存中，超过mem_bytes后排序并顺序写出为一个有序run，
+ * finish()对所有run做一次多路归并。run文件不经过缓冲池，每次读写SEQ_IO_PAGES个页面大小的数据，
+ * 数据量不超过mem_bytes时不写临时文件，直接在内存中排序。
+ */
+class ExternalSorter {
+   public:
+    using Less = std::function<bool(const char *, const char *)>;
+
+   private:
+    /* 一个有序run对应的临时文件，以及归并时的读缓冲 */
+    struct Run {
+        int fd;
+        size_t num_recs;
+        size_t next_rec;                // 下一条要读入缓冲的记录
+        std::vector<char> buf;
+        size_t buf_recs;                // 缓冲中的记录数
+        size_t buf_pos;                 // 缓冲中当前记录的下标
+    };
+
+    size_t rec_len_;
+    Less less_;
+    std::string run_prefix_;            // run文件名的前缀，文件建在当前数据库目录下
+    size_t mem_recs_;                   // 内存中最多缓存的记录数
+    std::vector<char> mem_;             // 尚未写出的记录
+    size_t mem_size_ = 0;
+    std::vector<Run> runs_;
+    size_t num_recs_ = 0;
+
+   public:
+    /**
+     * @param {size_t} rec_len 每条记录的长度
+     * @param {Less} less 记录的比较函数
+     * @param {string&} run_prefix run文件名的前缀，同时存在的排序应使用不同的前缀
+     * @param {size_t} mem_bytes 内存中排序的数据量
+     */
+    ExternalSorter(size_t rec_len, Less less, const std::string &run_prefix, size_t mem_bytes = EXTERNAL_SORT_MEM_BYTES)
+        : rec_len_(rec_len), less_(std::move(less)), run_prefix_(run_prefix) {
+        mem_recs_ = std::max<size_t>(mem_bytes / rec_len_, 1);
+    }
+
+    ~ExternalSorter() {
+        for (size_t i = 0; i < runs_.size(); i++) {
+            close(runs_[i].fd);
+            unlink(run_name(i).c_str());
+        }
+    }
+
+    size_t size() const { return num_recs_; }
+
+    void add(const char *rec) {
+        if (mem_size_ == mem_recs_) {
+            spill();
+        }
+        if (mem_.size() < (mem_size_ + 1) * rec_len_) {
+            mem_.resize(std::min(mem_recs_, std::max<size_t>(2 * mem_size_, 64)) * rec_len_);
+        }
+        memcpy(mem_.data() + mem_size_ * rec_len_, rec, rec_len_);
+        mem_size_++;
+        num_recs_++;
+    }
+
+    /**
+     * @description: 按序把所有记录交给consume，只能调用一次
+     * @param {Consumer} consume 参数为const char*，指向的记录只在本次调用期间有效
+     */
+    template <class Consumer>
+    void finish(Consumer &&consume) {
+        std::vector<const char *> sorted = sort_mem();
+        if (runs_.empty()) {
+            for (auto rec : sorted) consume(rec);
+            return;
+        }
+        if (!sorted.empty()) {
+            write_run(sorted);
+        }
+        mem_.clear();
+        mem_.shrink_to_fit();
+        mem_size_ = 0;
+
+        // 多路归并，每个run只保留一个读缓冲
+        size_t buf_recs = std::max<size_t>(SEQ_IO_PAGES * PAGE_SIZE / rec_len_, 1);
+        auto greater = [&](size_t a, size_t b) { return less_(current(runs_[b]), current(runs_[a])); };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+        for (size_t i = 0; i < runs_.size(); i++) {
+            runs_[i].buf.resize(buf_recs * rec_len_);
+            if (fill(runs_[i])) heap.push(i);
+        }
+        while (!heap.empty()) {
+            size_t i = heap.top();
+            heap.pop();
+            consume(current(runs_[i]));
+            runs_[i].buf_pos++;
+            if (runs_[i].buf_pos < runs_[i].buf_recs || fill(runs_[i])) {
+                heap.push(i);
+            }
+        }
+    }
+
+   private:
+    std::string run_name(size_t idx) const { return run_prefix_ + ".run" + std::to_string(idx); }
+
+    const char *current(const Run &run) const { return run.buf.data() + run.buf_pos * rec_len_; }
+
+    std::vector<const char *> sort_mem() {
+        std::vector<const char *> sorted(mem_size_);
+        for (size_t i = 0; i < mem_size_; i++) sorted[i] = mem_.data() + i * rec_len_;
+        std::sort(sorted.begin(), sorted.end(), less_);
+        return sorted;
+    }
+
+    void spill() {
+        write_run(sort_mem());
+        mem_size_ = 0;
+    }
+
+    /* 把有序的记录顺序写入一个新的run文件 */
+    void write_run(const std::vector<const char *> &sorted) {
+        std::string name = run_name(runs_.size());
+        int fd = open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0) {
+            throw UnixError();
+        }
+        runs_.push_back(Run{fd, sorted.size(), 0, {}, 0, 0});
+        std::vector<char> out;
+        out.reserve(SEQ_IO_PAGES * PAGE_SIZE + rec_len_);
+        off_t offset = 0;
+        auto flush = [&]() {
+            if (pwrite(fd, out.data(), out.size(), offset) != static_cast<ssize_t>(out.size())) {
+                throw UnixError();
+            }
+            offset += out.size();
+            out.clear();
+        };
+        for (auto rec : sorted) {
+            out.insert(out.end(), rec, rec + rec_len_);
+            if (out.size() >= SEQ_IO_PAGES * PAGE_SIZE) flush();
+        }
+        if (!out.empty()) flush();
+    }
+
+    /* 读入run的下一批记录，run已读完时返回false */
+    bool fill(Run &run) {
+        if (run.next_rec == run.num_recs) {
+            return false;
+        }
+        size_t n = std::min(run.buf.size() / rec_len_, run.num_recs - run.next_rec);
+        ssize_t bytes = static_cast<ssize_t>(n * rec_len_);
+        if (pread(run.fd, run.buf.data(), bytes, static_cast<off_t>(run.next_rec * rec_len_)) != bytes) {
+            throw UnixError();
+        }
+        run.next_rec += n;
+        run.buf_recs = n;
+        run.buf_pos = 0;
+        return true;
+    }
+};
+
+/**
+ * 并行外部排序，输入被划分为若干个morsel（例如表文件中连续的一段页面）：
+ *   1. 生成run：工作线程领取morsel，各自缓存记录，超过mem_bytes/线程数后排序写出一个有序run，最后剩余的记录排好序留在内存中；
+ *   2. 划分：从每个run中等间隔取样，样本排序后取线程数-1个分割点，二分查找分割点在每个run中的位置，把所有run切成键值范围互不相交的段；
+ *   3. 并行归并：每个线程对一段中所有run的切片做多路归并，写出该段的有序输出，finish()按段的顺序依次输出。
+ * 设置distinct后相邻的相等记录只保留第一条，相等的记录总是被划分到同一段中。
+ */
+class ParallelSorter {
+   public:
+    using Less = std::function<bool(const char *, const char *)>;
+    using Equal = std::function<bool(const char *, const char *)>;
+
+   private:
+    /* 一个有序的记录序列，存放在临时文件中（fd >= 0）或内存中 */
+    struct SortedRun {
+        std::string name;
+        int fd = -1;
+        std::vector<char> mem;
+        size_t num_recs = 0;
+    };
+
+   public:
+    /* 一个工作线程生成run的状态，producer通过add()加入记录 */
+    class Worker {
+        friend class ParallelSorter;
+
+        ParallelSorter *sorter_;
+        size_t id_;
+        std::vector<char> mem_;
+        size_t mem_size_ = 0;
+        std::vector<SortedRun> runs_;
+
+        Worker(ParallelSorter *sorter, size_t id) : sorter_(sorter), id_(id) {}
+
+       public:
+        size_t id() const { return id_; }
+
+        void add(const char *rec) {
+            size_t rec_len = sorter_->rec_len_;
+            size_t mem_recs = sorter_->worker_mem_recs_;
+            if (mem_size_ == mem_recs) {
+                runs_.push_back(sorter_->write_run(sorted(), "w" + std::to_string(id_) + ".run" + std::to_string(runs_.size())));
+                mem_size_ = 0;
+            }
+            if (mem_.size() < (mem_size_ + 1) * rec_len) {
+                mem_.resize(std::min(mem_recs, std::max<size_t>(2 * mem_size_, 64)) * rec_len);
+            }
+            memcpy(mem_.data() + mem_size_ * rec_len, rec, rec_len);
+            mem_size_++;
+        }
+
+       private:
+        std::vector<const char *> sorted() {
+            std::vector<const char *> recs(mem_size_);
+            for (size_t i = 0; i < mem_size_; i++) recs[i] = mem_.data() + i * sorter_->rec_len_;
+            std::sort(recs.begin(), recs.end(), sorter_->less_);
+            return recs;
+        }
+
+        /* 剩余的记录排好序作为一个内存中的run */
+        void finish() {
+            if (mem_size_ == 0) {
+                return;
+            }
+            SortedRun run;
+            run.num_recs = mem_size_;
+            run.mem.resize(mem_size_ * sorter_->rec_len_);
+            char *dst = run.mem.data();
+            for (auto rec : sorted()) {
+                memcpy(dst, rec, sorter_->rec_len_);
+                dst += sorter_->rec_len_;
+            }
+            mem_.clear();
+            mem_.shrink_to_fit();
+            runs_.push_back(std::move(run));
+        }
+    };
+
+   private:
+    size_t rec_len_;
+    Less less_;
+    Equal equal_;                       // 不为空时去掉相等的记录
+    std::string run_prefix_;
+    size_t num_threads_;
+    size_t mem_bytes_;
+    size_t worker_mem_recs_;            // 每个工作线程在内存中最多缓存的记录数
+    std::vector<SortedRun> runs_;       // 生成的所有run
+    std::vector<SortedRun> parts_;      // 归并后每一段的有序输出
+    size_t num_recs_ = 0;
+
+   public:
+    /**
+     * @param {size_t} rec_len 每条记录的长度
+     * @param {Less} less 记录的比较函数，会被多个线程同时调用
+     * @param {string&} run_prefix 临时文件名的前缀，同时存在的排序应使用不同的前缀
+     * @param {size_t} num_threads 工作线程数
+     * @param {size_t} mem_bytes 所有工作线程在内存中排序的数据总量
+     */
+    ParallelSorter(size_t rec_len, Less less, const std::string &run_prefix, size_t num_threads,
+                   size_t mem_bytes = EXTERNAL_SORT_MEM_BYTES)
+        : rec_len_(rec_len), less_(std::move(less)), run_prefix_(run_prefix), num_threads_(std::max<size_t>(num_threads, 1)),
+          mem_bytes_(mem_bytes) {
+        worker_mem_recs_ = std::max<size_t>(mem_bytes / num_threads_ / rec_len_, 1);
+    }
+
+    ~ParallelSorter() {
+        discard(runs_);
+        discard(parts_);
+    }
+
+    /* 处理num_morsels个morsel使用的线程数：不超过硬件线程数和PARALLEL_SORT_MAX_THREADS */
+    static size_t threads_for(size_t num_morsels) {
+        size_t hw = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        return std::max<size_t>(std::min({hw, PARALLEL_SORT_MAX_THREADS, num_morsels}), 1);
+    }
+
+    /* 相邻的相等记录只保留第一条，需要在generate()之前调用 */
+    void set_distinct(Equal equal) { equal_ = std::move(equal); }
+
+    /**
+     * @description: 生成run，工作线程依次领取morsel，调用produce(morsel, worker)，produce通过worker.add()加入记录
+     * @param {size_t} num_morsels morsel的个数
+     */
+    template <typename Producer>
+    void generate(size_t num_morsels, Producer &&produce) {
+        std::vector<Worker> workers;
+        for (size_t i = 0; i < num_threads_; i++) workers.push_back(Worker(this, i));
+        std::atomic<size_t> next_morsel{0};
+        run_parallel([&](size_t i) {
+            for (size_t morsel = next_morsel++; morsel < num_morsels; morsel = next_morsel++) {
+                produce(morsel, workers[i]);
+            }
+            workers[i].finish();
+        });
+        for (auto &worker : workers) {
+            for (auto &run : worker.runs_) runs_.push_back(std::move(run));
+        }
+    }
+
+    /**
+     * @description: 划分并并行归并所有run
+     * @return {size_t} 排序后（去重后）的记录数
+     */
+    size_t merge() {
+        size_t total = 0;
+        for (auto &run : runs_) total += run.num_recs;
+        std::vector<std::vector<char>> splitters = choose_splitters(total);
+        size_t num_parts = splitters.size() + 1;
+
+        // bounds[r][k]为第k段在第r个run中的起始位置
+        std::vector<std::vector<size_t>> bounds(runs_.size());
+        for (size_t r = 0; r < runs_.size(); r++) {
+            bounds[r].push_back(0);
+            for (auto &splitter : splitters) bounds[r].push_back(partition_point(runs_[r], splitter.data()));
+            bounds[r].push_back(runs_[r].num_recs);
+        }
+        // 所有run都在内存中时归并的输出也留在内存中
+        bool in_mem = std::all_of(runs_.begin(), runs_.end(), [](const SortedRun &run) { return run.fd < 0; });
+        parts_.resize(num_parts);
+        run_parallel([&](size_t k) {
+            if (k < num_parts) merge_part(k, bounds, in_mem);
+        }, num_parts);
+        discard(runs_);
+        num_recs_ = 0;
+        for (auto &part : parts_) num_recs_ += part.num_recs;
+        return num_recs_;
+    }
+
+    size_t size() const { return num_recs_; }
+
+    /**
+     * @description: 在merge()之后按序把所有记录交给consume，只能调用一次
+     * @param {Consumer} consume 参数为const char*，指向的记录只在本次调用期间有效
+     */
+    template <class Consumer>
+    void finish(Consumer &&consume) {
+        std::vector<char> buf;
+        for (auto &part : parts_) {
+            if (part.fd < 0) {
+                for (size_t i = 0; i < part.num_recs; i++) consume(part.mem.data() + i * rec_len_);
+                part.mem.clear();
+                part.mem.shrink_to_fit();
+                continue;
+            }
+            size_t buf_recs = std::max<size_t>(SEQ_IO_PAGES * PAGE_SIZE / rec_len_, 1);
+            buf.resize(buf_recs * rec_len_);
+            for (size_t pos = 0; pos < part.num_recs; pos += buf_recs) {
+                size_t n = std::min(buf_recs, part.num_recs - pos);
+                read_recs(part, pos, n, buf.data());
+                for (size_t i = 0; i < n; i++) consume(buf.data() + i * rec_len_);
+            }
+        }
+    }
+
+   private:
+    /* 删除临时文件，释放内存中的run */
+    static void discard(std::vector<SortedRun> &runs) {
+        for (auto &run : runs) {
+            if (run.fd >= 0) {
+                close(run.fd);
+                unlink(run.name.c_str());
+            }
+        }
+        runs.clear();
+    }
+
+    /* 启动n个线程执行fn(i)，等待全部结束，任一线程的异常在调用线程中重新抛出 */
+    template <typename Fn>
+    void run_parallel(Fn &&fn, size_t n = 0) {
+        n = n == 0 ? num_threads_ : n;
+        std::exception_ptr error;
+        std::mutex error_latch;
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < n; i++) {
+            threads.emplace_back([&, i]() {
+                try {
+                    fn(i);
+                } catch (...) {
+                    std::scoped_lock lock{error_latch};
+                    if (error == nullptr) error = std::current_exception();
+                }
+            });
+        }
+        for (auto &thread : threads) thread.join();
+        if (error != nullptr) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    /* 把有序的记录顺序写入一个新的临时文件 */
+    SortedRun write_run(const std::vector<const char *> &sorted, const std::string &suffix) {
+        SortedRun run;
+        run.name = run_prefix_ + "." + suffix;
+        run.fd = open(run.name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (run.fd < 0) {
+            throw UnixError();
+        }
+        RunWriter writer(run, rec_len_);
+        for (auto rec : sorted) writer.append(rec);
+        writer.flush();
+        return run;
+    }
+
+    /* 顺序写临时文件，每次写出SEQ_IO_PAGES个页面大小的数据 */
+    struct RunWriter {
+        SortedRun &run;
+        size_t rec_len;
+        std::vector<char> out;
+
+        RunWriter(SortedRun &run_, size_t rec_len_) : run(run_), rec_len(rec_len_) {
+            out.reserve(SEQ_IO_PAGES * PAGE_SIZE + rec_len);
+        }
+
+        void append(const char *rec) {
+            run.num_recs++;
+            if (run.fd < 0) {
+                run.mem.insert(run.mem.end(), rec, rec + rec_len);
+            } else {
+                out.insert(out.end(), rec, rec + rec_len);
+                if (out.size() >= SEQ_IO_PAGES * PAGE_SIZE) flush();
+            }
+        }
+
+        void flush() {
+            if (out.empty()) {
+                return;
+            }
+            off_t offset = static_cast<off_t>(run.num_recs * rec_len - out.size());
+            if (pwrite(run.fd, out.data(), out.size(), offset) != static_cast<ssize_t>(out.size())) {
+                throw UnixError();
+            }
+            out.clear();
+        }
+    };
+
+    void read_recs(const SortedRun &run, size_t pos, size_t n, char *dst) const {
+        if (run.fd < 0) {
+            memcpy(dst, run.mem.data() + pos * rec_len_, n * rec_len_);
+            return;
+        }
+        ssize_t bytes = static_cast<ssize_t>(n * rec_len_);
+        if (pread(run.fd, dst, bytes, static_cast<off_t>(pos * rec_len_)) != bytes) {
+            throw UnixError();
+        }
+    }
+
+    /* 记录是否划分到分割点之前的段：去重时与分割点相等的记录都划分到分割点所在的段 */
+    bool before(const char *rec, const char *splitter) const {
+        return less_(rec, splitter) && !(equal_ && equal_(rec, splitter));
+    }
+
+    /* 从所有run中等间隔取样，排序后取num_threads_-1个分割点，记录较少时不划分 */
+    std::vector<std::vector<char>> choose_splitters(size_t total) {
+        std::vector<std::vector<char>> splitters;
+        if (num_threads_ == 1 || total < num_threads_ * PARALLEL_SORT_SAMPLES) {
+            return splitters;
+        }
+        std::vector<char> samples;
+        for (auto &run : runs_) {
+            size_t n = std::max<size_t>(PARALLEL_SORT_SAMPLES * num_threads_ * run.num_recs / total, 1);
+            n = std::min(n, run.num_recs);
+            for (size_t i = 0; i < n; i++) {
+                samples.resize(samples.size() + rec_len_);
+                read_recs(run, (2 * i + 1) * run.num_recs / (2 * n), 1, samples.data() + samples.size() - rec_len_);
+            }
+        }
+        size_t num_samples = samples.size() / rec_len_;
+        std::vector<const char *> sorted(num_samples);
+        for (size_t i = 0; i < num_samples; i++) sorted[i] = samples.data() + i * rec_len_;
+        std::sort(sorted.begin(), sorted.end(), less_);
+        for (size_t k = 1; k < num_threads_; k++) {
+            const char *rec = sorted[k * num_samples / num_threads_];
+            splitters.emplace_back(rec, rec + rec_len_);
+        }
+        return splitters;
+    }
+
+    /* run中第一条不在分割点之前的记录的位置，文件run每次比较读入一条记录 */
+    size_t partition_point(const SortedRun &run, const char *splitter) const {
+        std::vector<char> rec(rec_len_);
+        size_t lo = 0;
+        size_t hi = run.num_recs;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            read_recs(run, mid, 1, rec.data());
+            if (before(rec.data(), splitter)) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    /* 多路归并第k段在所有run中的切片，写出该段的有序输出 */
+    void merge_part(size_t k, const std::vector<std::vector<size_t>> &bounds, bool in_mem) {
+        struct Cursor {
+            const SortedRun *run;
+            size_t next;            // 下一条要读入缓冲的记录
+            size_t end;
+            std::vector<char> buf;
+            size_t buf_recs = 0;
+            size_t buf_pos = 0;
+        };
+        std::vector<Cursor> cursors;
+        for (size_t r = 0; r < runs_.size(); r++) {
+            if (bounds[r][k] < bounds[r][k + 1]) {
+                cursors.push_back(Cursor{&runs_[r], bounds[r][k], bounds[r][k + 1], {}});
+            }
+        }
+        SortedRun &part = parts_[k];
+        if (!in_mem) {
+            part.name = run_prefix_ + ".part" + std::to_string(k);
+            part.fd = open(part.name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+            if (part.fd < 0) {
+                throw UnixError();
+            }
+        }
+        size_t buf_bytes = std::max(mem_bytes_ / num_threads_ / std::max<size_t>(cursors.size(), 1), static_cast<size_t>(PAGE_SIZE));
+        size_t buf_recs = std::max<size_t>(std::min<size_t>(buf_bytes, SEQ_IO_PAGES * PAGE_SIZE) / rec_len_, 1);
+        auto fill = [&](Cursor &cursor) {
+            if (cursor.run->fd < 0) {
+                return false;   // 内存中的run直接读取，不需要缓冲
+            }
+            size_t n = std::min(buf_recs, cursor.end - cursor.next);
+            cursor.buf.resize(n * rec_len_);
+            read_recs(*cursor.run, cursor.next, n, cursor.buf.data());
+            cursor.buf_recs = n;
+            cursor.buf_pos = 0;
+            return true;
+        };
+        auto current = [&](const Cursor &cursor) {
+            if (cursor.run->fd < 0) {
+                return cursor.run->mem.data() + cursor.next * rec_len_;
+            }
+            return cursor.buf.data() + cursor.buf_pos * rec_len_;
+        };
+        auto greater = [&](size_t a, size_t b) { return less_(current(cursors[b]), current(cursors[a])); };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+        for (size_t i = 0; i < cursors.size(); i++) {
+            fill(cursors[i]);
+            heap.push(i);
+        }
+        RunWriter writer(part, rec_len_);
+        std::vector<char> last;
+        while (!heap.empty()) {
+            size_t i = heap.top();
+            heap.pop();
+            Cursor &cursor = cursors[i];
+            const char *rec = current(cursor);
+            if (!equal_ || last.empty() || !equal_(last.data(), rec)) {
+                writer.append(rec);
+                if (equal_) last.assign(rec, rec + rec_len_);
+            }
+            // 前进到下一条记录
+            if (cursor.run->fd < 0) {
+                if (++cursor.next < cursor.end) heap.push(i);
+                continue;
+            }
+            if (++cursor.buf_pos == cursor.buf_recs) {
+                cursor.next += cursor.buf_recs;
+                if (cursor.next == cursor.end) continue;
+                fill(cursor);
+            }
+            heap.push(i);
+        }
+        writer.flush();
+    }
+};
@@ -87,4 +87,7 @@ class Page {
 
     /** The pin count of this page. */
     int pin_count_ = 0;
+
+    /** 异步读盘尚未完成，data_无效，见BufferPoolManager::fetch_page_async */
+    bool is_loading_ = false;
 };
\ No newline at end of file
@@ -15,10 +15,13 @@ See the Mulan PSL v2 for more details. */
 
 #include <algorithm>
 #include <fstream>
+#include <unordered_set>
 
 #include "index/ix.h"
 #include "record/rm.h"
+#include "record/rm_bulk_writer.h"
 #include "record_printer.h"
+#include "storage/external_sort.h"
 
 /**
  * @description: 判断是否为一个文件夹
@@ -121,6 +124,18 @@ void SmManager::open_db(const std::string& db_name) {
             ihs_.emplace(index_name, ix_manager_->open_index(tab_name, col_names));
         }
     }
+
+    // 打开所有三元组索引文件
+    for (auto &tab_entry : db_.tabs_) {
+        for (auto &col_name : tab_entry.second.trigram_cols) {
+            tgs_.emplace(ix_manager_->get_trigram_name(tab_entry.first, col_name),
+                         ix_manager_->open_trigram(tab_entry.first, col_name));
+        }
+    }
+
+    // 加载统计信息，没有统计信息的表由后台ANALYZE补齐
+    load_stats();
+    start_stats_worker();
     // 注意：打开数据库后应保持当前工作目录在数据库目录下
     // 后续表/索引/元数据文件均以相对路径读写。关闭数据库时再回退到上级目录。
 }
@@ -141,6 +156,11 @@ void SmManager::close_db() {
     // 将元数据刷盘（确保 DB_META_NAME 写在数据库目录下）
     flush_meta();
 
+    stop_stats_worker();
+    flush_stats();
+    stats_.clear();
+    workload_.clear();
+
     // 关闭所有表文件
     for (auto &fh_entry : fhs_) {
         rm_manager_->close_file(fh_entry.second.get());
@@ -153,9 +173,15 @@ void SmManager::close_db() {
     }
     ihs_.clear();
 
+    for (auto &tg_entry : tgs_) {
+        ix_manager_->close_trigram(tg_entry.second.get());
+    }
+    tgs_.clear();
+
     // 清理当前打开的数据库元数据
     db_.name_.clear();
     db_.tabs_.clear();
+    db_.views_.clear();
 
     // 回退到上级目录
     if (chdir("..") < 0) {
@@ -213,10 +239,17 @@ void SmManager::desc_table(const std::string& tab_name, Context* context) {
  * @param {vector<ColDef>&} col_defs 表的字段
  * @param {Context*} context 
  */
-void SmManager::create_table(const std::string& tab_name, const std::vector<ColDef>& col_defs, Context* context) {
+void SmManager::create_table(const std::string& tab_name, const std::vector<ColDef>& col_defs, Context* context,
+                             const std::vector<std::string>& organized_by) {
     if (db_.is_table(tab_name)) {
         throw TableExistsError(tab_name);
     }
+    for (auto &col_name : organized_by) {
+        auto pos = std::find_if(col_defs.begin(), col_defs.end(), [&](const ColDef &col) { return col.name == col_name; });
+        if (pos == col_defs.end()) {
+            throw ColumnNotFoundError(col_name);
+        }
+    }
     
     // 申请表级排他锁（创建表需要排他锁）
     // 注意：由于表还未创建，这里无法获取fd，所以暂时不申请锁
@@ -225,6 +258,7 @@ void SmManager::create_table(const std::string& tab_name, const std::vector<ColD
     int curr_offset = 0;
     TabMeta tab;
     tab.name = tab_name;
+    tab.organized_by = organized_by;
     for (auto &col_def : col_defs) {
         ColMeta col = {.tab_name = tab_name,
                        .name = col_def.name,
@@ -238,9 +272,13 @@ void SmManager::create_table(const std::string& tab_name, const std::vector<ColD
     // Create & open record file
     int record_size = curr_offset;  // record_size就是col meta所占的大小（表的元数据也是以记录的形式进行存储的）
     rm_manager_->create_file(tab_name, record_size);
-    db_.tabs_[tab_name] = tab;
-    // fhs_[tab_name] = rm_manager_->open_file(tab_name);
-    fhs_.emplace(tab_name, rm_manager_->open_file(tab_name));
+    {
+        std::unique_lock<std::shared_mutex> stats_lock(stats_latch_);
+        db_.tabs_[tab_name] = tab;
+        // fhs_[tab_name] = rm_manager_->open_file(tab_name);
+        fhs_.emplace(tab_name, rm_manager_->open_file(tab_name));
+        stats_.emplace(tab_name, std::make_unique<TableStats>(tab.cols));
+    }
     
     // 申请表级排他锁（创建表需要排他锁）
     // 注意：表创建后需要申请排他锁，但由于表刚创建，通常不会有并发问题
@@ -253,6 +291,11 @@ void SmManager::create_table(const std::string& tab_name, const std::vector<ColD
     }
 
     flush_meta();
+
+    // 聚簇键上的索引决定记录的存放位置，随表一起创建，表删除前不能单独删除
+    if (tab.is_organized()) {
+        create_index(tab_name, organized_by, context);
+    }
 }
 
 /**
@@ -264,6 +307,14 @@ void SmManager::drop_table(const std::string& tab_name, Context* context) {
     if (!db_.is_table(tab_name)) {
         throw TableNotFoundError(tab_name);
     }
+    if (db_.is_view(tab_name)) {
+        throw RMDBError(tab_name + " is a materialized view, use DROP MATERIALIZED VIEW");
+    }
+    for (auto &entry : db_.views_) {
+        if (entry.second.depends_on(tab_name)) {
+            throw RMDBError("Cannot drop table " + tab_name + ", materialized view " + entry.first + " depends on it");
+        }
+    }
     
     // 申请表级排他锁（删除表需要排他锁）
     if (context != nullptr && context->txn_ != nullptr && context->lock_mgr_ != nullptr) {
@@ -272,15 +323,28 @@ void SmManager::drop_table(const std::string& tab_name, Context* context) {
             throw std::runtime_error("Failed to acquire exclusive lock on table");
         }
     }
+    // 在线建索引全程持有表级IS锁，拿到排他锁后不会再有新的构建开始
+    {
+        std::shared_lock<std::shared_mutex> build_lock(index_build_latch_);
+        if (has_index_build(tab_name)) {
+            throw RMDBError("Cannot drop table " + tab_name + " while an index is being built on it");
+        }
+    }
     
     // 删除表上的所有索引
     TabMeta &tab = db_.get_table(tab_name);
+    tab.organized_by.clear();   // 聚簇键上的索引随表一起删除
     while (!tab.indexes.empty()) {
         // drop_index 内部会更新 tab.indexes，因此这里不能再手动 erase
         auto cols = tab.indexes.back().cols;  // copy
         drop_index(tab_name, cols, context);
     }
+    while (!tab.trigram_cols.empty()) {
+        drop_trigram_index(tab_name, tab.trigram_cols.back(), context);
+    }
     
+    std::unique_lock<std::shared_mutex> stats_lock(stats_latch_);
+    stop_stats_scan(tab_name);
     // 关闭表文件
     if (fhs_.find(tab_name) != fhs_.end()) {
         rm_manager_->close_file(fhs_[tab_name].get());
@@ -292,28 +356,495 @@ void SmManager::drop_table(const std::string& tab_name, Context* context) {
     
     // 从元数据中删除表
     db_.tabs_.erase(tab_name);
+    stats_.erase(tab_name);
+    stats_lock.unlock();
     
     flush_meta();
 }
 
+/**
+ * @description: 创建物化视图：建立存放视图内容的表并登记视图定义，视图内容由调用者计算后插入
+ * @param {ViewMeta&} view 视图定义
+ * @param {vector<ColDef>&} col_defs 视图表的字段
+ * @param {Context*} context
+ */
+void SmManager::create_view(const ViewMeta& view, const std::vector<ColDef>& col_defs, Context* context) {
+    create_table(view.name, col_defs, context);
+    db_.views_.emplace(view.name, view);
+    flush_meta();
+}
+
+/**
+ * @description: 删除物化视图及存放其内容的表
+ * @param {string&} view_name 视图名称
+ * @param {Context*} context
+ */
+void SmManager::drop_view(const std::string& view_name, Context* context) {
+    auto view_it = db_.views_.find(view_name);
+    if (view_it == db_.views_.end()) {
+        throw TableNotFoundError(view_name);
+    }
+    ViewMeta view = view_it->second;
+    db_.views_.erase(view_it);
+    try {
+        drop_table(view_name, context);
+    } catch (...) {
+        db_.views_.emplace(view_name, std::move(view));
+        throw;
+    }
+}
+
+/**
+ * @description: 清空表，直接用新建的空表文件和空索引文件替换原文件，不逐条删除记录
+ *               旧文件改名后保留到事务结束：提交时丢弃其缓冲页并删除，回滚时换回
+ * @param {string&} tab_name 表的名称
+ * @param {Context*} context
+ */
+void SmManager::truncate_table(const std::string& tab_name, Context* context) {
+    if (!db_.is_table(tab_name)) {
+        throw TableNotFoundError(tab_name);
+    }
+    Transaction* txn = context != nullptr ? context->txn_ : nullptr;
+
+    // 申请表级排他锁（清空表需要排他锁）
+    if (txn != nullptr && context->lock_mgr_ != nullptr) {
+        int tab_fd = fhs_.at(tab_name)->GetFd();
+        if (!context->lock_mgr_->lock_exclusive_on_table(txn, tab_fd)) {
+            throw std::runtime_error("Failed to acquire exclusive lock on table");
+        }
+    }
+
+    TabMeta &tab = db_.get_table(tab_name);
+    int record_size = fhs_.at(tab_name)->get_file_hdr().record_size;
+    {
+        std::shared_lock<std::shared_mutex> build_lock(index_build_latch_);
+        auto build_it = index_builds_.find(tab_name);
+        if (build_it != index_builds_.end() && !build_it->second.empty()) {
+            throw RMDBError("Cannot truncate table " + tab_name + " while an index is being built on it");
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(truncate_latch_);
+    std::unique_lock<std::shared_mutex> stats_lock(stats_latch_);
+    stop_stats_scan(tab_name);
+    // 同一事务内再次清空同一张表时，当前文件中只有本事务写入的数据，直接删除即可，最初的旧文件仍保留用于回滚
+    bool keep_old = txn != nullptr && truncated_files_.count({txn->get_transaction_id(), tab_name}) == 0;
+    std::string backup_suffix = keep_old ? ".trunc" + std::to_string(txn->get_transaction_id()) : "";
+    std::vector<TruncatedFile> old_files;
+
+    // 替换表文件
+    auto fh = std::move(fhs_.at(tab_name));
+    fhs_.erase(tab_name);
+    if (keep_old) {
+        disk_manager_->rename_file(tab_name, tab_name + backup_suffix);
+        old_files.push_back(TruncatedFile{tab_name, tab_name + backup_suffix, std::move(fh), nullptr});
+    } else {
+        discard_file(fh->GetFd(), tab_name);
+    }
+    rm_manager_->create_file(tab_name, record_size);
+    fhs_.emplace(tab_name, rm_manager_->open_file(tab_name));
+
+    // 替换表上的所有索引文件
+    for (auto &index : tab.indexes) {
+        std::string index_name = ix_manager_->get_index_name(tab_name, index.cols);
+        auto ih = std::move(ihs_.at(index_name));
+        ihs_.erase(index_name);
+        if (keep_old) {
+            disk_manager_->rename_file(index_name, index_name + backup_suffix);
+            old_files.push_back(TruncatedFile{index_name, index_name + backup_suffix, nullptr, std::move(ih)});
+        } else {
+            discard_file(ih->get_fd(), index_name);
+        }
+        ix_manager_->create_index(tab_name, index.cols);
+        ihs_.emplace(index_name, ix_manager_->open_index(tab_name, index.cols));
+    }
+    // 三元组索引直接清空，回滚时从换回的表文件重建
+    for (auto &col_name : tab.trigram_cols) {
+        tgs_.at(ix_manager_->get_trigram_name(tab_name, col_name))->clear();
+    }
+    if (keep_old) {
+        truncated_files_[{txn->get_transaction_id(), tab_name}] = std::move(old_files);
+    }
+    {
+        TableStats *stats = stats_.at(tab_name).get();
+        std::scoped_lock stats_entry_lock{stats->latch};
+        TableStats empty(tab.cols);
+        stats->num_rows = 0;
+        stats->exact_rows = true;
+        stats->replace(empty);
+    }
+    stats_lock.unlock();
+    lock.unlock();
+
+    if (txn == nullptr) {
+        return;
+    }
+    // 新表文件的句柄不同，同样需要持有排他锁直到事务结束
+    if (context->lock_mgr_ != nullptr) {
+        if (!context->lock_mgr_->lock_exclusive_on_table(txn, fhs_.at(tab_name)->GetFd())) {
+            throw std::runtime_error("Failed to acquire exclusive lock on table");
+        }
+    }
+    // 整张表只记录一条日志和一条写记录
+    if (context->log_mgr_ != nullptr) {
+        TruncateLogRecord log_record(txn->get_transaction_id(), tab_name);
+        log_record.prev_lsn_ = txn->get_prev_lsn();
+        txn->set_prev_lsn(context->log_mgr_->add_log_to_buffer(&log_record));
+    }
+    if (keep_old) {
+        txn->append_write_record(new WriteRecord(WType::TRUNCATE_TABLE, tab_name));
+    }
+}
+
+/**
+ * @description: 事务提交时删除TRUNCATE换下的旧文件，其缓冲页直接丢弃，不写回磁盘
+ * @param {string&} tab_name 表的名称
+ * @param {Transaction*} txn 提交的事务
+ */
+void SmManager::commit_truncate(const std::string& tab_name, Transaction* txn) {
+    std::scoped_lock lock{truncate_latch_};
+    auto it = truncated_files_.find({txn->get_transaction_id(), tab_name});
+    if (it == truncated_files_.end()) {
+        return;
+    }
+    for (auto &file : it->second) {
+        discard_file(file.fh != nullptr ? file.fh->GetFd() : file.ih->get_fd(), file.backup_name);
+    }
+    truncated_files_.erase(it);
+}
+
+/**
+ * @description: 事务回滚时删除TRUNCATE新建的文件，并把旧文件换回原位置
+ * @param {string&} tab_name 表的名称
+ * @param {Transaction*} txn 回滚的事务
+ */
+void SmManager::rollback_truncate(const std::string& tab_name, Transaction* txn) {
+    std::scoped_lock lock{truncate_latch_};
+    auto it = truncated_files_.find({txn->get_transaction_id(), tab_name});
+    if (it == truncated_files_.end()) {
+        return;
+    }
+    std::unique_lock<std::shared_mutex> stats_lock(stats_latch_);
+    stop_stats_scan(tab_name);
+    for (auto &file : it->second) {
+        if (file.fh != nullptr) {
+            auto fh_it = fhs_.find(file.file_name);
+            if (fh_it == fhs_.end()) {
+                // 表已在TRUNCATE之后被删除，旧文件也不再需要
+                discard_file(file.fh->GetFd(), file.backup_name);
+                continue;
+            }
+            discard_file(fh_it->second->GetFd(), file.file_name);
+            disk_manager_->rename_file(file.backup_name, file.file_name);
+            fh_it->second = std::move(file.fh);
+            // 旧数据换回后统计信息需要重新扫描
+            TableStats *stats = stats_.at(tab_name).get();
+            std::scoped_lock stats_entry_lock{stats->latch};
+            stats->exact_rows = false;
+            if (!stats->analyze_pending) {
+                stats->analyze_pending = true;
+                request_analyze(tab_name);
+            }
+        } else {
+            auto ih_it = ihs_.find(file.file_name);
+            if (ih_it == ihs_.end()) {
+                // 索引已在TRUNCATE之后被删除，旧文件也不再需要
+                discard_file(file.ih->get_fd(), file.backup_name);
+                continue;
+            }
+            discard_file(ih_it->second->get_fd(), file.file_name);
+            disk_manager_->rename_file(file.backup_name, file.file_name);
+            ih_it->second = std::move(file.ih);
+        }
+    }
+    truncated_files_.erase(it);
+    if (db_.is_table(tab_name)) {
+        rebuild_trigram_indexes(tab_name);
+    }
+}
+
+/**
+ * @description: 绕过缓冲池顺序读取表文件之前调用，把表的脏页写回磁盘
+ * @return {int} 需要读取的页数，从未写回过的空页面不在磁盘上
+ */
+int SmManager::flush_for_read(const std::string& tab_name) {
+    auto fh = fhs_.at(tab_name).get();
+    buffer_pool_manager_->flush_all_pages(fh->GetFd());
+    return std::min(fh->get_file_hdr().num_pages, disk_manager_->get_file_size(tab_name) / PAGE_SIZE);
+}
+
+/* 表文件的记录页每SEQ_IO_PAGES个页面为一个morsel，供并行排序的工作线程领取 */
+static size_t num_morsels(int num_pages) {
+    return num_pages > RM_FIRST_RECORD_PAGE ? (num_pages - RM_FIRST_RECORD_PAGE + SEQ_IO_PAGES - 1) / SEQ_IO_PAGES : 0;
+}
+
+/**
+ * @description: 绕过缓冲池一次读入第morsel段页面，依次把其中的每条记录交给consume(rid, 记录地址)，可以由多个线程同时调用
+ * @param {vector<char>&} buf 调用者所在线程的读缓冲
+ */
+template <typename Consumer>
+void SmManager::read_morsel(RmFileHandle* fh, int num_pages, size_t morsel, std::vector<char>& buf, Consumer&& consume) {
+    RmFileHdr file_hdr = fh->get_file_hdr();
+    int first_page = RM_FIRST_RECORD_PAGE + static_cast<int>(morsel) * SEQ_IO_PAGES;
+    int n = std::min(SEQ_IO_PAGES, num_pages - first_page);
+    buf.resize(SEQ_IO_PAGES * PAGE_SIZE);
+    disk_manager_->read_page(fh->GetFd(), first_page, buf.data(), n * PAGE_SIZE);
+    for (int i = 0; i < n; i++) {
+        char *bitmap = buf.data() + i * PAGE_SIZE + Page::OFFSET_PAGE_HDR + sizeof(RmPageHdr);
+        char *slots = bitmap + file_hdr.bitmap_size;
+        int max_n = file_hdr.num_records_per_page;
+        for (int slot_no = Bitmap::first_bit(true, bitmap, max_n); slot_no < max_n;
+             slot_no = Bitmap::next_bit(true, bitmap, max_n, slot_no)) {
+            consume(Rid{first_page + i, slot_no}, slots + slot_no * file_hdr.record_size);
+        }
+    }
+}
+
+/**
+ * @description: 按索引的键值顺序重写表文件，使索引范围扫描访问的记录在磁盘上连续
+ *               1. 刷出表的脏页，绕过缓冲池顺序读出所有记录，按索引键外部排序
+ *               2. 按序把记录紧密写入新表文件，同时得到每条记录的新位置，自底向上重建表上的所有索引
+ *               3. 丢弃旧文件的缓冲页，用rename原子地把新文件换到原文件名下
+ *               不记录日志，与其他DDL一样不能在显式事务中执行
+ * @param {string&} tab_name 表的名称
+ * @param {vector<string>&} col_names 作为聚簇顺序的索引字段，为空时使用建表时的ORGANIZED BY字段
+ * @param {Context*} context
+ */
+void SmManager::cluster_table(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context) {
+    if (!db_.is_table(tab_name)) {
+        throw TableNotFoundError(tab_name);
+    }
+    TabMeta &tab = db_.get_table(tab_name);
+    std::vector<std::string> key_names = col_names.empty() ? tab.organized_by : col_names;
+    if (key_names.empty()) {
+        throw RMDBError("There is no clustering index for table " + tab_name + ", use CLUSTER " + tab_name +
+                        " USING (col, ...)");
+    }
+    if (!tab.is_index(key_names)) {
+        throw IndexNotFoundError(tab_name, key_names);
+    }
+    Transaction* txn = context != nullptr ? context->txn_ : nullptr;
+    if (txn != nullptr && txn->get_txn_mode()) {
+        throw RMDBError("CLUSTER cannot run inside a transaction block");
+    }
+
+    // 申请表级排他锁（重写表需要排他锁）
+    if (txn != nullptr && context->lock_mgr_ != nullptr) {
+        if (!context->lock_mgr_->lock_exclusive_on_table(txn, fhs_.at(tab_name)->GetFd())) {
+            throw std::runtime_error("Failed to acquire exclusive lock on table");
+        }
+    }
+    // 表上的DML已被排他锁阻塞，在线建索引需要表级IS锁，也不会在重写期间开始；
+    // 这里只检查已注册的构建，不在重写期间持有index_build_latch_，以免阻塞其他表上的DML
+    {
+        std::shared_lock<std::shared_mutex> build_lock(index_build_latch_);
+        if (has_index_build(tab_name)) {
+            throw RMDBError("Cannot cluster table " + tab_name + " while an index is being built on it");
+        }
+    }
+
+    auto fh = fhs_.at(tab_name).get();
+    RmFileHdr file_hdr = fh->get_file_hdr();
+    IndexMeta *cluster_index = &*tab.get_index_meta(key_names);
+    std::vector<ColMeta> key_cols = cluster_index->cols;
+    std::string new_name = tab_name + ".cluster";
+
+    // 1. 多个线程并行读出所有记录并按聚簇键排序
+    int num_pages = flush_for_read(tab_name);
+    size_t morsels = num_morsels(num_pages);
+    size_t num_threads = ParallelSorter::threads_for(morsels);
+    ParallelSorter heap_sorter(file_hdr.record_size, [&key_cols](const char* a, const char* b) {
+        for (auto &col : key_cols) {
+            int res = ix_compare(a + col.offset, b + col.offset, col.type, col.len);
+            if (res != 0) return res < 0;
+        }
+        return false;
+    }, new_name, num_threads);
+    // 每个索引（部分索引只统计满足谓词的记录）的条目数，每个工作线程分别统计
+    std::vector<std::vector<size_t>> worker_entries(num_threads, std::vector<size_t>(tab.indexes.size(), 0));
+    heap_sorter.generate(morsels, [&](size_t morsel, ParallelSorter::Worker& worker) {
+        std::vector<char> buf;
+        auto &entries = worker_entries[worker.id()];
+        read_morsel(fh, num_pages, morsel, buf, [&](const Rid&, const char* rec) {
+            worker.add(rec);
+            for (size_t j = 0; j < tab.indexes.size(); j++) {
+                if (tab.indexes[j].covers(rec)) entries[j]++;
+            }
+        });
+    });
+    heap_sorter.merge();
+    std::vector<size_t> index_entries(tab.indexes.size(), 0);
+    for (auto &entries : worker_entries) {
+        for (size_t j = 0; j < entries.size(); j++) index_entries[j] += entries[j];
+    }
+
+    // 每个索引在新文件中的条目先经过外部排序，聚簇键上的索引按记录写出的顺序直接构建
+    struct IndexRebuild {
+        IndexMeta *meta;
+        std::unique_ptr<IxIndexHandle> ih;
+        std::unique_ptr<IxBulkBuilder> builder;
+        std::unique_ptr<ExternalSorter> sorter;
+    };
+    std::vector<IndexRebuild> rebuilds;
+    int new_fd = -1;
+    auto cleanup = [&]() {
+        for (auto &rebuild : rebuilds) {
+            if (rebuild.ih != nullptr) {
+                discard_file(rebuild.ih->get_fd(), ix_manager_->get_index_name(new_name, rebuild.meta->cols));
+            }
+        }
+        if (new_fd >= 0) {
+            disk_manager_->close_file(new_fd);
+            disk_manager_->destroy_file(new_name);
+        }
+    };
+
+    try {
+        for (size_t j = 0; j < tab.indexes.size(); j++) {
+            auto &index = tab.indexes[j];
+            ix_manager_->create_index(new_name, index.cols);
+            IndexRebuild rebuild{&index, ix_manager_->open_index(new_name, index.cols), nullptr, nullptr};
+            rebuild.builder = std::make_unique<IxBulkBuilder>(rebuild.ih.get(), index_entries[j]);
+            if (&index != cluster_index) {
+                std::vector<ColType> col_types;
+                std::vector<int> col_lens;
+                for (auto &col : index.cols) {
+                    col_types.push_back(col.type);
+                    col_lens.push_back(col.len);
+                }
+                rebuild.sorter = std::make_unique<ExternalSorter>(
+                    index.col_tot_len + sizeof(Rid),
+                    [col_types, col_lens](const char* a, const char* b) {
+                        return ix_compare(a, b, col_types, col_lens) < 0;
+                    },
+                    ix_manager_->get_index_name(new_name, index.cols));
+            }
+            rebuilds.push_back(std::move(rebuild));
+        }
+
+        // 2. 按序写新表文件
+        rm_manager_->create_file(new_name, file_hdr.record_size);
+        new_fd = disk_manager_->open_file(new_name);
+        RmBulkWriter writer(disk_manager_, new_fd);
+        std::vector<char> entry;
+        heap_sorter.finish([&](const char* rec) {
+            Rid rid = writer.append(rec);
+            for (auto &rebuild : rebuilds) {
+                if (!rebuild.meta->covers(rec)) continue;
+                entry.resize(rebuild.meta->col_tot_len + sizeof(Rid));
+                int offset = 0;
+                for (auto &col : rebuild.meta->cols) {
+                    memcpy(entry.data() + offset, rec + col.offset, col.len);
+                    offset += col.len;
+                }
+                if (rebuild.sorter == nullptr) {
+                    rebuild.builder->append(entry.data(), rid);
+                } else {
+                    memcpy(entry.data() + offset, &rid, sizeof(Rid));
+                    rebuild.sorter->add(entry.data());
+                }
+            }
+        });
+        writer.finish();
+        disk_manager_->close_file(new_fd);
+        new_fd = -1;
+
+        for (auto &rebuild : rebuilds) {
+            if (rebuild.sorter != nullptr) {
+                int key_len = rebuild.meta->col_tot_len;
+                rebuild.sorter->finish([&](const char* entry) {
+                    rebuild.builder->append(entry, *reinterpret_cast<const Rid*>(entry + key_len));
+                });
+                rebuild.sorter.reset();
+            }
+            rebuild.builder->finish();
+            ix_manager_->close_index(rebuild.ih.get());
+            rebuild.ih.reset();
+        }
+    } catch (...) {
+        cleanup();
+        throw;
+    }
+
+    // 3. 换上新文件，旧文件的缓冲页直接丢弃
+    auto swap_file = [&](int old_fd, const std::string& file_name, const std::string& new_file_name) {
+        if (!buffer_pool_manager_->discard_all_pages(old_fd)) {
+            throw InternalError("SmManager::cluster_table: page of " + file_name + " is still pinned");
+        }
+        disk_manager_->close_file(old_fd);
+        disk_manager_->replace_file(new_file_name, file_name);
+    };
+    std::unique_lock<std::shared_mutex> stats_lock(stats_latch_);
+    stop_stats_scan(tab_name);
+    swap_file(fh->GetFd(), tab_name, new_name);
+    fhs_[tab_name] = rm_manager_->open_file(tab_name);
+    for (auto &index : tab.indexes) {
+        std::string index_name = ix_manager_->get_index_name(tab_name, index.cols);
+        swap_file(ihs_.at(index_name)->get_fd(), index_name, ix_manager_->get_index_name(new_name, index.cols));
+        ihs_[index_name] = ix_manager_->open_index(tab_name, index.cols);
+    }
+    stats_lock.unlock();
+    // 记录的位置都变了，三元组索引按新表文件重建
+    rebuild_trigram_indexes(tab_name);
+
+    // 新表文件的句柄可能不同，同样需要持有排他锁直到语句结束
+    if (txn != nullptr && context->lock_mgr_ != nullptr) {
+        if (!context->lock_mgr_->lock_exclusive_on_table(txn, fhs_.at(tab_name)->GetFd())) {
+            throw std::runtime_error("Failed to acquire exclusive lock on table");
+        }
+    }
+}
+
+/**
+ * @description: 丢弃一个已打开的表文件或索引文件：缓冲页不写回，关闭并删除文件
+ * @param {int} fd 文件句柄
+ * @param {string&} file_name 文件当前的名称
+ */
+void SmManager::discard_file(int fd, const std::string& file_name) {
+    if (!buffer_pool_manager_->discard_all_pages(fd)) {
+        throw InternalError("SmManager::discard_file: page of " + file_name + " is still pinned");
+    }
+    disk_manager_->close_file(fd);
+    disk_manager_->destroy_file(file_name);
+}
+
+/**
+ * @description: 把where条件转换为部分索引的谓词
+ * @param {TabMeta&} tab 索引所属的表
+ * @param {vector<Condition>&} conds 已经过语义检查的条件，右侧均为常量
+ */
+std::vector<IndexPredicate> SmManager::get_index_preds(TabMeta& tab, const std::vector<Condition>& conds) {
+    std::vector<IndexPredicate> preds;
+    for (auto &cond : conds) {
+        IndexPredicate pred{*tab.get_col(cond.lhs_col.col_name), cond.op, std::string()};
+        // 常量按字段长度编码，与记录中的字段值直接比较
+        pred.val.assign(pred.col.len, '\0');
+        memcpy(&pred.val[0], cond.rhs_val.raw->data, std::min(pred.col.len, cond.rhs_val.raw->size));
+        preds.push_back(std::move(pred));
+    }
+    return preds;
+}
+
 /**
  * @description: 创建索引
  * @param {string&} tab_name 表的名称
  * @param {vector<string>&} col_names 索引包含的字段名称
  * @param {Context*} context
+ * @param {vector<Condition>&} conds 部分索引的谓词，为空时索引覆盖全表
  */
-void SmManager::create_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context) {
+void SmManager::create_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context,
+                             const std::vector<Condition>& conds) {
     TabMeta &tab = db_.get_table(tab_name);
     
-    if (tab.is_index(col_names)) {
+    if (tab.is_index(col_names) || is_index_building(tab_name, col_names)) {
         throw IndexExistsError(tab_name, col_names);
     }
     
-    // 申请表级意向排他锁（创建索引需要IX锁）
+    // 申请表级共享锁：绕过缓冲池直接读取表文件，建索引期间其他事务不能修改表
     if (context != nullptr && context->txn_ != nullptr && context->lock_mgr_ != nullptr) {
         int tab_fd = fhs_.at(tab_name)->GetFd();
-        if (!context->lock_mgr_->lock_IX_on_table(context->txn_, tab_fd)) {
-            throw std::runtime_error("Failed to acquire IX lock on table");
+        if (!context->lock_mgr_->lock_shared_on_table(context->txn_, tab_fd)) {
+            throw std::runtime_error("Failed to acquire shared lock on table");
         }
     }
     
@@ -332,29 +863,65 @@ void SmManager::create_index(const std::string& tab_name, const std::vector<std:
         index_meta.cols.push_back(col);
         index_meta.col_tot_len += col.len;
     }
+    index_meta.preds = get_index_preds(tab, conds);
     
     std::string index_name = ix_manager_->get_index_name(tab_name, col_names);
 
     // 创建并打开索引文件（句柄需要保存在 ihs_，供 DML 更新索引使用）
     ix_manager_->create_index(tab_name, index_cols);
     auto index_handle = ix_manager_->open_index(tab_name, col_names);
-    auto file_handle = fhs_.at(tab_name).get();
-    std::vector<char> key_buf(index_meta.col_tot_len);
-
-    for (RmScan scan(file_handle); !scan.is_end(); scan.next()) {
-        Rid rid = scan.rid();
-        auto record = file_handle->get_record(rid, context);
-        if (record == nullptr) {
-            continue;
-        }
-
-        int offset = 0;
-        for (const auto &col : index_cols) {
-            memcpy(key_buf.data() + offset, record->data + col.offset, col.len);
-            offset += col.len;
+    try {
+        // 多个线程并行读取表文件，把键值和rid排序，相同的键值只保留rid最小的一条（与按表的顺序逐条插入相同）
+        std::vector<ColType> col_types;
+        std::vector<int> col_lens;
+        for (auto &col : index_cols) {
+            col_types.push_back(col.type);
+            col_lens.push_back(col.len);
         }
+        int key_len = index_meta.col_tot_len;
+        auto key_less = [col_types, col_lens, key_len](const char* a, const char* b) {
+            int res = ix_compare(a, b, col_types, col_lens);
+            if (res != 0) return res < 0;
+            auto rid_a = reinterpret_cast<const Rid*>(a + key_len);
+            auto rid_b = reinterpret_cast<const Rid*>(b + key_len);
+            return rid_a->page_no != rid_b->page_no ? rid_a->page_no < rid_b->page_no : rid_a->slot_no < rid_b->slot_no;
+        };
+        auto fh = fhs_.at(tab_name).get();
+        int num_pages = flush_for_read(tab_name);
+        size_t morsels = num_morsels(num_pages);
+        ParallelSorter sorter(key_len + sizeof(Rid), key_less, index_name, ParallelSorter::threads_for(morsels));
+        sorter.set_distinct([col_types, col_lens](const char* a, const char* b) {
+            return ix_compare(a, b, col_types, col_lens) == 0;
+        });
+        sorter.generate(morsels, [&](size_t morsel, ParallelSorter::Worker& worker) {
+            std::vector<char> buf;
+            std::vector<char> entry(key_len + sizeof(Rid));
+            read_morsel(fh, num_pages, morsel, buf, [&](const Rid& rid, const char* rec) {
+                if (!index_meta.covers(rec)) {
+                    return;
+                }
+                int offset = 0;
+                for (const auto &col : index_cols) {
+                    memcpy(entry.data() + offset, rec + col.offset, col.len);
+                    offset += col.len;
+                }
+                memcpy(entry.data() + offset, &rid, sizeof(Rid));
+                worker.add(entry.data());
+            });
+        });
 
-        index_handle->insert_entry(key_buf.data(), rid, context ? context->txn_ : nullptr);
+        // 按序输出的键值对自底向上批量构建B+树
+        IxBulkBuilder builder(index_handle.get(), sorter.merge());
+        sorter.finish([&](const char* entry) {
+            builder.append(entry, *reinterpret_cast<const Rid*>(entry + key_len));
+        });
+        builder.finish();
+        // 批量构建的页面绕过了缓冲池，重新打开索引，之后新分配的页面从文件末尾开始
+        ix_manager_->close_index(index_handle.get());
+        index_handle = ix_manager_->open_index(tab_name, col_names);
+    } catch (...) {
+        discard_file(index_handle->get_fd(), index_name);
+        throw;
     }
 
     for (auto &col : tab.cols) {
@@ -368,6 +935,223 @@ void SmManager::create_index(const std::string& tab_name, const std::vector<std:
     flush_meta();
 }
 
+/**
+ * @description: 在线创建索引，构建期间不阻塞表上的DML
+ *               1. 注册构建中的索引，此后的DML把索引变更记录到side log中
+ *               2. 不加锁地对表做一次快照扫描，把排好序的键值批量插入新索引
+ *               3. 分批回放side log，剩余变更较少时，在短暂阻塞DML的情况下回放剩余变更并使索引生效
+ * @param {string&} tab_name 表的名称
+ * @param {vector<string>&} col_names 索引包含的字段名称
+ * @param {Context*} context
+ * @param {vector<Condition>&} conds 部分索引的谓词，为空时索引覆盖全表
+ */
+void SmManager::create_index_concurrently(const std::string& tab_name, const std::vector<std::string>& col_names,
+                                          Context* context, const std::vector<Condition>& conds) {
+    TabMeta &tab = db_.get_table(tab_name);
+    if (tab.is_index(col_names) || is_index_building(tab_name, col_names)) {
+        throw IndexExistsError(tab_name, col_names);
+    }
+
+    // 申请表级IS锁直到事务结束：不阻塞DML，但与DROP TABLE、TRUNCATE、CLUSTER等需要排他锁的DDL冲突
+    if (context != nullptr && context->txn_ != nullptr && context->lock_mgr_ != nullptr) {
+        if (!context->lock_mgr_->lock_IS_on_table(context->txn_, fhs_.at(tab_name)->GetFd())) {
+            throw std::runtime_error("Failed to acquire IS lock on table");
+        }
+    }
+
+    auto build = std::make_shared<IndexBuild>();
+    IndexMeta &index_meta = build->index_meta;
+    index_meta.tab_name = tab_name;
+    index_meta.col_num = static_cast<int>(col_names.size());
+    index_meta.col_tot_len = 0;
+    for (const auto &col_name : col_names) {
+        index_meta.cols.push_back(*tab.get_col(col_name));
+        index_meta.col_tot_len += index_meta.cols.back().len;
+    }
+    index_meta.preds = get_index_preds(tab, conds);
+    std::string index_name = ix_manager_->get_index_name(tab_name, col_names);
+    ix_manager_->create_index(tab_name, index_meta.cols);
+    auto index_handle = ix_manager_->open_index(tab_name, col_names);
+    build->ih = index_handle.get();
+
+    // 1. 注册：等待正在执行的DML结束，之后的DML都会把变更写入side log
+    {
+        std::unique_lock<std::shared_mutex> build_lock(index_build_latch_);
+        index_builds_[tab_name].push_back(build);
+    }
+
+    // 调用者需持有index_build_latch_的排他锁
+    auto unregister = [&]() {
+        auto build_it = index_builds_.find(tab_name);
+        if (build_it == index_builds_.end()) {
+            return;
+        }
+        auto &builds = build_it->second;
+        builds.erase(std::remove(builds.begin(), builds.end(), build), builds.end());
+        if (builds.empty()) {
+            index_builds_.erase(build_it);
+        }
+    };
+
+    try {
+        // 2. 快照扫描：不申请表锁和行锁，扫描期间被修改的记录由side log补齐
+        std::vector<ColType> col_types;
+        std::vector<int> col_lens;
+        for (auto &col : index_meta.cols) {
+            col_types.push_back(col.type);
+            col_lens.push_back(col.len);
+        }
+        auto file_handle = fhs_.at(tab_name).get();
+        std::vector<std::pair<std::string, Rid>> entries;
+        for (RmScan scan(file_handle); !scan.is_end(); scan.next()) {
+            Rid rid = scan.rid();
+            std::unique_ptr<RmRecord> record;
+            try {
+                record = file_handle->get_record(rid, nullptr);
+            } catch (std::runtime_error &) {
+                continue;  // 记录在扫描过程中被并发删除
+            }
+            if (!index_meta.covers(record->data)) {
+                continue;
+            }
+            std::string key(index_meta.col_tot_len, '\0');
+            int offset = 0;
+            for (auto &col : index_meta.cols) {
+                memcpy(&key[offset], record->data + col.offset, col.len);
+                offset += col.len;
+            }
+            entries.emplace_back(std::move(key), rid);
+        }
+
+        // 按键值排序后顺序插入，新结点总是在最右侧分裂，访问的页面集中在最右路径上
+        std::sort(entries.begin(), entries.end(), [&](const auto &a, const auto &b) {
+            return ix_compare(a.first.data(), b.first.data(), col_types, col_lens) < 0;
+        });
+        for (auto &entry : entries) {
+            build->ih->insert_entry(entry.first.data(), entry.second, nullptr);
+        }
+        entries.clear();
+
+        // 3. 分批回放side log，不阻塞DML
+        static constexpr size_t INDEX_BUILD_FINAL_BATCH = 256;
+        while (true) {
+            std::vector<IndexBuildOp> ops;
+            {
+                std::scoped_lock log_lock{build->latch};
+                if (build->side_log_.size() <= INDEX_BUILD_FINAL_BATCH) {
+                    break;
+                }
+                ops.swap(build->side_log_);
+            }
+            replay_index_build(build.get(), ops);
+        }
+
+        // 4. 短暂阻塞DML，回放剩余变更，使索引对DML和查询可见
+        std::unique_lock<std::shared_mutex> build_lock(index_build_latch_);
+        replay_index_build(build.get(), build->side_log_);
+        unregister();
+        for (auto &col : tab.cols) {
+            if (std::find(col_names.begin(), col_names.end(), col.name) != col_names.end()) {
+                col.index = true;
+            }
+        }
+        tab.indexes.push_back(index_meta);
+        ihs_.emplace(index_name, std::move(index_handle));
+        flush_meta();
+    } catch (...) {
+        {
+            std::unique_lock<std::shared_mutex> build_lock(index_build_latch_);
+            unregister();
+        }
+        if (index_handle != nullptr) {
+            discard_file(index_handle->get_fd(), index_name);
+        }
+        throw;
+    }
+}
+
+/**
+ * @description: DML修改记录后调用，把表上正在构建的索引需要的变更记录到side log中，调用者需持有index_build_latch_的共享锁
+ * @param {string&} tab_name 表的名称
+ * @param {char*} old_rec 修改前的记录，插入时为nullptr
+ * @param {char*} new_rec 修改后的记录，删除时为nullptr
+ * @param {Rid&} rid 记录的位置
+ */
+void SmManager::capture_index_build(const std::string& tab_name, const char* old_rec, const char* new_rec,
+                                    const Rid& rid) {
+    auto build_it = index_builds_.find(tab_name);
+    if (build_it == index_builds_.end()) {
+        return;
+    }
+    for (auto &build : build_it->second) {
+        auto &index = build->index_meta;
+        auto make_key = [&](const char* rec) {
+            std::string key(index.col_tot_len, '\0');
+            int offset = 0;
+            for (auto &col : index.cols) {
+                memcpy(&key[offset], rec + col.offset, col.len);
+                offset += col.len;
+            }
+            return key;
+        };
+        std::scoped_lock log_lock{build->latch};
+        if (old_rec != nullptr && index.covers(old_rec)) {
+            build->side_log_.push_back(IndexBuildOp{IndexOpType::INDEX_DELETE, make_key(old_rec), rid});
+        }
+        if (new_rec != nullptr && index.covers(new_rec)) {
+            build->side_log_.push_back(IndexBuildOp{IndexOpType::INDEX_INSERT, make_key(new_rec), rid});
+        }
+    }
+}
+
+/**
+ * @description: 判断表上是否有正在构建的指定索引
+ * @param {string&} tab_name 表的名称
+ * @param {vector<string>&} col_names 索引包含的字段名称
+ */
+bool SmManager::is_index_building(const std::string& tab_name, const std::vector<std::string>& col_names) {
+    std::shared_lock<std::shared_mutex> build_lock(index_build_latch_);
+    auto build_it = index_builds_.find(tab_name);
+    if (build_it == index_builds_.end()) {
+        return false;
+    }
+    for (auto &build : build_it->second) {
+        auto &cols = build->index_meta.cols;
+        if (cols.size() == col_names.size() &&
+            std::equal(cols.begin(), cols.end(), col_names.begin(),
+                       [](const ColMeta &col, const std::string &name) { return col.name == name; })) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @description: 判断表上是否有正在构建的索引，调用者需持有index_build_latch_
+ * @param {string&} tab_name 表的名称
+ */
+bool SmManager::has_index_build(const std::string& tab_name) {
+    auto build_it = index_builds_.find(tab_name);
+    return build_it != index_builds_.end() && !build_it->second.empty();
+}
+
+/**
+ * @description: 按顺序把side log中的索引变更应用到构建中的索引上
+ * @param {IndexBuild*} build 构建中的索引
+ * @param {vector<IndexBuildOp>&} ops 需要回放的变更，回放后清空
+ */
+void SmManager::replay_index_build(IndexBuild* build, std::vector<IndexBuildOp>& ops) {
+    for (auto &op : ops) {
+        // 快照扫描可能已经包含了该变更，插入重复键和删除不存在的键都直接忽略
+        if (op.op_type == IndexOpType::INDEX_INSERT) {
+            build->ih->insert_entry(op.key.data(), op.rid, nullptr);
+        } else {
+            build->ih->delete_entry(op.key.data(), nullptr);
+        }
+    }
+    ops.clear();
+}
+
 /**
  * @description: 删除索引
  * @param {string&} tab_name 表名称
@@ -376,6 +1160,9 @@ void SmManager::create_index(const std::string& tab_name, const std::vector<std:
  */
 void SmManager::drop_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context) {
     TabMeta &tab = db_.get_table(tab_name);
+    if (tab.organized_by == col_names) {
+        throw RMDBError("Cannot drop the index that organizes table " + tab_name);
+    }
     
     // 申请表级意向排他锁（删除索引需要IX锁）
     if (context != nullptr && context->txn_ != nullptr && context->lock_mgr_ != nullptr) {
@@ -384,6 +1171,11 @@ void SmManager::drop_index(const std::string& tab_name, const std::vector<std::s
             throw std::runtime_error("Failed to acquire IX lock on table");
         }
     }
+    // IX锁不与在线建索引冲突，删除期间持有共享锁，使在线建索引不能注册，也不能把新索引加入tab.indexes
+    std::shared_lock<std::shared_mutex> build_lock(index_build_latch_);
+    if (has_index_build(tab_name)) {
+        throw RMDBError("Cannot drop an index on table " + tab_name + " while an index is being built on it");
+    }
     
     // 查找索引元数据
     auto index_it = tab.get_index_meta(col_names);
@@ -433,4 +1225,355 @@ void SmManager::drop_index(const std::string& tab_name, const std::vector<ColMet
         col_names.push_back(col.name);
     }
     drop_index(tab_name, col_names, context);
-}
\ No newline at end of file
+}
+/**
+ * @description: 在CHAR字段上创建三元组倒排索引，用于加速LIKE '%...%'这类不能用B+树索引的子串匹配
+ * @param {string&} tab_name 表的名称
+ * @param {string&} col_name 字段名称
+ * @param {Context*} context
+ */
+void SmManager::create_trigram_index(const std::string& tab_name, const std::string& col_name, Context* context) {
+    TabMeta &tab = db_.get_table(tab_name);
+    auto col = tab.get_col(col_name);
+    if (tab.is_trigram_index(col_name)) {
+        throw IndexExistsError(tab_name, {col_name});
+    }
+    if (col->type != TYPE_STRING) {
+        throw IncompatibleTypeError(coltype2str(col->type), coltype2str(TYPE_STRING));
+    }
+
+    // 申请表级意向排他锁（创建索引需要IX锁）
+    if (context != nullptr && context->txn_ != nullptr && context->lock_mgr_ != nullptr) {
+        if (!context->lock_mgr_->lock_IX_on_table(context->txn_, fhs_.at(tab_name)->GetFd())) {
+            throw std::runtime_error("Failed to acquire IX lock on table");
+        }
+    }
+
+    ix_manager_->create_trigram(tab_name, *col);
+    auto tg = ix_manager_->open_trigram(tab_name, col_name);
+    auto file_handle = fhs_.at(tab_name).get();
+    for (RmScan scan(file_handle); !scan.is_end(); scan.next()) {
+        auto record = file_handle->get_record(scan.rid(), context);
+        if (record != nullptr) {
+            tg->insert_entry(record->data + col->offset, scan.rid());
+        }
+    }
+
+    tab.trigram_cols.push_back(col_name);
+    tgs_.emplace(ix_manager_->get_trigram_name(tab_name, col_name), std::move(tg));
+    flush_meta();
+}
+
+/**
+ * @description: 删除三元组倒排索引
+ * @param {string&} tab_name 表的名称
+ * @param {string&} col_name 字段名称
+ * @param {Context*} context
+ */
+void SmManager::drop_trigram_index(const std::string& tab_name, const std::string& col_name, Context* context) {
+    TabMeta &tab = db_.get_table(tab_name);
+    if (!tab.is_trigram_index(col_name)) {
+        throw IndexNotFoundError(tab_name, {col_name});
+    }
+
+    // 申请表级意向排他锁（删除索引需要IX锁）
+    if (context != nullptr && context->txn_ != nullptr && context->lock_mgr_ != nullptr) {
+        if (!context->lock_mgr_->lock_IX_on_table(context->txn_, fhs_.at(tab_name)->GetFd())) {
+            throw std::runtime_error("Failed to acquire IX lock on table");
+        }
+    }
+
+    std::string tgm_name = ix_manager_->get_trigram_name(tab_name, col_name);
+    auto tg_it = tgs_.find(tgm_name);
+    if (tg_it != tgs_.end()) {
+        ix_manager_->close_trigram(tg_it->second.get());
+        tgs_.erase(tg_it);
+    }
+    ix_manager_->destroy_trigram(tab_name, col_name);
+    tab.trigram_cols.erase(std::find(tab.trigram_cols.begin(), tab.trigram_cols.end(), col_name));
+    flush_meta();
+}
+
+/**
+ * @description: DML修改记录后调用，维护表上的三元组索引
+ * @param {string&} tab_name 表的名称
+ * @param {char*} old_rec 修改前的记录，插入时为nullptr
+ * @param {char*} new_rec 修改后的记录，删除时为nullptr
+ * @param {Rid&} rid 记录的位置
+ */
+void SmManager::capture_trigram(const std::string& tab_name, const char* old_rec, const char* new_rec,
+                                const Rid& rid) {
+    TabMeta &tab = db_.get_table(tab_name);
+    for (auto &col_name : tab.trigram_cols) {
+        auto col = tab.get_col(col_name);
+        if (old_rec != nullptr && new_rec != nullptr &&
+            memcmp(old_rec + col->offset, new_rec + col->offset, col->len) == 0) {
+            continue;
+        }
+        IxTrigramHandle *tg = tgs_.at(ix_manager_->get_trigram_name(tab_name, col_name)).get();
+        if (old_rec != nullptr) {
+            tg->delete_entry(old_rec + col->offset, rid);
+        }
+        if (new_rec != nullptr) {
+            tg->insert_entry(new_rec + col->offset, rid);
+        }
+    }
+}
+
+/**
+ * @description: 表文件被整体替换后（TRUNCATE回滚、CLUSTER），扫描新表文件重建表上的三元组索引
+ * @param {string&} tab_name 表的名称
+ */
+void SmManager::rebuild_trigram_indexes(const std::string& tab_name) {
+    TabMeta &tab = db_.get_table(tab_name);
+    auto file_handle = fhs_.at(tab_name).get();
+    for (auto &col_name : tab.trigram_cols) {
+        auto col = tab.get_col(col_name);
+        IxTrigramHandle *tg = tgs_.at(ix_manager_->get_trigram_name(tab_name, col_name)).get();
+        tg->clear();
+        for (RmScan scan(file_handle); !scan.is_end(); scan.next()) {
+            auto record = file_handle->get_record(scan.rid(), nullptr);
+            if (record != nullptr) {
+                tg->insert_entry(record->data + col->offset, scan.rid());
+            }
+        }
+    }
+}
+
+/**
+ * @description: 扫描全表重新生成统计信息
+ *               与后台ANALYZE相同，扫描不申请表锁和行锁，不阻塞并发的DML
+ * @param {string&} tab_name 表的名称
+ * @param {Context*} context
+ */
+void SmManager::analyze_table(const std::string& tab_name, Context* context) {
+    if (!db_.is_table(tab_name)) {
+        throw TableNotFoundError(tab_name);
+    }
+    scan_stats(tab_name);
+}
+
+/**
+ * @description: DML修改记录后调用，把变更加入表的统计信息，草图偏离超过阈值时提交后台ANALYZE
+ * @param {string&} tab_name 表的名称
+ * @param {char*} old_rec 修改前的记录，插入时为nullptr
+ * @param {char*} new_rec 修改后的记录，删除时为nullptr
+ */
+void SmManager::capture_stats(const std::string& tab_name, const char* old_rec, const char* new_rec) {
+    bool need_analyze;
+    {
+        std::shared_lock<std::shared_mutex> stats_lock(stats_latch_);
+        auto stats_it = stats_.find(tab_name);
+        if (stats_it == stats_.end()) {
+            return;
+        }
+        TableStats *stats = stats_it->second.get();
+        std::scoped_lock lock{stats->latch};
+        stats->record_change(old_rec, new_rec);
+        need_analyze = !stats->analyze_pending && stats->needs_analyze();
+        if (need_analyze) {
+            stats->analyze_pending = true;
+        }
+    }
+    if (need_analyze) {
+        request_analyze(tab_name);
+    }
+}
+
+/**
+ * @description: 根据统计信息估计表上满足条件的记录数
+ * @return {double} 估计的记录数，表没有统计信息时返回-1
+ */
+double SmManager::estimate_rows(const std::string& tab_name, const std::vector<Condition>& conds) {
+    std::shared_lock<std::shared_mutex> stats_lock(stats_latch_);
+    auto stats_it = stats_.find(tab_name);
+    if (stats_it == stats_.end()) {
+        return -1;
+    }
+    std::scoped_lock lock{stats_it->second->latch};
+    return stats_it->second->estimate_rows(tab_name, conds);
+}
+
+/**
+ * @description: 表的内容或结构发生了变化：事务提交或回滚了对表的修改，或者执行了表上的DDL
+ */
+void SmManager::bump_table_version(const std::string& tab_name) {
+    std::scoped_lock lock{version_latch_};
+    table_versions_[tab_name] = ++version_clock_;
+}
+
+/**
+ * @description: 表当前的版本，从未修改过的表为0
+ */
+uint64_t SmManager::table_version(const std::string& tab_name) {
+    std::scoped_lock lock{version_latch_};
+    auto it = table_versions_.find(tab_name);
+    return it == table_versions_.end() ? 0 : it->second;
+}
+
+/**
+ * @description: 打开数据库时读入DB_STATS_NAME，文件不存在或与表结构不一致的表交给后台ANALYZE
+ *               读入后删除文件：异常退出时文件不存在，重启后所有表都重新ANALYZE，不会沿用过时的记录数
+ */
+void SmManager::load_stats() {
+    for (auto &entry : db_.tabs_) {
+        auto stats = std::make_unique<TableStats>(entry.second.cols);
+        stats->exact_rows = false;
+        stats_.emplace(entry.first, std::move(stats));
+    }
+    std::unordered_set<std::string> loaded;
+    std::ifstream ifs(DB_STATS_NAME);
+    size_t n = 0;
+    if (ifs) {
+        ifs >> n;
+    }
+    for (size_t i = 0; i < n && ifs; i++) {
+        std::string tab_name;
+        ifs >> tab_name;
+        auto stats_it = stats_.find(tab_name);
+        if (stats_it == stats_.end()) {
+            break;
+        }
+        if (ifs >> *stats_it->second) {
+            stats_it->second->exact_rows = true;
+            loaded.insert(tab_name);
+        } else {
+            stats_it->second = std::make_unique<TableStats>(db_.get_table(tab_name).cols);
+            stats_it->second->exact_rows = false;
+        }
+    }
+    ifs.close();
+    unlink(DB_STATS_NAME.c_str());
+    for (auto &entry : stats_) {
+        if (loaded.count(entry.first) == 0) {
+            entry.second->analyze_pending = true;
+            request_analyze(entry.first);
+        }
+    }
+}
+
+/**
+ * @description: 把所有表的统计信息写入DB_STATS_NAME
+ */
+void SmManager::flush_stats() {
+    std::shared_lock<std::shared_mutex> stats_lock(stats_latch_);
+    std::ofstream ofs(DB_STATS_NAME);
+    ofs << stats_.size() << '\n';
+    for (auto &entry : stats_) {
+        std::scoped_lock lock{entry.second->latch};
+        ofs << entry.first << ' ' << *entry.second << '\n';
+    }
+}
+
+/**
+ * @description: 快照扫描全表生成新的草图，替换表当前的统计信息
+ *               扫描期间只持有该表的scan_latch，不阻塞其他表上的DDL；删除或替换该表文件的DDL通过stop_stats_scan()
+ *               让扫描放弃结果后退出。并发DML的修改可能反映也可能不反映在结果中
+ * @param {string&} tab_name 表的名称
+ */
+void SmManager::scan_stats(const std::string& tab_name) {
+    std::shared_lock<std::shared_mutex> stats_lock(stats_latch_);
+    auto stats_it = stats_.find(tab_name);
+    auto fh_it = fhs_.find(tab_name);
+    if (stats_it == stats_.end() || fh_it == fhs_.end()) {
+        return;
+    }
+    TableStats *stats = stats_it->second.get();
+    auto file_handle = fh_it->second.get();
+    // 持有scan_latch期间表文件和统计信息都不会被删除或替换
+    std::shared_lock<std::shared_mutex> scan_lock(stats->scan_latch);
+    stats_lock.unlock();
+    std::vector<ColMeta> cols;
+    {
+        std::scoped_lock lock{stats->latch};
+        for (auto &col : stats->cols) {
+            cols.push_back(col.col);
+        }
+    }
+    TableStats fresh(cols);
+    bool cancelled = false;
+    try {
+        for (RmScan scan(file_handle); !scan.is_end(); scan.next()) {
+            if (stats->scan_cancelled.load(std::memory_order_relaxed)) {
+                cancelled = true;
+                break;
+            }
+            std::unique_ptr<RmRecord> record;
+            try {
+                record = file_handle->get_record(scan.rid(), nullptr);
+            } catch (std::runtime_error &) {
+                continue;  // 记录在扫描过程中被并发删除
+            }
+            fresh.record_change(nullptr, record->data);
+        }
+    } catch (...) {
+        std::scoped_lock lock{stats->latch};
+        stats->analyze_pending = false;
+        throw;
+    }
+    std::scoped_lock lock{stats->latch};
+    if (!cancelled) {
+        stats->replace(fresh);
+    }
+    stats->analyze_pending = false;
+}
+
+/**
+ * @description: 删除或替换表文件前调用，让表上正在进行的ANALYZE扫描放弃结果并等待其退出，调用者需持有stats_latch_的排他锁
+ * @param {string&} tab_name 表的名称
+ */
+void SmManager::stop_stats_scan(const std::string& tab_name) {
+    auto stats_it = stats_.find(tab_name);
+    if (stats_it == stats_.end()) {
+        return;
+    }
+    TableStats *stats = stats_it->second.get();
+    stats->scan_cancelled = true;
+    std::unique_lock<std::shared_mutex> scan_lock(stats->scan_latch);
+    // 持有stats_latch_的排他锁，新的扫描在调用者释放之前不会开始
+    stats->scan_cancelled = false;
+}
+
+/**
+ * @description: 把表交给后台ANALYZE线程，调用者需已把表的analyze_pending置为true
+ */
+void SmManager::request_analyze(const std::string& tab_name) {
+    std::scoped_lock lock{analyze_queue_latch_};
+    analyze_queue_.push_back(tab_name);
+    analyze_queue_cv_.notify_one();
+}
+
+void SmManager::start_stats_worker() {
+    stats_worker_stop_ = false;
+    stats_worker_ = std::thread([this]() {
+        while (true) {
+            std::string tab_name;
+            {
+                std::unique_lock<std::mutex> lock(analyze_queue_latch_);
+                analyze_queue_cv_.wait(lock, [&]() { return stats_worker_stop_ || !analyze_queue_.empty(); });
+                if (stats_worker_stop_) {
+                    return;
+                }
+                tab_name = std::move(analyze_queue_.front());
+                analyze_queue_.pop_front();
+            }
+            try {
+                scan_stats(tab_name);
+            } catch (std::exception &) {
+                // 统计信息只用于估计，失败后等待下一次触发
+            }
+        }
+    });
+}
+
+void SmManager::stop_stats_worker() {
+    {
+        std::scoped_lock lock{analyze_queue_latch_};
+        stats_worker_stop_ = true;
+        analyze_queue_.clear();
+    }
+    analyze_queue_cv_.notify_all();
+    if (stats_worker_.joinable()) {
+        stats_worker_.join();
+    }
+}
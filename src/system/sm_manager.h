@@ -10,10 +10,19 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
 #include "index/ix.h"
 #include "record/rm_file_handle.h"
 #include "sm_defs.h"
 #include "sm_meta.h"
+#include "sm_stats.h"
+#include "sm_workload.h"
 #include "common/context.h"
 
 class Context;
@@ -24,17 +33,58 @@ struct ColDef {
     int len;           // Length of column
 };
 
+/* 被TRUNCATE换下的旧文件，事务提交时删除，事务回滚时换回 */
+struct TruncatedFile {
+    std::string file_name;                  // 原文件名
+    std::string backup_name;                // 旧文件改名后的文件名
+    std::unique_ptr<RmFileHandle> fh;       // 旧表文件句柄，索引文件时为空
+    std::unique_ptr<IxIndexHandle> ih;      // 旧索引文件句柄，表文件时为空
+};
+
+/* CREATE INDEX CONCURRENTLY构建期间，并发DML产生的一条索引变更 */
+struct IndexBuildOp {
+    IndexOpType op_type;    // INDEX_INSERT 或 INDEX_DELETE
+    std::string key;        // 索引键值
+    Rid rid;                // 记录的位置
+};
+
+/* 正在后台构建、尚未对查询可见的索引 */
+struct IndexBuild {
+    IndexMeta index_meta;                   // 索引元数据，构建完成后加入TabMeta
+    IxIndexHandle* ih;                      // 新索引文件的句柄
+    std::mutex latch;                       // 用于side_log_的并发
+    std::vector<IndexBuildOp> side_log_;    // 快照扫描开始后并发DML产生的索引变更，构建完成前回放
+};
+
 /* 系统管理器，负责元数据管理和DDL语句的执行 */
 class SmManager {
    public:
     DbMeta db_;             // 当前打开的数据库的元数据
     std::unordered_map<std::string, std::unique_ptr<RmFileHandle>> fhs_;    // file name -> record file handle, 当前数据库中每张表的数据文件
     std::unordered_map<std::string, std::unique_ptr<IxIndexHandle>> ihs_;   // file name -> index file handle, 当前数据库中每个索引的文件
+    std::unordered_map<std::string, std::unique_ptr<IxTrigramHandle>> tgs_; // file name -> trigram index handle, 当前数据库中每个三元组索引的文件
+    std::shared_mutex index_build_latch_;   // DML修改表及索引期间持有共享锁，CREATE INDEX CONCURRENTLY注册和切换索引时短暂持有排他锁
+    WorkloadLog workload_;                  // 执行过的全表扫描，ADVISE INDEXES据此推荐索引
    private:
     DiskManager* disk_manager_;
     BufferPoolManager* buffer_pool_manager_;
     RmManager* rm_manager_;
     IxManager* ix_manager_;
+    std::map<std::pair<txn_id_t, std::string>, std::vector<TruncatedFile>> truncated_files_;  // (txn_id, tab_name) -> 被TRUNCATE换下的旧文件
+    std::mutex truncate_latch_;     // 用于truncated_files_的并发
+    std::unordered_map<std::string, std::vector<std::shared_ptr<IndexBuild>>> index_builds_;  // tab_name -> 正在构建的索引，受index_build_latch_保护
+
+    std::unordered_map<std::string, std::unique_ptr<TableStats>> stats_;    // tab_name -> 表的统计信息
+    std::shared_mutex stats_latch_;         // 保护stats_和fhs_中的表文件，增删表、替换表文件时持有排他锁
+    std::thread stats_worker_;              // 后台ANALYZE线程，数据库打开期间运行
+    std::mutex analyze_queue_latch_;        // 用于analyze_queue_和stats_worker_stop_的并发
+    std::condition_variable analyze_queue_cv_;
+    std::deque<std::string> analyze_queue_; // 等待后台ANALYZE的表
+    bool stats_worker_stop_ = false;
+
+    std::unordered_map<std::string, uint64_t> table_versions_;  // tab_name -> 表的版本，查询结果缓存据此判断结果是否失效
+    uint64_t version_clock_ = 0;            // 版本号全局递增，删除后重建的同名表也不会与旧缓存项的版本相同
+    std::mutex version_latch_;              // 用于table_versions_和version_clock_的并发
 
    public:
     SmManager(DiskManager* disk_manager, BufferPoolManager* buffer_pool_manager, RmManager* rm_manager,
@@ -44,7 +94,7 @@ class SmManager {
           rm_manager_(rm_manager),
           ix_manager_(ix_manager) {}
 
-    ~SmManager() {}
+    ~SmManager() { stop_stats_worker(); }
 
     BufferPoolManager* get_bpm() { return buffer_pool_manager_; }
 
@@ -68,13 +118,80 @@ class SmManager {
 
     void desc_table(const std::string& tab_name, Context* context);
 
-    void create_table(const std::string& tab_name, const std::vector<ColDef>& col_defs, Context* context);
+    void create_table(const std::string& tab_name, const std::vector<ColDef>& col_defs, Context* context,
+                      const std::vector<std::string>& organized_by = {});
 
     void drop_table(const std::string& tab_name, Context* context);
 
-    void create_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context);
+    void create_view(const ViewMeta& view, const std::vector<ColDef>& col_defs, Context* context);
+
+    void drop_view(const std::string& view_name, Context* context);
+
+    void truncate_table(const std::string& tab_name, Context* context);
+
+    void commit_truncate(const std::string& tab_name, Transaction* txn);
+
+    void rollback_truncate(const std::string& tab_name, Transaction* txn);
+
+    void cluster_table(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context);
+
+    void create_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context,
+                      const std::vector<Condition>& conds = {});
+
+    void create_index_concurrently(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context,
+                                   const std::vector<Condition>& conds = {});
+
+    void capture_index_build(const std::string& tab_name, const char* old_rec, const char* new_rec, const Rid& rid);
 
     void drop_index(const std::string& tab_name, const std::vector<std::string>& col_names, Context* context);
     
     void drop_index(const std::string& tab_name, const std::vector<ColMeta>& col_names, Context* context);
+
+    void create_trigram_index(const std::string& tab_name, const std::string& col_name, Context* context);
+
+    void drop_trigram_index(const std::string& tab_name, const std::string& col_name, Context* context);
+
+    void capture_trigram(const std::string& tab_name, const char* old_rec, const char* new_rec, const Rid& rid);
+
+    void analyze_table(const std::string& tab_name, Context* context);
+
+    void capture_stats(const std::string& tab_name, const char* old_rec, const char* new_rec);
+
+    double estimate_rows(const std::string& tab_name, const std::vector<Condition>& conds);
+
+    void bump_table_version(const std::string& tab_name);
+
+    uint64_t table_version(const std::string& tab_name);
+
+   private:
+    void discard_file(int fd, const std::string& file_name);
+
+    int flush_for_read(const std::string& tab_name);
+
+    template <typename Consumer>
+    void read_morsel(RmFileHandle* fh, int num_pages, size_t morsel, std::vector<char>& buf, Consumer&& consume);
+
+    std::vector<IndexPredicate> get_index_preds(TabMeta& tab, const std::vector<Condition>& conds);
+
+    bool is_index_building(const std::string& tab_name, const std::vector<std::string>& col_names);
+
+    bool has_index_build(const std::string& tab_name);
+
+    void replay_index_build(IndexBuild* build, std::vector<IndexBuildOp>& ops);
+
+    void rebuild_trigram_indexes(const std::string& tab_name);
+
+    void load_stats();
+
+    void flush_stats();
+
+    void scan_stats(const std::string& tab_name);
+
+    void stop_stats_scan(const std::string& tab_name);
+
+    void request_analyze(const std::string& tab_name);
+
+    void start_stats_worker();
+
+    void stop_stats_worker();
 };
\ No newline at end of file
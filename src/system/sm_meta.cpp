@@ -0,0 +1,136 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "sm_meta.h"
+
+#include "common/common.h"
+
+ViewMeta::ViewMeta() = default;
+
+ViewMeta::ViewMeta(const ViewMeta &other) = default;
+
+ViewMeta &ViewMeta::operator=(const ViewMeta &other) = default;
+
+ViewMeta::~ViewMeta() = default;
+
+std::ostream &operator<<(std::ostream &os, const ViewMeta &view) {
+    os << view.name << ' ' << view.count_star << ' ' << view.tables.size();
+    for (auto &tab_name : view.tables) {
+        os << ' ' << tab_name;
+    }
+    os << '\n' << view.cols.size();
+    for (auto &col : view.cols) {
+        os << ' ' << col.tab_name << ' ' << col.col_name;
+    }
+    os << '\n' << view.conds.size();
+    for (auto &cond : view.conds) {
+        os << '\n' << cond.lhs_col.tab_name << ' ' << cond.lhs_col.col_name << ' ' << cond.op << ' '
+           << cond.is_rhs_val << ' ';
+        if (cond.is_rhs_val) {
+            // 值按raw原样保存，字符串可能包含空格
+            os << cond.rhs_val.type << ' ' << cond.rhs_val.raw->size << ' ';
+            os.write(cond.rhs_val.raw->data, cond.rhs_val.raw->size);
+        } else {
+            os << cond.rhs_col.tab_name << ' ' << cond.rhs_col.col_name;
+        }
+    }
+    return os;
+}
+
+std::istream &operator>>(std::istream &is, ViewMeta &view) {
+    size_t n;
+    is >> view.name >> view.count_star >> n;
+    view.tables.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        is >> view.tables[i];
+    }
+    is >> n;
+    view.cols.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        is >> view.cols[i].tab_name >> view.cols[i].col_name;
+    }
+    is >> n;
+    view.conds.resize(n);
+    for (auto &cond : view.conds) {
+        int op;
+        is >> cond.lhs_col.tab_name >> cond.lhs_col.col_name >> op >> cond.is_rhs_val;
+        cond.op = static_cast<CompOp>(op);
+        if (!cond.is_rhs_val) {
+            is >> cond.rhs_col.tab_name >> cond.rhs_col.col_name;
+            continue;
+        }
+        int type, size;
+        is >> type >> size;
+        is.get();
+        auto raw = std::make_shared<RmRecord>(size);
+        is.read(raw->data, size);
+        Value &val = cond.rhs_val;
+        val.type = static_cast<ColType>(type);
+        if (val.type == TYPE_INT) {
+            memcpy(&val.int_val, raw->data, sizeof(int));
+        } else if (val.type == TYPE_FLOAT) {
+            memcpy(&val.float_val, raw->data, sizeof(float));
+        } else if (val.type == TYPE_BIGINT || val.type == TYPE_DATETIME) {
+            memcpy(&val.bigint_val, raw->data, sizeof(int64_t));
+        } else {
+            val.str_val = std::string(raw->data, strnlen(raw->data, size));
+        }
+        val.raw = std::move(raw);
+    }
+    return is;
+}
+
+std::ostream &operator<<(std::ostream &os, const DbMeta &db_meta) {
+    os << DB_META_VERSION_TAG << ' ' << DB_META_VERSION << '\n';
+    os << db_meta.name_ << '\n' << db_meta.tabs_.size() << '\n';
+    for (auto &entry : db_meta.tabs_) {
+        os << entry.second << '\n';
+    }
+    os << db_meta.views_.size() << '\n';
+    for (auto &entry : db_meta.views_) {
+        os << entry.second << '\n';
+    }
+    return os;
+}
+
+std::istream &operator>>(std::istream &is, DbMeta &db_meta) {
+    // 旧格式的文件没有版本头，第一个单词就是数据库名称
+    std::string tag;
+    int version = 0;
+    is >> tag;
+    if (tag == DB_META_VERSION_TAG) {
+        is >> version >> db_meta.name_;
+    } else {
+        db_meta.name_ = tag;
+    }
+    if (version > DB_META_VERSION) {
+        throw InternalError("Unsupported meta version " + std::to_string(version));
+    }
+    is.iword(legacy_meta_index()) = (version == 0);
+
+    size_t n;
+    is >> n;
+    for (size_t i = 0; i < n; i++) {
+        TabMeta tab;
+        is >> tab;
+        db_meta.tabs_[tab.name] = tab;
+    }
+    is.iword(legacy_meta_index()) = 0;
+    if (version == 0) {
+        return is;
+    }
+    is >> n;
+    for (size_t i = 0; i < n; i++) {
+        ViewMeta view;
+        is >> view;
+        db_meta.views_[view.name] = view;
+    }
+    return is;
+}
@@ -11,14 +11,28 @@ See the Mulan PSL v2 for more details. */
 #pragma once
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <map>
 #include <string>
 #include <vector>
 
+#include "common/config.h"
 #include "errors.h"
 #include "sm_defs.h"
 
+struct TabCol;
+struct Condition;
+
+/**
+ * 读取元数据文件时流中的标志位下标，标志非0表示文件是版本0的旧格式：
+ * 索引没有谓词，表没有组织方式和三元组索引字段，数据库没有物化视图
+ */
+inline int legacy_meta_index() {
+    static const int index = std::ios_base::xalloc();
+    return index;
+}
+
 /* 字段元数据 */
 struct ColMeta {
     std::string tab_name;   // 字段所属表名称
@@ -39,18 +53,136 @@ struct ColMeta {
     }
 };
 
+/* 部分索引谓词：字段 op 常量 */
+struct IndexPredicate {
+    ColMeta col;        // 谓词字段
+    CompOp op;          // 比较运算符
+    std::string val;    // 常量，按字段类型编码，长度为col.len
+
+    /* 比较字段值a与b，返回负数、0、正数 */
+    int compare(const char *a, const char *b) const {
+        switch (col.type) {
+            case TYPE_INT: {
+                int x = *reinterpret_cast<const int *>(a), y = *reinterpret_cast<const int *>(b);
+                return (x < y) ? -1 : ((x > y) ? 1 : 0);
+            }
+            case TYPE_FLOAT: {
+                float x = *reinterpret_cast<const float *>(a), y = *reinterpret_cast<const float *>(b);
+                return (x < y) ? -1 : ((x > y) ? 1 : 0);
+            }
+            case TYPE_BIGINT:
+            case TYPE_DATETIME: {
+                int64_t x = *reinterpret_cast<const int64_t *>(a), y = *reinterpret_cast<const int64_t *>(b);
+                return (x < y) ? -1 : ((x > y) ? 1 : 0);
+            }
+            case TYPE_STRING:
+                return memcmp(a, b, col.len);
+            default:
+                throw InternalError("Unexpected data type");
+        }
+    }
+
+    /* 判断字段值value是否满足谓词 */
+    bool eval_value(const char *value) const {
+        int c = compare(value, val.data());
+        switch (op) {
+            case OP_EQ: return c == 0;
+            case OP_NE: return c != 0;
+            case OP_LT: return c < 0;
+            case OP_GT: return c > 0;
+            case OP_LE: return c <= 0;
+            case OP_GE: return c >= 0;
+            default: throw InternalError("Unexpected comparison operator");
+        }
+    }
+
+    /* 判断记录是否满足谓词 */
+    bool eval(const char *rec) const { return eval_value(rec + col.offset); }
+
+    /* 判断同一字段上的条件“col cond_op cond_val”是否蕴含该谓词 */
+    bool implied_by(CompOp cond_op, const char *cond_val) const {
+        if (cond_op == OP_EQ) {
+            return eval_value(cond_val);
+        }
+        int c = compare(cond_val, val.data());
+        switch (cond_op) {
+            case OP_NE: return op == OP_NE && c == 0;
+            case OP_GT: return (op == OP_GT || op == OP_GE || op == OP_NE) && c >= 0;
+            case OP_GE: return ((op == OP_GT || op == OP_NE) && c > 0) || (op == OP_GE && c >= 0);
+            case OP_LT: return (op == OP_LT || op == OP_LE || op == OP_NE) && c <= 0;
+            case OP_LE: return ((op == OP_LT || op == OP_NE) && c < 0) || (op == OP_LE && c <= 0);
+            default: return false;
+        }
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const IndexPredicate &pred) {
+        os << pred.col << ' ' << pred.op << ' ';
+        const char *data = pred.val.data();
+        switch (pred.col.type) {
+            case TYPE_INT: return os << *reinterpret_cast<const int *>(data);
+            case TYPE_FLOAT: {
+                auto precision = os.precision(9);
+                os << *reinterpret_cast<const float *>(data);
+                os.precision(precision);
+                return os;
+            }
+            case TYPE_BIGINT:
+            case TYPE_DATETIME: return os << *reinterpret_cast<const int64_t *>(data);
+            default: {
+                size_t len = strnlen(data, pred.val.size());
+                os << len << ' ';
+                return os.write(data, len);
+            }
+        }
+    }
+
+    friend std::istream &operator>>(std::istream &is, IndexPredicate &pred) {
+        is >> pred.col >> pred.op;
+        pred.val.assign(pred.col.len, '\0');
+        char *data = &pred.val[0];
+        if (pred.col.type == TYPE_INT) {
+            is >> *reinterpret_cast<int *>(data);
+        } else if (pred.col.type == TYPE_FLOAT) {
+            is >> *reinterpret_cast<float *>(data);
+        } else if (pred.col.type == TYPE_BIGINT || pred.col.type == TYPE_DATETIME) {
+            is >> *reinterpret_cast<int64_t *>(data);
+        } else {
+            size_t len;
+            is >> len;
+            is.get();
+            is.read(data, std::min(len, pred.val.size()));
+        }
+        return is;
+    }
+};
+
 /* 索引元数据 */
 struct IndexMeta {
     std::string tab_name;           // 索引所属表名称
     int col_tot_len;                // 索引字段长度总和
     int col_num;                    // 索引字段数量
     std::vector<ColMeta> cols;      // 索引包含的字段
+    std::vector<IndexPredicate> preds;  // 部分索引的谓词（合取），为空表示索引覆盖全表
+
+    bool is_partial() const { return !preds.empty(); }
+
+    /* 判断记录是否满足部分索引的谓词，只有满足的记录才会出现在索引中 */
+    bool covers(const char *rec) const {
+        for (auto &pred : preds) {
+            if (!pred.eval(rec)) return false;
+        }
+        return true;
+    }
 
     friend std::ostream &operator<<(std::ostream &os, const IndexMeta &index) {
         os << index.tab_name << " " << index.col_tot_len << " " << index.col_num;
         for(auto& col: index.cols) {
             os << "\n" << col;
         }
+        os << "\n" << index.preds.size();
+        for(auto& pred: index.preds) {
+            os << "\n" << pred;
+        }
         return os;
     }
 
@@ -61,6 +193,15 @@ struct IndexMeta {
             is >> col;
             index.cols.push_back(col);
         }
+        size_t n = 0;
+        if (!is.iword(legacy_meta_index())) {
+            is >> n;
+        }
+        for(size_t i = 0; i < n; ++i) {
+            IndexPredicate pred;
+            is >> pred;
+            index.preds.push_back(pred);
+        }
         return is;
     }
 };
@@ -70,14 +211,21 @@ struct TabMeta {
     std::string name;                   // 表名称
     std::vector<ColMeta> cols;          // 表包含的字段
     std::vector<IndexMeta> indexes;     // 表上建立的索引
+    std::vector<std::string> organized_by;  // 聚簇键：记录按该键上的索引顺序存放，为空表示普通堆表
+    std::vector<std::string> trigram_cols;  // 建有三元组倒排索引的CHAR字段
 
     TabMeta(){}
 
     TabMeta(const TabMeta &other) {
         name = other.name;
         for(auto col : other.cols) cols.push_back(col);
+        organized_by = other.organized_by;
+        trigram_cols = other.trigram_cols;
     }
 
+    /* 是否为按聚簇键组织的表 */
+    bool is_organized() const { return !organized_by.empty(); }
+
     /* 判断当前表中是否存在名为col_name的字段 */
     bool is_col(const std::string &col_name) const {
         auto pos = std::find_if(cols.begin(), cols.end(), [&](const ColMeta &col) { return col.name == col_name; });
@@ -100,6 +248,11 @@ struct TabMeta {
         return false;
     }
 
+    /* 判断字段col_name上是否建有三元组倒排索引 */
+    bool is_trigram_index(const std::string &col_name) const {
+        return std::find(trigram_cols.begin(), trigram_cols.end(), col_name) != trigram_cols.end();
+    }
+
     /* 根据字段名称集合获取索引元数据 */
     std::vector<IndexMeta>::iterator get_index_meta(const std::vector<std::string>& col_names) {
         for(auto index = indexes.begin(); index != indexes.end(); ++index) {
@@ -133,6 +286,14 @@ struct TabMeta {
         for (auto &index : tab.indexes) {
             os << index << "\n";
         }
+        os << tab.organized_by.size() << "\n";
+        for (auto &col_name : tab.organized_by) {
+            os << col_name << "\n";
+        }
+        os << tab.trigram_cols.size() << "\n";
+        for (auto &col_name : tab.trigram_cols) {
+            os << col_name << "\n";
+        }
         return os;
     }
 
@@ -150,10 +311,51 @@ struct TabMeta {
             is >> index;
             tab.indexes.push_back(index);
         }
+        if (is.iword(legacy_meta_index())) {
+            return is;
+        }
+        is >> n;
+        tab.organized_by.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            is >> tab.organized_by[i];
+        }
+        is >> n;
+        tab.trigram_cols.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            is >> tab.trigram_cols[i];
+        }
         return is;
     }
 };
 
+/**
+ * 物化视图元数据：视图的内容存放在同名的表中，随基表的修改增量维护
+ * 定义查询只支持多表连接上的选择投影，或者连接结果的count(*)
+ */
+struct ViewMeta {
+    std::string name;                   // 视图名称，同时是存放视图内容的表的名称
+    std::vector<std::string> tables;    // 定义查询的基表
+    std::vector<TabCol> cols;           // 投影列，依次对应视图表的字段，count(*)视图为空
+    std::vector<Condition> conds;       // 定义查询的where条件
+    bool count_star = false;            // 定义查询为select count(*)，视图表只有一行计数
+
+    // cols和conds的元素类型在这里只有声明，构造、复制和析构也在sm_meta.cpp中实现
+    ViewMeta();
+    ViewMeta(const ViewMeta &other);
+    ViewMeta &operator=(const ViewMeta &other);
+    ~ViewMeta();
+
+    /* 判断视图是否依赖表tab_name */
+    bool depends_on(const std::string &tab_name) const {
+        return std::find(tables.begin(), tables.end(), tab_name) != tables.end();
+    }
+
+    // 定义查询中的条件依赖common.h，读写在sm_meta.cpp中实现
+    friend std::ostream &operator<<(std::ostream &os, const ViewMeta &view);
+
+    friend std::istream &operator>>(std::istream &is, ViewMeta &view);
+};
+
 // 注意重载了操作符 << 和 >>，这需要更底层同样重载TabMeta、ColMeta的操作符 << 和 >>
 /* 数据库元数据 */
 class DbMeta {
@@ -162,6 +364,7 @@ class DbMeta {
    private:
     std::string name_;                      // 数据库名称
     std::map<std::string, TabMeta> tabs_;   // 数据库中包含的表
+    std::map<std::string, ViewMeta> views_; // 数据库中的物化视图，内容存放在tabs_中的同名表里
 
    public:
     // DbMeta(std::string name) : name_(name) {}
@@ -173,6 +376,17 @@ class DbMeta {
         tabs_[tab_name] = meta;
     }
 
+    /* 判断表tab_name是否为物化视图 */
+    bool is_view(const std::string &tab_name) const { return views_.find(tab_name) != views_.end(); }
+
+    const std::map<std::string, ViewMeta> &views() const { return views_; }
+
+    /* 判断是否有物化视图依赖表tab_name */
+    bool has_views_on(const std::string &tab_name) const {
+        return std::any_of(views_.begin(), views_.end(),
+                           [&](const auto &entry) { return entry.second.depends_on(tab_name); });
+    }
+
     /* 获取指定名称表的元数据 */
     TabMeta &get_table(const std::string &tab_name) {
         auto pos = tabs_.find(tab_name);
@@ -184,22 +398,7 @@ class DbMeta {
     }
 
     // 重载操作符 <<
-    friend std::ostream &operator<<(std::ostream &os, const DbMeta &db_meta) {
-        os << db_meta.name_ << '\n' << db_meta.tabs_.size() << '\n';
-        for (auto &entry : db_meta.tabs_) {
-            os << entry.second << '\n';
-        }
-        return os;
-    }
+    friend std::ostream &operator<<(std::ostream &os, const DbMeta &db_meta);
 
-    friend std::istream &operator>>(std::istream &is, DbMeta &db_meta) {
-        size_t n;
-        is >> db_meta.name_ >> n;
-        for (size_t i = 0; i < n; i++) {
-            TabMeta tab;
-            is >> tab;
-            db_meta.tabs_[tab.name] = tab;
-        }
-        return is;
-    }
+    friend std::istream &operator>>(std::istream &is, DbMeta &db_meta);
 };
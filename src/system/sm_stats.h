@@ -0,0 +1,381 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "common/common.h"
+#include "sm_meta.h"
+
+/**
+ * HyperLogLog基数估计：2^HLL_PRECISION个寄存器，误差约1.04/sqrt(2^HLL_PRECISION)。
+ * 两个草图按寄存器取最大值即可合并，但不能删除已加入的值
+ */
+class HyperLogLog {
+   public:
+    static constexpr int HLL_PRECISION = 11;
+    static constexpr int HLL_REGISTERS = 1 << HLL_PRECISION;
+
+   private:
+    std::vector<uint8_t> registers_;
+
+   public:
+    HyperLogLog() : registers_(HLL_REGISTERS, 0) {}
+
+    void add_hash(uint64_t hash) {
+        size_t idx = hash >> (64 - HLL_PRECISION);
+        uint64_t rest = hash << HLL_PRECISION;
+        uint8_t rank = rest == 0 ? 64 - HLL_PRECISION + 1 : static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+        registers_[idx] = std::max(registers_[idx], rank);
+    }
+
+    void clear() { std::fill(registers_.begin(), registers_.end(), 0); }
+
+    void merge(const HyperLogLog &other) {
+        for (int i = 0; i < HLL_REGISTERS; i++) {
+            registers_[i] = std::max(registers_[i], other.registers_[i]);
+        }
+    }
+
+    double estimate() const {
+        double sum = 0;
+        int zeros = 0;
+        for (auto reg : registers_) {
+            sum += std::ldexp(1.0, -reg);
+            zeros += reg == 0;
+        }
+        double m = HLL_REGISTERS;
+        double est = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+        // 基数较小时改用线性计数
+        if (est <= 2.5 * m && zeros > 0) {
+            est = m * std::log(m / zeros);
+        }
+        return est;
+    }
+
+    /* 每个寄存器写成两位十六进制数，所有寄存器写成一行 */
+    friend std::ostream &operator<<(std::ostream &os, const HyperLogLog &hll) {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex(2 * HLL_REGISTERS, '0');
+        for (int i = 0; i < HLL_REGISTERS; i++) {
+            hex[2 * i] = digits[hll.registers_[i] >> 4];
+            hex[2 * i + 1] = digits[hll.registers_[i] & 0xf];
+        }
+        return os << hex;
+    }
+
+    friend std::istream &operator>>(std::istream &is, HyperLogLog &hll) {
+        std::string hex;
+        is >> hex;
+        if (hex.size() != 2 * HLL_REGISTERS) {
+            is.setstate(std::ios::failbit);
+            return is;
+        }
+        for (int i = 0; i < HLL_REGISTERS; i++) {
+            hll.registers_[i] = static_cast<uint8_t>(std::stoi(hex.substr(2 * i, 2), nullptr, 16));
+        }
+        return is;
+    }
+};
+
+/**
+ * KLL分位数草图：第h层的每个值代表2^h个原始值，某层超过容量时排序后隔一个取一个提升到上一层。
+ * 高层容量为KLL_K，越往下按2/3递减，总空间为O(KLL_K)。两个草图逐层拼接后再压缩即可合并
+ */
+class KllSketch {
+   public:
+    static constexpr int KLL_K = 200;
+
+   private:
+    std::vector<std::vector<double>> levels_;   // levels_[h]中每个值的权重为2^h
+    uint64_t n_ = 0;                            // 加入的值的个数
+    uint64_t rng_ = 0x9e3779b97f4a7c15ULL;      // 压缩时决定保留奇数位还是偶数位
+
+   public:
+    uint64_t size() const { return n_; }
+
+    void add(double v) {
+        if (levels_.empty()) {
+            levels_.emplace_back();
+        }
+        levels_[0].push_back(v);
+        n_++;
+        compress();
+    }
+
+    void merge(const KllSketch &other) {
+        if (levels_.size() < other.levels_.size()) {
+            levels_.resize(other.levels_.size());
+        }
+        for (size_t h = 0; h < other.levels_.size(); h++) {
+            levels_[h].insert(levels_[h].end(), other.levels_[h].begin(), other.levels_[h].end());
+        }
+        n_ += other.n_;
+        compress();
+    }
+
+    /**
+     * @description: 估计不大于（inclusive为false时小于）v的值所占的比例
+     */
+    double rank(double v, bool inclusive) const {
+        double below = 0, total = 0;
+        for (size_t h = 0; h < levels_.size(); h++) {
+            double weight = std::ldexp(1.0, static_cast<int>(h));
+            for (double x : levels_[h]) {
+                total += weight;
+                if (x < v || (inclusive && x == v)) below += weight;
+            }
+        }
+        return total == 0 ? 0 : below / total;
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const KllSketch &kll) {
+        os << kll.n_ << ' ' << kll.levels_.size() << std::setprecision(17);
+        for (auto &level : kll.levels_) {
+            os << ' ' << level.size();
+            for (double x : level) os << ' ' << x;
+        }
+        return os;
+    }
+
+    friend std::istream &operator>>(std::istream &is, KllSketch &kll) {
+        size_t num_levels;
+        is >> kll.n_ >> num_levels;
+        kll.levels_.assign(num_levels, {});
+        for (auto &level : kll.levels_) {
+            size_t n;
+            is >> n;
+            level.resize(n);
+            for (double &x : level) is >> x;
+        }
+        return is;
+    }
+
+   private:
+    size_t capacity(size_t h) const {
+        double cap = KLL_K * std::pow(2.0 / 3.0, static_cast<double>(levels_.size() - 1 - h));
+        return std::max<size_t>(static_cast<size_t>(cap), 2);
+    }
+
+    void compress() {
+        for (size_t h = 0; h < levels_.size(); h++) {
+            if (levels_[h].size() < capacity(h)) {
+                continue;
+            }
+            if (h + 1 == levels_.size()) {
+                levels_.emplace_back();
+            }
+            auto &level = levels_[h];
+            std::sort(level.begin(), level.end());
+            // 个数为奇数时留下最后一个值，保证总权重不变
+            double rest = 0;
+            bool has_rest = level.size() % 2 == 1;
+            if (has_rest) {
+                rest = level.back();
+                level.pop_back();
+            }
+            rng_ ^= rng_ << 13;
+            rng_ ^= rng_ >> 7;
+            rng_ ^= rng_ << 17;
+            for (size_t i = rng_ & 1; i < level.size(); i += 2) {
+                levels_[h + 1].push_back(level[i]);
+            }
+            level.clear();
+            if (has_rest) {
+                level.push_back(rest);
+            }
+        }
+    }
+};
+
+/* 一个字段的统计信息 */
+struct ColumnStats {
+    ColMeta col;
+    HyperLogLog distinct;   // 不同值个数
+    KllSketch quantiles;    // 值的分布
+
+    /* 字段值映射为保持顺序的double，字符串取前8个字节 */
+    static double stats_key(const ColMeta &col, const char *value) {
+        switch (col.type) {
+            case TYPE_INT: return *reinterpret_cast<const int *>(value);
+            case TYPE_FLOAT: return *reinterpret_cast<const float *>(value);
+            case TYPE_BIGINT:
+            case TYPE_DATETIME: return static_cast<double>(*reinterpret_cast<const int64_t *>(value));
+            default: {
+                uint64_t key = 0;
+                for (int i = 0; i < 8; i++) {
+                    key = (key << 8) | (i < col.len ? static_cast<uint8_t>(value[i]) : 0);
+                }
+                return static_cast<double>(key);
+            }
+        }
+    }
+
+    static uint64_t stats_hash(const char *value, int len) {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (int i = 0; i < len; i++) {
+            h = (h ^ static_cast<uint8_t>(value[i])) * 0x100000001b3ULL;
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    void add(const char *rec) {
+        const char *value = rec + col.offset;
+        distinct.add_hash(stats_hash(value, col.len));
+        quantiles.add(stats_key(col, value));
+    }
+};
+
+/**
+ * 表的统计信息：记录数由DML精确维护，每个字段的草图随插入和更新增量加入新值。
+ * 删除和更新前的旧值无法从草图中撤销，累计的这类变更超过阈值后由后台ANALYZE重新扫描全表
+ */
+struct TableStats {
+    std::mutex latch;
+    bool exact_rows = true;         // num_rows是否由DML从已知的记录数开始精确维护，否则以ANALYZE扫描到的记录数为准
+    int64_t num_rows = 0;           // 当前的记录数
+    int64_t analyzed_rows = 0;      // 上次ANALYZE扫描到的记录数
+    int64_t modified_rows = 0;      // 上次ANALYZE之后草图没有反映的删除和更新
+    bool analyze_pending = false;   // 已经提交给后台ANALYZE，尚未完成
+    std::shared_mutex scan_latch;           // ANALYZE扫描表文件期间持有共享锁，删除或替换表文件前持有排他锁
+    std::atomic<bool> scan_cancelled{false};    // 表文件将被删除或替换，正在进行的ANALYZE扫描应放弃结果并退出
+    std::vector<ColumnStats> cols;
+
+    explicit TableStats(const std::vector<ColMeta> &tab_cols) {
+        for (auto &col : tab_cols) {
+            cols.push_back(ColumnStats{col, {}, {}});
+        }
+    }
+
+    /* 一条记录的变更，old_rec为nullptr表示插入，new_rec为nullptr表示删除，调用者需持有latch */
+    void record_change(const char *old_rec, const char *new_rec) {
+        if (new_rec != nullptr) {
+            for (auto &col : cols) col.add(new_rec);
+        }
+        if (old_rec == nullptr) {
+            num_rows++;
+        } else {
+            modified_rows++;
+            if (new_rec == nullptr) num_rows = std::max<int64_t>(num_rows - 1, 0);
+        }
+    }
+
+    /* 草图偏离表中实际数据的程度超过阈值，调用者需持有latch */
+    bool needs_analyze() const {
+        return modified_rows > AUTO_ANALYZE_BASE_ROWS +
+                                   AUTO_ANALYZE_SCALE * static_cast<double>(std::max(num_rows, analyzed_rows));
+    }
+
+    /**
+     * @description: 用ANALYZE重新扫描得到的草图替换当前的草图，调用者需持有latch
+     *               扫描不阻塞DML，扫描到的记录数不一定准确，记录数已精确维护时保留原值
+     */
+    void replace(TableStats &fresh) {
+        if (!exact_rows) {
+            num_rows = fresh.num_rows;
+            exact_rows = true;
+        }
+        analyzed_rows = num_rows;
+        modified_rows = 0;
+        cols = std::move(fresh.cols);
+    }
+
+    /**
+     * @description: 估计满足条件的记录数，条件之间按相互独立处理，调用者需持有latch
+     * @param {string&} tab_name 表名，只考虑左侧为该表字段的条件
+     */
+    double estimate_rows(const std::string &tab_name, const std::vector<Condition> &conds) const {
+        double selectivity = 1;
+        for (auto &cond : conds) {
+            if (cond.lhs_col.tab_name != tab_name) continue;
+            auto lhs = find_col(cond.lhs_col.col_name);
+            if (lhs == nullptr) continue;
+            if (!cond.is_rhs_val) {
+                auto rhs = find_col(cond.rhs_col.col_name);
+                if (cond.rhs_col.tab_name == tab_name && rhs != nullptr && cond.op == OP_EQ) {
+                    selectivity /= std::max(distinct_values(*lhs), distinct_values(*rhs));
+                } else {
+                    selectivity *= DEFAULT_RANGE_SELECTIVITY;
+                }
+                continue;
+            }
+            double ndv = distinct_values(*lhs);
+            double v = ColumnStats::stats_key(lhs->col, cond.rhs_val.raw->data);
+            bool has_dist = lhs->quantiles.size() > 0;
+            switch (cond.op) {
+                case OP_EQ: selectivity /= ndv; break;
+                case OP_NE: selectivity *= 1 - 1 / ndv; break;
+                case OP_LT: selectivity *= has_dist ? lhs->quantiles.rank(v, false) : DEFAULT_RANGE_SELECTIVITY; break;
+                case OP_LE: selectivity *= has_dist ? lhs->quantiles.rank(v, true) : DEFAULT_RANGE_SELECTIVITY; break;
+                case OP_GT: selectivity *= has_dist ? 1 - lhs->quantiles.rank(v, true) : DEFAULT_RANGE_SELECTIVITY; break;
+                case OP_GE: selectivity *= has_dist ? 1 - lhs->quantiles.rank(v, false) : DEFAULT_RANGE_SELECTIVITY; break;
+                case OP_LIKE: selectivity *= DEFAULT_LIKE_SELECTIVITY; break;
+            }
+        }
+        return num_rows * selectivity;
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const TableStats &stats) {
+        os << stats.num_rows << ' ' << stats.analyzed_rows << ' ' << stats.modified_rows << ' ' << stats.cols.size();
+        for (auto &col : stats.cols) {
+            os << '\n' << col.col.name << ' ' << col.distinct << '\n' << col.quantiles;
+        }
+        return os;
+    }
+
+    /* 字段按名字对应，文件中的字段与表不一致时返回的流处于失败状态 */
+    friend std::istream &operator>>(std::istream &is, TableStats &stats) {
+        size_t n;
+        is >> stats.num_rows >> stats.analyzed_rows >> stats.modified_rows >> n;
+        if (n != stats.cols.size()) {
+            is.setstate(std::ios::failbit);
+            return is;
+        }
+        for (auto &col : stats.cols) {
+            std::string name;
+            is >> name;
+            if (name != col.col.name) {
+                is.setstate(std::ios::failbit);
+                return is;
+            }
+            is >> col.distinct >> col.quantiles;
+        }
+        return is;
+    }
+
+   private:
+    static constexpr double DEFAULT_RANGE_SELECTIVITY = 1.0 / 3;
+    static constexpr double DEFAULT_LIKE_SELECTIVITY = 0.05;  // 没有前缀的LIKE，前缀部分已改写为范围条件单独估计
+
+    const ColumnStats *find_col(const std::string &col_name) const {
+        for (auto &col : cols) {
+            if (col.col.name == col_name) return &col;
+        }
+        return nullptr;
+    }
+
+    /* 不同值个数不超过记录数，且至少为1 */
+    double distinct_values(const ColumnStats &col) const {
+        return std::max(1.0, std::min(col.distinct.estimate(), static_cast<double>(std::max<int64_t>(num_rows, 1))));
+    }
+};
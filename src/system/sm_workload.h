@@ -0,0 +1,142 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/common.h"
+#include "common/config.h"
+
+/* 一种全表扫描的形状：表和条件用到的字段，不区分常量 */
+struct WorkloadShape {
+    std::string tab_name;
+    std::vector<std::string> eq_cols;       // 等值条件的字段，按条件出现的顺序
+    std::vector<std::string> range_cols;    // 范围条件的字段
+    std::vector<std::string> join_cols;     // 与其他表连接的字段
+    std::vector<Condition> conds;           // 最近一次规划时表上的条件，用于估计选择率
+    uint64_t executions = 0;                // 扫描执行的次数，连接内表的重复扫描也计入
+    uint64_t scan_ns = 0;                   // 扫描算子累计花费的时间
+};
+
+/* 工作负载记录中的一项，规划时登记，执行扫描的算子直接累加计数 */
+struct WorkloadEntry {
+    WorkloadShape shape;                    // 受WorkloadLog::latch_保护，executions和scan_ns不使用
+    std::atomic<uint64_t> executions{0};
+    std::atomic<uint64_t> scan_ns{0};
+};
+
+/* 扫描算子中统计一次调用的耗时，entry为空时不计时 */
+class WorkloadTimer {
+    WorkloadEntry *entry_;
+    std::chrono::steady_clock::time_point start_;
+
+   public:
+    explicit WorkloadTimer(WorkloadEntry *entry) : entry_(entry) {
+        if (entry_ != nullptr) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~WorkloadTimer() {
+        if (entry_ != nullptr) {
+            auto elapsed = std::chrono::steady_clock::now() - start_;
+            entry_->scan_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        }
+    }
+};
+
+/**
+ * 工作负载记录：规划器每生成一个全表扫描就按形状登记一次，ADVISE INDEXES据此推荐索引。
+ * 登记过的项在数据库关闭前不会删除，计划中保存的指针一直有效；形状个数达到WORKLOAD_MAX_SHAPES后不再登记新的形状
+ */
+class WorkloadLog {
+    std::mutex latch_;
+    std::unordered_map<std::string, std::unique_ptr<WorkloadEntry>> entries_;
+
+   public:
+    /**
+     * @description: 登记tab_name上按conds过滤的一次全表扫描
+     * @return {WorkloadEntry*} 扫描形状对应的项，记录已满时为空
+     * @param {vector<string>} join_cols 语句中该表与其他表连接的字段
+     */
+    WorkloadEntry *record(const std::string &tab_name, const std::vector<Condition> &conds,
+                          const std::vector<std::string> &join_cols) {
+        WorkloadShape shape;
+        shape.tab_name = tab_name;
+        auto add = [](std::vector<std::string> &cols, const std::string &col_name) {
+            if (std::find(cols.begin(), cols.end(), col_name) == cols.end()) {
+                cols.push_back(col_name);
+            }
+        };
+        for (auto &cond : conds) {
+            if (!cond.is_rhs_val || cond.lhs_col.tab_name != tab_name) {
+                continue;
+            }
+            if (cond.op == OP_EQ) {
+                add(shape.eq_cols, cond.lhs_col.col_name);
+            } else if (cond.op == OP_LT || cond.op == OP_GT || cond.op == OP_LE || cond.op == OP_GE) {
+                add(shape.range_cols, cond.lhs_col.col_name);
+            }
+        }
+        for (auto &col_name : join_cols) {
+            add(shape.join_cols, col_name);
+        }
+        std::sort(shape.range_cols.begin(), shape.range_cols.end());
+        std::sort(shape.join_cols.begin(), shape.join_cols.end());
+        // 等值字段的顺序影响索引匹配，保留原顺序
+        std::string key = tab_name;
+        for (auto *cols : {&shape.eq_cols, &shape.range_cols, &shape.join_cols}) {
+            key += '|';
+            for (auto &col_name : *cols) {
+                key += col_name + ',';
+            }
+        }
+        shape.conds = conds;
+
+        std::scoped_lock lock{latch_};
+        auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            if (entries_.size() >= WORKLOAD_MAX_SHAPES) {
+                return nullptr;
+            }
+            it = entries_.emplace(key, std::make_unique<WorkloadEntry>()).first;
+        }
+        it->second->shape = std::move(shape);
+        return it->second.get();
+    }
+
+    /* 所有执行过的形状的副本 */
+    std::vector<WorkloadShape> snapshot() {
+        std::vector<WorkloadShape> shapes;
+        std::scoped_lock lock{latch_};
+        for (auto &entry : entries_) {
+            if (entry.second->executions == 0) {
+                continue;
+            }
+            shapes.push_back(entry.second->shape);
+            shapes.back().executions = entry.second->executions;
+            shapes.back().scan_ns = entry.second->scan_ns;
+        }
+        return shapes;
+    }
+
+    void clear() {
+        std::scoped_lock lock{latch_};
+        entries_.clear();
+    }
+};
@@ -0,0 +1,108 @@
+#undef NDEBUG
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "embedded/embedded.h"
+#include "embedded/engine.h"
+#include "execution/execution_pipeline.h"
+#include "gtest/gtest.h"
+
+const std::string TEST_DB_NAME = "PipelineDistinctTest_db";  // 以数据库名作为根目录
+const int NUM_ROWS = 6000;
+const int NUM_A = 1000;
+const size_t TEST_DISTINCT_MEM_BYTES = 4096;  // 远小于DISTINCT_MEM_BYTES，去重很快溢出到临时文件
+
+class PipelineDistinctTest : public ::testing::Test {
+   public:
+    std::unique_ptr<Engine> engine_;
+    std::unique_ptr<Session> session_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        if (system(("rm -rf " + TEST_DB_NAME).c_str()) != 0) {
+            throw UnixError();
+        }
+        engine_ = std::make_unique<Engine>();
+        engine_->open_db(TEST_DB_NAME);
+        session_ = std::make_unique<Session>(engine_.get());
+        session_->execute("create table t (a int, b int, c int);");
+        session_->execute("begin;");
+        for (int i = 0; i < NUM_ROWS; i++) {
+            // 每个a有3个不同的b，(a, b)共3000个不同的键值，按插入顺序乱序出现
+            session_->execute("insert into t values (" + std::to_string(i * 7919 % NUM_A) + ", " +
+                              std::to_string(i % 3) + ", " + std::to_string(i) + ");");
+        }
+        session_->execute("commit;");
+    }
+
+    void TearDown() override {
+        session_.reset();
+        engine_.reset();
+        if (system(("rm -rf " + TEST_DB_NAME).c_str()) != 0) {
+            throw UnixError();
+        }
+    }
+
+    /* select distinct a, b from t order by a [desc]，用给定的去重内存预算执行，返回输出的(a, b) */
+    std::vector<std::pair<int, int>> select_distinct(bool is_desc, const std::shared_ptr<ast::Limit> &limit) {
+        auto order = std::make_shared<ast::OrderBy>(std::make_shared<ast::Col>("", "a"),
+                                                    is_desc ? ast::OrderBy_DESC : ast::OrderBy_ASC);
+        auto select = std::make_shared<ast::SelectStmt>(
+            std::vector<std::shared_ptr<ast::Col>>{std::make_shared<ast::Col>("", "a"), std::make_shared<ast::Col>("", "b")},
+            std::vector<std::string>{"t"}, std::vector<std::shared_ptr<ast::BinaryExpr>>{}, order, nullptr,
+            std::vector<std::shared_ptr<ast::AggCall>>{}, limit);
+        select->distinct = true;
+
+        std::vector<char> buf(BUFFER_LENGTH);
+        int len = 0;
+        Context context(engine_->lock_manager_.get(), engine_->log_manager_.get(), nullptr, buf.data(), &len);
+        context.txn_ = engine_->txn_manager_->begin(nullptr, context.log_mgr_);
+        auto plan = engine_->optimizer_->plan_query(engine_->analyze_->do_analyze(select), &context);
+        auto projection = std::dynamic_pointer_cast<ProjectionPlan>(std::dynamic_pointer_cast<DMLPlan>(plan)->subplan_);
+        SelectPipeline pipeline(
+            engine_->sm_manager_.get(), projection, &context,
+            [&](std::shared_ptr<Plan> subplan) { return engine_->portal_->convert_plan_executor(subplan, &context); },
+            TEST_DISTINCT_MEM_BYTES);
+        std::vector<std::pair<int, int>> rows;
+        auto sink = [&](const char *rec) {
+            rows.emplace_back(*reinterpret_cast<const int *>(rec), *reinterpret_cast<const int *>(rec + sizeof(int)));
+        };
+        pipeline.run(sink);
+        engine_->txn_manager_->commit(context.txn_, context.log_mgr_);
+        return rows;
+    }
+};
+
+/**
+ * @brief 去重的键值超过内存预算溢出到临时文件时，输出仍然按order by有序，且每个键值只输出一次
+ */
+TEST_F(PipelineDistinctTest, SpillWithOrderBy) {
+    for (bool is_desc : {false, true}) {
+        auto rows = select_distinct(is_desc, nullptr);
+        ASSERT_EQ(rows.size(), static_cast<size_t>(NUM_A * 3));
+        std::set<std::pair<int, int>> keys(rows.begin(), rows.end());
+        ASSERT_EQ(keys.size(), rows.size());
+        for (size_t i = 1; i < rows.size(); i++) {
+            if (is_desc) {
+                ASSERT_GE(rows[i - 1].first, rows[i].first);
+            } else {
+                ASSERT_LE(rows[i - 1].first, rows[i].first);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 溢出时limit取的是排序后的前几个键值
+ */
+TEST_F(PipelineDistinctTest, SpillWithOrderByLimit) {
+    auto rows = select_distinct(false, std::make_shared<ast::Limit>(10, 0));
+    ASSERT_EQ(rows.size(), static_cast<size_t>(10));
+    for (size_t i = 0; i < rows.size(); i++) {
+        ASSERT_EQ(rows[i].first, static_cast<int>(i / 3));
+    }
+}
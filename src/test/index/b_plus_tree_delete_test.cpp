@@ -217,6 +217,23 @@ class BPlusTreeTests : public ::testing::Test {
         }
     }
 
+    /**
+     * @brief 子树中叶子结点的键值对总数
+     */
+    int count_entries(const IxIndexHandle *ih, int page_no) {
+        IxNodeHandle *node = ih->fetch_node(page_no);
+        int count = 0;
+        if (node->is_leaf_page()) {
+            count = node->get_size();
+        } else {
+            for (int i = 0; i < node->get_size(); i++) {
+                count += count_entries(ih, node->value_at(i));
+            }
+        }
+        buffer_pool_manager_->unpin_page(node->get_page_id(), false);
+        return count;
+    }
+
     /**
      * @brief dfs遍历整个树，检查孩子结点的第一个和最后一个key是否正确
      *
@@ -233,6 +250,10 @@ class BPlusTreeTests : public ::testing::Test {
             IxNodeHandle *child = ih->fetch_node(node->value_at(i));  // 第i个孩子
             // check parent
             assert(child->get_parent_page_no() == now_page_no);
+            // check subtree count
+            if (ih->is_counted()) {
+                ASSERT_EQ(node->get_rid(i)->slot_no, count_entries(ih, node->value_at(i)));
+            }
             // check first key
             int node_key = node->key_at(i);  // node的第i个key
             int child_first_key = child->key_at(0);
@@ -285,6 +306,18 @@ class BPlusTreeTests : public ::testing::Test {
             }
         }
 
+        // test rank and iid_at
+        if (ih->is_counted() && !ih->is_empty()) {
+            size_t pos = 0;
+            for (auto &entry : mock) {
+                int mock_key = entry.first;
+                ASSERT_EQ(ih->rank(ih->lower_bound((const char *)&mock_key)), pos);
+                ASSERT_EQ(ih->get_rid(ih->iid_at(pos)), entry.second);
+                pos++;
+            }
+            ASSERT_EQ(ih->rank(ih->leaf_end()), mock.size());
+        }
+
         // test scan
         IxScan scan(ih, ih->leaf_begin(), ih->leaf_end(), buffer_pool_manager_.get());
         auto it = mock.begin();
@@ -491,4 +524,38 @@ TEST_F(BPlusTreeTests, LargeScaleTest) {
     }
     std::cout << "Insert keys count: " << add_cnt << '\n' << "Delete keys count: " << del_cnt << '\n';
     check_all(ih_.get(), mock);
-}
\ No newline at end of file
+}
+/**
+ * @brief 随机插入后按范围删除，整段删除覆盖多个叶子的键值对
+ */
+TEST_F(BPlusTreeTests, RangeDeleteTest) {
+    const int order = 255;
+    const int scale = 20000;
+
+    if (order >= 2 && order <= ih_->file_hdr_->btree_order_) {
+        ih_->file_hdr_->btree_order_ = order;
+    }
+    std::multimap<int, Rid> mock;
+    for (int round = 0; round < 50; round++) {
+        for (int i = 0; i < 400; i++) {
+            int rand_key = rand() % scale;
+            if (mock.find(rand_key) != mock.end()) {
+                continue;
+            }
+            Rid rand_val = {.page_no = rand(), .slot_no = rand()};
+            ih_->insert_entry((const char *)&rand_key, rand_val, txn_.get());
+            mock.insert(std::make_pair(rand_key, rand_val));
+        }
+
+        int lower = rand() % scale;
+        int upper = lower + rand() % (scale / 4);
+        int expect = 0;
+        for (auto it = mock.lower_bound(lower); it != mock.end() && it->first <= upper;) {
+            it = mock.erase(it);
+            expect++;
+        }
+        int removed = ih_->delete_range((const char *)&lower, (const char *)&upper, txn_.get());
+        ASSERT_EQ(removed, expect);
+        check_all(ih_.get(), mock);
+    }
+}
@@ -0,0 +1,93 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+// 批量查找（group prefetching）的性能测试：索引全部驻留在缓冲池中，
+// 比较逐个调用get_value与不同组大小的get_values的单次查找耗时
+// 用法：b_plus_tree_probe_bench [key的个数] [查找次数]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include "index/ix.h"
+#include "storage/buffer_pool_manager.h"
+
+const std::string BENCH_DB_NAME = "BPlusTreeProbeBench_db";
+const std::string BENCH_FILE_NAME = "table1";
+
+int main(int argc, char **argv) {
+    int num_keys = argc > 1 ? atoi(argv[1]) : (1 << 20);
+    int num_probes = argc > 2 ? atoi(argv[2]) : (1 << 20);
+
+    auto disk_manager = std::make_unique<DiskManager>();
+    auto buffer_pool_manager = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager.get());
+    auto ix_manager = std::make_unique<IxManager>(disk_manager.get(), buffer_pool_manager.get());
+
+    std::string cmd = "rm -rf " + BENCH_DB_NAME + " && mkdir " + BENCH_DB_NAME;
+    if (system(cmd.c_str()) != 0 || chdir(BENCH_DB_NAME.c_str()) < 0) {
+        throw UnixError();
+    }
+    std::vector<ColMeta> cols = {{BENCH_FILE_NAME, "col1", TYPE_INT, 4, 0, true}};
+    ix_manager->create_index(BENCH_FILE_NAME, cols);
+    auto ih = ix_manager->open_index(BENCH_FILE_NAME, cols);
+
+    // 随机顺序插入，得到与线上相近的半满结点
+    std::vector<int> keys(num_keys);
+    for (int i = 0; i < num_keys; ++i) keys[i] = i * 2;
+    std::mt19937 rng(2023);
+    std::shuffle(keys.begin(), keys.end(), rng);
+    for (int key : keys) {
+        ih->insert_entry(reinterpret_cast<const char *>(&key), Rid{key, 0}, nullptr);
+    }
+
+    // 一半命中一半不命中
+    std::vector<int> probe_keys(num_probes);
+    std::uniform_int_distribution<int> dist(0, num_keys * 2 - 1);
+    for (auto &key : probe_keys) key = dist(rng);
+    std::vector<const char *> probes(num_probes);
+    for (int i = 0; i < num_probes; ++i) probes[i] = reinterpret_cast<const char *>(&probe_keys[i]);
+
+    auto report = [&](const char *name, int group_size, auto &&run) {
+        run();  // 预热
+        auto start = std::chrono::steady_clock::now();
+        int found = run();
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / num_probes;
+        printf("%-12s group=%-4d %8.1f ns/probe  found=%d\n", name, group_size, ns, found);
+        return found;
+    };
+
+    int expect = report("get_value", 1, [&]() {
+        int found = 0;
+        std::vector<Rid> result;
+        for (auto probe : probes) {
+            result.clear();
+            found += ih->get_value(probe, &result, nullptr);
+        }
+        return found;
+    });
+    std::vector<Rid> result;
+    std::vector<bool> found;
+    for (int group_size : {1, 2, 4, 8, 16, 32, 64, 128}) {
+        int n = report("get_values", group_size,
+                       [&]() { return ih->get_values(probes, &result, &found, nullptr, group_size); });
+        if (n != expect) {
+            printf("mismatch: get_values found %d keys, get_value found %d\n", n, expect);
+            return 1;
+        }
+    }
+
+    ix_manager->close_index(ih.get());
+    if (chdir("..") < 0) {
+        throw UnixError();
+    }
+    return 0;
+}
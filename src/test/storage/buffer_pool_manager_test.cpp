@@ -3,6 +3,7 @@
 #include <cassert>
 #include <cstring>
 #include <ctime>
+#include <deque>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -427,3 +428,75 @@ TEST_F(BufferPoolManagerTest, ConcurrencyTest) {
 
     disk_manager_->close_file(fd);
 }
+
+/**
+ * @brief 协程按窗口异步读取[begin, end)的页面，检查页面内容后unpin；skip_last为真时最后一个页面不co_await，由析构unpin
+ */
+CoTask fetch_pages_async(BufferPoolManager *bpm, CoScheduler *scheduler, int fd, int begin, int end, bool skip_last,
+                         int *num_checked) {
+    std::deque<PageFetch> window;
+    for (int page_no = begin; page_no < end; page_no++) {
+        window.push_back(bpm->fetch_page_async(PageId{fd, page_no}, scheduler));
+    }
+    for (int page_no = begin; page_no < (skip_last ? end - 1 : end); page_no++) {
+        Page *page = co_await window.front();
+        window.pop_front();
+        EXPECT_NE(nullptr, page);
+        EXPECT_EQ(page_no, *reinterpret_cast<int *>(page->get_data()));
+        EXPECT_EQ(true, bpm->unpin_page(PageId{fd, page_no}, false));
+        (*num_checked)++;
+    }
+}
+
+/**
+ * @brief 缺页的协程挂起等待异步读取，多个协程的读请求同时在途；读取失败时co_await抛出异常并释放预留的帧
+ */
+TEST_F(BufferPoolManagerTest, AsyncFetchTest) {
+    const std::string filename = "async_fetch_test";
+    const int num_pages = 64;
+    const size_t buffer_pool_size = 16;
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+    {
+        auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager_.get());
+        for (int i = 0; i < num_pages; i++) {
+            PageId page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+            Page *page = bpm->new_page(&page_id);
+            ASSERT_NE(nullptr, page);
+            *reinterpret_cast<int *>(page->get_data()) = page_id.page_no;
+            EXPECT_EQ(true, bpm->unpin_page(page_id, true));
+        }
+        bpm->flush_all_pages(fd);
+    }
+
+    auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager_.get());
+    for (int begin = 0; begin < num_pages; begin += buffer_pool_size) {
+        CoScheduler scheduler;
+        int num_checked = 0;
+        int half = static_cast<int>(buffer_pool_size / 2);
+        scheduler.spawn(fetch_pages_async(bpm.get(), &scheduler, fd, begin, begin + half, false, &num_checked));
+        scheduler.spawn(fetch_pages_async(bpm.get(), &scheduler, fd, begin + half, begin + 2 * half, true, &num_checked));
+        scheduler.run();
+        EXPECT_EQ(2 * half - 1, num_checked);
+    }
+
+    // 读取文件末尾之后的页面失败
+    CoScheduler scheduler;
+    scheduler.spawn([](BufferPoolManager *bpm, CoScheduler *scheduler, int fd) -> CoTask {
+        PageFetch fetch = bpm->fetch_page_async(PageId{fd, num_pages + 1}, scheduler);
+        co_await fetch;
+    }(bpm.get(), &scheduler, fd));
+    EXPECT_THROW(scheduler.run(), InternalError);
+
+    // 所有页面都已unpin，读取失败的帧也已释放，缓冲池的帧可以同时全部pin住
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+        Page *page = bpm->fetch_page(PageId{fd, static_cast<int>(i)});
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(static_cast<int>(i), *reinterpret_cast<int *>(page->get_data()));
+    }
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+        EXPECT_EQ(true, bpm->unpin_page(PageId{fd, static_cast<int>(i)}, false));
+    }
+
+    disk_manager_->close_file(fd);
+}
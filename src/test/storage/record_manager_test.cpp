@@ -1,5 +1,7 @@
 #undef NDEBUG
 
+#include <sstream>  // 标准库头文件在替换private之前包含，C++20的sstream不能在private被替换后编译
+
 #define private public
 #include "record/rm.h"
 #undef private  // for use private variables in "rm.h"
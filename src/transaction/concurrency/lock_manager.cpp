@@ -78,7 +78,7 @@ bool LockManager::lock_shared_on_record(Transaction* txn, const Rid& rid, int ta
     ++lockRequestQueue.shared_lock_num_;
     // 成功申请共享锁
     lockRequestQueue.request_queue_.back().granted_ = true;
-    txn->get_lock_set()->emplace(lockDataId);
+    txn->append_lock(lockDataId);
     return true;
 }
 
@@ -146,7 +146,7 @@ bool LockManager::lock_exclusive_on_record(Transaction* txn, const Rid& rid, int
     lockRequestQueue.request_queue_.emplace_back(txn->get_transaction_id(), LockMode::EXLUCSIVE);
     // 成功申请排他锁
     lockRequestQueue.request_queue_.back().granted_ = true;
-    txn->get_lock_set()->emplace(lockDataId);
+    txn->append_lock(lockDataId);
     return true;
 }
 
@@ -190,7 +190,7 @@ bool LockManager::lock_shared_on_gap(Transaction* txn, int tab_fd, int left_key,
     lockRequestQueue.request_queue_.emplace_back(txn->get_transaction_id(), LockMode::SHARED);
     ++lockRequestQueue.shared_lock_num_;
     lockRequestQueue.request_queue_.back().granted_ = true;
-    txn->get_lock_set()->emplace(lockDataId);
+    txn->append_lock(lockDataId);
     return true;
 }
 
@@ -242,7 +242,7 @@ bool LockManager::lock_exclusive_on_gap(Transaction* txn, int tab_fd, int left_k
     lockRequestQueue.group_lock_mode_ = GroupLockMode::X;
     lockRequestQueue.request_queue_.emplace_back(txn->get_transaction_id(), LockMode::EXLUCSIVE);
     lockRequestQueue.request_queue_.back().granted_ = true;
-    txn->get_lock_set()->emplace(lockDataId);
+    txn->append_lock(lockDataId);
     return true;
 }
 
@@ -312,7 +312,7 @@ bool LockManager::lock_shared_on_table(Transaction* txn, int tab_fd) {
     ++lockRequestQueue.shared_lock_num_;
     // 成功申请共享锁
     lockRequestQueue.request_queue_.back().granted_ = true;
-    txn->get_lock_set()->emplace(lockDataId);
+    txn->append_lock(lockDataId);
     return true;
 }
 
@@ -366,7 +366,7 @@ bool LockManager::lock_exclusive_on_table(Transaction* txn, int tab_fd) {
     lockRequestQueue.request_queue_.emplace_back(txn->get_transaction_id(), LockMode::EXLUCSIVE);
     lockRequestQueue.request_queue_.back().granted_ = true;
     // 成功申请共享锁
-    txn->get_lock_set()->emplace(lockDataId);
+    txn->append_lock(lockDataId);
     return true;
 }
 
@@ -415,7 +415,7 @@ bool LockManager::lock_IS_on_table(Transaction* txn, int tab_fd) {
     lockRequestQueue.request_queue_.emplace_back(txn->get_transaction_id(), LockMode::INTENTION_SHARED);
     lockRequestQueue.request_queue_.back().granted_ = true;
     // 成功申请共享锁
-    txn->get_lock_set()->emplace(lockDataId);
+    txn->append_lock(lockDataId);
     return true;
 }
 
@@ -483,7 +483,7 @@ bool LockManager::lock_IX_on_table(Transaction* txn, int tab_fd) {
     ++lockRequestQueue.IX_lock_num_;
     // 成功申请意向排他锁
     lockRequestQueue.request_queue_.back().granted_ = true;
-    txn->get_lock_set()->emplace(lockDataId);
+    txn->append_lock(lockDataId);
     return true;
 }
 
@@ -15,7 +15,9 @@ See the Mulan PSL v2 for more details. */
 #include <string>
 #include <thread>
 #include <memory>
+#include <mutex>
 #include <unordered_set>
+#include <vector>
 
 #include "txn_defs.h"
 
@@ -52,7 +54,15 @@ class Transaction {
     inline void set_prev_lsn(lsn_t prev_lsn) { prev_lsn_ = prev_lsn; }
 
     inline std::shared_ptr<std::deque<WriteRecord *>> get_write_set() { return write_set_; }  
-    inline void append_write_record(WriteRecord* write_record) { write_set_->push_back(write_record); }
+    inline void append_write_record(WriteRecord* write_record) {
+        std::scoped_lock lock{latch_};
+        write_set_->push_back(write_record);
+    }
+    /* 并行DML的工作线程共用一个事务，每个线程一次加入它负责的一批写记录 */
+    inline void append_write_records(const std::vector<WriteRecord*>& write_records) {
+        std::scoped_lock lock{latch_};
+        write_set_->insert(write_set_->end(), write_records.begin(), write_records.end());
+    }
 
     inline std::shared_ptr<std::deque<Page*>> get_index_deleted_page_set() { return index_deleted_page_set_; }
     inline void append_index_deleted_page(Page* page) { index_deleted_page_set_->push_back(page); }
@@ -61,6 +71,10 @@ class Transaction {
     inline void append_index_latch_page_set(Page* page) { index_latch_page_set_->push_back(page); }
 
     inline std::shared_ptr<std::unordered_set<LockDataId>> get_lock_set() { return lock_set_; }
+    inline void append_lock(const LockDataId& lock_data_id) {
+        std::scoped_lock lock{latch_};
+        lock_set_->emplace(lock_data_id);
+    }
 
    private:
     bool txn_mode_;                   // 用于标识当前事务为显式事务还是单条SQL语句的隐式事务
@@ -75,4 +89,5 @@ class Transaction {
     std::shared_ptr<std::unordered_set<LockDataId>> lock_set_;  // 事务申请的所有锁
     std::shared_ptr<std::deque<Page*>> index_latch_page_set_;          // 维护事务执行过程中加锁的索引页面
     std::shared_ptr<std::deque<Page*>> index_deleted_page_set_;    // 维护事务执行过程中删除的索引页面
+    std::mutex latch_;                // 保护write_set_和lock_set_的加入，并行DML的多个工作线程共用一个事务
 };
@@ -10,6 +10,8 @@ See the Mulan PSL v2 for more details. */
 
 #include "transaction_manager.h"
 
+#include <set>
+
 #include "record/rm_file_handle.h"
 #include "system/sm_manager.h"
 #include "common/context.h"
@@ -54,7 +56,19 @@ void TransactionManager::commit(Transaction *txn, LogManager *log_manager) {
     std::scoped_lock lock(latch_);
 
     auto write_set = txn->get_write_set();
+    // TRUNCATE换下的旧文件在提交时才真正删除
+    std::set<std::string> written_tabs;
+    for (auto &item : *write_set) {
+        if (item->GetWriteType() == WType::TRUNCATE_TABLE) {
+            sm_manager_->commit_truncate(item->GetTableName(), txn);
+        }
+        written_tabs.insert(item->GetTableName());
+    }
     write_set->clear();
+    // 在释放锁之前增加表的版本，之后读到新数据的查询不会以旧版本放入结果缓存
+    for (auto &tab_name : written_tabs) {
+        sm_manager_->bump_table_version(tab_name);
+    }
     auto lock_set = txn->get_lock_set();
     for (auto lock : *lock_set) {
         lock_manager_->unlock(txn, lock);
@@ -81,9 +95,22 @@ void TransactionManager::abort(Transaction * txn, LogManager *log_manager) {
 
     auto write_set = txn->get_write_set();
     Context *context = new Context(lock_manager_, log_manager, txn);
+    // 与DML相同，回滚期间不允许CREATE INDEX CONCURRENTLY注册或切换索引
+    std::shared_lock<std::shared_mutex> build_lock(sm_manager_->index_build_latch_);
+    std::set<std::string> written_tabs;
+    for (auto &item : *write_set) {
+        written_tabs.insert(item->GetTableName());
+    }
     while (!write_set->empty()) {
         auto &item = write_set->back();
         WType type = item->GetWriteType();
+
+        // TRUNCATE没有逐条的记录和索引操作，直接把旧文件换回即可
+        if (type == WType::TRUNCATE_TABLE) {
+            sm_manager_->rollback_truncate(item->GetTableName(), txn);
+            write_set->pop_back();
+            continue;
+        }
         
         // 首先处理索引 undo log（倒序执行，LIFO）
         auto &index_ops = item->GetIndexOps();
@@ -92,10 +119,13 @@ void TransactionManager::abort(Transaction * txn, LogManager *log_manager) {
             auto &tab_name = item->GetTableName();
             auto tab = sm_manager_->db_.get_table(tab_name);
             
-            // 获取索引句柄
-            auto ih = sm_manager_->ihs_.at(
-                sm_manager_->get_ix_manager()->get_index_name(tab_name, idx_op.index_cols)
-            ).get();
+            // 获取索引句柄，索引可能已被删除
+            auto ih_it = sm_manager_->ihs_.find(
+                sm_manager_->get_ix_manager()->get_index_name(tab_name, idx_op.index_cols));
+            if (ih_it == sm_manager_->ihs_.end()) {
+                continue;
+            }
+            auto ih = ih_it->second.get();
             
             if (idx_op.op_type == IndexOpType::INDEX_INSERT) {
                 // 回滚索引插入：删除索引条目
@@ -161,6 +191,9 @@ void TransactionManager::abort(Transaction * txn, LogManager *log_manager) {
             } catch (...) {
                 // 记录可能不存在，忽略
             }
+            if (rec_data != nullptr) {
+                undo_untracked_indexes(item, rec_data->data, nullptr, context);
+            }
         } else if (type == WType::DELETE_TUPLE) {
             auto &tab_name = item->GetTableName();
             auto &rid = item->GetRid();  // 使用原来的RID
@@ -196,6 +229,9 @@ void TransactionManager::abort(Transaction * txn, LogManager *log_manager) {
                     // 先删除现有记录的索引条目，避免索引不一致
                     for (size_t i = 0; i < tab.indexes.size(); ++i) {
                         auto &index = tab.indexes[i];
+                        if (!index.covers(existing_rec->data)) {
+                            continue;
+                        }
                         auto ih =
                             sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name, index.cols)).get();
                         char *key = new char[index.col_tot_len];
@@ -266,6 +302,9 @@ void TransactionManager::abort(Transaction * txn, LogManager *log_manager) {
                                 // 先删除现有记录的索引条目
                                 for (size_t i = 0; i < tab.indexes.size(); ++i) {
                                     auto &index = tab.indexes[i];
+                                    if (!index.covers(existing_rec->data)) {
+                                        continue;
+                                    }
                                     auto ih =
                                         sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name, index.cols)).get();
                                     char *key = new char[index.col_tot_len];
@@ -322,6 +361,9 @@ void TransactionManager::abort(Transaction * txn, LogManager *log_manager) {
             
             // 注意：索引 undo log 已经在上面处理了，这里只需要恢复记录
             // 如果记录恢复失败，索引 undo log 已经尝试恢复了，即使失败也不会导致不一致
+            if (record_restored) {
+                undo_untracked_indexes(item, nullptr, rec.data, context);
+            }
         } else if (type == WType::UPDATE_TUPLE) {
             auto &tab_name = item->GetTableName();
             auto &rid = item->GetRid();
@@ -421,9 +463,15 @@ void TransactionManager::abort(Transaction * txn, LogManager *log_manager) {
             
             // 注意：索引 undo log 已经在上面处理了，这里只需要恢复记录
             // 如果记录恢复失败，索引 undo log 已经尝试恢复了，即使失败也不会导致不一致
+            if (record_restored) {
+                undo_untracked_indexes(item, current_rec != nullptr ? current_rec->data : nullptr, record.data, context);
+            }
         }
         write_set->pop_back();
     }
+    for (auto &tab_name : written_tabs) {
+        sm_manager_->bump_table_version(tab_name);
+    }
 
     auto lock_set = txn->get_lock_set();
     for (auto lock : *lock_set) {
@@ -431,4 +479,51 @@ void TransactionManager::abort(Transaction * txn, LogManager *log_manager) {
     }
     lock_set->clear();
     txn->set_state(TransactionState::ABORTED);
+}
+
+/**
+ * @description: 回滚一条写记录时，维护写记录中没有索引undo log的索引：
+ *               写操作之后才建好的索引，以及正在由CREATE INDEX CONCURRENTLY构建的索引
+ * @param {WriteRecord*} item 正在回滚的写记录
+ * @param {char*} undo_old 回滚时被移除的记录内容，没有则为nullptr
+ * @param {char*} undo_new 回滚时被恢复的记录内容，没有则为nullptr
+ * @param {Context*} context
+ */
+void TransactionManager::undo_untracked_indexes(WriteRecord *item, const char *undo_old, const char *undo_new,
+                                                Context *context) {
+    auto &tab_name = item->GetTableName();
+    auto &rid = item->GetRid();
+    sm_manager_->capture_index_build(tab_name, undo_old, undo_new, rid);
+    sm_manager_->capture_trigram(tab_name, undo_old, undo_new, rid);
+    sm_manager_->capture_stats(tab_name, undo_old, undo_new);
+
+    auto ix_manager = sm_manager_->get_ix_manager();
+    std::unordered_set<std::string> tracked;
+    for (auto &idx_op : item->GetIndexOps()) {
+        tracked.insert(ix_manager->get_index_name(tab_name, idx_op.index_cols));
+    }
+    auto &tab = sm_manager_->db_.get_table(tab_name);
+    for (auto &index : tab.indexes) {
+        std::string index_name = ix_manager->get_index_name(tab_name, index.cols);
+        if (tracked.count(index_name) != 0) {
+            continue;
+        }
+        auto ih = sm_manager_->ihs_.at(index_name).get();
+        std::vector<char> key(index.col_tot_len);
+        auto make_key = [&](const char *rec) {
+            int offset = 0;
+            for (auto &col : index.cols) {
+                memcpy(key.data() + offset, rec + col.offset, col.len);
+                offset += col.len;
+            }
+        };
+        if (undo_old != nullptr && index.covers(undo_old)) {
+            make_key(undo_old);
+            ih->delete_entry(key.data(), context->txn_);
+        }
+        if (undo_new != nullptr && index.covers(undo_new)) {
+            make_key(undo_new);
+            ih->insert_entry(key.data(), rid, context->txn_);
+        }
+    }
 }
\ No newline at end of file
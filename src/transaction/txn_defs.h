@@ -25,8 +25,8 @@ enum class TransactionState { DEFAULT, GROWING, SHRINKING, COMMITTED, ABORTED };
 /* 系统的隔离级别，当前赛题中为可串行化隔离级别 */
 enum class IsolationLevel { READ_UNCOMMITTED, REPEATABLE_READ, READ_COMMITTED, SERIALIZABLE };
 
-/* 事务写操作类型，包括插入、删除、更新三种操作 */
-enum class WType { INSERT_TUPLE = 0, DELETE_TUPLE, UPDATE_TUPLE};
+/* 事务写操作类型，包括插入、删除、更新三种元组操作，以及整表清空操作 */
+enum class WType { INSERT_TUPLE = 0, DELETE_TUPLE, UPDATE_TUPLE, TRUNCATE_TABLE};
 
 /* 索引操作类型 */
 enum class IndexOpType { INDEX_INSERT = 0, INDEX_DELETE };
@@ -92,11 +92,19 @@ struct IndexWriteRecord {
  * ----------------------------------------------
  * | wtype | tab_name | tuple_rid | tuple_value |
  * ----------------------------------------------
+ * TRUNCATE（tuple_rid无意义，旧文件由SmManager保留）
+ * --------------------
+ * | wtype | tab_name |
+ * --------------------
  */
 class WriteRecord {
    public:
     WriteRecord() = default;
 
+    // constructor for truncate operation
+    WriteRecord(WType wtype, const std::string &tab_name)
+        : wtype_(wtype), tab_name_(tab_name), rid_{-1, -1} {}
+
     // constructor for insert operation
     WriteRecord(WType wtype, const std::string &tab_name, const Rid &rid)
         : wtype_(wtype), tab_name_(tab_name), rid_(rid) {}